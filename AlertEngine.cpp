@@ -0,0 +1,249 @@
+#include "AlertEngine.h"
+#include "Metrics.h"
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+double returnPercent(Money price, int shares, Money costBasis) {
+    return Money::ratio(price * shares - costBasis, costBasis) * 100.0;
+}
+
+} // namespace
+
+// Constructor
+AlertEngine::AlertEngine() : activeRules(0) {}
+
+// Rule management
+std::uint32_t AlertEngine::bucketFor(const std::string& symbol) {
+    auto found = bucketBySymbol.find(symbol);
+    if (found != bucketBySymbol.end()) {
+        return found->second;
+    }
+    std::uint32_t bucket = static_cast<std::uint32_t>(buckets.size());
+    buckets.emplace_back();
+    buckets.back().symbol = symbol;
+    bucketBySymbol.emplace(symbol, bucket);
+    return bucket;
+}
+
+AlertRuleId AlertEngine::addRule(const std::string& symbol, AlertType type, std::int64_t priceKey,
+                                 double percentKey) {
+    if (symbol.empty()) {
+        throw std::invalid_argument("Alert rule needs a symbol");
+    }
+    if (!std::isfinite(percentKey)) {
+        throw std::invalid_argument("Alert threshold must be finite");
+    }
+    std::uint32_t bucket = bucketFor(symbol);
+    AlertRuleId id = rules.size() + 1;
+    rules.push_back({bucket, type, true, priceKey, percentKey});
+
+    SymbolRules& target = buckets[bucket];
+    switch (type) {
+        case AlertType::StopLoss:    target.stopLoss.add(priceKey, id); break;
+        case AlertType::TakeProfit:  target.takeProfit.add(priceKey, id); break;
+        case AlertType::PercentMove:
+            (percentKey >= 0.0 ? target.moveUp : target.moveDown).add(percentKey, id);
+            break;
+        case AlertType::ReturnAbove: target.returnAbove.add(percentKey, id); break;
+        case AlertType::ReturnBelow: target.returnBelow.add(percentKey, id); break;
+    }
+    ++activeRules;
+    return id;
+}
+
+AlertRuleId AlertEngine::addStopLoss(const std::string& symbol, Money level) {
+    return addRule(symbol, AlertType::StopLoss, level.raw(), 0.0);
+}
+
+AlertRuleId AlertEngine::addTakeProfit(const std::string& symbol, Money level) {
+    return addRule(symbol, AlertType::TakeProfit, level.raw(), 0.0);
+}
+
+AlertRuleId AlertEngine::addPercentMove(const std::string& symbol, double percent) {
+    if (percent == 0.0) {
+        throw std::invalid_argument("Percent move threshold must be non-zero");
+    }
+    return addRule(symbol, AlertType::PercentMove, 0, percent);
+}
+
+AlertRuleId AlertEngine::addReturnAbove(const std::string& symbol, double percent) {
+    return addRule(symbol, AlertType::ReturnAbove, 0, percent);
+}
+
+AlertRuleId AlertEngine::addReturnBelow(const std::string& symbol, double percent) {
+    return addRule(symbol, AlertType::ReturnBelow, 0, percent);
+}
+
+bool AlertEngine::removeRule(AlertRuleId id) {
+    if (id == 0 || id > rules.size() || !rules[id - 1].active) {
+        return false;
+    }
+    RuleSlot& slot = rules[id - 1];
+    SymbolRules& target = buckets[slot.bucket];
+    switch (slot.type) {
+        case AlertType::StopLoss:    target.stopLoss.remove(slot.priceKey, id); break;
+        case AlertType::TakeProfit:  target.takeProfit.remove(slot.priceKey, id); break;
+        case AlertType::PercentMove:
+            (slot.percentKey >= 0.0 ? target.moveUp : target.moveDown).remove(slot.percentKey, id);
+            break;
+        case AlertType::ReturnAbove: target.returnAbove.remove(slot.percentKey, id); break;
+        case AlertType::ReturnBelow: target.returnBelow.remove(slot.percentKey, id); break;
+    }
+    slot.active = false;
+    --activeRules;
+    return true;
+}
+
+size_t AlertEngine::getRuleCount() const {
+    return activeRules;
+}
+
+void AlertEngine::prepare() {
+    for (SymbolRules& target : buckets) {
+        target.stopLoss.ensureSorted();
+        target.takeProfit.ensureSorted();
+        target.moveUp.ensureSorted();
+        target.moveDown.ensureSorted();
+        target.returnAbove.ensureSorted();
+        target.returnBelow.ensureSorted();
+    }
+}
+
+void AlertEngine::clear() {
+    buckets.clear();
+    bucketBySymbol.clear();
+    rules.clear();
+    activeRules = 0;
+    pending.clear();
+}
+
+// Evaluation
+void AlertEngine::trigger(const SymbolRules& target, AlertRuleId id, AlertType type, Money oldPrice,
+                          Money newPrice, double threshold, double observed) {
+    Alert alert;
+    alert.rule = id;
+    alert.type = type;
+    alert.symbol = target.symbol;
+    alert.previousPrice = oldPrice;
+    alert.price = newPrice;
+    alert.threshold = threshold;
+    alert.observed = observed;
+    pending.push_back(std::move(alert));
+}
+
+size_t AlertEngine::evaluate(const std::string& symbol, Money oldPrice, Money newPrice, int shares,
+                             Money costBasis) {
+    auto found = bucketBySymbol.find(symbol);
+    if (found == bucketBySymbol.end() || oldPrice == newPrice) {
+        return 0;
+    }
+    SymbolRules& target = buckets[found->second];
+    size_t before = pending.size();
+
+    std::int64_t oldUnits = oldPrice.raw();
+    std::int64_t newUnits = newPrice.raw();
+    double move = Money::ratio(newPrice - oldPrice, oldPrice) * 100.0;
+
+    if (newUnits < oldUnits) {
+        // Falling: stop-loss levels in [new, old) were crossed
+        target.stopLoss.visitRange(newUnits, true, oldUnits, false, [&](std::int64_t key, AlertRuleId id) {
+            trigger(target, id, AlertType::StopLoss, oldPrice, newPrice,
+                    Money::fromUnits(key).toDouble(), move);
+        });
+        if (!oldPrice.isZero()) {
+            // Every downward threshold at or above the move fired
+            target.moveDown.visitRange(move, true, 0.0, false, [&](double key, AlertRuleId id) {
+                trigger(target, id, AlertType::PercentMove, oldPrice, newPrice, key, move);
+            });
+        }
+    } else {
+        // Rising: take-profit levels in (old, new] were crossed
+        target.takeProfit.visitRange(oldUnits, false, newUnits, true, [&](std::int64_t key, AlertRuleId id) {
+            trigger(target, id, AlertType::TakeProfit, oldPrice, newPrice,
+                    Money::fromUnits(key).toDouble(), move);
+        });
+        if (!oldPrice.isZero()) {
+            target.moveUp.visitRange(0.0, false, move, true, [&](double key, AlertRuleId id) {
+                trigger(target, id, AlertType::PercentMove, oldPrice, newPrice, key, move);
+            });
+        }
+    }
+
+    if (shares > 0 && costBasis > Money() && !(target.returnAbove.empty() && target.returnBelow.empty())) {
+        double oldReturn = returnPercent(oldPrice, shares, costBasis);
+        double newReturn = returnPercent(newPrice, shares, costBasis);
+        if (newReturn > oldReturn) {
+            target.returnAbove.visitRange(oldReturn, false, newReturn, true, [&](double key, AlertRuleId id) {
+                trigger(target, id, AlertType::ReturnAbove, oldPrice, newPrice, key, newReturn);
+            });
+        } else if (newReturn < oldReturn) {
+            target.returnBelow.visitRange(newReturn, true, oldReturn, false, [&](double key, AlertRuleId id) {
+                trigger(target, id, AlertType::ReturnBelow, oldPrice, newPrice, key, newReturn);
+            });
+        }
+    }
+
+    size_t fired = pending.size() - before;
+    if (fired > 0) {
+        METRIC_ADD(AlertsTriggered, fired);
+    }
+    return fired;
+}
+
+// TickListener
+void AlertEngine::onTick(const Investment& investment, Money oldPrice) {
+    const std::shared_ptr<Stock>& stock = investment.getStock();
+    if (stock) {
+        evaluate(stock->getSymbol(), oldPrice, stock->getCurrentPrice(),
+                 investment.getSharesOwned(), investment.getTotalInvested());
+    }
+}
+
+void AlertEngine::onBatchEnd() {
+    flush();
+}
+
+void AlertEngine::onSplit(const Investment& investment, SplitRatio ratio) {
+    const std::shared_ptr<Stock>& stock = investment.getStock();
+    if (!stock) {
+        return;
+    }
+    auto found = bucketBySymbol.find(stock->getSymbol());
+    if (found == bucketBySymbol.end()) {
+        return;
+    }
+    auto rescale = [this, ratio](std::int64_t key, AlertRuleId rule) {
+        std::int64_t scaled = Money::fromUnits(key).mulDiv(ratio.denominator, ratio.numerator).raw();
+        rules[rule - 1].priceKey = scaled;
+        return scaled;
+    };
+    SymbolRules& target = buckets[found->second];
+    target.stopLoss.rescaleKeys(rescale);
+    target.takeProfit.rescaleKeys(rescale);
+}
+
+// Delivery
+void AlertEngine::setAlertSink(AlertCallback callback) {
+    sink = std::move(callback);
+}
+
+void AlertEngine::flush() {
+    if (!sink || pending.empty()) {
+        return;
+    }
+    std::vector<Alert> batch;
+    batch.swap(pending);
+    sink(batch);
+}
+
+std::vector<Alert> AlertEngine::takeAlerts() {
+    std::vector<Alert> batch;
+    batch.swap(pending);
+    return batch;
+}
+
+size_t AlertEngine::getPendingCount() const {
+    return pending.size();
+}
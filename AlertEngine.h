@@ -0,0 +1,185 @@
+#ifndef ALERT_ENGINE_H
+#define ALERT_ENGINE_H
+
+#include "TickListener.h"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class AlertType : std::uint8_t {
+    StopLoss,         // Price falls to or through a level
+    TakeProfit,       // Price rises to or through a level
+    PercentMove,      // A single tick moves the price by at least the given percent
+    ReturnAbove,      // Position return rises to or through a percent
+    ReturnBelow,      // Position return falls to or through a percent
+};
+
+using AlertRuleId = std::uint64_t;
+
+struct Alert {
+    AlertRuleId rule = 0;
+    AlertType type = AlertType::StopLoss;
+    std::string symbol;
+    Money previousPrice;
+    Money price;
+    double threshold = 0.0;  // Price level or percent the rule was set at
+    double observed = 0.0;   // Tick move or position return (percent) that fired it
+};
+
+using AlertCallback = std::function<void(const std::vector<Alert>&)>;
+
+// Sorted (threshold, rule) pairs for one symbol and rule kind. Additions are
+// appended and sorted lazily, so bulk loading stays O(n log n).
+template <typename Key>
+class ThresholdIndex {
+private:
+    struct Entry {
+        Key key;
+        AlertRuleId rule;
+        bool operator<(const Entry& other) const {
+            return key < other.key || (key == other.key && rule < other.rule);
+        }
+    };
+
+    std::vector<Entry> entries;
+    bool sorted = true;
+
+public:
+    void ensureSorted() {
+        if (!sorted) {
+            std::sort(entries.begin(), entries.end());
+            sorted = true;
+        }
+    }
+
+    bool empty() const { return entries.empty(); }
+    size_t size() const { return entries.size(); }
+
+    void add(Key key, AlertRuleId rule) {
+        if (sorted && !entries.empty() && Entry{key, rule} < entries.back()) {
+            sorted = false;
+        }
+        entries.push_back({key, rule});
+    }
+
+    bool remove(Key key, AlertRuleId rule) {
+        ensureSorted();
+        auto it = std::lower_bound(entries.begin(), entries.end(), Entry{key, rule});
+        if (it == entries.end() || it->key != key || it->rule != rule) {
+            return false;
+        }
+        entries.erase(it);
+        return true;
+    }
+
+    // Visits every rule with lo < key <= hi (or lo <= key when loInclusive,
+    // key < hi when !hiInclusive). Cost is O(log n + matches).
+    template <typename Visitor>
+    void visitRange(Key lo, bool loInclusive, Key hi, bool hiInclusive, Visitor&& visit) {
+        if (entries.empty()) {
+            return;
+        }
+        ensureSorted();
+        auto keyLess = [](const Entry& e, Key k) { return e.key < k; };
+        auto keyGreater = [](Key k, const Entry& e) { return k < e.key; };
+        auto first = loInclusive ? std::lower_bound(entries.begin(), entries.end(), lo, keyLess)
+                                 : std::upper_bound(entries.begin(), entries.end(), lo, keyGreater);
+        auto last = hiInclusive ? std::upper_bound(first, entries.end(), hi, keyGreater)
+                                : std::lower_bound(first, entries.end(), hi, keyLess);
+        for (; first < last; ++first) {
+            visit(first->key, first->rule);
+        }
+    }
+
+    // Replaces every key with rescale(key, rule)
+    template <typename Rescale>
+    void rescaleKeys(Rescale&& rescale) {
+        for (Entry& entry : entries) {
+            entry.key = rescale(entry.key, entry.rule);
+        }
+        sorted = false;
+    }
+};
+
+// Evaluates stop-loss, take-profit, percent-move and return-threshold rules.
+// Rules are indexed by symbol and kept sorted by threshold, so a tick only
+// touches the rules whose boundary lies between the old and new value: cost is
+// one hash lookup plus O(log n + triggered) per rule kind. Price and return
+// rules are edge-triggered (they fire each time the boundary is crossed in
+// their direction); percent-move rules fire on every tick that moves far
+// enough. Triggered alerts are buffered and handed out in batches.
+// Not thread-safe; drive it from the thread that updates prices.
+class AlertEngine : public TickListener {
+private:
+    struct SymbolRules {
+        std::string symbol;
+        ThresholdIndex<std::int64_t> stopLoss;    // Money units
+        ThresholdIndex<std::int64_t> takeProfit;  // Money units
+        ThresholdIndex<double> moveUp;            // Percent > 0
+        ThresholdIndex<double> moveDown;          // Percent < 0
+        ThresholdIndex<double> returnAbove;
+        ThresholdIndex<double> returnBelow;
+    };
+
+    struct RuleSlot {
+        std::uint32_t bucket;
+        AlertType type;
+        bool active;
+        std::int64_t priceKey;
+        double percentKey;
+    };
+
+    std::vector<SymbolRules> buckets;
+    std::unordered_map<std::string, std::uint32_t> bucketBySymbol;
+    std::vector<RuleSlot> rules;  // Indexed by rule id - 1
+    size_t activeRules;
+
+    std::vector<Alert> pending;
+    AlertCallback sink;
+
+    std::uint32_t bucketFor(const std::string& symbol);
+    AlertRuleId addRule(const std::string& symbol, AlertType type, std::int64_t priceKey, double percentKey);
+    void trigger(const SymbolRules& target, AlertRuleId id, AlertType type, Money oldPrice, Money newPrice,
+                 double threshold, double observed);
+
+public:
+    AlertEngine();
+
+    // Rule management
+    AlertRuleId addStopLoss(const std::string& symbol, Money level);
+    AlertRuleId addTakeProfit(const std::string& symbol, Money level);
+    AlertRuleId addPercentMove(const std::string& symbol, double percent);  // Sign gives direction
+    AlertRuleId addReturnAbove(const std::string& symbol, double percent);
+    AlertRuleId addReturnBelow(const std::string& symbol, double percent);
+    bool removeRule(AlertRuleId id);
+    size_t getRuleCount() const;
+    void clear();
+    // Sorts indexes that received rules since the last tick, so bulk loading
+    // is not paid for by the first ticks that touch them.
+    void prepare();
+
+    // Evaluation. Return rules need the position (shares and cost basis);
+    // pass zero shares to evaluate price rules only.
+    size_t evaluate(const std::string& symbol, Money oldPrice, Money newPrice,
+                    int shares = 0, Money costBasis = Money());
+
+    // TickListener
+    void onTick(const Investment& investment, Money oldPrice) override;
+    void onBatchEnd() override;
+    // Stop-loss and take-profit levels follow the split (old/new shares), so
+    // the post-split price does not cross them; percent and return rules are
+    // unaffected
+    void onSplit(const Investment& investment, SplitRatio ratio) override;
+
+    // Delivery: with a sink set, flush() hands it the pending batch;
+    // otherwise takeAlerts() returns and clears it.
+    void setAlertSink(AlertCallback callback);
+    void flush();
+    std::vector<Alert> takeAlerts();
+    size_t getPendingCount() const;
+};
+
+#endif // ALERT_ENGINE_H
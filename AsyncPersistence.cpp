@@ -0,0 +1,630 @@
+#include "AsyncPersistence.h"
+#include "Metrics.h"
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define PORTFOLIO_HAVE_IO_URING 1
+#endif
+#endif
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+#ifdef PORTFOLIO_HAVE_IO_URING
+
+// Minimal io_uring ring driven through the raw syscalls, so there is no
+// liburing dependency. One ring per worker thread; it only ever has one
+// file's transfer in flight.
+class UringRing {
+private:
+    static constexpr unsigned kEntries = 32;
+    static constexpr size_t kChunk = 1 << 20;
+
+    int ringFd = -1;
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned* sqMask = nullptr;
+    unsigned* sqArray = nullptr;
+    unsigned sqEntries = 0;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned* cqMask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+    io_uring_sqe* sqes = nullptr;
+    void* sqRing = MAP_FAILED;
+    void* cqRing = MAP_FAILED;
+    size_t sqRingSize = 0;
+    size_t cqRingSize = 0;
+    size_t sqesSize = 0;
+
+    void queue(std::uint8_t opcode, int fd, char* address, unsigned length, std::uint64_t offset,
+               std::uint64_t tag) {
+        unsigned tail = *sqTail;
+        unsigned slot = tail & *sqMask;
+        io_uring_sqe& sqe = sqes[slot];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = opcode;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<std::uint64_t>(address);
+        sqe.len = length;
+        sqe.off = offset;
+        sqe.user_data = tag;
+        sqArray[slot] = slot;
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+    }
+
+    bool enter(unsigned submit, unsigned wait) {
+        while (true) {
+            long result = syscall(__NR_io_uring_enter, ringFd, submit, wait, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (result >= 0) {
+                return true;
+            }
+            if (errno != EINTR) {
+                return false;
+            }
+        }
+    }
+
+    bool reap(std::uint64_t& tag, int& result) {
+        unsigned head = *cqHead;
+        if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+            return false;
+        }
+        const io_uring_cqe& cqe = cqes[head & *cqMask];
+        tag = cqe.user_data;
+        result = cqe.res;
+        __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+public:
+    UringRing() {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        int fd = static_cast<int>(syscall(__NR_io_uring_setup, kEntries, &params));
+        if (fd < 0) {
+            return;  // ENOSYS, or blocked by seccomp/sysctl
+        }
+        ringFd = fd;
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single) {
+            sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+        }
+        sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        cqRing = single ? sqRing
+                        : mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                               IORING_OFF_CQ_RING);
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqeMemory = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                               IORING_OFF_SQES);
+        if (sqRing == MAP_FAILED || cqRing == MAP_FAILED || sqeMemory == MAP_FAILED) {
+            if (sqeMemory != MAP_FAILED) {
+                munmap(sqeMemory, sqesSize);
+            }
+            release();
+            return;
+        }
+        char* sq = static_cast<char*>(sqRing);
+        char* cq = static_cast<char*>(cqRing);
+        sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        sqEntries = params.sq_entries;
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        sqes = static_cast<io_uring_sqe*>(sqeMemory);
+    }
+
+    ~UringRing() {
+        if (sqes) {
+            munmap(sqes, sqesSize);
+        }
+        release();
+    }
+
+    void release() {
+        if (cqRing != MAP_FAILED && cqRing != sqRing) {
+            munmap(cqRing, cqRingSize);
+        }
+        if (sqRing != MAP_FAILED) {
+            munmap(sqRing, sqRingSize);
+        }
+        sqRing = cqRing = MAP_FAILED;
+        sqes = nullptr;
+        if (ringFd >= 0) {
+            close(ringFd);
+            ringFd = -1;
+        }
+    }
+
+    bool ready() const { return sqes != nullptr; }
+
+    // Reads or writes `length` bytes at offset 0 in 1 MiB chunks, up to the
+    // ring size in flight, then optionally fsyncs. Short chunks are appended
+    // to `remainders` as (offset, length) for the caller to finish
+    // synchronously. False on an I/O error, once nothing is in flight.
+    bool transfer(int fd, bool write, char* buffer, size_t length, bool sync,
+                  std::vector<std::pair<size_t, size_t>>& remainders) {
+        const std::uint8_t opcode = write ? IORING_OP_WRITE : IORING_OP_READ;
+        const size_t chunks = (length + kChunk - 1) / kChunk;
+        size_t queued = 0;
+        size_t inFlight = 0;
+        bool failed = false;
+        while ((!failed && queued < chunks) || inFlight > 0) {
+            unsigned submit = 0;
+            while (!failed && queued < chunks && inFlight < sqEntries) {
+                size_t offset = queued * kChunk;
+                unsigned size = static_cast<unsigned>(std::min(kChunk, length - offset));
+                queue(opcode, fd, buffer + offset, size, offset, queued);
+                ++queued;
+                ++inFlight;
+                ++submit;
+            }
+            if (!enter(submit, 1)) {
+                return false;
+            }
+            std::uint64_t tag;
+            int result;
+            while (reap(tag, result)) {
+                --inFlight;
+                if (result < 0) {
+                    failed = true;  // Keep reaping: the buffer is still in use
+                    continue;
+                }
+                size_t offset = static_cast<size_t>(tag) * kChunk;
+                size_t size = std::min(kChunk, length - offset);
+                if (static_cast<size_t>(result) < size) {
+                    remainders.emplace_back(offset + static_cast<size_t>(result), size - static_cast<size_t>(result));
+                }
+            }
+        }
+        if (failed) {
+            return false;
+        }
+        if (sync) {
+            queue(IORING_OP_FSYNC, fd, nullptr, 0, 0, 0);
+            if (!enter(1, 1)) {
+                return false;
+            }
+            std::uint64_t tag;
+            int result = 0;
+            while (!reap(tag, result)) {
+                if (!enter(0, 1)) {
+                    return false;
+                }
+            }
+            return result >= 0;
+        }
+        return true;
+    }
+};
+
+UringRing& threadRing() {
+    thread_local UringRing ring;
+    return ring;
+}
+
+#endif // PORTFOLIO_HAVE_IO_URING
+
+// Synchronous fallback, and completion of short io_uring transfers
+bool transferRange(int fd, bool write, char* buffer, size_t offset, size_t length) {
+#ifndef _WIN32
+    while (length > 0) {
+        ssize_t done = write ? pwrite(fd, buffer + offset, length, static_cast<off_t>(offset))
+                             : pread(fd, buffer + offset, length, static_cast<off_t>(offset));
+        if (done < 0 && errno == EINTR) {
+            continue;
+        }
+        if (done <= 0) {
+            return false;
+        }
+        offset += static_cast<size_t>(done);
+        length -= static_cast<size_t>(done);
+    }
+    return true;
+#else
+    (void)fd; (void)write; (void)buffer; (void)offset; (void)length;
+    return false;
+#endif
+}
+
+bool transferFile(int fd, bool write, char* buffer, size_t length, bool sync, bool useUring) {
+#ifdef PORTFOLIO_HAVE_IO_URING
+    if (useUring && threadRing().ready()) {
+        std::vector<std::pair<size_t, size_t>> remainders;
+        if (!threadRing().transfer(fd, write, buffer, length, sync, remainders)) {
+            return false;
+        }
+        for (const auto& part : remainders) {
+            if (!transferRange(fd, write, buffer, part.first, part.second)) {
+                return false;
+            }
+        }
+        return remainders.empty() || !sync || fsync(fd) == 0;
+    }
+#else
+    (void)useUring;
+#endif
+    if (!transferRange(fd, write, buffer, 0, length)) {
+        return false;
+    }
+#ifndef _WIN32
+    return !sync || fsync(fd) == 0;
+#else
+    return true;
+#endif
+}
+
+// Writes `data` to `filename` by way of a temporary file renamed into place
+bool writeWholeFile(const std::string& filename, std::string& data, bool sync, bool useUring) {
+    const std::string temporary = filename + ".tmp";
+#ifndef _WIN32
+    int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = transferFile(fd, true, &data[0], data.size(), sync, useUring);
+    ok = close(fd) == 0 && ok;
+#else
+    (void)sync; (void)useUring;
+    std::ofstream file(temporary, std::ios::binary);
+    bool ok = file.is_open() && file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    file.close();
+#endif
+    if (!ok || std::rename(temporary.c_str(), filename.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool readWholeFile(const std::string& filename, std::string& data, bool useUring) {
+#ifndef _WIN32
+    int fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    bool ok = fstat(fd, &info) == 0;
+    if (ok) {
+        data.resize(static_cast<size_t>(info.st_size));
+        ok = data.empty() || transferFile(fd, false, &data[0], data.size(), false, useUring);
+    }
+    close(fd);
+    return ok;
+#else
+    (void)useUring;
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+#endif
+}
+
+// Read-only istream over a string that is parsed in place
+class StringViewBuffer : public std::streambuf {
+public:
+    explicit StringViewBuffer(std::string& text) {
+        setg(&text[0], &text[0], &text[0] + text.size());
+    }
+};
+
+bool probeIoUring() {
+#ifdef PORTFOLIO_HAVE_IO_URING
+    return threadRing().ready();
+#else
+    return false;
+#endif
+}
+
+} // namespace
+
+// Fixed pool of I/O threads draining a job queue; the destructor finishes
+// every queued job before joining.
+class PersistenceWorkers {
+private:
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::function<void()>> jobs;
+    std::vector<std::thread> threads;
+    bool stopping = false;
+
+    void work() {
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (jobs.empty()) {
+                    return;
+                }
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+        }
+    }
+
+public:
+    explicit PersistenceWorkers(size_t count) {
+        for (size_t i = 0; i < std::max<size_t>(1, count); ++i) {
+            threads.emplace_back(&PersistenceWorkers::work, this);
+        }
+    }
+
+    ~PersistenceWorkers() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    void post(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::move(job));
+        }
+        wake.notify_one();
+    }
+};
+
+// SnapshotCapture
+SnapshotCapture::SnapshotCapture(Portfolio& source)
+    : source(source), version(0), nextRow(0), restarts(0) {
+    if (source.activeCapture) {
+        throw std::logic_error("Portfolio already has a snapshot in progress");
+    }
+    source.activeCapture = this;
+    restart();
+}
+
+SnapshotCapture::~SnapshotCapture() {
+    if (source.activeCapture == this) {
+        source.activeCapture = nullptr;
+    }
+}
+
+Investment SnapshotCapture::copyRow(const Investment& investment) {
+    Investment row(std::make_shared<Stock>(*investment.getStock()), investment.getSharesOwned(),
+                   investment.getPurchasePrice(), investment.getTotalInvested());
+    row.setBookedCost(investment.getBookedCost());
+    row.setAcquiredDay(investment.getAcquiredDay());
+    return row;
+}
+
+void SnapshotCapture::restart() {
+    image.reset(new Portfolio(source.portfolioName));
+    image->totalInitialInvestment = source.totalInitialInvestment;
+    image->fxRates = source.fxRates;
+    image->investments.reserve(source.investments.size());
+    version = source.structureVersion;
+    nextRow = 0;
+    preImages.clear();
+}
+
+bool SnapshotCapture::step(size_t rows) {
+    if (!image) {
+        return true;
+    }
+    if (source.structureVersion != version) {
+        ++restarts;
+        restart();
+    }
+    const size_t total = source.investments.size();
+    const size_t end = std::min(total, nextRow + std::max<size_t>(1, rows));
+    for (; nextRow < end; ++nextRow) {
+        const Investment& investment = source.investments[nextRow];
+        if (!investment.getStock()) {
+            continue;
+        }
+        auto saved = preImages.find(nextRow);
+        if (saved != preImages.end()) {
+            image->investments.push_back(std::move(saved->second));
+            preImages.erase(saved);
+        } else {
+            image->investments.push_back(copyRow(investment));
+        }
+    }
+    if (nextRow == total && source.activeCapture == this) {
+        source.activeCapture = nullptr;  // Complete: later ticks no longer matter
+    }
+    return nextRow == total;
+}
+
+bool SnapshotCapture::isComplete() const {
+    return !image || source.activeCapture != this;
+}
+
+size_t SnapshotCapture::getRestarts() const {
+    return restarts;
+}
+
+std::unique_ptr<Portfolio> SnapshotCapture::take() {
+    if (!isComplete()) {
+        return nullptr;
+    }
+    return std::move(image);
+}
+
+void SnapshotCapture::beforePriceChange(size_t row) {
+    if (row >= nextRow && row < source.investments.size() && preImages.find(row) == preImages.end()) {
+        preImages.emplace(row, copyRow(source.investments[row]));
+    }
+}
+
+// AsyncPersistence
+AsyncPersistence::AsyncPersistence(Portfolio& portfolio, const AsyncPersistenceOptions& options)
+    : portfolio(portfolio), options(options), lastAutoSnapshot(Clock::now()), autoSnapshotBusy(false),
+      written(0), failed(0), bytes(0), ioUring(false), workers(new PersistenceWorkers(options.ioThreads)) {
+    ioUring = options.useIoUring && probeIoUring();
+    portfolio.addTickListener(this);
+}
+
+AsyncPersistence::~AsyncPersistence() {
+    finishCapture();
+    portfolio.removeTickListener(this);
+    workers.reset();  // Drains the queued writes
+}
+
+void AsyncPersistence::submit(Request request, std::unique_ptr<Portfolio> image) {
+    // std::function needs a copyable callable, so the move-only state rides
+    // in a shared_ptr
+    auto state = std::make_shared<std::pair<Request, std::unique_ptr<Portfolio>>>(std::move(request),
+                                                                                   std::move(image));
+    const bool sync = options.durable;
+    const bool uring = ioUring;
+    workers->post([this, state, sync, uring]() {
+        Request& job = state->first;
+        Portfolio& image = *state->second;
+        bool ok = false;
+        std::uint64_t size = 0;
+        try {
+            // Every format goes through the same (durable, io_uring) write
+            std::ostringstream out(std::ios::out | std::ios::binary);
+            switch (job.format) {
+                case SnapshotFormat::CSV:      ok = image.exportToCSV(out); break;
+                case SnapshotFormat::Columnar: ok = image.exportToColumnar(out); break;
+                default:                       ok = image.saveToStream(out); break;
+            }
+            std::string data = out.str();
+            size = data.size();
+            ok = ok && writeWholeFile(job.filename, data, sync, uring);
+        } catch (const std::exception&) {
+            ok = false;
+        }
+        (ok ? written : failed).fetch_add(1, std::memory_order_relaxed);
+        bytes.fetch_add(ok ? size : 0, std::memory_order_relaxed);
+        if (job.automatic) {
+            autoSnapshotBusy.store(false, std::memory_order_release);
+        }
+        job.done.set_value(ok);
+    });
+}
+
+std::future<bool> AsyncPersistence::save(const std::string& filename, SnapshotFormat format) {
+    Request request{filename, format, false, std::promise<bool>()};
+    std::future<bool> result = request.done.get_future();
+    pending.push_back(std::move(request));
+    pump();
+    return result;
+}
+
+std::future<std::unique_ptr<Portfolio>> AsyncPersistence::load(const std::string& filename) {
+    auto promise = std::make_shared<std::promise<std::unique_ptr<Portfolio>>>();
+    std::future<std::unique_ptr<Portfolio>> result = promise->get_future();
+    const bool uring = ioUring;
+    workers->post([promise, filename, uring]() {
+        std::unique_ptr<Portfolio> loaded;
+        try {
+            std::string data;
+            if (readWholeFile(filename, data, uring)) {
+                StringViewBuffer buffer(data);
+                std::istream in(&buffer);
+                loaded.reset(new Portfolio());
+                if (!loaded->loadFromStream(in)) {
+                    loaded.reset();
+                }
+            }
+        } catch (const std::exception&) {
+            loaded.reset();
+        }
+        promise->set_value(std::move(loaded));
+    });
+    return result;
+}
+
+bool AsyncPersistence::pump() {
+    if (!capture) {
+        if (pending.empty()) {
+            return false;
+        }
+        capture.reset(new SnapshotCapture(portfolio));
+    }
+
+    Clock::time_point start = Clock::now();
+    bool complete;
+    {
+        METRIC_TIME_SCOPE(SnapshotSlice);
+        complete = capture->step(options.rowsPerSlice);
+    }
+    std::uint64_t elapsed = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+    localStats.slices += 1;
+    localStats.maxSliceNs = std::max(localStats.maxSliceNs, elapsed);
+
+    if (complete) {
+        localStats.captureRestarts += capture->getRestarts();
+        std::unique_ptr<Portfolio> image = capture->take();
+        capture.reset();
+        Request request = std::move(pending.front());
+        pending.pop_front();
+        submit(std::move(request), std::move(image));
+    }
+    return capture || !pending.empty();
+}
+
+void AsyncPersistence::finishCapture() {
+    while (pump()) {
+    }
+}
+
+PersistenceStats AsyncPersistence::getStats() const {
+    PersistenceStats stats = localStats;
+    stats.snapshotsWritten = written.load(std::memory_order_relaxed);
+    stats.snapshotsFailed = failed.load(std::memory_order_relaxed);
+    stats.bytesWritten = bytes.load(std::memory_order_relaxed);
+    stats.ioUring = ioUring;
+    return stats;
+}
+
+void AsyncPersistence::onBatchEnd() {
+    if (options.autoSnapshotInterval.count() > 0 && !options.autoSnapshotFile.empty()) {
+        Clock::time_point now = Clock::now();
+        if (now - lastAutoSnapshot >= options.autoSnapshotInterval &&
+            !autoSnapshotBusy.load(std::memory_order_acquire)) {
+            lastAutoSnapshot = now;
+            autoSnapshotBusy.store(true, std::memory_order_relaxed);
+            localStats.autoSnapshots += 1;
+            pending.push_back(Request{options.autoSnapshotFile, options.autoSnapshotFormat, true,
+                                      std::promise<bool>()});
+        }
+    }
+    pump();
+}
@@ -0,0 +1,150 @@
+#ifndef ASYNC_PERSISTENCE_H
+#define ASYNC_PERSISTENCE_H
+
+#include "Portfolio.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+// Consistent copy of a Portfolio taken a few rows at a time on the thread that
+// owns it, so no single step stalls that thread for long. The image is the
+// portfolio as of the moment the capture (re)started:
+//  - a price tick on a row not copied yet saves that row's pre-tick state
+//    first (Portfolio calls beforePriceChange);
+//  - FX updates need nothing: the image takes the FX table when it starts;
+//  - any other change (positions added, removed or resized, sorts, loads)
+//    restarts the capture. Every step copies at most `rows` rows, however
+//    often it restarts, so the owning thread is never stalled; the capture
+//    completes once structural changes leave it a quiet stretch.
+// Changes made directly through a Stock pointer, or through the references
+// returned by non-const element access and getInvestment, bypass the
+// Portfolio and are not tracked. At most one capture per portfolio at a time.
+class SnapshotCapture {
+private:
+    Portfolio& source;
+    std::unique_ptr<Portfolio> image;
+    std::uint64_t version;
+    size_t nextRow;
+    size_t restarts;
+    std::unordered_map<size_t, Investment> preImages;  // Rows ticked before they were copied
+
+    void restart();
+    static Investment copyRow(const Investment& investment);
+
+public:
+    // Throws std::logic_error if the portfolio already has a capture
+    explicit SnapshotCapture(Portfolio& source);
+    ~SnapshotCapture();
+
+    SnapshotCapture(const SnapshotCapture&) = delete;
+    SnapshotCapture& operator=(const SnapshotCapture&) = delete;
+
+    // Copies up to `rows` more rows; true once the image is complete
+    bool step(size_t rows);
+    bool isComplete() const;
+    size_t getRestarts() const;
+
+    // The finished image; the capture is spent afterwards
+    std::unique_ptr<Portfolio> take();
+
+    // Called by Portfolio on its own thread just before a row's price changes
+    void beforePriceChange(size_t row);
+};
+
+enum class SnapshotFormat {
+    Text,      // saveToFile's format
+    CSV,       // exportToCSV's format
+    Columnar,  // exportToColumnar's format
+};
+
+struct AsyncPersistenceOptions {
+    size_t rowsPerSlice = 256;  // Rows copied per step on the portfolio's thread
+    size_t ioThreads = 2;       // Background serialization and write workers
+    bool useIoUring = true;     // Write through io_uring where the kernel allows it
+    bool durable = false;       // fsync each file before it replaces the previous one
+    // Periodic snapshots, taken from onBatchEnd; a zero interval disables them
+    std::chrono::milliseconds autoSnapshotInterval{0};
+    std::string autoSnapshotFile;
+    SnapshotFormat autoSnapshotFormat = SnapshotFormat::Text;
+};
+
+struct PersistenceStats {
+    std::uint64_t snapshotsWritten = 0;
+    std::uint64_t snapshotsFailed = 0;
+    std::uint64_t autoSnapshots = 0;
+    std::uint64_t captureRestarts = 0;
+    std::uint64_t bytesWritten = 0;
+    std::uint64_t slices = 0;
+    std::uint64_t maxSliceNs = 0;  // Longest single step on the portfolio's thread
+    bool ioUring = false;          // Whether writes go through io_uring
+};
+
+class PersistenceWorkers;
+
+// Non-blocking save/load for a Portfolio. save() queues a request and returns
+// a future at once; the image is captured in slices (each pump(), and after
+// every tick batch since this is a TickListener on the portfolio), then
+// serialized and written by a background worker to a temporary file that is
+// renamed over the target, so readers never see a partial file. Writes use
+// io_uring when available (Linux, not blocked by the sandbox) and plain
+// pwrite on the worker threads otherwise.
+//
+// All members except getStats() must be called on the portfolio's thread,
+// and this object must be destroyed before the portfolio.
+class AsyncPersistence : public TickListener {
+private:
+    struct Request {
+        std::string filename;
+        SnapshotFormat format;
+        bool automatic;
+        std::promise<bool> done;
+    };
+
+    Portfolio& portfolio;
+    AsyncPersistenceOptions options;
+    std::unique_ptr<SnapshotCapture> capture;
+    std::deque<Request> pending;  // Front is being captured
+    std::chrono::steady_clock::time_point lastAutoSnapshot;
+    std::atomic<bool> autoSnapshotBusy;
+    PersistenceStats localStats;  // Fields updated on the portfolio's thread
+    std::atomic<std::uint64_t> written;
+    std::atomic<std::uint64_t> failed;
+    std::atomic<std::uint64_t> bytes;
+    bool ioUring;
+    std::unique_ptr<PersistenceWorkers> workers;
+
+    void submit(Request request, std::unique_ptr<Portfolio> image);
+
+public:
+    explicit AsyncPersistence(Portfolio& portfolio,
+                              const AsyncPersistenceOptions& options = AsyncPersistenceOptions());
+    ~AsyncPersistence() override;  // Completes queued saves
+
+    AsyncPersistence(const AsyncPersistence&) = delete;
+    AsyncPersistence& operator=(const AsyncPersistence&) = delete;
+
+    // Resolves to true once the file is written
+    std::future<bool> save(const std::string& filename, SnapshotFormat format = SnapshotFormat::Text);
+
+    // Reads and parses a saveToFile-format file on a worker; resolves to the
+    // loaded portfolio, or nullptr if it could not be read
+    std::future<std::unique_ptr<Portfolio>> load(const std::string& filename);
+
+    // Advances the current capture by one slice; true while captures remain
+    bool pump();
+    // Captures everything queued now, handing each image to the workers
+    void finishCapture();
+
+    PersistenceStats getStats() const;
+
+    // TickListener
+    void onTick(const Investment&, Money) override {}
+    void onBatchEnd() override;
+};
+
+#endif // ASYNC_PERSISTENCE_H
@@ -0,0 +1,145 @@
+#include "Attributes.h"
+#include <cctype>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+struct Dictionary {
+    std::string name;
+    std::vector<std::string> values;
+    std::unordered_map<std::string, AttributeCode> codes;
+
+    explicit Dictionary(const std::string& name) : name(name) {
+        values.push_back("");
+        codes[""] = Attributes::kUnset;
+    }
+};
+
+struct AttributeRegistry {
+    std::mutex mutex;
+    std::vector<Dictionary> fields;
+    std::unordered_map<std::string, AttributeField> fieldIds;
+
+    AttributeRegistry() {
+        for (const char* name : {"sector", "industry", "country"}) {
+            fieldIds[name] = static_cast<AttributeField>(fields.size());
+            fields.emplace_back(name);
+        }
+    }
+
+    Dictionary& at(AttributeField field) {
+        if (field >= fields.size()) {
+            throw std::out_of_range("Unknown attribute field");
+        }
+        return fields[field];
+    }
+};
+
+AttributeRegistry& registry() {
+    static AttributeRegistry instance;
+    return instance;
+}
+
+std::string normalizeField(const std::string& name) {
+    std::string normalized = name;
+    for (char& c : normalized) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return normalized;
+}
+
+} // namespace
+
+// Fields
+AttributeField Attributes::fieldOf(const std::string& name) {
+    std::string normalized = normalizeField(name);
+    if (normalized.empty() || normalized.find_first_of(",\n") != std::string::npos) {
+        throw std::invalid_argument("Invalid attribute field name: " + name);
+    }
+    AttributeRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    auto it = reg.fieldIds.find(normalized);
+    if (it != reg.fieldIds.end()) {
+        return it->second;
+    }
+    if (reg.fields.size() > std::numeric_limits<AttributeField>::max()) {
+        throw std::length_error("Too many attribute fields registered");
+    }
+    AttributeField field = static_cast<AttributeField>(reg.fields.size());
+    reg.fields.emplace_back(normalized);
+    reg.fieldIds.emplace(normalized, field);
+    return field;
+}
+
+bool Attributes::findField(const std::string& name, AttributeField& field) {
+    AttributeRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    auto it = reg.fieldIds.find(normalizeField(name));
+    if (it == reg.fieldIds.end()) {
+        return false;
+    }
+    field = it->second;
+    return true;
+}
+
+std::string Attributes::fieldName(AttributeField field) {
+    AttributeRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    return reg.at(field).name;
+}
+
+size_t Attributes::fieldCount() {
+    AttributeRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    return reg.fields.size();
+}
+
+// Values
+AttributeCode Attributes::encode(AttributeField field, const std::string& value) {
+    if (value.find_first_of(",\n") != std::string::npos) {
+        throw std::invalid_argument("Attribute values cannot contain commas or newlines");
+    }
+    AttributeRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    Dictionary& dictionary = reg.at(field);
+    auto it = dictionary.codes.find(value);
+    if (it != dictionary.codes.end()) {
+        return it->second;
+    }
+    AttributeCode code = static_cast<AttributeCode>(dictionary.values.size());
+    dictionary.values.push_back(value);
+    dictionary.codes.emplace(value, code);
+    return code;
+}
+
+std::string Attributes::decode(AttributeField field, AttributeCode code) {
+    AttributeRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    Dictionary& dictionary = reg.at(field);
+    if (code >= dictionary.values.size()) {
+        throw std::out_of_range("Unknown attribute code");
+    }
+    return dictionary.values[code];
+}
+
+bool Attributes::find(AttributeField field, const std::string& value, AttributeCode& code) {
+    AttributeRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    Dictionary& dictionary = reg.at(field);
+    auto it = dictionary.codes.find(value);
+    if (it == dictionary.codes.end()) {
+        return false;
+    }
+    code = it->second;
+    return true;
+}
+
+size_t Attributes::codeCount(AttributeField field) {
+    AttributeRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    return reg.at(field).values.size();
+}
@@ -0,0 +1,34 @@
+#ifndef ATTRIBUTES_H
+#define ATTRIBUTES_H
+
+#include <cstdint>
+#include <string>
+
+using AttributeField = std::uint16_t;
+using AttributeCode = std::uint32_t;
+
+// Process-wide dictionaries for instrument attributes (sector, industry,
+// country and any custom tag). Each field interns its values to dense codes,
+// so a Stock stores a few integers and group-by is an array index per row.
+class Attributes {
+public:
+    static constexpr AttributeField kSector = 0;
+    static constexpr AttributeField kIndustry = 1;
+    static constexpr AttributeField kCountry = 2;
+    static constexpr AttributeCode kUnset = 0;  // Decodes to ""
+
+    // Fields are case-insensitive names; fieldOf registers custom ones on first
+    // use, findField only looks them up.
+    static AttributeField fieldOf(const std::string& name);
+    static bool findField(const std::string& name, AttributeField& field);
+    static std::string fieldName(AttributeField field);
+    static size_t fieldCount();
+
+    // Values are stored as given; "" always encodes to kUnset
+    static AttributeCode encode(AttributeField field, const std::string& value);
+    static std::string decode(AttributeField field, AttributeCode code);
+    static bool find(AttributeField field, const std::string& value, AttributeCode& code);  // No interning
+    static size_t codeCount(AttributeField field);  // Including kUnset
+};
+
+#endif // ATTRIBUTES_H
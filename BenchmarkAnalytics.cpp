@@ -0,0 +1,434 @@
+#include "BenchmarkAnalytics.h"
+#include "Kernels.h"
+#include "Metrics.h"
+#include "ParallelFor.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+constexpr size_t kPortfoliosPerItem = 16;  // Portfolios per unit of parallel work
+
+std::string trim(const std::string& text) {
+    size_t begin = 0;
+    size_t end = text.size();
+    while (begin < end && std::isspace(static_cast<unsigned char>(text[begin]))) {
+        ++begin;
+    }
+    while (end > begin && std::isspace(static_cast<unsigned char>(text[end - 1]))) {
+        --end;
+    }
+    return text.substr(begin, end - begin);
+}
+
+std::vector<std::string> splitRow(const std::string& line) {
+    std::vector<std::string> cells;
+    std::stringstream ss(line);
+    std::string cell;
+    while (std::getline(ss, cell, ',')) {
+        cells.push_back(trim(cell));
+    }
+    if (!line.empty() && line.back() == ',') {
+        cells.emplace_back();
+    }
+    return cells;
+}
+
+bool parseDouble(const std::string& text, double& value) {
+    if (text.empty()) {
+        return false;
+    }
+    char* end = nullptr;
+    value = std::strtod(text.c_str(), &end);
+    return *end == '\0' && std::isfinite(value);
+}
+
+// What the run needs about a symbol, looked up once per position
+struct SymbolInfo {
+    std::uint32_t row = ReturnHistory::kMissing;
+    double benchmarkWeight = 0.0;
+    double windowReturn = 0.0;           // Compounded over the history
+    AttributeCode group = Attributes::kUnset;  // The benchmark's group, if it gives one
+};
+
+// One holding of the portfolio being analysed
+struct Holding {
+    const SymbolInfo* info;
+    double value;
+    AttributeCode group;
+};
+
+} // namespace
+
+// BenchmarkIndex
+BenchmarkIndex::BenchmarkIndex(const std::string& name) : name(name) {}
+
+void BenchmarkIndex::addConstituent(const std::string& symbol, double weight, const std::string& group) {
+    if (!(weight >= 0.0) || !std::isfinite(weight)) {
+        throw std::invalid_argument("Benchmark weight cannot be negative");
+    }
+    auto it = bySymbol.find(symbol);
+    if (it != bySymbol.end()) {
+        constituents[it->second].weight = weight;
+        constituents[it->second].group = group;
+        return;
+    }
+    bySymbol.emplace(symbol, constituents.size());
+    constituents.push_back({symbol, weight, group});
+}
+
+void BenchmarkIndex::clear() {
+    constituents.clear();
+    bySymbol.clear();
+}
+
+const BenchmarkIndex::Constituent* BenchmarkIndex::find(const std::string& symbol) const {
+    auto it = bySymbol.find(symbol);
+    return it == bySymbol.end() ? nullptr : &constituents[it->second];
+}
+
+bool BenchmarkIndex::loadFromCSV(const std::string& filename) {
+    std::ifstream file(filename);
+    std::string line;
+    if (!file.is_open() || !std::getline(file, line)) {
+        return false;
+    }
+    while (std::getline(file, line)) {
+        if (trim(line).empty()) {
+            continue;
+        }
+        std::vector<std::string> cells = splitRow(line);
+        double weight = 0.0;
+        if (cells.size() < 2 || cells.size() > 3 || cells[0].empty() || !parseDouble(cells[1], weight) ||
+            weight < 0.0) {
+            return false;
+        }
+        addConstituent(cells[0], weight, cells.size() == 3 ? cells[2] : std::string());
+    }
+    return true;
+}
+
+// ReturnHistory
+void ReturnHistory::setPeriods(const std::vector<std::string>& labels) {
+    if (labels.size() != periods.size()) {
+        symbols.clear();
+        bySymbol.clear();
+        returns.clear();
+    }
+    periods = labels;
+}
+
+void ReturnHistory::setSeries(const std::string& symbol, const std::vector<double>& series) {
+    if (series.size() != periods.size()) {
+        throw std::invalid_argument("Return series length does not match the periods");
+    }
+    auto it = bySymbol.find(symbol);
+    if (it == bySymbol.end()) {
+        it = bySymbol.emplace(symbol, static_cast<std::uint32_t>(symbols.size())).first;
+        symbols.push_back(symbol);
+        returns.resize(returns.size() + periods.size());
+    }
+    std::copy(series.begin(), series.end(), returns.begin() + static_cast<std::ptrdiff_t>(it->second * periods.size()));
+}
+
+void ReturnHistory::clear() {
+    periods.clear();
+    symbols.clear();
+    bySymbol.clear();
+    returns.clear();
+}
+
+std::uint32_t ReturnHistory::rowOf(const std::string& symbol) const {
+    auto it = bySymbol.find(symbol);
+    return it == bySymbol.end() ? kMissing : it->second;
+}
+
+bool ReturnHistory::loadFromCSV(const std::string& filename) {
+    std::ifstream file(filename);
+    std::string line;
+    if (!file.is_open() || !std::getline(file, line)) {
+        return false;
+    }
+    std::vector<std::string> header = splitRow(line);
+    if (header.size() < 2) {
+        return false;
+    }
+    const size_t columns = header.size() - 1;
+
+    // Read period-major as the file is laid out, then transpose once
+    std::vector<std::string> labels;
+    std::vector<double> byPeriod;
+    while (std::getline(file, line)) {
+        if (trim(line).empty()) {
+            continue;
+        }
+        std::vector<std::string> cells = splitRow(line);
+        if (cells.size() > columns + 1) {
+            return false;
+        }
+        labels.push_back(cells[0]);
+        for (size_t c = 0; c < columns; ++c) {
+            double value = 0.0;
+            if (c + 1 < cells.size() && !cells[c + 1].empty() && !parseDouble(cells[c + 1], value)) {
+                return false;
+            }
+            byPeriod.push_back(value);
+        }
+    }
+
+    clear();
+    setPeriods(labels);
+    std::vector<double> series(labels.size());
+    for (size_t c = 0; c < columns; ++c) {
+        if (header[c + 1].empty()) {
+            return false;
+        }
+        for (size_t t = 0; t < labels.size(); ++t) {
+            series[t] = byPeriod[t * columns + c];
+        }
+        setSeries(header[c + 1], series);
+    }
+    return true;
+}
+
+// RelativeAnalytics
+RelativeResults RelativeAnalytics::run(const std::vector<const Portfolio*>& portfolios,
+                                       const BenchmarkIndex& benchmark, const ReturnHistory& history,
+                                       const RelativeOptions& options) {
+    METRIC_TIME_SCOPE(RelativeAnalytics);
+    auto start = std::chrono::steady_clock::now();
+    const size_t periods = history.periodCount();
+    const AttributeField field = Attributes::fieldOf(options.groupField);
+
+    RelativeResults results;
+    results.benchmark = benchmark.getName();
+    results.periods = periods;
+    results.portfolios.resize(portfolios.size());
+
+    // Every symbol with a history or a benchmark weight
+    std::unordered_map<std::string, SymbolInfo> symbols;
+    symbols.reserve(history.symbolCount() + benchmark.size());
+    for (std::uint32_t row = 0; row < history.symbolCount(); ++row) {
+        SymbolInfo& info = symbols[history.symbolName(row)];
+        info.row = row;
+        double growth = 1.0;
+        const double* series = history.series(row);
+        for (size_t t = 0; t < periods; ++t) {
+            growth *= 1.0 + series[t];
+        }
+        info.windowReturn = growth - 1.0;
+    }
+    double totalWeight = 0.0;
+    for (size_t i = 0; i < benchmark.size(); ++i) {
+        totalWeight += benchmark[i].weight;
+    }
+    const double weightScale = totalWeight > 0.0 ? 1.0 / totalWeight : 0.0;
+    for (size_t i = 0; i < benchmark.size(); ++i) {
+        SymbolInfo& info = symbols[benchmark[i].symbol];
+        info.benchmarkWeight = benchmark[i].weight * weightScale;
+        info.group = Attributes::encode(field, benchmark[i].group);
+    }
+
+    // Group dictionary as of now; codes interned later fall under kUnset
+    const size_t groupCount = Attributes::codeCount(field);
+    std::vector<std::string> groupNames(groupCount);
+    for (size_t g = 0; g < groupCount; ++g) {
+        groupNames[g] = Attributes::decode(field, static_cast<AttributeCode>(g));
+    }
+
+    // The benchmark side, shared by every portfolio: its periodic returns,
+    // centred for the covariance, and its weight and contribution per group
+    std::vector<std::uint32_t> benchmarkRows;
+    std::vector<double> benchmarkRowWeights;
+    std::vector<double> benchmarkGroupWeight(groupCount, 0.0);
+    std::vector<double> benchmarkGroupContribution(groupCount, 0.0);
+    for (size_t i = 0; i < benchmark.size(); ++i) {
+        const SymbolInfo& info = symbols[benchmark[i].symbol];
+        benchmarkGroupWeight[info.group] += info.benchmarkWeight;
+        benchmarkGroupContribution[info.group] += info.benchmarkWeight * info.windowReturn;
+        if (info.row != ReturnHistory::kMissing && info.benchmarkWeight != 0.0) {
+            benchmarkRows.push_back(info.row);
+            benchmarkRowWeights.push_back(info.benchmarkWeight);
+        }
+    }
+    const double* returns = periods > 0 && history.symbolCount() > 0 ? history.series(0) : nullptr;
+    std::vector<double> benchmarkSeries(periods, 0.0);
+    if (returns) {
+        kernels::weightedRows(returns, periods, benchmarkRows.data(), benchmarkRowWeights.data(),
+                              benchmarkRows.size(), periods, benchmarkSeries.data());
+    }
+    double benchmarkMean = 0.0;
+    for (size_t t = 0; t < periods; ++t) {
+        benchmarkMean += benchmarkSeries[t];
+    }
+    benchmarkMean = periods > 0 ? benchmarkMean / static_cast<double>(periods) : 0.0;
+    std::vector<double> centred(periods);
+    double benchmarkSquares = 0.0;
+    for (size_t t = 0; t < periods; ++t) {
+        centred[t] = benchmarkSeries[t] - benchmarkMean;
+        benchmarkSquares += centred[t] * centred[t];
+    }
+    double benchmarkReturn = 0.0;
+    for (double contribution : benchmarkGroupContribution) {
+        benchmarkReturn += contribution;
+    }
+    const double sampleScale = periods > 1 ? 1.0 / static_cast<double>(periods - 1) : 0.0;
+    results.benchmarkVolatility = std::sqrt(benchmarkSquares * sampleScale * options.periodsPerYear);
+
+    const size_t items = (portfolios.size() + kPortfoliosPerItem - 1) / kPortfoliosPerItem;
+    parallelFor(items, workerThreads(options.threads), [&](size_t item) {
+        std::vector<Holding> holdings;
+        std::vector<std::uint32_t> rows;
+        std::vector<double> rowWeights;
+        std::vector<double> series(periods);
+        std::vector<double> groupWeight(groupCount);
+        std::vector<double> groupContribution(groupCount);
+        const size_t last = std::min(portfolios.size(), (item + 1) * kPortfoliosPerItem);
+        for (size_t p = item * kPortfoliosPerItem; p < last; ++p) {
+            const Portfolio& portfolio = *portfolios[p];
+            RelativePerformance& out = results.portfolios[p];
+            out.portfolio = portfolio.getPortfolioName();
+            out.benchmarkReturn = benchmarkReturn;
+
+            // Holdings in the base currency
+            const FxRateTable& rates = portfolio.getFxRates();
+            holdings.clear();
+            Money total;
+            for (const Investment& investment : portfolio) {
+                const Stock* stock = investment.getStock().get();
+                if (!stock) {
+                    continue;
+                }
+                const Money value = rates.convert(investment.getCurrentValue(), stock->getCurrency());
+                total += value;
+                auto it = symbols.find(stock->getSymbol());
+                const SymbolInfo* info = it == symbols.end() ? nullptr : &it->second;
+                AttributeCode group = info && info->group != Attributes::kUnset ? info->group
+                                                                                : stock->getAttributeCode(field);
+                holdings.push_back({info, value.toDouble(), group < groupCount ? group : Attributes::kUnset});
+            }
+            out.baseValue = total;
+            if (total.isNegative() || total.isZero()) {
+                continue;
+            }
+
+            // One pass over the holdings: weights, active share, group sums
+            // and the rows for the return series. Constituents not held add
+            // their whole weight to active share, so start from all of it.
+            const double invTotal = 1.0 / total.toDouble();
+            std::fill(groupWeight.begin(), groupWeight.end(), 0.0);
+            std::fill(groupContribution.begin(), groupContribution.end(), 0.0);
+            rows.clear();
+            rowWeights.clear();
+            double activeSum = totalWeight > 0.0 ? 1.0 : 0.0;
+            for (const Holding& holding : holdings) {
+                const double weight = holding.value * invTotal;
+                const double benchmarkWeight = holding.info ? holding.info->benchmarkWeight : 0.0;
+                activeSum += std::fabs(weight - benchmarkWeight) - benchmarkWeight;
+                groupWeight[holding.group] += weight;
+                if (holding.info && holding.info->row != ReturnHistory::kMissing) {
+                    groupContribution[holding.group] += weight * holding.info->windowReturn;
+                    if (weight != 0.0) {
+                        rows.push_back(holding.info->row);
+                        rowWeights.push_back(weight);
+                    }
+                } else {
+                    out.missingWeight += weight;
+                }
+            }
+            out.activeShare = 0.5 * activeSum;
+
+            // Periodic returns, then one pass for tracking error and beta
+            if (returns) {
+                kernels::weightedRows(returns, periods, rows.data(), rowWeights.data(), rows.size(), periods,
+                                      series.data());
+            }
+            double activeTotal = 0.0;
+            double activeSquares = 0.0;
+            double covariance = 0.0;
+            for (size_t t = 0; t < periods; ++t) {
+                const double active = series[t] - benchmarkSeries[t];
+                activeTotal += active;
+                activeSquares += active * active;
+                covariance += series[t] * centred[t];
+            }
+            if (periods > 1) {
+                const double n = static_cast<double>(periods);
+                const double activeMean = activeTotal / n;
+                const double activeVariance = std::max(0.0, (activeSquares - activeTotal * activeMean) * sampleScale);
+                out.trackingError = std::sqrt(activeVariance * options.periodsPerYear);
+                out.beta = benchmarkSquares > 0.0 ? covariance / benchmarkSquares : 0.0;
+                out.informationRatio =
+                    out.trackingError > 0.0 ? activeMean * options.periodsPerYear / out.trackingError : 0.0;
+            }
+
+            // Brinson-Fachler by group. A group the benchmark lacks is
+            // measured against the whole benchmark; one the portfolio lacks
+            // has no selection effect.
+            for (size_t g = 0; g < groupCount; ++g) {
+                const double wp = groupWeight[g];
+                const double wb = benchmarkGroupWeight[g];
+                if (wp == 0.0 && wb == 0.0) {
+                    continue;
+                }
+                GroupAttribution group;
+                group.group = groupNames[g];
+                group.portfolioWeight = wp;
+                group.benchmarkWeight = wb;
+                group.activeWeight = wp - wb;
+                group.benchmarkReturn = wb > 0.0 ? benchmarkGroupContribution[g] / wb : benchmarkReturn;
+                group.portfolioReturn = wp > 0.0 ? groupContribution[g] / wp : group.benchmarkReturn;
+                group.allocation = (wp - wb) * (group.benchmarkReturn - benchmarkReturn);
+                group.selection = wb * (group.portfolioReturn - group.benchmarkReturn);
+                group.interaction = (wp - wb) * (group.portfolioReturn - group.benchmarkReturn);
+                out.portfolioReturn += groupContribution[g];
+                out.groups.push_back(group);
+            }
+            std::sort(out.groups.begin(), out.groups.end(), [](const GroupAttribution& a, const GroupAttribution& b) {
+                return a.benchmarkWeight != b.benchmarkWeight ? a.benchmarkWeight > b.benchmarkWeight
+                                                              : a.portfolioWeight > b.portfolioWeight;
+            });
+            out.activeReturn = out.portfolioReturn - benchmarkReturn;
+        }
+    });
+
+    results.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return results;
+}
+
+RelativeResults RelativeAnalytics::run(const Portfolio& portfolio, const BenchmarkIndex& benchmark,
+                                       const ReturnHistory& history, const RelativeOptions& options) {
+    return run(std::vector<const Portfolio*>{&portfolio}, benchmark, history, options);
+}
+
+bool RelativeAnalytics::exportToCSV(const RelativeResults& results, const std::string& filename) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        return false;
+    }
+    file << "portfolio,group,weight,benchmark_weight,active_weight,return,benchmark_return,allocation,selection,"
+            "interaction,tracking_error,beta,information_ratio,active_share\n";
+    for (const RelativePerformance& p : results.portfolios) {
+        double allocation = 0.0, selection = 0.0, interaction = 0.0;
+        for (const GroupAttribution& g : p.groups) {
+            allocation += g.allocation;
+            selection += g.selection;
+            interaction += g.interaction;
+        }
+        file << p.portfolio << ",total,1,1,0," << p.portfolioReturn << "," << p.benchmarkReturn << "," << allocation
+             << "," << selection << "," << interaction << "," << p.trackingError << "," << p.beta << ","
+             << p.informationRatio << "," << p.activeShare << "\n";
+        for (const GroupAttribution& g : p.groups) {
+            file << p.portfolio << "," << g.group << "," << g.portfolioWeight << "," << g.benchmarkWeight << ","
+                 << g.activeWeight << "," << g.portfolioReturn << "," << g.benchmarkReturn << "," << g.allocation
+                 << "," << g.selection << "," << g.interaction << ",,,,\n";
+        }
+    }
+    return file.good();
+}
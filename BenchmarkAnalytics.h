@@ -0,0 +1,148 @@
+#ifndef BENCHMARK_ANALYTICS_H
+#define BENCHMARK_ANALYTICS_H
+
+#include "Attributes.h"
+#include "Portfolio.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// An index a portfolio is measured against: constituents with their weights
+// and the group (sector, by default) each is attributed to.
+class BenchmarkIndex {
+public:
+    struct Constituent {
+        std::string symbol;
+        double weight;
+        std::string group;
+    };
+
+private:
+    std::string name;
+    std::vector<Constituent> constituents;
+    std::unordered_map<std::string, size_t> bySymbol;
+
+public:
+    explicit BenchmarkIndex(const std::string& name = "Benchmark");
+
+    const std::string& getName() const { return name; }
+    void setName(const std::string& indexName) { name = indexName; }
+
+    // Adding a symbol already present replaces it. Weights need not sum to
+    // one; they are normalized when analytics run. Throws
+    // std::invalid_argument for a negative weight.
+    void addConstituent(const std::string& symbol, double weight, const std::string& group = "");
+    void clear();
+    size_t size() const { return constituents.size(); }
+    const Constituent& operator[](size_t index) const { return constituents[index]; }
+    const Constituent* find(const std::string& symbol) const;
+
+    // CSV with a header and one row per constituent: symbol,weight[,group].
+    // Weights may be fractions or percentages. Adds to the current
+    // constituents; false if the file cannot be read or a row does not parse
+    // (rows before it are kept).
+    bool loadFromCSV(const std::string& filename);
+};
+
+// Periodic returns per symbol (e.g. daily, as fractions: 0.01 for +1%),
+// stored symbol-major so each symbol's series is one contiguous row.
+class ReturnHistory {
+private:
+    std::vector<std::string> periods;
+    std::vector<std::string> symbols;
+    std::unordered_map<std::string, std::uint32_t> bySymbol;
+    std::vector<double> returns;  // symbols x periods
+
+public:
+    static constexpr std::uint32_t kMissing = UINT32_MAX;
+
+    // Sets the period labels; clears any series of another length
+    void setPeriods(const std::vector<std::string>& labels);
+    // A symbol's series, one return per period; replaces an existing one.
+    // Throws std::invalid_argument if the length does not match.
+    void setSeries(const std::string& symbol, const std::vector<double>& series);
+    void clear();
+
+    size_t periodCount() const { return periods.size(); }
+    size_t symbolCount() const { return symbols.size(); }
+    const std::string& periodLabel(size_t period) const { return periods[period]; }
+    const std::string& symbolName(std::uint32_t row) const { return symbols[row]; }
+    std::uint32_t rowOf(const std::string& symbol) const;  // kMissing when absent
+    const double* series(std::uint32_t row) const {
+        return returns.data() + static_cast<size_t>(row) * periods.size();
+    }
+
+    // CSV with a header "period,<symbol>,<symbol>,..." and one row per period,
+    // oldest first; an empty cell is a zero return. Replaces the current
+    // contents; false if the file cannot be read or a cell does not parse.
+    bool loadFromCSV(const std::string& filename);
+};
+
+struct RelativeOptions {
+    std::string groupField = "sector";  // Attribute the attribution groups by
+    double periodsPerYear = 252.0;      // Annualizes tracking error and the information ratio
+    size_t threads = 0;                 // 0 = one per hardware thread
+};
+
+// Brinson-Fachler attribution for one group. Returns are over the whole
+// history: each holding's compounded return, weighted by today's weights.
+struct GroupAttribution {
+    std::string group;  // "" collects holdings without a value
+    double portfolioWeight = 0.0;
+    double benchmarkWeight = 0.0;
+    double activeWeight = 0.0;
+    double portfolioReturn = 0.0;
+    double benchmarkReturn = 0.0;
+    double allocation = 0.0;   // (wp - wb) * (Rb - R_benchmark)
+    double selection = 0.0;    // wb * (Rp - Rb)
+    double interaction = 0.0;  // (wp - wb) * (Rp - Rb)
+};
+
+// One portfolio against the benchmark. allocation + selection + interaction
+// summed over the groups equals activeReturn.
+struct RelativePerformance {
+    std::string portfolio;
+    Money baseValue;
+    double activeShare = 0.0;        // Half the sum of |active weight| over every constituent and holding
+    double missingWeight = 0.0;      // Weight of holdings with no return history (taken as flat)
+    double portfolioReturn = 0.0;
+    double benchmarkReturn = 0.0;
+    double activeReturn = 0.0;
+    double trackingError = 0.0;      // Annualized standard deviation of periodic active returns
+    double beta = 0.0;               // Against the benchmark's periodic returns
+    double informationRatio = 0.0;   // Annualized mean active return / tracking error
+    std::vector<GroupAttribution> groups;  // By benchmark weight, largest first
+};
+
+struct RelativeResults {
+    std::string benchmark;
+    size_t periods = 0;
+    double benchmarkVolatility = 0.0;  // Annualized
+    std::vector<RelativePerformance> portfolios;
+    double seconds = 0.0;
+};
+
+// Benchmark-relative analytics for many portfolios at once. The benchmark's
+// weights, its periodic returns and its per-group sums are computed once.
+// Each portfolio then takes one pass over its holdings for weights, active
+// share and its per-group sums, builds its periodic return series as a
+// weighted sum of its holdings' return rows (a vectorized axpy per holding),
+// and folds the active returns into tracking error and beta in one more pass
+// over the periods. Portfolios are spread over worker threads; they are only
+// read, so they must not be modified while run() is in progress.
+class RelativeAnalytics {
+public:
+    static RelativeResults run(const std::vector<const Portfolio*>& portfolios, const BenchmarkIndex& benchmark,
+                               const ReturnHistory& history, const RelativeOptions& options = RelativeOptions());
+    static RelativeResults run(const Portfolio& portfolio, const BenchmarkIndex& benchmark,
+                               const ReturnHistory& history, const RelativeOptions& options = RelativeOptions());
+
+    // Per portfolio, a "total" row then one row per group:
+    // portfolio,group,weight,benchmark_weight,active_weight,return,benchmark_return,
+    // allocation,selection,interaction,tracking_error,beta,information_ratio,active_share
+    // (the last four on total rows only)
+    static bool exportToCSV(const RelativeResults& results, const std::string& filename);
+};
+
+#endif // BENCHMARK_ANALYTICS_H
@@ -0,0 +1,61 @@
+#include "Calendar.h"
+#include <cstdio>
+#include <ctime>
+
+namespace calendar {
+
+namespace {
+
+// Howard Hinnant's days_from_civil / civil_from_days
+int daysFromCivil(int year, int month, int day) {
+    year -= month <= 2 ? 1 : 0;
+    const int era = (year >= 0 ? year : year - 399) / 400;
+    const int yearOfEra = year - era * 400;
+    const int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+void civilFromDays(int days, int& year, int& month, int& day) {
+    days += 719468;
+    const int era = (days >= 0 ? days : days - 146096) / 146097;
+    const int dayOfEra = days - era * 146097;
+    const int yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    const int dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    const int monthIndex = (5 * dayOfYear + 2) / 153;
+    day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+    month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+    year = yearOfEra + era * 400 + (month <= 2 ? 1 : 0);
+}
+
+} // namespace
+
+bool parseDay(const std::string& text, int& day) {
+    int year = 0, month = 0, dayOfMonth = 0;
+    char trailing = 0;
+    if (std::sscanf(text.c_str(), "%4d-%2d-%2d%c", &year, &month, &dayOfMonth, &trailing) != 3 || month < 1 ||
+        month > 12 || dayOfMonth < 1) {
+        return false;
+    }
+    static const int kDaysInMonth[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    const bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    if (dayOfMonth > kDaysInMonth[month - 1] + (month == 2 && leap ? 1 : 0)) {
+        return false;
+    }
+    day = daysFromCivil(year, month, dayOfMonth);
+    return true;
+}
+
+std::string formatDay(int day) {
+    int year = 0, month = 0, dayOfMonth = 0;
+    civilFromDays(day, year, month, dayOfMonth);
+    char text[32];
+    std::snprintf(text, sizeof(text), "%04d-%02d-%02d", year, month, dayOfMonth);
+    return text;
+}
+
+int today() {
+    return static_cast<int>(std::time(nullptr) / 86400);
+}
+
+} // namespace calendar
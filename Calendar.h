@@ -0,0 +1,19 @@
+#ifndef CALENDAR_H
+#define CALENDAR_H
+
+#include <string>
+
+// Calendar dates as a day count since 1970-01-01 (proleptic Gregorian, UTC),
+// so date arithmetic is integer arithmetic and dates fit in a column.
+namespace calendar {
+
+// "YYYY-MM-DD" -> day count; false if malformed or not a real date
+bool parseDay(const std::string& text, int& day);
+// Day count -> "YYYY-MM-DD"
+std::string formatDay(int day);
+// Today (UTC)
+int today();
+
+} // namespace calendar
+
+#endif // CALENDAR_H
@@ -0,0 +1,776 @@
+#include "ColumnarFile.h"
+#include "Metrics.h"
+#include "Portfolio.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+namespace {
+
+const char kMagic[8] = {'P', 'F', 'C', 'O', 'L', '1', '\0', '\0'};
+constexpr size_t kTrailerSize = 4 + sizeof(kMagic);  // Footer length + magic
+constexpr const char* kAttributePrefix = "attr:";
+// Optional integer columns after the attribute columns (see Investment and
+// Stock::getLastSplitDay); files without them load with both unknown
+constexpr const char* kAcquiredDayColumn = "acquired_day";
+constexpr const char* kLastSplitDayColumn = "last_split_day";
+
+// Fixed columns, in file order; attribute columns follow
+enum FixedColumn : size_t {
+    kSymbol, kCompany, kCurrency, kPrice, kPreviousPrice, kShares, kPurchasePrice, kTotalInvested, kFixedColumns
+};
+
+const ColumnInfo kFixedSchema[kFixedColumns] = {
+    {"symbol", ColumnType::String},
+    {"company", ColumnType::String},
+    {"currency", ColumnType::String},
+    {"price", ColumnType::Money},
+    {"previous_price", ColumnType::Money},
+    {"shares", ColumnType::Int64},
+    {"purchase_price", ColumnType::Money},
+    {"total_invested", ColumnType::Money},
+};
+
+std::uint64_t zigzag(std::int64_t value) {
+    return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+std::int64_t unzigzag(std::uint64_t value) {
+    return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+bool fitsInt(std::int64_t value) {
+    return value >= std::numeric_limits<int>::min() && value <= std::numeric_limits<int>::max();
+}
+
+class ByteWriter {
+public:
+    std::string bytes;
+
+    void putU8(std::uint8_t value) { bytes.push_back(static_cast<char>(value)); }
+
+    void putVarint(std::uint64_t value) {
+        while (value >= 0x80) {
+            bytes.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        bytes.push_back(static_cast<char>(value));
+    }
+
+    void putSigned(std::int64_t value) { putVarint(zigzag(value)); }
+
+    void putString(const std::string& value) {
+        putVarint(value.size());
+        bytes += value;
+    }
+};
+
+// Bounds-checked decoding; any overrun latches ok to false and yields zeros
+class ByteReader {
+private:
+    const char* cursor;
+    const char* end;
+
+public:
+    bool ok;
+
+    ByteReader(const char* data, size_t length) : cursor(data), end(data + length), ok(true) {}
+
+    std::uint8_t getU8() {
+        if (cursor >= end) {
+            ok = false;
+            return 0;
+        }
+        return static_cast<std::uint8_t>(*cursor++);
+    }
+
+    std::uint64_t getVarint() {
+        std::uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            std::uint8_t byte = getU8();
+            value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                return value;
+            }
+        }
+        ok = false;
+        return 0;
+    }
+
+    std::int64_t getSigned() { return unzigzag(getVarint()); }
+
+    std::string getString() {
+        std::uint64_t length = getVarint();
+        if (!ok || length > static_cast<std::uint64_t>(end - cursor)) {
+            ok = false;
+            return std::string();
+        }
+        std::string value(cursor, static_cast<size_t>(length));
+        cursor += length;
+        return value;
+    }
+
+    size_t remaining() const { return static_cast<size_t>(end - cursor); }
+
+    const char* take(size_t length) {
+        if (length > static_cast<size_t>(end - cursor)) {
+            ok = false;
+            return nullptr;
+        }
+        const char* start = cursor;
+        cursor += length;
+        return start;
+    }
+};
+
+size_t varintSize(std::uint64_t value) {
+    size_t bytes = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        ++bytes;
+    }
+    return bytes;
+}
+
+int bitWidth(std::uint64_t range) {
+    int width = 0;
+    while (width < 64 && (range >> width) != 0) {
+        ++width;
+    }
+    return width;
+}
+
+// Integers: bit-packed offsets from the minimum, or (length, value) runs when
+// that is smaller. Returns the encoding chosen.
+ColumnEncoding encodeIntegers(const std::vector<std::int64_t>& values, ByteWriter& out) {
+    if (values.empty()) {
+        out.putU8(static_cast<std::uint8_t>(ColumnEncoding::RunLength));
+        out.putVarint(0);
+        return ColumnEncoding::RunLength;
+    }
+    std::int64_t minimum = *std::min_element(values.begin(), values.end());
+    std::int64_t maximum = *std::max_element(values.begin(), values.end());
+    int width = bitWidth(static_cast<std::uint64_t>(maximum) - static_cast<std::uint64_t>(minimum));
+
+    size_t runs = 0;
+    size_t runBytes = 0;
+    size_t packedBytes = (values.size() * static_cast<size_t>(width) + 7) / 8 + 11;
+    for (size_t start = 0, i = 1; i <= values.size() && runBytes < packedBytes; ++i) {
+        if (i == values.size() || values[i] != values[start]) {
+            ++runs;
+            runBytes += varintSize(i - start) + varintSize(zigzag(values[start]));
+            start = i;
+        }
+    }
+
+    if (width == 0 || runBytes < packedBytes) {
+        out.putU8(static_cast<std::uint8_t>(ColumnEncoding::RunLength));
+        out.putVarint(runs);
+        size_t start = 0;
+        for (size_t i = 1; i <= values.size(); ++i) {
+            if (i == values.size() || values[i] != values[start]) {
+                out.putVarint(i - start);
+                out.putSigned(values[start]);
+                start = i;
+            }
+        }
+        return ColumnEncoding::RunLength;
+    }
+
+    out.putU8(static_cast<std::uint8_t>(ColumnEncoding::BitPacked));
+    out.putVarint(values.size());
+    out.putSigned(minimum);
+    out.putU8(static_cast<std::uint8_t>(width));
+    std::uint64_t buffer = 0;
+    int buffered = 0;
+    for (std::int64_t value : values) {
+        std::uint64_t offset = static_cast<std::uint64_t>(value) - static_cast<std::uint64_t>(minimum);
+        // Emit the value in pieces so no shift ever reaches 64
+        int remaining = width;
+        while (remaining > 0) {
+            int take = std::min(remaining, 64 - buffered);
+            std::uint64_t piece = take == 64 ? offset : (offset & ((std::uint64_t(1) << take) - 1));
+            buffer |= buffered == 0 ? piece : piece << buffered;
+            buffered += take;
+            remaining -= take;
+            offset = take == 64 ? 0 : offset >> take;
+            while (buffered >= 8) {
+                out.putU8(static_cast<std::uint8_t>(buffer & 0xFF));
+                buffer = buffered == 8 ? 0 : buffer >> 8;
+                buffered -= 8;
+            }
+        }
+    }
+    if (buffered > 0) {
+        out.putU8(static_cast<std::uint8_t>(buffer & 0xFF));
+    }
+    return ColumnEncoding::BitPacked;
+}
+
+bool decodeIntegers(ByteReader& in, std::vector<std::int64_t>& values, std::uint64_t expected) {
+    ColumnEncoding encoding = static_cast<ColumnEncoding>(in.getU8());
+    values.clear();
+    if (encoding == ColumnEncoding::RunLength) {
+        std::uint64_t runs = in.getVarint();
+        for (std::uint64_t r = 0; r < runs && in.ok; ++r) {
+            std::uint64_t length = in.getVarint();
+            std::int64_t value = in.getSigned();
+            if (length > expected - values.size()) {
+                return false;
+            }
+            values.insert(values.end(), static_cast<size_t>(length), value);
+        }
+    } else if (encoding == ColumnEncoding::BitPacked) {
+        std::uint64_t count = in.getVarint();
+        std::int64_t minimum = in.getSigned();
+        int width = in.getU8();
+        // Width 0 is never written (equal values are run-length encoded); the
+        // count must fit in the chunk's remaining bits before anything is sized
+        if (!in.ok || count != expected || width == 0 || width > 64 ||
+            count > static_cast<std::uint64_t>(in.remaining()) * 8 / static_cast<std::uint64_t>(width)) {
+            return false;
+        }
+        const char* packed = in.take(static_cast<size_t>((count * static_cast<std::uint64_t>(width) + 7) / 8));
+        if (!packed) {
+            return false;
+        }
+        values.resize(static_cast<size_t>(count));
+        std::uint64_t bit = 0;
+        for (size_t i = 0; i < values.size(); ++i) {
+            std::uint64_t offset = 0;
+            for (int got = 0; got < width;) {
+                std::uint64_t byte = static_cast<std::uint8_t>(packed[bit / 8]);
+                int inByte = static_cast<int>(bit % 8);
+                int take = std::min(8 - inByte, width - got);
+                offset |= ((byte >> inByte) & ((1u << take) - 1)) << got;
+                got += take;
+                bit += static_cast<std::uint64_t>(take);
+            }
+            values[i] = static_cast<std::int64_t>(static_cast<std::uint64_t>(minimum) + offset);
+        }
+    } else {
+        return false;
+    }
+    return in.ok && values.size() == expected;
+}
+
+// Strings: a chunk dictionary when values repeat, plain otherwise
+ColumnEncoding encodeStrings(const std::vector<const std::string*>& values, ByteWriter& out) {
+    std::unordered_map<std::string, std::int64_t> codes;
+    std::vector<const std::string*> dictionary;
+    std::vector<std::int64_t> indices(values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        auto inserted = codes.emplace(*values[i], static_cast<std::int64_t>(dictionary.size()));
+        if (inserted.second) {
+            dictionary.push_back(values[i]);
+        }
+        indices[i] = inserted.first->second;
+    }
+    if (dictionary.size() * 2 > values.size()) {
+        out.putU8(static_cast<std::uint8_t>(ColumnEncoding::Plain));
+        for (const std::string* value : values) {
+            out.putString(*value);
+        }
+        return ColumnEncoding::Plain;
+    }
+    out.putU8(static_cast<std::uint8_t>(ColumnEncoding::Dictionary));
+    out.putVarint(dictionary.size());
+    for (const std::string* value : dictionary) {
+        out.putString(*value);
+    }
+    encodeIntegers(indices, out);
+    return ColumnEncoding::Dictionary;
+}
+
+bool decodeStrings(ByteReader& in, std::vector<std::string>& values, std::uint64_t expected) {
+    ColumnEncoding encoding = static_cast<ColumnEncoding>(in.getU8());
+    values.clear();
+    if (encoding == ColumnEncoding::Plain) {
+        // Every value takes at least its length byte
+        if (expected > static_cast<std::uint64_t>(in.remaining())) {
+            return false;
+        }
+        values.reserve(static_cast<size_t>(expected));
+        for (std::uint64_t i = 0; i < expected && in.ok; ++i) {
+            values.push_back(in.getString());
+        }
+        return in.ok;
+    }
+    if (encoding != ColumnEncoding::Dictionary) {
+        return false;
+    }
+    std::uint64_t entries = in.getVarint();
+    if (!in.ok || entries > static_cast<std::uint64_t>(in.remaining())) {
+        return false;
+    }
+    std::vector<std::string> dictionary;
+    dictionary.reserve(static_cast<size_t>(entries));
+    for (std::uint64_t i = 0; i < entries && in.ok; ++i) {
+        dictionary.push_back(in.getString());
+    }
+    std::vector<std::int64_t> indices;
+    if (!in.ok || !decodeIntegers(in, indices, expected)) {
+        return false;
+    }
+    values.reserve(indices.size());
+    for (std::int64_t index : indices) {
+        if (index < 0 || static_cast<std::uint64_t>(index) >= dictionary.size()) {
+            return false;
+        }
+        values.push_back(dictionary[static_cast<size_t>(index)]);
+    }
+    return true;
+}
+
+// Converts Money units written at another precision to this build's
+std::int64_t rescaleMoney(std::int64_t units, int fileDecimals) {
+    if (fileDecimals == Money::kDecimals) {
+        return units;
+    }
+    return Money::fromUnits(units).mulDiv(moneyPow10(Money::kDecimals), moneyPow10(fileDecimals)).raw();
+}
+
+} // namespace
+
+// Writer
+bool ColumnarWriter::write(const Portfolio& portfolio, const std::string& filename,
+                           const ColumnarWriteOptions& options) {
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+    bool ok = write(portfolio, file, options);
+    file.close();
+    return ok && !file.fail();
+}
+
+bool ColumnarWriter::write(const Portfolio& portfolio, std::ostream& file, const ColumnarWriteOptions& options) {
+    METRIC_TIME_SCOPE(ExportColumnar);
+    file.write(kMagic, sizeof(kMagic));
+    std::uint64_t offset = sizeof(kMagic);
+
+    // Schema: fixed columns, then one column per attribute field in use
+    std::vector<ColumnInfo> schema(kFixedSchema, kFixedSchema + kFixedColumns);
+    std::vector<AttributeField> attributeFields;
+    std::vector<std::uint8_t> fieldUsed(Attributes::fieldCount(), 0);
+    for (const Investment& investment : portfolio) {
+        if (investment.getStock()) {
+            for (AttributeField field : investment.getStock()->getAttributeFields()) {
+                if (field < fieldUsed.size() && !fieldUsed[field]) {
+                    fieldUsed[field] = 1;
+                }
+            }
+        }
+    }
+    for (size_t field = 0; field < fieldUsed.size(); ++field) {
+        if (fieldUsed[field]) {
+            attributeFields.push_back(static_cast<AttributeField>(field));
+            schema.push_back({kAttributePrefix + Attributes::fieldName(static_cast<AttributeField>(field)),
+                              ColumnType::String});
+        }
+    }
+    const size_t acquiredDayColumn = schema.size();
+    schema.push_back({kAcquiredDayColumn, ColumnType::Int64});
+    const size_t lastSplitDayColumn = schema.size();
+    schema.push_back({kLastSplitDayColumn, ColumnType::Int64});
+
+    // Row groups: gather one group's rows, encode column by column
+    std::vector<RowGroupInfo> groups;
+    size_t groupSize = std::max<size_t>(1, options.rowGroupSize);
+    size_t total = portfolio.getInvestmentCount();
+    std::vector<const Investment*> rows;
+    std::vector<std::int64_t> integers;
+    std::vector<const std::string*> strings;
+    std::vector<std::string> decoded;  // Owned text for computed columns
+    std::unordered_map<AttributeCode, std::string> attributeText;  // Decoded once per chunk
+    size_t next = 0;
+    while (next < total) {
+        rows.clear();
+        for (; next < total && rows.size() < groupSize; ++next) {
+            if (portfolio[next].getStock()) {
+                rows.push_back(&portfolio[next]);
+            }
+        }
+        if (rows.empty()) {
+            break;
+        }
+
+        RowGroupInfo group;
+        group.rows = rows.size();
+        for (size_t c = 0; c < schema.size(); ++c) {
+            ByteWriter out;
+            ColumnChunkInfo chunk;
+            if (schema[c].type == ColumnType::String) {
+                decoded.clear();
+                decoded.reserve(rows.size());
+                attributeText.clear();
+                strings.clear();
+                for (const Investment* row : rows) {
+                    const Stock& stock = *row->getStock();
+                    switch (c) {
+                        case kSymbol:   strings.push_back(&stock.getSymbol()); continue;
+                        case kCompany:  decoded.push_back(stock.getCompanyName()); break;
+                        case kCurrency: decoded.push_back(stock.getCurrencyCode()); break;
+                        default: {
+                            AttributeField field = attributeFields[c - kFixedColumns];
+                            AttributeCode code = stock.getAttributeCode(field);
+                            auto found = attributeText.find(code);
+                            if (found == attributeText.end()) {
+                                found = attributeText.emplace(code, Attributes::decode(field, code)).first;
+                            }
+                            strings.push_back(&found->second);
+                            continue;
+                        }
+                    }
+                    strings.push_back(&decoded.back());
+                }
+                auto bounds = std::minmax_element(strings.begin(), strings.end(),
+                    [](const std::string* a, const std::string* b) { return *a < *b; });
+                chunk.minText = **bounds.first;
+                chunk.maxText = **bounds.second;
+                chunk.encoding = encodeStrings(strings, out);
+            } else {
+                integers.resize(rows.size());
+                for (size_t r = 0; r < rows.size(); ++r) {
+                    const Investment& row = *rows[r];
+                    if (c == acquiredDayColumn) {
+                        integers[r] = row.getAcquiredDay();
+                        continue;
+                    }
+                    if (c == lastSplitDayColumn) {
+                        integers[r] = row.getStock()->getLastSplitDay();
+                        continue;
+                    }
+                    switch (c) {
+                        case kPrice:         integers[r] = row.getStock()->getCurrentPrice().raw(); break;
+                        case kPreviousPrice: integers[r] = row.getStock()->getPreviousPrice().raw(); break;
+                        case kShares:        integers[r] = row.getSharesOwned(); break;
+                        case kPurchasePrice: integers[r] = row.getPurchasePrice().raw(); break;
+                        default:             integers[r] = row.getTotalInvested().raw(); break;
+                    }
+                }
+                auto bounds = std::minmax_element(integers.begin(), integers.end());
+                chunk.minValue = *bounds.first;
+                chunk.maxValue = *bounds.second;
+                chunk.encoding = encodeIntegers(integers, out);
+            }
+            chunk.offset = offset;
+            chunk.length = out.bytes.size();
+            file.write(out.bytes.data(), static_cast<std::streamsize>(out.bytes.size()));
+            offset += out.bytes.size();
+            group.columns.push_back(std::move(chunk));
+        }
+        METRIC_ADD(PositionsExported, rows.size());
+        groups.push_back(std::move(group));
+    }
+
+    // Footer
+    ByteWriter footer;
+    footer.putString(portfolio.getPortfolioName());
+    footer.putSigned(portfolio.getTotalInitialInvestment().raw());
+    footer.putU8(static_cast<std::uint8_t>(Money::kDecimals));
+    const FxRateTable& fx = portfolio.getFxRates();
+    footer.putString(Currency::codeOf(fx.getBaseCurrency()));
+    std::vector<CurrencyId> currencies = fx.getCurrencies();
+    footer.putVarint(currencies.size());
+    for (CurrencyId currency : currencies) {
+        footer.putString(Currency::codeOf(currency));
+        footer.putSigned(fx.getRateUnits(currency));
+    }
+    footer.putVarint(schema.size());
+    for (const ColumnInfo& column : schema) {
+        footer.putString(column.name);
+        footer.putU8(static_cast<std::uint8_t>(column.type));
+    }
+    footer.putVarint(groups.size());
+    for (const RowGroupInfo& group : groups) {
+        footer.putVarint(group.rows);
+        for (size_t c = 0; c < schema.size(); ++c) {
+            const ColumnChunkInfo& chunk = group.columns[c];
+            footer.putVarint(chunk.offset);
+            footer.putVarint(chunk.length);
+            footer.putU8(static_cast<std::uint8_t>(chunk.encoding));
+            if (schema[c].type == ColumnType::String) {
+                footer.putString(chunk.minText);
+                footer.putString(chunk.maxText);
+            } else {
+                footer.putSigned(chunk.minValue);
+                footer.putSigned(chunk.maxValue);
+            }
+        }
+    }
+    std::uint32_t footerLength = static_cast<std::uint32_t>(footer.bytes.size());
+    char lengthBytes[4];
+    for (int i = 0; i < 4; ++i) {
+        lengthBytes[i] = static_cast<char>((footerLength >> (8 * i)) & 0xFF);
+    }
+    file.write(footer.bytes.data(), static_cast<std::streamsize>(footer.bytes.size()));
+    file.write(lengthBytes, sizeof(lengthBytes));
+    file.write(kMagic, sizeof(kMagic));
+    return !file.fail();
+}
+
+// Reader
+ColumnarReader::ColumnarReader() : moneyDecimals(Money::kDecimals) {}
+
+bool ColumnarReader::open(const std::string& filename) {
+    file.close();
+    file.clear();
+    columns.clear();
+    rowGroups.clear();
+    fxRates.clear();
+    file.open(filename, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    file.seekg(0, std::ios::end);
+    std::streamoff size = file.tellg();
+    char head[sizeof(kMagic)];
+    char trailer[kTrailerSize];
+    if (size < static_cast<std::streamoff>(sizeof(kMagic) + kTrailerSize)) {
+        return false;
+    }
+    file.seekg(0);
+    file.read(head, sizeof(head));
+    file.seekg(size - static_cast<std::streamoff>(kTrailerSize));
+    file.read(trailer, sizeof(trailer));
+    if (!file || std::memcmp(head, kMagic, sizeof(kMagic)) != 0 ||
+        std::memcmp(trailer + 4, kMagic, sizeof(kMagic)) != 0) {
+        return false;
+    }
+    std::uint32_t footerLength = 0;
+    for (int i = 0; i < 4; ++i) {
+        footerLength |= static_cast<std::uint32_t>(static_cast<std::uint8_t>(trailer[i])) << (8 * i);
+    }
+    std::streamoff footerStart = size - static_cast<std::streamoff>(kTrailerSize) - footerLength;
+    if (footerStart < static_cast<std::streamoff>(sizeof(kMagic))) {
+        return false;
+    }
+    std::string bytes(footerLength, '\0');
+    file.seekg(footerStart);
+    file.read(&bytes[0], footerLength);
+    if (!file) {
+        return false;
+    }
+
+    ByteReader in(bytes.data(), bytes.size());
+    portfolioName = in.getString();
+    std::int64_t initialUnits = in.getSigned();
+    moneyDecimals = in.getU8();
+    if (moneyDecimals > 9) {
+        return false;
+    }
+    totalInitialInvestment = Money::fromUnits(rescaleMoney(initialUnits, moneyDecimals));
+    baseCurrency = in.getString();
+    std::uint64_t rateCount = in.getVarint();
+    for (std::uint64_t i = 0; i < rateCount && in.ok; ++i) {
+        std::string code = in.getString();
+        fxRates.emplace_back(code, in.getSigned());
+    }
+    std::uint64_t columnCount = in.getVarint();
+    for (std::uint64_t i = 0; i < columnCount && in.ok; ++i) {
+        ColumnInfo column;
+        column.name = in.getString();
+        column.type = static_cast<ColumnType>(in.getU8());
+        if (column.type > ColumnType::String) {
+            return false;
+        }
+        columns.push_back(std::move(column));
+    }
+    std::uint64_t groupCount = in.getVarint();
+    std::uint64_t totalRows = 0;
+    for (std::uint64_t g = 0; g < groupCount && in.ok; ++g) {
+        RowGroupInfo group;
+        group.rows = in.getVarint();
+        std::uint64_t groupBytes = 0;
+        for (const ColumnInfo& column : columns) {
+            ColumnChunkInfo chunk;
+            chunk.offset = in.getVarint();
+            chunk.length = in.getVarint();
+            chunk.encoding = static_cast<ColumnEncoding>(in.getU8());
+            if (column.type == ColumnType::String) {
+                chunk.minText = in.getString();
+                chunk.maxText = in.getString();
+            } else {
+                chunk.minValue = in.getSigned();
+                chunk.maxValue = in.getSigned();
+                if (column.type == ColumnType::Money) {
+                    chunk.minValue = rescaleMoney(chunk.minValue, moneyDecimals);
+                    chunk.maxValue = rescaleMoney(chunk.maxValue, moneyDecimals);
+                }
+            }
+            if (chunk.length > static_cast<std::uint64_t>(footerStart) ||
+                chunk.offset > static_cast<std::uint64_t>(footerStart) - chunk.length) {
+                return false;
+            }
+            groupBytes += chunk.length;
+            group.columns.push_back(std::move(chunk));
+        }
+        // Symbols are distinct, so the symbol column alone takes at least a
+        // byte per row: a footer claiming more rows than its chunks (or the
+        // file) hold is corrupt and must not size any allocation
+        totalRows += group.rows;
+        if (group.rows > groupBytes || totalRows > static_cast<std::uint64_t>(size)) {
+            return false;
+        }
+        rowGroups.push_back(std::move(group));
+    }
+    if (!in.ok || columns.size() < kFixedColumns) {
+        return false;
+    }
+    for (size_t c = 0; c < kFixedColumns; ++c) {
+        if (columns[c].name != kFixedSchema[c].name || columns[c].type != kFixedSchema[c].type) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const std::string& ColumnarReader::getPortfolioName() const {
+    return portfolioName;
+}
+
+Money ColumnarReader::getTotalInitialInvestment() const {
+    return totalInitialInvestment;
+}
+
+const std::string& ColumnarReader::getBaseCurrency() const {
+    return baseCurrency;
+}
+
+const std::vector<std::pair<std::string, std::int64_t>>& ColumnarReader::getFxRateUnits() const {
+    return fxRates;
+}
+
+const std::vector<ColumnInfo>& ColumnarReader::getColumns() const {
+    return columns;
+}
+
+const std::vector<RowGroupInfo>& ColumnarReader::getRowGroups() const {
+    return rowGroups;
+}
+
+int ColumnarReader::findColumn(const std::string& name) const {
+    for (size_t c = 0; c < columns.size(); ++c) {
+        if (columns[c].name == name) {
+            return static_cast<int>(c);
+        }
+    }
+    return -1;
+}
+
+std::uint64_t ColumnarReader::getRowCount() const {
+    std::uint64_t rows = 0;
+    for (const RowGroupInfo& group : rowGroups) {
+        rows += group.rows;
+    }
+    return rows;
+}
+
+bool ColumnarReader::mayContain(size_t group, size_t column, std::int64_t lo, std::int64_t hi) const {
+    if (group >= rowGroups.size() || column >= columns.size() || columns[column].type == ColumnType::String) {
+        return true;
+    }
+    const ColumnChunkInfo& chunk = rowGroups[group].columns[column];
+    return chunk.maxValue >= lo && chunk.minValue <= hi;
+}
+
+bool ColumnarReader::readChunk(const ColumnChunkInfo& chunk, std::string& bytes) {
+    bytes.resize(static_cast<size_t>(chunk.length));
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(chunk.offset));
+    file.read(&bytes[0], static_cast<std::streamsize>(chunk.length));
+    return static_cast<bool>(file);
+}
+
+bool ColumnarReader::readIntColumn(size_t group, size_t column, std::vector<std::int64_t>& values) {
+    if (group >= rowGroups.size() || column >= columns.size() || columns[column].type == ColumnType::String) {
+        return false;
+    }
+    std::string bytes;
+    if (!readChunk(rowGroups[group].columns[column], bytes)) {
+        return false;
+    }
+    ByteReader in(bytes.data(), bytes.size());
+    if (!decodeIntegers(in, values, rowGroups[group].rows)) {
+        return false;
+    }
+    if (columns[column].type == ColumnType::Money && moneyDecimals != Money::kDecimals) {
+        for (std::int64_t& value : values) {
+            value = rescaleMoney(value, moneyDecimals);
+        }
+    }
+    return true;
+}
+
+bool ColumnarReader::readStringColumn(size_t group, size_t column, std::vector<std::string>& values) {
+    if (group >= rowGroups.size() || column >= columns.size() || columns[column].type != ColumnType::String) {
+        return false;
+    }
+    std::string bytes;
+    if (!readChunk(rowGroups[group].columns[column], bytes)) {
+        return false;
+    }
+    ByteReader in(bytes.data(), bytes.size());
+    return decodeStrings(in, values, rowGroups[group].rows);
+}
+
+bool ColumnarReader::readRowGroup(size_t group, std::vector<Investment>& out) {
+    std::vector<std::string> symbols, companies, currencies;
+    std::vector<std::int64_t> price, previousPrice, shares, purchasePrice, totalInvested;
+    if (!readStringColumn(group, kSymbol, symbols) || !readStringColumn(group, kCompany, companies) ||
+        !readStringColumn(group, kCurrency, currencies) || !readIntColumn(group, kPrice, price) ||
+        !readIntColumn(group, kPreviousPrice, previousPrice) || !readIntColumn(group, kShares, shares) ||
+        !readIntColumn(group, kPurchasePrice, purchasePrice) ||
+        !readIntColumn(group, kTotalInvested, totalInvested)) {
+        return false;
+    }
+
+    size_t rows = symbols.size();
+    std::vector<std::int64_t> acquiredDays(rows, 0), lastSplitDays(rows, 0);
+    const int acquiredDayColumn = findColumn(kAcquiredDayColumn);
+    const int lastSplitDayColumn = findColumn(kLastSplitDayColumn);
+    if ((acquiredDayColumn >= 0 && !readIntColumn(group, static_cast<size_t>(acquiredDayColumn), acquiredDays)) ||
+        (lastSplitDayColumn >= 0 && !readIntColumn(group, static_cast<size_t>(lastSplitDayColumn), lastSplitDays)) ||
+        acquiredDays.size() != rows || lastSplitDays.size() != rows) {
+        return false;
+    }
+    std::vector<std::shared_ptr<Stock>> stocks(rows);
+    size_t first = out.size();
+    out.reserve(first + rows);
+    for (size_t r = 0; r < rows; ++r) {
+        if (!fitsInt(shares[r]) || !fitsInt(acquiredDays[r]) || !fitsInt(lastSplitDays[r])) {
+            METRIC_INCREMENT(PositionsSkipped);
+            continue;
+        }
+        try {
+            stocks[r] = std::make_shared<Stock>(symbols[r], companies[r], Money::fromUnits(price[r]), currencies[r]);
+            stocks[r]->setPreviousPrice(Money::fromUnits(previousPrice[r]));
+            stocks[r]->setLastSplitDay(static_cast<int>(lastSplitDays[r]));
+            out.emplace_back(stocks[r], static_cast<int>(shares[r]), Money::fromUnits(purchasePrice[r]),
+                             Money::fromUnits(totalInvested[r]));
+            out.back().setAcquiredDay(static_cast<int>(acquiredDays[r]));
+            METRIC_INCREMENT(PositionsLoaded);
+        } catch (const std::exception&) {
+            stocks[r].reset();
+            METRIC_INCREMENT(PositionsSkipped);
+        }
+    }
+
+    std::vector<std::string> values;
+    for (size_t c = kFixedColumns; c < columns.size(); ++c) {
+        if (columns[c].name.compare(0, std::strlen(kAttributePrefix), kAttributePrefix) != 0 ||
+            !readStringColumn(group, c, values)) {
+            continue;
+        }
+        AttributeField field = Attributes::fieldOf(columns[c].name.substr(std::strlen(kAttributePrefix)));
+        for (size_t r = 0; r < rows; ++r) {
+            if (stocks[r] && !values[r].empty()) {
+                stocks[r]->setAttribute(field, values[r]);
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,119 @@
+#ifndef COLUMNAR_FILE_H
+#define COLUMNAR_FILE_H
+
+#include "Investment.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+class Portfolio;
+
+enum class ColumnType : std::uint8_t {
+    Int64,
+    Money,   // Int64 fixed-point units at the writer's Money precision
+    String,
+};
+
+enum class ColumnEncoding : std::uint8_t {
+    Plain,       // Strings: length-prefixed bytes
+    BitPacked,   // Integers: frame of reference (min) plus fixed-width packed offsets
+    RunLength,   // Integers: (run length, value) pairs
+    Dictionary,  // Strings: chunk dictionary plus integer-encoded codes
+};
+
+struct ColumnInfo {
+    std::string name;
+    ColumnType type = ColumnType::Int64;
+};
+
+// Location, encoding and statistics of one column within one row group.
+// Integer and Money columns keep min/max values; string columns keep min/max
+// text.
+struct ColumnChunkInfo {
+    std::uint64_t offset = 0;
+    std::uint64_t length = 0;
+    ColumnEncoding encoding = ColumnEncoding::Plain;
+    std::int64_t minValue = 0;
+    std::int64_t maxValue = 0;
+    std::string minText;
+    std::string maxText;
+};
+
+struct RowGroupInfo {
+    std::uint64_t rows = 0;
+    std::vector<ColumnChunkInfo> columns;  // Parallel to the schema
+};
+
+struct ColumnarWriteOptions {
+    size_t rowGroupSize = 65536;  // Rows encoded and held in memory at a time
+};
+
+// Column-oriented portfolio file, loosely modelled on Parquet:
+//
+//   magic | row group 0 column chunks | row group 1 ... | footer | footer length | magic
+//
+// Money columns store exact fixed-point units (no rounding, unlike the CSV
+// export). Integer chunks are bit-packed against the chunk minimum or
+// run-length encoded, whichever is smaller; string chunks with repeated
+// values are dictionary encoded with integer-encoded codes. The footer holds
+// the portfolio header, FX rates, the schema and per-chunk min/max stats, so
+// readers can skip row groups without decoding them. Attributes are stored as
+// one string column per field ("attr:sector", ...), followed by the positions'
+// acquisition days and their stocks' last split days. Multi-byte values are
+// little-endian varints, so files are portable across hosts.
+class ColumnarWriter {
+public:
+    static bool write(const Portfolio& portfolio, const std::string& filename,
+                      const ColumnarWriteOptions& options = ColumnarWriteOptions());
+    // The same into an open (binary) stream
+    static bool write(const Portfolio& portfolio, std::ostream& out,
+                      const ColumnarWriteOptions& options = ColumnarWriteOptions());
+};
+
+class ColumnarReader {
+private:
+    std::ifstream file;
+    std::string portfolioName;
+    Money totalInitialInvestment;
+    int moneyDecimals;
+    std::string baseCurrency;
+    std::vector<std::pair<std::string, std::int64_t>> fxRates;  // Code, rate units
+    std::vector<ColumnInfo> columns;
+    std::vector<RowGroupInfo> rowGroups;
+
+    bool readChunk(const ColumnChunkInfo& chunk, std::string& bytes);
+
+public:
+    ColumnarReader();
+
+    // Reads and validates the footer only (chunk bounds, and row counts
+    // against the chunks' and file's size); column data is read on demand
+    bool open(const std::string& filename);
+
+    // Header
+    const std::string& getPortfolioName() const;
+    Money getTotalInitialInvestment() const;
+    const std::string& getBaseCurrency() const;
+    const std::vector<std::pair<std::string, std::int64_t>>& getFxRateUnits() const;
+
+    // Schema and statistics
+    const std::vector<ColumnInfo>& getColumns() const;
+    const std::vector<RowGroupInfo>& getRowGroups() const;
+    int findColumn(const std::string& name) const;  // -1 when absent
+    std::uint64_t getRowCount() const;
+    // False when the group's stats prove no value of an integer or Money
+    // column (in Money units) lies in [lo, hi]; such groups can be skipped
+    // without reading them.
+    bool mayContain(size_t group, size_t column, std::int64_t lo, std::int64_t hi) const;
+
+    // Column data, decoded one chunk at a time. Money columns are rescaled to
+    // this build's Money precision.
+    bool readIntColumn(size_t group, size_t column, std::vector<std::int64_t>& values);
+    bool readStringColumn(size_t group, size_t column, std::vector<std::string>& values);
+
+    // Rebuilds one row group as investments, appending to out
+    bool readRowGroup(size_t group, std::vector<Investment>& out);
+};
+
+#endif // COLUMNAR_FILE_H
@@ -0,0 +1,271 @@
+#include "CorporateActions.h"
+#include "Calendar.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+AdjustmentFactor factorOf(const CorporateAction& action) {
+    AdjustmentFactor factor;
+    if (action.type == CorporateActionType::CashDividend) {
+        factor.prices = 1.0 - Money::ratio(action.cashAmount, action.referencePrice);
+    } else {
+        factor.shares = action.ratio;
+        factor.prices = static_cast<double>(action.ratio.denominator) / static_cast<double>(action.ratio.numerator);
+    }
+    return factor;
+}
+
+AdjustmentFactor combine(const AdjustmentFactor& a, const AdjustmentFactor& b) {
+    AdjustmentFactor combined;
+    combined.shares = a.shares * b.shares;
+    combined.prices = a.prices * b.prices;
+    return combined;
+}
+
+// Kept apart so GCC vectorizes the loop (no aliasing with the factor)
+void scale(double* values, size_t n, double factor) {
+    for (size_t i = 0; i < n; ++i) {
+        values[i] *= factor;
+    }
+}
+
+std::string trim(const std::string& text) {
+    size_t begin = 0;
+    size_t end = text.size();
+    while (begin < end && std::isspace(static_cast<unsigned char>(text[begin]))) {
+        ++begin;
+    }
+    while (end > begin && std::isspace(static_cast<unsigned char>(text[end - 1]))) {
+        --end;
+    }
+    return text.substr(begin, end - begin);
+}
+
+bool parseInteger(const std::string& text, std::int64_t& value) {
+    if (text.empty()) {
+        return false;
+    }
+    char* end = nullptr;
+    value = std::strtoll(text.c_str(), &end, 10);
+    return *end == '\0';
+}
+
+// "new:old", e.g. "3:2"
+bool parseRatio(const std::string& text, SplitRatio& ratio) {
+    size_t colon = text.find(':');
+    return colon != std::string::npos && parseInteger(trim(text.substr(0, colon)), ratio.numerator) &&
+           parseInteger(trim(text.substr(colon + 1)), ratio.denominator);
+}
+
+} // namespace
+
+CorporateActions::CorporateActions() : count(0) {}
+
+const CorporateActions::SymbolActions* CorporateActions::find(const std::string& symbol) const {
+    auto it = bySymbol.find(symbol);
+    return it == bySymbol.end() ? nullptr : &it->second;
+}
+
+size_t CorporateActions::firstAfter(const SymbolActions& entry, int day) {
+    return static_cast<size_t>(
+        std::upper_bound(entry.actions.begin(), entry.actions.end(), day,
+                         [](int value, const CorporateAction& action) { return value < action.exDay; }) -
+        entry.actions.begin());
+}
+
+void CorporateActions::add(const CorporateAction& action) {
+    CorporateAction posted = action;
+    if (action.type == CorporateActionType::CashDividend) {
+        if (action.cashAmount.isNegative() || action.referencePrice <= action.cashAmount) {
+            throw std::invalid_argument("Dividend must be non-negative and below the reference price");
+        }
+        posted.ratio = SplitRatio();
+    } else {
+        if (action.ratio.numerator <= 0 || action.ratio.denominator <= 0) {
+            throw std::invalid_argument("Split ratio must be positive");
+        }
+        posted.ratio = action.ratio * SplitRatio();
+    }
+
+    // Usually appended; a backdated action lands in ex-day order, after any
+    // others on the same day
+    SymbolActions& entry = bySymbol[action.symbol];
+    const size_t at = firstAfter(entry, posted.exDay);
+    entry.actions.insert(entry.actions.begin() + static_cast<std::ptrdiff_t>(at), posted);
+    entry.from.resize(entry.actions.size() + 1);
+    entry.from.back() = AdjustmentFactor();
+    for (size_t i = entry.actions.size(); i-- > 0;) {
+        entry.from[i] = combine(factorOf(entry.actions[i]), entry.from[i + 1]);
+    }
+    ++count;
+}
+
+void CorporateActions::addSplit(const std::string& symbol, int exDay, std::int64_t newShares,
+                                std::int64_t oldShares) {
+    CorporateAction action;
+    action.symbol = symbol;
+    action.type = CorporateActionType::Split;
+    action.exDay = exDay;
+    action.ratio = {newShares, oldShares};
+    add(action);
+}
+
+void CorporateActions::addStockDividend(const std::string& symbol, int exDay, double percent) {
+    // To a millionth of a percent: 5% is 21/20 new shares per old
+    constexpr std::int64_t kScale = 100000000;
+    if (!(percent > 0.0)) {
+        throw std::invalid_argument("Stock dividend must be positive");
+    }
+    CorporateAction action;
+    action.symbol = symbol;
+    action.type = CorporateActionType::StockDividend;
+    action.exDay = exDay;
+    action.ratio = {kScale + static_cast<std::int64_t>(percent / 100.0 * kScale + 0.5), kScale};
+    add(action);
+}
+
+void CorporateActions::addCashDividend(const std::string& symbol, int exDay, Money amount, Money referencePrice) {
+    CorporateAction action;
+    action.symbol = symbol;
+    action.type = CorporateActionType::CashDividend;
+    action.exDay = exDay;
+    action.cashAmount = amount;
+    action.referencePrice = referencePrice;
+    add(action);
+}
+
+void CorporateActions::clear() {
+    bySymbol.clear();
+    count = 0;
+}
+
+std::vector<CorporateAction> CorporateActions::actionsFor(const std::string& symbol) const {
+    const SymbolActions* entry = find(symbol);
+    return entry ? entry->actions : std::vector<CorporateAction>();
+}
+
+AdjustmentFactor CorporateActions::factorSince(const std::string& symbol, int day) const {
+    const SymbolActions* entry = find(symbol);
+    return entry ? entry->from[firstAfter(*entry, day)] : AdjustmentFactor();
+}
+
+void CorporateActions::adjustPrices(const std::string& symbol, const int* days, double* prices, size_t n) const {
+    const SymbolActions* entry = find(symbol);
+    if (!entry) {
+        return;
+    }
+    // Figures before the next ex-day share one factor; the run ends at the
+    // first figure on or after it
+    for (size_t i = 0; i < n;) {
+        const size_t next = firstAfter(*entry, days[i]);
+        if (next == entry->actions.size()) {
+            break;  // Everything left is after the last action
+        }
+        const size_t end =
+            static_cast<size_t>(std::lower_bound(days + i, days + n, entry->actions[next].exDay) - days);
+        scale(prices + i, end - i, entry->from[next].prices);
+        i = end;
+    }
+}
+
+void CorporateActions::adjustQuantities(const std::string& symbol, const int* days, std::int64_t* shares,
+                                        size_t n) const {
+    const SymbolActions* entry = find(symbol);
+    if (!entry) {
+        return;
+    }
+    for (size_t i = 0; i < n;) {
+        const size_t next = firstAfter(*entry, days[i]);
+        if (next == entry->actions.size()) {
+            break;
+        }
+        const size_t end =
+            static_cast<size_t>(std::lower_bound(days + i, days + n, entry->actions[next].exDay) - days);
+        const SplitRatio ratio = entry->from[next].shares;
+        if (ratio.numerator != ratio.denominator) {
+            for (size_t j = i; j < end; ++j) {
+                shares[j] = static_cast<std::int64_t>(static_cast<__int128>(shares[j]) * ratio.numerator /
+                                                      ratio.denominator);
+            }
+        }
+        i = end;
+    }
+}
+
+size_t CorporateActions::applyTo(Portfolio& portfolio, int throughDay) const {
+    size_t posted = 0;
+    for (const auto& symbolEntry : bySymbol) {
+        const Investment* investment = static_cast<const Portfolio&>(portfolio).getInvestment(symbolEntry.first);
+        if (!investment || !investment->getStock()) {
+            continue;
+        }
+        // Read once: actions sharing an ex-day are all posted. Shares bought
+        // on or after an ex-day were bought at the adjusted price already.
+        const int after = std::max(investment->getStock()->getLastSplitDay(), investment->getAcquiredDay());
+        for (const CorporateAction& action : symbolEntry.second.actions) {
+            if (action.type != CorporateActionType::CashDividend && action.exDay > after &&
+                action.exDay <= throughDay && portfolio.applySplit(action.symbol, action.ratio, action.exDay)) {
+                ++posted;
+            }
+        }
+    }
+    return posted;
+}
+
+bool CorporateActions::loadFromCSV(const std::string& filename) {
+    std::ifstream file(filename);
+    std::string line;
+    if (!file.is_open() || !std::getline(file, line)) {
+        return false;
+    }
+    while (std::getline(file, line)) {
+        if (trim(line).empty()) {
+            continue;
+        }
+        std::vector<std::string> cells;
+        std::stringstream ss(line);
+        std::string cell;
+        while (std::getline(ss, cell, ',')) {
+            cells.push_back(trim(cell));
+        }
+        if (cells.size() == 4) {
+            cells.emplace_back();  // No reference price
+        }
+        int exDay = 0;
+        if (cells.size() != 5 || cells[0].empty() || !calendar::parseDay(cells[2], exDay)) {
+            return false;
+        }
+        try {
+            if (cells[1] == "split") {
+                SplitRatio ratio;
+                if (!parseRatio(cells[3], ratio)) {
+                    return false;
+                }
+                addSplit(cells[0], exDay, ratio.numerator, ratio.denominator);
+            } else if (cells[1] == "stock_dividend") {
+                char* end = nullptr;
+                double percent = std::strtod(cells[3].c_str(), &end);
+                if (cells[3].empty() || *end != '\0') {
+                    return false;
+                }
+                addStockDividend(cells[0], exDay, percent);
+            } else if (cells[1] == "cash_dividend") {
+                Money amount, reference;
+                if (!Money::tryParse(cells[3], amount) || !Money::tryParse(cells[4], reference)) {
+                    return false;
+                }
+                addCashDividend(cells[0], exDay, amount, reference);
+            } else {
+                return false;
+            }
+        } catch (const std::invalid_argument&) {
+            return false;
+        }
+    }
+    return true;
+}
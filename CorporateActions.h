@@ -0,0 +1,94 @@
+#ifndef CORPORATE_ACTIONS_H
+#define CORPORATE_ACTIONS_H
+
+#include "Portfolio.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class CorporateActionType {
+    Split,          // Includes reverse splits
+    StockDividend,
+    CashDividend,
+};
+
+// exDay counts days since 1970-01-01 (see Calendar.h): the first day the
+// stock trades without the split or dividend.
+struct CorporateAction {
+    std::string symbol;
+    CorporateActionType type = CorporateActionType::Split;
+    int exDay = 0;
+    SplitRatio ratio;      // Split and StockDividend: new shares per old share
+    Money cashAmount;      // CashDividend: paid per share
+    Money referencePrice;  // CashDividend: last close before the ex-day
+};
+
+// What a figure recorded on some day is multiplied by to be in today's terms
+struct AdjustmentFactor {
+    SplitRatio shares;    // Quantities; cost bases do not change
+    double prices = 1.0;  // Prices: inverse of the share ratio, times (1 - dividend / close) per cash dividend
+};
+
+// Splits, reverse splits and dividends by symbol, kept as cumulative
+// adjustment factors rather than applied to every record they touch. Each
+// symbol holds its actions by ex-day with the product of every action from
+// that one on, so the factor for any historical figure is one binary search.
+// Posting an action costs O(actions on that symbol); holdings pick splits up
+// lazily through their Stock (applyTo), and price or quantity series are
+// adjusted when read, in bulk passes that multiply each run between two
+// ex-days by one constant.
+class CorporateActions {
+private:
+    struct SymbolActions {
+        std::vector<CorporateAction> actions;  // By ex-day, in the order posted within a day
+        std::vector<AdjustmentFactor> from;    // from[i]: product of actions[i..]; from[size] = identity
+    };
+
+    std::unordered_map<std::string, SymbolActions> bySymbol;
+    size_t count;
+
+    const SymbolActions* find(const std::string& symbol) const;
+    static size_t firstAfter(const SymbolActions& entry, int day);
+
+public:
+    CorporateActions();
+
+    // Throws std::invalid_argument for a non-positive ratio, a negative
+    // dividend, or a cash dividend not below its reference price
+    void add(const CorporateAction& action);
+    void addSplit(const std::string& symbol, int exDay, std::int64_t newShares, std::int64_t oldShares);
+    void addStockDividend(const std::string& symbol, int exDay, double percent);
+    void addCashDividend(const std::string& symbol, int exDay, Money amount, Money referencePrice);
+    void clear();
+
+    size_t size() const { return count; }
+    std::vector<CorporateAction> actionsFor(const std::string& symbol) const;
+
+    // Factor for a figure recorded on `day`: every action with a later ex-day
+    AdjustmentFactor factorSince(const std::string& symbol, int day) const;
+
+    // Bulk adjustment in place of figures recorded on days[i], which must be
+    // ascending (a price series). Quantities round toward zero.
+    void adjustPrices(const std::string& symbol, const int* days, double* prices, size_t n) const;
+    void adjustQuantities(const std::string& symbol, const int* days, std::int64_t* shares, size_t n) const;
+
+    // Posts every split and stock dividend with an ex-day after both the held
+    // Stock's last one and the holding's acquisition day, up to and including
+    // throughDay, to the portfolio's holdings (see Portfolio::applySplit).
+    // The last split day is saved with the portfolio, so loading it and
+    // applying the same actions again posts nothing twice. Returns the number
+    // posted.
+    size_t applyTo(Portfolio& portfolio, int throughDay) const;
+
+    // CSV with a header and one row per action:
+    // symbol,type,ex_date,value,reference_price
+    // type is split (value "new:old", e.g. 3:2 or 1:10), stock_dividend
+    // (value in percent) or cash_dividend (value per share, with the
+    // reference price); ex_date is YYYY-MM-DD and reference_price may be empty
+    // otherwise. Adds to the current actions; false if the file cannot be read
+    // or a row does not parse (rows before it are kept).
+    bool loadFromCSV(const std::string& filename);
+};
+
+#endif // CORPORATE_ACTIONS_H
@@ -0,0 +1,69 @@
+#include "Currency.h"
+#include <cctype>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+struct CurrencyRegistry {
+    std::mutex mutex;
+    std::vector<std::string> codes;
+    std::unordered_map<std::string, CurrencyId> ids;
+
+    CurrencyRegistry() {
+        codes.push_back("USD");
+        ids["USD"] = Currency::kDefault;
+    }
+};
+
+CurrencyRegistry& registry() {
+    static CurrencyRegistry instance;
+    return instance;
+}
+
+} // namespace
+
+CurrencyId Currency::idOf(const std::string& code) {
+    if (code.size() != 3) {
+        throw std::invalid_argument("Currency code must have 3 letters: " + code);
+    }
+    std::string normalized = code;
+    for (char& c : normalized) {
+        if (!std::isalpha(static_cast<unsigned char>(c))) {
+            throw std::invalid_argument("Currency code must have 3 letters: " + code);
+        }
+        c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+
+    CurrencyRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    auto it = reg.ids.find(normalized);
+    if (it != reg.ids.end()) {
+        return it->second;
+    }
+    if (reg.codes.size() > std::numeric_limits<CurrencyId>::max()) {
+        throw std::length_error("Too many currencies registered");
+    }
+    CurrencyId id = static_cast<CurrencyId>(reg.codes.size());
+    reg.codes.push_back(normalized);
+    reg.ids.emplace(normalized, id);
+    return id;
+}
+
+std::string Currency::codeOf(CurrencyId id) {
+    CurrencyRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    if (id >= reg.codes.size()) {
+        throw std::out_of_range("Unknown currency id");
+    }
+    return reg.codes[id];
+}
+
+size_t Currency::count() {
+    CurrencyRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    return reg.codes.size();
+}
@@ -0,0 +1,22 @@
+#ifndef CURRENCY_H
+#define CURRENCY_H
+
+#include <cstdint>
+#include <string>
+
+using CurrencyId = std::uint16_t;
+
+// Process-wide table of ISO currency codes interned to dense ids, so positions
+// carry a 2-byte tag and per-currency aggregates are plain array indexes.
+class Currency {
+public:
+    static constexpr CurrencyId kDefault = 0;  // "USD", registered first
+
+    // Returns the id for a code, registering it on first use. Codes are
+    // upper-cased; throws std::invalid_argument unless 3 letters.
+    static CurrencyId idOf(const std::string& code);
+    static std::string codeOf(CurrencyId id);
+    static size_t count();
+};
+
+#endif // CURRENCY_H
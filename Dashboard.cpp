@@ -0,0 +1,365 @@
+#include "Dashboard.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr int kHeaderLines = 3;  // Title, column headings, rule
+constexpr int kFooterLines = 1;  // Status line
+
+#ifndef _WIN32
+bool writeAll(const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t written = ::write(STDOUT_FILENO, data, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        length -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+// Raw, non-echoing input on the alternate screen with the cursor hidden;
+// the destructor puts the terminal back whatever happens in between.
+class TerminalSession {
+private:
+    termios saved;
+    bool active;
+
+public:
+    TerminalSession() : saved(), active(false) {
+        if (::tcgetattr(STDIN_FILENO, &saved) != 0) {
+            return;
+        }
+        termios raw = saved;
+        raw.c_lflag &= static_cast<tcflag_t>(~(ICANON | ECHO));
+        raw.c_cc[VMIN] = 0;
+        raw.c_cc[VTIME] = 0;
+        if (::tcsetattr(STDIN_FILENO, TCSANOW, &raw) != 0) {
+            return;
+        }
+        active = true;
+        const char enter[] = "\x1b[?1049h\x1b[?25l\x1b[2J";
+        writeAll(enter, sizeof(enter) - 1);
+    }
+
+    ~TerminalSession() {
+        if (active) {
+            const char leave[] = "\x1b[0m\x1b[?25h\x1b[?1049l";
+            writeAll(leave, sizeof(leave) - 1);
+            ::tcsetattr(STDIN_FILENO, TCSANOW, &saved);
+        }
+    }
+
+    bool isActive() const { return active; }
+};
+
+bool terminalSize(int& rows, int& columns) {
+    winsize size;
+    if (::ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) != 0 || size.ws_row == 0 || size.ws_col == 0) {
+        return false;
+    }
+    rows = size.ws_row;
+    columns = size.ws_col;
+    return true;
+}
+#endif
+
+} // namespace
+
+// Constructor and Destructor
+Dashboard::Dashboard(Portfolio& portfolio, DashboardOptions options)
+    : portfolio(portfolio), options(options), filtered(false), requestedRows(0), requestedColumns(0),
+      height(0), width(0), scroll(0),
+      dirty(true), paused(false), quit(false), framesDrawn(0), bytesWritten(0), lastInvestmentCount(0),
+      attached(false) {}
+
+Dashboard::~Dashboard() {
+    if (attached) {
+        portfolio.removeTickListener(this);
+    }
+}
+
+// Configuration
+void Dashboard::setFeed(FeedFunction newFeed) {
+    feed = std::move(newFeed);
+}
+
+void Dashboard::setQuery(const PositionQuery& newQuery) {
+    query = newQuery;
+    filtered = newQuery.hasFilter() || newQuery.hasSort() || newQuery.getLimit() != PositionQuery::kNoLimit;
+    scroll = 0;
+    dirty = true;
+}
+
+// TickListener
+void Dashboard::onTick(const Investment&, Money) {
+    dirty = true;
+}
+
+// Statistics
+size_t Dashboard::getFramesDrawn() const {
+    return framesDrawn;
+}
+
+size_t Dashboard::getBytesWritten() const {
+    return bytesWritten;
+}
+
+// Layout and input
+void Dashboard::resize(int newHeight, int newWidth) {
+    requestedRows = newHeight;
+    requestedColumns = newWidth;
+    height = std::max(newHeight, kHeaderLines + kFooterLines + 1);
+    // Leave the last column free so a full line never wraps the terminal
+    width = std::max(newWidth - 1, 20);
+    screen.assign(static_cast<size_t>(height), std::string(static_cast<size_t>(width), ' '));
+    displayed.clear();
+    dirty = true;
+}
+
+size_t Dashboard::pageRows() const {
+    return static_cast<size_t>(height - kHeaderLines - kFooterLines);
+}
+
+size_t Dashboard::rowCount() const {
+    return filtered ? visibleRows.size() : portfolio.getInvestmentCount();
+}
+
+void Dashboard::scrollBy(long delta) {
+    long target = static_cast<long>(scroll) + delta;
+    scroll = target < 0 ? 0 : static_cast<size_t>(target);
+    dirty = true;  // render() clamps to the last page
+}
+
+void Dashboard::handleInput(const char* input, size_t length) {
+    long page = static_cast<long>(pageRows());
+    for (size_t i = 0; i < length; ++i) {
+        char c = input[i];
+        if (c == '\x1b' && i + 2 < length && input[i + 1] == '[') {
+            char code = input[i + 2];
+            i += 2;
+            if (code >= '0' && code <= '9' && i + 1 < length && input[i + 1] == '~') {
+                ++i;
+            }
+            switch (code) {
+                case 'A': scrollBy(-1); break;
+                case 'B': scrollBy(1); break;
+                case '5': scrollBy(-page); break;
+                case '6': scrollBy(page); break;
+                case 'H': case '1': scroll = 0; dirty = true; break;
+                case 'F': case '4': scrollBy(static_cast<long>(rowCount())); break;
+                default: break;
+            }
+            continue;
+        }
+        switch (c) {
+            case 'q': case 'Q': quit = true; break;
+            case 'k': scrollBy(-1); break;
+            case 'j': scrollBy(1); break;
+            case 'b': scrollBy(-page); break;
+            case ' ': scrollBy(page); break;
+            case 'g': scroll = 0; dirty = true; break;
+            case 'G': scrollBy(static_cast<long>(rowCount())); break;
+            case 'p': case 'P': paused = !paused; dirty = true; break;
+            default: break;
+        }
+    }
+}
+
+// Rendering
+void Dashboard::setLine(int row, const char* text) {
+    std::string& line = screen[static_cast<size_t>(row)];
+    size_t length = std::min(std::strlen(text), static_cast<size_t>(width));
+    line.replace(0, length, text, length);
+    std::fill(line.begin() + static_cast<std::ptrdiff_t>(length), line.end(), ' ');
+}
+
+void Dashboard::formatPosition(int row, const Investment& investment) {
+    char buffer[256];
+    const std::shared_ptr<Stock>& stock = investment.getStock();
+    if (!stock) {
+        setLine(row, "");
+        return;
+    }
+    std::snprintf(buffer, sizeof(buffer), "%-8.8s %-24.24s %8d %11.2f %11.2f %13.2f %13.2f %8.2f%%",
+                  stock->getSymbol().c_str(), stock->getCompanyName().c_str(), investment.getSharesOwned(),
+                  investment.getPurchasePrice().toDouble(), stock->getCurrentPrice().toDouble(),
+                  investment.getCurrentValue().toDouble(), investment.getGainLoss().toDouble(),
+                  investment.getPercentageReturn());
+    setLine(row, buffer);
+}
+
+void Dashboard::render() {
+    char buffer[512];
+    if (filtered) {
+        visibleRows = query.execute(portfolio);
+    }
+    size_t total = rowCount();
+    size_t page = pageRows();
+    scroll = std::min(scroll, total > page ? total - page : 0);
+    size_t last = std::min(total, scroll + page);
+
+    std::snprintf(buffer, sizeof(buffer), "PORTFOLIO: %s | Value %.2f %s | Gain/Loss %.2f | Return %.2f%%%s",
+                  portfolio.getPortfolioName().c_str(), portfolio.getCurrentValue().toDouble(),
+                  portfolio.getBaseCurrency().c_str(), portfolio.getTotalGainLoss().toDouble(),
+                  portfolio.getPercentageReturn(), paused ? " | PAUSED" : "");
+    setLine(0, buffer);
+    std::snprintf(buffer, sizeof(buffer), "%-8s %-24s %8s %11s %11s %13s %13s %9s",
+                  "Symbol", "Company", "Shares", "Avg Cost", "Curr Price", "Value", "Gain/Loss", "Return");
+    setLine(1, buffer);
+    std::string rule(static_cast<size_t>(width), '-');
+    setLine(2, rule.c_str());
+
+    // Only the rows inside the scroll window are formatted
+    const Portfolio& positions = portfolio;  // Read-only: leaves the symbol index alone
+    int row = kHeaderLines;
+    for (size_t i = scroll; i < last; ++i, ++row) {
+        formatPosition(row, positions[filtered ? visibleRows[i] : i]);
+    }
+    for (; row < height - kFooterLines; ++row) {
+        setLine(row, "");
+    }
+
+    std::snprintf(buffer, sizeof(buffer), "Rows %zu-%zu of %zu%s | q quit  j/k PgUp/PgDn g/G scroll  p pause | "
+                  "frame %zu, %zu KB written",
+                  total == 0 ? 0 : scroll + 1, last, total, filtered ? " (query)" : "",
+                  framesDrawn + 1, bytesWritten / 1024);
+    setLine(height - 1, buffer);
+}
+
+void Dashboard::flushDifferences() {
+    output.clear();
+    if (displayed.size() != screen.size()) {
+        // First frame or resize: start from a blank screen
+        output += "\x1b[2J";
+        displayed.assign(screen.size(), std::string(static_cast<size_t>(width), ' '));
+    }
+    char move[32];
+    for (size_t y = 0; y < screen.size(); ++y) {
+        const std::string& next = screen[y];
+        std::string& shown = displayed[y];
+        if (next == shown) {
+            continue;
+        }
+        size_t first = 0;
+        while (next[first] == shown[first]) {
+            ++first;
+        }
+        size_t last = next.size() - 1;
+        while (next[last] == shown[last]) {
+            --last;
+        }
+        std::snprintf(move, sizeof(move), "\x1b[%zu;%zuH", y + 1, first + 1);
+        output += move;
+        output.append(next, first, last - first + 1);
+        shown = next;
+    }
+#ifndef _WIN32
+    if (!output.empty() && writeAll(output.data(), output.size())) {
+        bytesWritten += output.size();
+    }
+#endif
+}
+
+// Main loop
+bool Dashboard::run() {
+#ifdef _WIN32
+    return false;
+#else
+    if (!::isatty(STDIN_FILENO) || !::isatty(STDOUT_FILENO)) {
+        return false;
+    }
+    TerminalSession session;
+    if (!session.isActive()) {
+        return false;
+    }
+
+    portfolio.addTickListener(this);
+    attached = true;
+    quit = false;
+    dirty = true;
+    framesDrawn = 0;
+    bytesWritten = 0;
+    lastInvestmentCount = portfolio.getInvestmentCount();
+    requestedRows = requestedColumns = 0;
+
+    using Clock = std::chrono::steady_clock;
+    auto interval = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1.0 / std::max(1.0, options.maxFps)));
+    Clock::time_point nextFrame = Clock::now();
+
+    while (!quit) {
+        Clock::time_point now = Clock::now();
+        int timeoutMs = 0;
+        if (nextFrame > now) {
+            timeoutMs = static_cast<int>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(nextFrame - now).count()) + 1;
+        }
+        pollfd input{STDIN_FILENO, POLLIN, 0};
+        if (::poll(&input, 1, timeoutMs) > 0 && (input.revents & (POLLIN | POLLHUP))) {
+            char keys[64];
+            ssize_t length = ::read(STDIN_FILENO, keys, sizeof(keys));
+            if (length > 0) {
+                handleInput(keys, static_cast<size_t>(length));
+            } else if (length == 0) {
+                quit = true;  // End of input
+            }
+        }
+
+        now = Clock::now();
+        if (quit || now < nextFrame) {
+            continue;
+        }
+        nextFrame += interval;
+        if (nextFrame < now) {
+            nextFrame = now + interval;  // Fell behind: drop frames rather than burst
+        }
+
+        if (feed && !paused) {
+            feed(portfolio);
+        }
+        int rows = options.rows;
+        int columns = options.columns;
+        if (rows <= 0 || columns <= 0) {
+            int termRows = 24;
+            int termColumns = 80;
+            terminalSize(termRows, termColumns);
+            rows = rows > 0 ? rows : termRows;
+            columns = columns > 0 ? columns : termColumns;
+        }
+        if (rows != requestedRows || columns != requestedColumns) {
+            resize(rows, columns);
+        }
+        if (portfolio.getInvestmentCount() != lastInvestmentCount) {
+            lastInvestmentCount = portfolio.getInvestmentCount();
+            dirty = true;
+        }
+        if (dirty) {
+            render();
+            flushDifferences();
+            dirty = false;
+            ++framesDrawn;
+        }
+    }
+
+    portfolio.removeTickListener(this);
+    attached = false;
+    return true;
+#endif
+}
@@ -0,0 +1,88 @@
+#ifndef DASHBOARD_H
+#define DASHBOARD_H
+
+#include "Portfolio.h"
+#include "PositionQuery.h"
+#include "TickListener.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+struct DashboardOptions {
+    double maxFps = 20.0;  // Frame rate cap; input is still read between frames
+    int rows = 0;          // Screen size; 0 asks the terminal
+    int columns = 0;
+};
+
+// Live ANSI terminal view of a portfolio. Each frame is rendered into an
+// in-memory screen and compared with the previous one; only the changed span
+// of each changed line is written, in one write per frame, so a tick costs a
+// few bytes of terminal output instead of a full table. Only the rows in the
+// scroll window are formatted, and frames are skipped entirely until a tick,
+// a key press or a resize makes the screen dirty.
+//
+// Keys are read with poll() in raw mode, so price updates keep flowing while
+// waiting for input: q quits, arrows or j/k scroll, PgUp/PgDn (b/space) page,
+// Home/End (g/G) jump, p pauses the feed. Everything runs on the calling
+// thread, including the feed, so the portfolio needs no locking.
+class Dashboard : public TickListener {
+public:
+    // Called once per frame before rendering, e.g. to apply queued prices
+    using FeedFunction = std::function<void(Portfolio&)>;
+
+    explicit Dashboard(Portfolio& portfolio, DashboardOptions options = DashboardOptions());
+    ~Dashboard() override;
+
+    Dashboard(const Dashboard&) = delete;
+    Dashboard& operator=(const Dashboard&) = delete;
+
+    void setFeed(FeedFunction feed);
+    void setQuery(const PositionQuery& query);  // Shows only matching rows, in query order
+
+    // Runs until q is pressed. Returns false without drawing when stdin or
+    // stdout is not a terminal (or on platforms without termios).
+    bool run();
+
+    // TickListener
+    void onTick(const Investment& investment, Money oldPrice) override;
+
+    // Statistics of the last run
+    size_t getFramesDrawn() const;
+    size_t getBytesWritten() const;
+
+private:
+    Portfolio& portfolio;
+    DashboardOptions options;
+    FeedFunction feed;
+    PositionQuery query;
+    bool filtered;
+
+    std::vector<std::string> screen;     // Frame being built, one padded line per row
+    std::vector<std::string> displayed;  // What the terminal shows
+    std::vector<size_t> visibleRows;     // Query result of the current frame
+    std::string output;
+    int requestedRows;     // Screen size the layout was built for
+    int requestedColumns;
+    int height;
+    int width;
+    size_t scroll;
+    bool dirty;
+    bool paused;
+    bool quit;
+    size_t framesDrawn;
+    size_t bytesWritten;
+    size_t lastInvestmentCount;
+    bool attached;  // Registered as a tick listener
+
+    void resize(int newHeight, int newWidth);
+    size_t pageRows() const;
+    size_t rowCount() const;
+    void scrollBy(long delta);
+    void handleInput(const char* input, size_t length);
+    void setLine(int row, const char* text);
+    void formatPosition(int row, const Investment& investment);
+    void render();
+    void flushDifferences();
+};
+
+#endif // DASHBOARD_H
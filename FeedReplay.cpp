@@ -0,0 +1,285 @@
+#include "FeedReplay.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Tick {
+    std::int64_t timestamp;
+    const char* symbol;
+    size_t symbolLength;
+    Money price;
+};
+
+// Up to 19 digits, enough for nanosecond epoch timestamps
+bool parseInteger(const char*& cursor, const char* end, std::int64_t& value) {
+    const char* start = cursor;
+    std::uint64_t accumulated = 0;
+    while (cursor < end && *cursor >= '0' && *cursor <= '9' && cursor - start < 19) {
+        accumulated = accumulated * 10 + static_cast<std::uint64_t>(*cursor - '0');
+        ++cursor;
+    }
+    value = static_cast<std::int64_t>(accumulated);
+    return cursor > start && accumulated <= static_cast<std::uint64_t>(INT64_MAX);
+}
+
+// Plain decimals with up to Money::kDecimals places parse in place; anything
+// else (more places, exponents) goes through Money::tryParse.
+bool parsePrice(const char* begin, const char* end, Money& price) {
+    const char* cursor = begin;
+    std::int64_t whole = 0;
+    if (parseInteger(cursor, end, whole) || (cursor < end && *cursor == '.')) {
+        std::int64_t fraction = 0;
+        int places = 0;
+        if (cursor < end && *cursor == '.') {
+            ++cursor;
+            while (cursor < end && *cursor >= '0' && *cursor <= '9' && places < Money::kDecimals) {
+                fraction = fraction * 10 + (*cursor - '0');
+                ++cursor;
+                ++places;
+            }
+        }
+        if (cursor == end && whole < Money::kScale * 1000000) {
+            price = Money::fromUnits(whole * Money::kScale + fraction * moneyPow10(Money::kDecimals - places));
+            return true;
+        }
+    }
+    return Money::tryParse(std::string(begin, end), price);
+}
+
+// Parses the line starting at cursor and advances past it. Returns false for
+// lines that are not ticks; malformed is set when the line was not a comment,
+// header or blank.
+bool nextTick(const char*& cursor, const char* end, Tick& tick, bool& malformed) {
+    const char* lineEnd = static_cast<const char*>(std::memchr(cursor, '\n', static_cast<size_t>(end - cursor)));
+    if (!lineEnd) {
+        lineEnd = end;
+    }
+    const char* line = cursor;
+    cursor = lineEnd < end ? lineEnd + 1 : end;
+    const char* stop = lineEnd;
+    if (stop > line && stop[-1] == '\r') {
+        --stop;
+    }
+    malformed = false;
+    if (stop == line || *line == '#' || !(*line >= '0' && *line <= '9')) {
+        return false;  // Blank, comment or header
+    }
+
+    const char* field = line;
+    const char* comma = static_cast<const char*>(std::memchr(field, ',', static_cast<size_t>(stop - field)));
+    if (!comma || !parseInteger(field, comma, tick.timestamp) || field != comma) {
+        malformed = true;
+        return false;
+    }
+    tick.symbol = comma + 1;
+    comma = static_cast<const char*>(std::memchr(tick.symbol, ',', static_cast<size_t>(stop - tick.symbol)));
+    if (!comma || comma == tick.symbol || !parsePrice(comma + 1, stop, tick.price)) {
+        malformed = true;
+        return false;
+    }
+    tick.symbolLength = static_cast<size_t>(comma - tick.symbol);
+    return true;
+}
+
+std::uint64_t nanosecondsBetween(Clock::time_point from, Clock::time_point to) {
+    return to > from ? static_cast<std::uint64_t>(
+                           std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count())
+                     : 0;
+}
+
+} // namespace
+
+// MappedFile
+MappedFile::MappedFile() : bytes(nullptr), length(0), mapped(false) {}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& filename) {
+    close();
+#ifndef _WIN32
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        return false;
+    }
+    length = static_cast<size_t>(info.st_size);
+    if (length > 0) {
+        void* address = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED) {
+            ::madvise(address, length, MADV_SEQUENTIAL);
+            bytes = static_cast<const char*>(address);
+            mapped = true;
+        }
+    }
+    ::close(fd);
+    if (mapped || length == 0) {
+        bytes = mapped ? bytes : fallback.data();
+        return true;
+    }
+#endif
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    fallback.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    bytes = fallback.data();
+    length = fallback.size();
+    return true;
+}
+
+void MappedFile::close() {
+#ifndef _WIN32
+    if (mapped) {
+        ::munmap(const_cast<char*>(bytes), length);
+    }
+#endif
+    mapped = false;
+    bytes = nullptr;
+    length = 0;
+    fallback.clear();
+}
+
+// Replay
+bool FeedReplay::run(Portfolio& portfolio, const std::string& filename, const ReplayOptions& options,
+                     ReplayReport& report) {
+    report = ReplayReport();
+    MappedFile file;
+    if (!file.open(filename)) {
+        return false;
+    }
+
+    const size_t batchSize = std::max<size_t>(1, options.batchSize);
+    const bool paced = options.speed > 0.0;
+    std::vector<PriceUpdate> batch;
+    std::vector<Clock::time_point> due;
+    batch.reserve(batchSize);
+    due.reserve(batchSize);
+    std::string symbol;
+    LatencyHistogram latency;
+
+    auto flush = [&]() {
+        if (due.empty()) {
+            return;
+        }
+        size_t applied;
+        if (batchSize == 1) {
+            applied = portfolio.updateStockPrice(symbol, batch.front().price) ? 1 : 0;
+        } else {
+            applied = portfolio.updateStockPrices(batch);
+        }
+        portfolio.getCurrentValue();  // The tick is done once the valuation reflects it
+        Clock::time_point done = Clock::now();
+        for (Clock::time_point start : due) {
+            latency.record(nanosecondsBetween(start, done));
+        }
+        report.applied += applied;
+        report.rejected += due.size() - applied;
+        report.batches += 1;
+        batch.clear();
+        due.clear();
+    };
+
+    const char* cursor = file.data();
+    const char* end = cursor + file.size();
+    std::int64_t firstTimestamp = 0;
+    std::int64_t lastTimestamp = 0;
+    Clock::time_point start = Clock::now();
+    Tick tick;
+    bool malformed;
+    while (cursor < end && (options.maxTicks == 0 || report.ticks < options.maxTicks)) {
+        if (!nextTick(cursor, end, tick, malformed)) {
+            report.malformed += malformed;
+            continue;
+        }
+        if (report.ticks == 0) {
+            firstTimestamp = tick.timestamp;
+        }
+        lastTimestamp = std::max(lastTimestamp, tick.timestamp);
+
+        Clock::time_point now = Clock::now();
+        Clock::time_point dueAt = now;
+        if (paced) {
+            double offsetNs = static_cast<double>(tick.timestamp - firstTimestamp) / options.speed;
+            dueAt = start + std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(
+                static_cast<std::int64_t>(offsetNs)));
+            if (dueAt > now) {
+                flush();  // Ticks already due go out before waiting for this one
+                std::this_thread::sleep_until(dueAt);
+            }
+        }
+
+        if (batchSize == 1) {
+            symbol.assign(tick.symbol, tick.symbolLength);
+            batch.push_back({std::string(), tick.price});
+        } else {
+            batch.push_back({std::string(tick.symbol, tick.symbolLength), tick.price});
+        }
+        due.push_back(dueAt);
+        ++report.ticks;
+        if (batch.size() >= batchSize) {
+            flush();
+        }
+    }
+    flush();
+
+    report.wallSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    report.feedSeconds = report.ticks > 0 ? static_cast<double>(lastTimestamp - firstTimestamp) * 1e-9 : 0.0;
+    report.ticksPerSecond = report.wallSeconds > 0.0 ? static_cast<double>(report.ticks) / report.wallSeconds : 0.0;
+    latency.mergeInto(report.latency);
+    return true;
+}
+
+bool FeedReplay::writeSyntheticFile(const Portfolio& portfolio, const std::string& filename, size_t ticks,
+                                    double ticksPerSecond, unsigned seed) {
+    std::vector<std::string> symbols;
+    std::vector<double> prices;
+    for (const Investment& investment : portfolio) {
+        if (investment.getStock()) {
+            symbols.push_back(investment.getStock()->getSymbol());
+            prices.push_back(std::max(0.01, investment.getStock()->getCurrentPrice().toDouble()));
+        }
+    }
+    std::ofstream file(filename);
+    if (!file.is_open() || symbols.empty()) {
+        return false;
+    }
+
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<size_t> pick(0, symbols.size() - 1);
+    std::normal_distribution<double> move(0.0, 0.001);
+    double spacingNs = ticksPerSecond > 0.0 ? 1e9 / ticksPerSecond : 0.0;
+    std::int64_t origin = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    char line[128];
+    file << "timestamp_ns,symbol,price\n";
+    for (size_t i = 0; i < ticks; ++i) {
+        size_t s = pick(rng);
+        prices[s] = std::max(0.01, prices[s] * (1.0 + move(rng)));
+        int written = std::snprintf(line, sizeof(line), "%lld,%s,%.4f\n",
+                                    static_cast<long long>(origin + static_cast<std::int64_t>(i * spacingNs)),
+                                    symbols[s].c_str(), prices[s]);
+        file.write(line, written);
+    }
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,70 @@
+#ifndef FEED_REPLAY_H
+#define FEED_REPLAY_H
+
+#include "Metrics.h"
+#include "Portfolio.h"
+#include <cstdint>
+#include <string>
+
+// Read-only view of a whole file: memory-mapped where the platform supports
+// it, read into memory otherwise.
+class MappedFile {
+private:
+    const char* bytes;
+    size_t length;
+    std::string fallback;
+    bool mapped;
+
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& filename);
+    void close();
+
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+};
+
+struct ReplayOptions {
+    double speed = 0.0;    // Multiple of recorded time (2 = twice as fast); 0 replays flat out
+    size_t batchSize = 1;  // Ticks per updateStockPrices call; 1 calls updateStockPrice per tick
+    size_t maxTicks = 0;   // Stop after this many ticks; 0 replays the whole file
+};
+
+struct ReplayReport {
+    size_t ticks = 0;       // Ticks parsed and sent to the portfolio
+    size_t applied = 0;     // Ticks the portfolio accepted
+    size_t rejected = 0;    // Unknown symbol or invalid price
+    size_t malformed = 0;   // Lines that did not parse
+    size_t batches = 0;
+    double wallSeconds = 0.0;
+    double feedSeconds = 0.0;     // Recorded time the replay covered
+    double ticksPerSecond = 0.0;  // Sustained throughput
+    // Tick-to-valuation latency in ns: from when a tick was due (its scheduled
+    // time when paced, when it was read flat out) until getCurrentValue()
+    // reflects it.
+    HistogramSnapshot latency;
+};
+
+// Replays a recorded tick file against a portfolio. The file holds one
+// "timestamp,symbol,price" line per tick, with the timestamp in integer
+// nanoseconds, in ascending order; blank lines, '#' comments and a header
+// line are skipped. The file is memory-mapped and parsed in place, so the
+// replay loop allocates nothing per tick beyond what the portfolio does.
+class FeedReplay {
+public:
+    // Returns false if the file cannot be opened
+    static bool run(Portfolio& portfolio, const std::string& filename, const ReplayOptions& options,
+                    ReplayReport& report);
+
+    // Writes a random-walk tick file over the portfolio's symbols, starting at
+    // their current prices, with ticks evenly spaced at the given rate.
+    static bool writeSyntheticFile(const Portfolio& portfolio, const std::string& filename, size_t ticks,
+                                   double ticksPerSecond, unsigned seed = 42);
+};
+
+#endif // FEED_REPLAY_H
@@ -0,0 +1,63 @@
+#include "FxRateTable.h"
+#include <cmath>
+
+// Constructors
+FxRateTable::FxRateTable() : FxRateTable(Currency::kDefault) {}
+
+FxRateTable::FxRateTable(CurrencyId baseCurrency) : baseCurrency(baseCurrency) {
+    setBaseCurrency(baseCurrency);
+}
+
+// Base currency
+CurrencyId FxRateTable::getBaseCurrency() const {
+    return baseCurrency;
+}
+
+void FxRateTable::setBaseCurrency(CurrencyId currency) {
+    baseCurrency = currency;
+    rateUnits.assign(static_cast<size_t>(currency) + 1, 0);
+    rateUnits[currency] = kRateScale;
+}
+
+// Rates
+bool FxRateTable::setRate(CurrencyId currency, double rate) {
+    if (currency == baseCurrency || !std::isfinite(rate) || rate <= 0.0 ||
+        rate * kRateScale >= 9.2e18) {
+        return false;
+    }
+    if (currency >= rateUnits.size()) {
+        rateUnits.resize(static_cast<size_t>(currency) + 1, 0);
+    }
+    rateUnits[currency] = static_cast<std::int64_t>(std::nearbyint(rate * kRateScale));
+    return rateUnits[currency] > 0;
+}
+
+bool FxRateTable::hasRate(CurrencyId currency) const {
+    return getRateUnits(currency) != 0;
+}
+
+double FxRateTable::getRate(CurrencyId currency) const {
+    return static_cast<double>(getRateUnits(currency)) / kRateScale;
+}
+
+std::int64_t FxRateTable::getRateUnits(CurrencyId currency) const {
+    return currency < rateUnits.size() ? rateUnits[currency] : 0;
+}
+
+std::vector<CurrencyId> FxRateTable::getCurrencies() const {
+    std::vector<CurrencyId> result;
+    for (size_t id = 0; id < rateUnits.size(); ++id) {
+        if (rateUnits[id] != 0) {
+            result.push_back(static_cast<CurrencyId>(id));
+        }
+    }
+    return result;
+}
+
+Money FxRateTable::convert(Money amount, CurrencyId currency) const {
+    std::int64_t rate = getRateUnits(currency);
+    if (rate == kRateScale) {
+        return amount;
+    }
+    return amount.mulDiv(rate, kRateScale);
+}
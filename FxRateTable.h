@@ -0,0 +1,42 @@
+#ifndef FX_RATE_TABLE_H
+#define FX_RATE_TABLE_H
+
+#include "Currency.h"
+#include "Money.h"
+#include <cstdint>
+#include <vector>
+
+// Conversion rates into a base currency, indexed by CurrencyId. Rates are
+// fixed-point with 10 decimals so converting an exact Money total stays
+// deterministic (one 128-bit multiply and a half-to-even rounding).
+class FxRateTable {
+public:
+    static constexpr int kRateDecimals = 10;
+    static constexpr std::int64_t kRateScale = moneyPow10(kRateDecimals);
+
+private:
+    CurrencyId baseCurrency;
+    std::vector<std::int64_t> rateUnits;  // base units per unit of currency; 0 = no rate
+
+public:
+    // Constructors
+    FxRateTable();
+    explicit FxRateTable(CurrencyId baseCurrency);
+
+    // Base currency (always has rate 1). Changing it clears every other rate.
+    CurrencyId getBaseCurrency() const;
+    void setBaseCurrency(CurrencyId currency);
+
+    // Rates
+    bool setRate(CurrencyId currency, double rate);
+    bool hasRate(CurrencyId currency) const;
+    double getRate(CurrencyId currency) const;
+    std::int64_t getRateUnits(CurrencyId currency) const;
+    std::vector<CurrencyId> getCurrencies() const;
+
+    // Converts an amount in the given currency into the base currency;
+    // currencies without a rate convert to zero.
+    Money convert(Money amount, CurrencyId currency) const;
+};
+
+#endif // FX_RATE_TABLE_H
@@ -2,30 +2,57 @@
 #include <iomanip>
 #include <thread>
 
+#include <limits>
 #include <stdexcept>
 
+namespace {
+
+int splitShares(int shares, SplitRatio ratio) {
+    __int128 split = static_cast<__int128>(shares) * ratio.numerator / ratio.denominator;
+    if (split > std::numeric_limits<int>::max()) {
+        throw std::overflow_error("Share count after split is out of range");
+    }
+    return static_cast<int>(split);
+}
+
+} // namespace
+
 // Default constructor
-Investment::Investment() : stock(nullptr), sharesOwned(0), purchasePrice(0.0), totalInvested(0.0) {}
+Investment::Investment()
+    : stock(nullptr), sharesOwned(0), purchasePrice(), totalInvested(), bookedCost(), acquiredDay(0),
+      splitsApplied(0) {}
+
+// Parameterized constructors
+Investment::Investment(std::shared_ptr<Stock> stock, int shares, Money purchasePrice)
+    : Investment(stock, shares, purchasePrice, purchasePrice * shares) {}
 
-// Parameterized constructor
 Investment::Investment(std::shared_ptr<Stock> stock, int shares, double purchasePrice)
-    : stock(stock), sharesOwned(shares), purchasePrice(purchasePrice) {
+    : Investment(stock, shares, Money::fromDouble(purchasePrice)) {}
+
+// Restores a position with a known cost basis (e.g. after partial sells)
+Investment::Investment(std::shared_ptr<Stock> stock, int shares, Money purchasePrice, Money totalInvested)
+    : stock(stock), sharesOwned(shares), purchasePrice(purchasePrice), totalInvested(totalInvested),
+      bookedCost(), acquiredDay(0), splitsApplied(0) {
     if (!stock) {
         throw std::invalid_argument("Stock pointer cannot be null");
     }
+    splitsApplied = stock->getSplitCount();
     if (shares < 0) {
         throw std::invalid_argument("Number of shares cannot be negative");
     }
-    if (purchasePrice < 0) {
+    if (purchasePrice.isNegative()) {
         throw std::invalid_argument("Purchase price cannot be negative");
     }
-    totalInvested = shares * purchasePrice;
+    if (totalInvested.isNegative()) {
+        throw std::invalid_argument("Total invested cannot be negative");
+    }
 }
 
 // Copy constructor
 Investment::Investment(const Investment& other)
     : stock(other.stock), sharesOwned(other.sharesOwned), 
-      purchasePrice(other.purchasePrice), totalInvested(other.totalInvested) {}
+      purchasePrice(other.purchasePrice), totalInvested(other.totalInvested), bookedCost(other.bookedCost),
+      acquiredDay(other.acquiredDay), splitsApplied(other.splitsApplied), valuation(other.valuation) {}
 
 // Destructor
 Investment::~Investment() {
@@ -33,80 +60,149 @@ Investment::~Investment() {
 }
 
 // Getters
-std::shared_ptr<Stock> Investment::getStock() const {
+const std::shared_ptr<Stock>& Investment::getStock() const {
     return stock;
 }
 
 int Investment::getSharesOwned() const {
-    return sharesOwned;
+    if (!stock || splitsApplied == stock->getSplitCount()) {
+        return sharesOwned;
+    }
+    return splitShares(sharesOwned, stock->getSplitRatioSince(splitsApplied));
 }
 
-double Investment::getPurchasePrice() const {
-    return purchasePrice;
+Money Investment::getPurchasePrice() const {
+    if (!stock || splitsApplied == stock->getSplitCount()) {
+        return purchasePrice;
+    }
+    SplitRatio ratio = stock->getSplitRatioSince(splitsApplied);
+    return purchasePrice.mulDiv(ratio.denominator, ratio.numerator);
 }
 
-double Investment::getTotalInvested() const {
+Money Investment::getTotalInvested() const {
     return totalInvested;
 }
 
+Money Investment::getBookedCost() const {
+    return bookedCost;
+}
+
+int Investment::getAcquiredDay() const {
+    return acquiredDay;
+}
+
+// Folds splits posted since the last mutation into the stored figures
+void Investment::settleSplits() {
+    if (stock && splitsApplied != stock->getSplitCount()) {
+        sharesOwned = getSharesOwned();
+        purchasePrice = getPurchasePrice();
+        splitsApplied = stock->getSplitCount();
+    }
+}
+
 // Setters
 void Investment::setSharesOwned(int shares) {
     if (shares < 0) {
         throw std::invalid_argument("Number of shares cannot be negative");
     }
+    settleSplits();
     sharesOwned = shares;
+    bumpValuation();
 }
 
-void Investment::addShares(int shares, double pricePerShare) {
+void Investment::addShares(int shares, Money pricePerShare) {
     if (shares <= 0) {
         throw std::invalid_argument("Number of shares to add must be positive");
     }
-    if (pricePerShare < 0) {
+    if (pricePerShare.isNegative()) {
         throw std::invalid_argument("Price per share cannot be negative");
     }
 
-    // Calculate weighted average purchase price
-    double newInvestment = shares * pricePerShare;
-    double newTotalShares = sharesOwned + shares;
-
-    if (newTotalShares > 0) {
-        purchasePrice = (totalInvested + newInvestment) / newTotalShares;
-    }
+    // Cost basis stays exact; only the per-share average is rounded
+    settleSplits();
+    Money newInvestment = pricePerShare * shares;
+    std::int64_t newTotalShares = static_cast<std::int64_t>(sharesOwned) + shares;
 
-    sharesOwned += shares;
     totalInvested += newInvestment;
+    purchasePrice = totalInvested / newTotalShares;
+    sharesOwned += shares;
+    bumpValuation();
+}
+
+void Investment::addShares(int shares, double pricePerShare) {
+    addShares(shares, Money::fromDouble(pricePerShare));
 }
 
 void Investment::removeShares(int shares) {
     if (shares <= 0) {
         throw std::invalid_argument("Number of shares to remove must be positive");
     }
+    settleSplits();
     if (shares > sharesOwned) {
         throw std::invalid_argument("Cannot remove more shares than owned");
     }
 
-    double proportionRemoved = static_cast<double>(shares) / sharesOwned;
-    totalInvested *= (1.0 - proportionRemoved);
+    // Remove the sold shares' share of the cost basis (and of the booked
+    // cost), rounded once. Selling the whole position always leaves exactly
+    // zero, so errors cannot accumulate.
+    totalInvested -= totalInvested.mulDiv(shares, sharesOwned);
+    bookedCost -= bookedCost.mulDiv(shares, sharesOwned);
     sharesOwned -= shares;
+    bumpValuation();
+}
+
+std::int64_t Investment::settleSplitFraction(SplitRatio ratio) {
+    settleSplits();
+    __int128 exact = static_cast<__int128>(sharesOwned) * ratio.numerator;
+    std::int64_t fraction = static_cast<std::int64_t>(exact % ratio.denominator);
+    if (fraction == 0) {
+        return 0;
+    }
+    // The fraction's share of the cost, in the same units as exact
+    auto writeOff = [&](Money cost) {
+        return Money::fromUnits(static_cast<std::int64_t>(static_cast<__int128>(cost.raw()) * fraction / exact));
+    };
+    totalInvested -= writeOff(totalInvested);
+    bookedCost -= writeOff(bookedCost);
+    bumpValuation();
+    return fraction;
+}
+
+void Investment::setBookedCost(Money cost) {
+    bookedCost = cost;
+}
+
+void Investment::setAcquiredDay(int day) {
+    acquiredDay = day;
+}
+
+void Investment::attachValuation(const ValuationEpochPtr& epoch) {
+    valuation = epoch;
+    if (valuation && stock) {
+        stock->watchValuation(valuation);
+    }
+}
+
+void Investment::bumpValuation() {
+    if (valuation) {
+        valuation->bump();
+    }
 }
 
 // Financial calculations
-double Investment::getCurrentValue() const {
+Money Investment::getCurrentValue() const {
     if (!stock) {
-        return 0.0;
+        return Money();
     }
-    return sharesOwned * stock->getCurrentPrice();
+    return stock->getCurrentPrice() * getSharesOwned();
 }
 
-double Investment::getGainLoss() const {
+Money Investment::getGainLoss() const {
     return getCurrentValue() - totalInvested;
 }
 
 double Investment::getPercentageReturn() const {
-    if (totalInvested == 0.0) {
-        return 0.0;
-    }
-    return (getGainLoss() / totalInvested) * 100.0;
+    return Money::ratio(getGainLoss(), totalInvested) * 100.0;
 }
 
 // Assignment operator
@@ -116,6 +212,14 @@ Investment& Investment::operator=(const Investment& other) {
         sharesOwned = other.sharesOwned;
         purchasePrice = other.purchasePrice;
         totalInvested = other.totalInvested;
+        bookedCost = other.bookedCost;
+        acquiredDay = other.acquiredDay;
+        splitsApplied = other.splitsApplied;
+        // A position from elsewhere: its stock now affects our holder too
+        if (valuation && stock && other.valuation != valuation) {
+            stock->watchValuation(valuation);
+        }
+        bumpValuation();
     }
     return *this;
 }
@@ -135,8 +239,8 @@ void Investment::displayInvestment() const {
     std::cout << std::fixed << std::setprecision(2);
     std::cout << "Symbol: " << stock->getSymbol() << "\n";
     std::cout << "Company: " << stock->getCompanyName() << "\n";
-    std::cout << "Shares Owned: " << sharesOwned << "\n";
-    std::cout << "Purchase Price: $" << purchasePrice << "\n";
+    std::cout << "Shares Owned: " << getSharesOwned() << "\n";
+    std::cout << "Purchase Price: $" << getPurchasePrice() << "\n";
     std::cout << "Current Price: $" << stock->getCurrentPrice() << "\n";
     std::cout << "Total Invested: $" << totalInvested << "\n";
     std::cout << "Current Value: $" << getCurrentValue() << "\n";
@@ -148,8 +252,8 @@ void Investment::displayInvestment() const {
 std::ostream& operator<<(std::ostream& os, const Investment& investment) {
     if (investment.stock) {
         os << investment.stock->getSymbol() << "," 
-           << investment.sharesOwned << "," 
-           << investment.purchasePrice << "," 
+           << investment.getSharesOwned() << "," 
+           << investment.getPurchasePrice() << "," 
            << investment.totalInvested;
     }
     return os;
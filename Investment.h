@@ -8,30 +8,56 @@ class Investment {
 private:
     std::shared_ptr<Stock> stock;  // Aggregation - Investment aggregates Stock
     int sharesOwned;
-    double purchasePrice;
-    double totalInvested;
+    Money purchasePrice;   // Weighted average cost per share
+    Money totalInvested;   // Exact cost basis of the shares still held
+    Money bookedCost;      // The same in the holding portfolio's base currency, at each trade's FX rate
+    int acquiredDay;       // First purchase, in days since 1970-01-01 (see Calendar.h); 0 = unknown
+    // Stock splits already reflected in sharesOwned and purchasePrice. Later
+    // ones are applied on read, and folded in by the next mutation.
+    std::uint32_t splitsApplied;
+    // The holding portfolio's valuation counter (see ValuationEpoch.h); kept
+    // by assignment, which replaces the position, not the holder
+    ValuationEpochPtr valuation;
+
+    void settleSplits();
+    void bumpValuation();
 
 public:
     // Constructors and Destructor
     Investment();
+    Investment(std::shared_ptr<Stock> stock, int shares, Money purchasePrice);
     Investment(std::shared_ptr<Stock> stock, int shares, double purchasePrice);
+    Investment(std::shared_ptr<Stock> stock, int shares, Money purchasePrice, Money totalInvested);
     Investment(const Investment& other);  // Copy constructor
     ~Investment();
 
-    // Getters
-    std::shared_ptr<Stock> getStock() const;
+    // Getters. Shares and the average price are as of the stock's latest
+    // split: shares round down (the fraction is paid as cash in lieu, see
+    // Portfolio::applySplit) and the cost basis is unchanged. Throws
+    // std::overflow_error if the split share count does not fit in an int.
+    const std::shared_ptr<Stock>& getStock() const;
     int getSharesOwned() const;
-    double getPurchasePrice() const;
-    double getTotalInvested() const;
+    Money getPurchasePrice() const;
+    Money getTotalInvested() const;
+    Money getBookedCost() const;
+    int getAcquiredDay() const;
 
     // Setters
     void setSharesOwned(int shares);
+    void addShares(int shares, Money pricePerShare);
     void addShares(int shares, double pricePerShare);
     void removeShares(int shares);
+    // Cash in lieu for a split by ratio (in lowest terms) about to be posted:
+    // writes off the cost of the fractional new share and returns that
+    // fraction in 1/denominator shares, 0 when the split comes out even
+    std::int64_t settleSplitFraction(SplitRatio ratio);
+    void setBookedCost(Money cost);  // Set by the holding Portfolio
+    void setAcquiredDay(int day);
+    void attachValuation(const ValuationEpochPtr& epoch);  // By the holding Portfolio; null detaches
 
     // Financial calculations
-    double getCurrentValue() const;
-    double getGainLoss() const;
+    Money getCurrentValue() const;
+    Money getGainLoss() const;
     double getPercentageReturn() const;
 
     // Operators
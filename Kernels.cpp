@@ -0,0 +1,161 @@
+#include "Kernels.h"
+
+namespace kernels {
+
+void sumByCurrency(const Investment* investments, size_t count,
+                   std::int64_t* valueUnits, std::int64_t* costUnits, std::uint32_t* positions,
+                   size_t currencyCount) {
+    for (size_t i = 0; i < count; ++i) {
+        const Stock* stock = investments[i].getStock().get();
+        if (!stock) {
+            continue;
+        }
+        CurrencyId currency = stock->getCurrency();
+        if (currency >= currencyCount) {
+            continue;
+        }
+        valueUnits[currency] += investments[i].getCurrentValue().raw();
+        costUnits[currency] += investments[i].getTotalInvested().raw();
+        positions[currency] += 1;
+    }
+}
+
+void sumByGroup(const Investment* investments, size_t count, AttributeField field,
+                std::int64_t* valueUnits, std::int64_t* costUnits, std::uint32_t* positions,
+                size_t codeCount, size_t currencyCount) {
+    for (size_t i = 0; i < count; ++i) {
+        const Stock* stock = investments[i].getStock().get();
+        if (!stock) {
+            continue;
+        }
+        AttributeCode code = stock->getAttributeCode(field);
+        CurrencyId currency = stock->getCurrency();
+        if (code >= codeCount || currency >= currencyCount) {
+            continue;
+        }
+        size_t cell = static_cast<size_t>(code) * currencyCount + currency;
+        valueUnits[cell] += investments[i].getCurrentValue().raw();
+        costUnits[cell] += investments[i].getTotalInvested().raw();
+        positions[cell] += 1;
+    }
+}
+
+double sumPercentageReturns(const Investment* investments, size_t count) {
+    double sum = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        sum += investments[i].getPercentageReturn();
+    }
+    return sum;
+}
+
+PORTFOLIO_MULTIVERSION
+double weightDrift(const double* values, const double* targets, size_t count, double invTotal,
+                   double* drift) {
+    double maxDrift = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        double d = values[i] * invTotal - targets[i];
+        drift[i] = d;
+        double magnitude = d < 0.0 ? -d : d;
+        maxDrift = magnitude > maxDrift ? magnitude : maxDrift;
+    }
+    return maxDrift;
+}
+
+PORTFOLIO_MULTIVERSION
+void shockPnl(const double* shocks, size_t stride, const double* exposures, size_t factorCount,
+              size_t count, double* pnl) {
+    for (size_t s = 0; s < count; ++s) {
+        pnl[s] = 0.0;
+    }
+    for (size_t f = 0; f < factorCount; ++f) {
+        const double exposure = exposures[f];
+        if (exposure == 0.0) {
+            continue;
+        }
+        const double* row = shocks + f * stride;
+        for (size_t s = 0; s < count; ++s) {
+            pnl[s] += exposure * row[s];
+        }
+    }
+}
+
+PORTFOLIO_MULTIVERSION
+void weightedRows(const double* series, size_t stride, const std::uint32_t* rows, const double* weights,
+                  size_t count, size_t length, double* out) {
+    for (size_t t = 0; t < length; ++t) {
+        out[t] = 0.0;
+    }
+    for (size_t k = 0; k < count; ++k) {
+        const double weight = weights[k];
+        const double* row = series + static_cast<size_t>(rows[k]) * stride;
+        for (size_t t = 0; t < length; ++t) {
+            out[t] += weight * row[t];
+        }
+    }
+}
+
+PORTFOLIO_MULTIVERSION
+void compareDoubles(const double* column, size_t count, CompareOp op, double value, std::uint8_t* mask) {
+    // One branch-free loop per operator so each vectorizes on its own
+    switch (op) {
+        case CompareOp::Less:
+            for (size_t i = 0; i < count; ++i) mask[i] = column[i] < value;
+            break;
+        case CompareOp::LessEqual:
+            for (size_t i = 0; i < count; ++i) mask[i] = column[i] <= value;
+            break;
+        case CompareOp::Greater:
+            for (size_t i = 0; i < count; ++i) mask[i] = column[i] > value;
+            break;
+        case CompareOp::GreaterEqual:
+            for (size_t i = 0; i < count; ++i) mask[i] = column[i] >= value;
+            break;
+        case CompareOp::Equal:
+            for (size_t i = 0; i < count; ++i) mask[i] = column[i] == value;
+            break;
+        case CompareOp::NotEqual:
+            for (size_t i = 0; i < count; ++i) mask[i] = column[i] != value;
+            break;
+    }
+}
+
+PORTFOLIO_MULTIVERSION
+void compareCodes(const std::uint32_t* column, size_t count, bool equal, std::uint32_t code,
+                  std::uint8_t* mask) {
+    std::uint8_t match = equal ? 1 : 0;
+    for (size_t i = 0; i < count; ++i) {
+        mask[i] = static_cast<std::uint8_t>((column[i] == code) == match);
+    }
+}
+
+PORTFOLIO_MULTIVERSION
+void maskAnd(std::uint8_t* mask, const std::uint8_t* other, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        mask[i] &= other[i];
+    }
+}
+
+PORTFOLIO_MULTIVERSION
+void maskOr(std::uint8_t* mask, const std::uint8_t* other, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        mask[i] |= other[i];
+    }
+}
+
+PORTFOLIO_MULTIVERSION
+void maskNot(std::uint8_t* mask, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        mask[i] ^= 1;
+    }
+}
+
+size_t maskToIndices(const std::uint8_t* mask, size_t count, size_t offset, size_t* out) {
+    size_t written = 0;
+    for (size_t i = 0; i < count; ++i) {
+        out[written] = offset + i;
+        written += mask[i];
+    }
+    return written;
+}
+
+} // namespace kernels
@@ -0,0 +1,64 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include "Investment.h"
+#include "Platform.h"
+#include <cstddef>
+
+// Numeric loops over positions. The kernels over plain columns carry
+// PORTFOLIO_MULTIVERSION, so each is compiled per ISA level and dispatched on
+// the running CPU. They are free functions on purpose: GCC's target_clones is
+// unreliable on member functions under LTO.
+namespace kernels {
+
+enum class CompareOp : std::uint8_t { Less, LessEqual, Greater, GreaterEqual, Equal, NotEqual };
+
+// Aggregates over Investments. Each row goes through the Investment and
+// Stock getters (a pointer chase per position, with branches), so these are
+// scalar loops compiled once; per-ISA clones would not change them.
+
+// Sums position value and cost basis per currency in one pass. Output arrays
+// are indexed by CurrencyId and must hold currencyCount entries (zeroed by the
+// caller). Integer accumulation keeps totals exact in any order.
+void sumByCurrency(const Investment* investments, size_t count,
+                   std::int64_t* valueUnits, std::int64_t* costUnits, std::uint32_t* positions,
+                   size_t currencyCount);
+// Same as sumByCurrency, keyed by [attribute code][currency]: arrays hold
+// codeCount * currencyCount entries, index code * currencyCount + currency.
+void sumByGroup(const Investment* investments, size_t count, AttributeField field,
+                std::int64_t* valueUnits, std::int64_t* costUnits, std::uint32_t* positions,
+                size_t codeCount, size_t currencyCount);
+double sumPercentageReturns(const Investment* investments, size_t count);
+
+// Column kernels: unit-stride loops over raw arrays, written to vectorize
+
+// drift[i] = values[i] * invTotal - targets[i]; returns the largest |drift|.
+double weightDrift(const double* values, const double* targets, size_t count, double invTotal,
+                   double* drift);
+
+// pnl[s] = sum over f of exposures[f] * shocks[f * stride + s], for s in
+// [0, count). Shocks are factor-major so the inner loop is a unit-stride
+// axpy; factors with zero exposure are skipped.
+void shockPnl(const double* shocks, size_t stride, const double* exposures, size_t factorCount,
+              size_t count, double* pnl);
+
+// out[t] = sum over k of weights[k] * series[rows[k] * stride + t], for t in
+// [0, length): a weighted sum of a few rows of a row-major matrix, each added
+// as a unit-stride axpy.
+void weightedRows(const double* series, size_t stride, const std::uint32_t* rows, const double* weights,
+                  size_t count, size_t length, double* out);
+
+// Predicate building blocks for column scans: each writes one 0/1 byte per row
+// so blocks of results combine with plain elementwise loops.
+void compareDoubles(const double* column, size_t count, CompareOp op, double value, std::uint8_t* mask);
+void compareCodes(const std::uint32_t* column, size_t count, bool equal, std::uint32_t code,
+                  std::uint8_t* mask);
+void maskAnd(std::uint8_t* mask, const std::uint8_t* other, size_t count);
+void maskOr(std::uint8_t* mask, const std::uint8_t* other, size_t count);
+void maskNot(std::uint8_t* mask, size_t count);
+// Appends offset + i for every set mask[i]; returns the number appended.
+size_t maskToIndices(const std::uint8_t* mask, size_t count, size_t offset, size_t* out);
+
+} // namespace kernels
+
+#endif // KERNELS_H
@@ -0,0 +1,384 @@
+#include "Metrics.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+#ifndef _WIN32
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+#endif
+
+namespace {
+
+constexpr size_t kCounterCount = static_cast<size_t>(MetricCounter::Count);
+constexpr size_t kTimerCount = static_cast<size_t>(MetricTimer::Count);
+
+// One shard per thread. Shards are never freed: when a thread exits its shard
+// is handed to the next thread, so totals stay monotonic.
+struct MetricsShard {
+    std::atomic<std::uint64_t> counters[kCounterCount];
+    LatencyHistogram timers[kTimerCount];
+    bool inUse;
+
+    MetricsShard() : inUse(true) {
+        for (auto& counter : counters) {
+            counter.store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+std::mutex& registryMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::vector<std::unique_ptr<MetricsShard>>& registry() {
+    static std::vector<std::unique_ptr<MetricsShard>> shards;
+    return shards;
+}
+
+MetricsShard* acquireShard() {
+    std::lock_guard<std::mutex> lock(registryMutex());
+    for (auto& shard : registry()) {
+        if (!shard->inUse) {
+            shard->inUse = true;
+            return shard.get();
+        }
+    }
+    registry().emplace_back(new MetricsShard());
+    return registry().back().get();
+}
+
+struct ShardHandle {
+    MetricsShard* shard;
+    ShardHandle() : shard(acquireShard()) {}
+    ~ShardHandle() {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        shard->inUse = false;
+    }
+};
+
+MetricsShard& localShard() {
+    thread_local ShardHandle handle;
+    return *handle.shard;
+}
+
+const char* const kCounterNames[kCounterCount] = {
+    "ticks_applied",
+    "ticks_rejected",
+    "investments_added",
+    "investments_merged",
+    "investments_removed",
+    "positions_loaded",
+    "positions_skipped",
+    "positions_saved",
+    "positions_exported",
+    "alerts_triggered",
+};
+
+const char* const kTimerNames[kTimerCount] = {
+    "update_stock_price",
+    "update_stock_prices",
+    "add_investment",
+    "remove_investment",
+    "remove_shares",
+    "load_from_file",
+    "save_to_file",
+    "export_to_csv",
+    "export_columnar",
+    "load_columnar",
+    "stream_aggregate",
+    "snapshot_slice",
+    "scenario_run",
+    "harvest_scan",
+    "option_reprice",
+    "relative_analytics",
+    "get_current_value",
+    "get_total_gain_loss",
+    "get_average_return",
+    "get_top_performers",
+    "get_losers",
+    "sort_investments",
+    "group_by",
+    "query",
+};
+
+const double kReportedPercentiles[] = {0.5, 0.9, 0.99, 0.999};
+
+} // namespace
+
+// LatencyHistogram
+LatencyHistogram::LatencyHistogram() : totalCount(0), totalNs(0), maxNs(0) {
+    for (auto& bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+int LatencyHistogram::bucketIndex(std::uint64_t ns) {
+    if (ns < static_cast<std::uint64_t>(2 * kSubBuckets)) {
+        return static_cast<int>(ns);
+    }
+    const std::uint64_t maxValue = (std::uint64_t(1) << kMaxMagnitude) - 1;
+    if (ns > maxValue) {
+        ns = maxValue;
+    }
+    int magnitude = 63 - __builtin_clzll(ns);
+    int shift = magnitude - kSubBucketBits;
+    int subBucket = static_cast<int>((ns >> shift) & (kSubBuckets - 1));
+    return 2 * kSubBuckets + (magnitude - kSubBucketBits - 1) * kSubBuckets + subBucket;
+}
+
+std::uint64_t LatencyHistogram::bucketUpperBound(int index) {
+    if (index < 2 * kSubBuckets) {
+        return static_cast<std::uint64_t>(index);
+    }
+    int offset = index - 2 * kSubBuckets;
+    int shift = offset / kSubBuckets + 1;
+    std::uint64_t subBucket = static_cast<std::uint64_t>(offset % kSubBuckets);
+    return ((kSubBuckets + subBucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::mergeInto(HistogramSnapshot& snapshot) const {
+    if (snapshot.buckets.size() < static_cast<size_t>(kBucketCount)) {
+        snapshot.buckets.resize(kBucketCount, 0);
+    }
+    for (int b = 0; b < kBucketCount; ++b) {
+        snapshot.buckets[b] += buckets[b].load(std::memory_order_relaxed);
+    }
+    snapshot.count += totalCount.load(std::memory_order_relaxed);
+    snapshot.sumNs += totalNs.load(std::memory_order_relaxed);
+    snapshot.maxNs = std::max(snapshot.maxNs, maxNs.load(std::memory_order_relaxed));
+}
+
+// HistogramSnapshot
+double HistogramSnapshot::percentileNs(double percentile) const {
+    if (count == 0) {
+        return 0.0;
+    }
+    std::uint64_t rank = static_cast<std::uint64_t>(percentile * count + 0.5);
+    rank = std::max<std::uint64_t>(1, std::min(rank, count));
+
+    std::uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return static_cast<double>(std::min(LatencyHistogram::bucketUpperBound(static_cast<int>(i)), maxNs));
+        }
+    }
+    return static_cast<double>(maxNs);
+}
+
+double HistogramSnapshot::meanNs() const {
+    return count == 0 ? 0.0 : static_cast<double>(sumNs) / count;
+}
+
+// MetricsSnapshot
+std::string MetricsSnapshot::toPrometheus() const {
+    std::ostringstream os;
+    for (size_t i = 0; i < counters.size(); ++i) {
+        std::string name = std::string("portfolio_") + kCounterNames[i] + "_total";
+        os << "# TYPE " << name << " counter\n";
+        os << name << " " << counters[i] << "\n";
+    }
+
+    os << "# TYPE portfolio_operation_latency_seconds summary\n";
+    os << std::setprecision(9);
+    for (size_t i = 0; i < timers.size(); ++i) {
+        const HistogramSnapshot& h = timers[i];
+        for (double p : kReportedPercentiles) {
+            os << "portfolio_operation_latency_seconds{op=\"" << kTimerNames[i]
+               << "\",quantile=\"" << p << "\"} " << h.percentileNs(p) * 1e-9 << "\n";
+        }
+        os << "portfolio_operation_latency_seconds_sum{op=\"" << kTimerNames[i] << "\"} "
+           << h.sumNs * 1e-9 << "\n";
+        os << "portfolio_operation_latency_seconds_count{op=\"" << kTimerNames[i] << "\"} "
+           << h.count << "\n";
+    }
+    return os.str();
+}
+
+std::string MetricsSnapshot::toJson() const {
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(1);
+    os << "{\n  \"counters\": {";
+    for (size_t i = 0; i < counters.size(); ++i) {
+        os << (i ? ", " : "") << "\"" << kCounterNames[i] << "\": " << counters[i];
+    }
+    os << "},\n  \"latency_ns\": {\n";
+    for (size_t i = 0; i < timers.size(); ++i) {
+        const HistogramSnapshot& h = timers[i];
+        os << "    \"" << kTimerNames[i] << "\": {\"count\": " << h.count
+           << ", \"mean\": " << h.meanNs()
+           << ", \"p50\": " << h.percentileNs(0.5)
+           << ", \"p90\": " << h.percentileNs(0.9)
+           << ", \"p99\": " << h.percentileNs(0.99)
+           << ", \"p999\": " << h.percentileNs(0.999)
+           << ", \"max\": " << h.maxNs << "}"
+           << (i + 1 < timers.size() ? "," : "") << "\n";
+    }
+    os << "  }\n}\n";
+    return os.str();
+}
+
+// Metrics
+void Metrics::increment(MetricCounter counter, std::uint64_t by) {
+    auto& slot = localShard().counters[static_cast<size_t>(counter)];
+    slot.store(slot.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+}
+
+void Metrics::recordLatency(MetricTimer timer, std::uint64_t ns) {
+    localShard().timers[static_cast<size_t>(timer)].record(ns);
+}
+
+MetricsSnapshot Metrics::snapshot() {
+    MetricsSnapshot result;
+    result.counters.assign(kCounterCount, 0);
+    result.timers.resize(kTimerCount);
+    for (auto& h : result.timers) {
+        h.buckets.assign(LatencyHistogram::kBucketCount, 0);
+    }
+
+    std::lock_guard<std::mutex> lock(registryMutex());
+    for (const auto& shard : registry()) {
+        for (size_t c = 0; c < kCounterCount; ++c) {
+            result.counters[c] += shard->counters[c].load(std::memory_order_relaxed);
+        }
+        for (size_t t = 0; t < kTimerCount; ++t) {
+            shard->timers[t].mergeInto(result.timers[t]);
+        }
+    }
+    return result;
+}
+
+// Not synchronized with concurrent recording; intended for tests and between runs.
+void Metrics::reset() {
+    std::lock_guard<std::mutex> lock(registryMutex());
+    for (auto& shard : registry()) {
+        for (auto& counter : shard->counters) {
+            counter.store(0, std::memory_order_relaxed);
+        }
+        for (auto& timer : shard->timers) {
+            for (auto& bucket : timer.buckets) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+            timer.totalCount.store(0, std::memory_order_relaxed);
+            timer.totalNs.store(0, std::memory_order_relaxed);
+            timer.maxNs.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+const char* Metrics::counterName(MetricCounter counter) {
+    return kCounterNames[static_cast<size_t>(counter)];
+}
+
+const char* Metrics::timerName(MetricTimer timer) {
+    return kTimerNames[static_cast<size_t>(timer)];
+}
+
+bool Metrics::exportToFile(const std::string& filename, Format format) {
+    MetricsSnapshot snap = snapshot();
+    std::string body = format == Format::Prometheus ? snap.toPrometheus() : snap.toJson();
+
+    // Write next to the target and rename so scrapers never see a partial file.
+    std::string tmpName = filename + ".tmp";
+    {
+        std::ofstream file(tmpName);
+        if (!file.is_open()) {
+            return false;
+        }
+        file << body;
+        if (!file) {
+            return false;
+        }
+    }
+    return std::rename(tmpName.c_str(), filename.c_str()) == 0;
+}
+
+bool Metrics::exportToSocket(const std::string& address, Format format) {
+#ifdef _WIN32
+    (void)address;
+    (void)format;
+    return false;
+#else
+    MetricsSnapshot snap = snapshot();
+    std::string body = format == Format::Prometheus ? snap.toPrometheus() : snap.toJson();
+
+    int fd = -1;
+    if (address.rfind("unix:", 0) == 0) {
+        std::string path = address.substr(5);
+        sockaddr_un addr;
+        std::memset(&addr, 0, sizeof(addr));
+        if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+            return false;
+        }
+        addr.sun_family = AF_UNIX;
+        std::memcpy(addr.sun_path, path.c_str(), path.size());
+
+        fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            return false;
+        }
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            ::close(fd);
+            return false;
+        }
+    } else {
+        size_t colon = address.rfind(':');
+        if (colon == std::string::npos) {
+            return false;
+        }
+        std::string host = address.substr(0, colon);
+        std::string port = address.substr(colon + 1);
+
+        addrinfo hints;
+        std::memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* results = nullptr;
+        if (::getaddrinfo(host.c_str(), port.c_str(), &hints, &results) != 0) {
+            return false;
+        }
+        for (addrinfo* ai = results; ai; ai = ai->ai_next) {
+            fd = ::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+            if (fd < 0) {
+                continue;
+            }
+            if (::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+                break;
+            }
+            ::close(fd);
+            fd = -1;
+        }
+        ::freeaddrinfo(results);
+        if (fd < 0) {
+            return false;
+        }
+    }
+
+    const char* data = body.data();
+    size_t remaining = body.size();
+    while (remaining > 0) {
+        ssize_t sent = ::send(fd, data, remaining, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            ::close(fd);
+            return false;
+        }
+        data += sent;
+        remaining -= static_cast<size_t>(sent);
+    }
+    ::close(fd);
+    return true;
+#endif
+}
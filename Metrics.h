@@ -0,0 +1,170 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Hot-path instrumentation: per-thread counters and HDR-style latency
+// histograms. Recording only touches the calling thread's shard, so the cost is
+// a clock read plus a couple of uncontended stores. Build with
+// -DPORTFOLIO_NO_METRICS (make METRICS=0) to compile the macros out entirely.
+
+enum class MetricCounter : std::uint8_t {
+    TicksApplied,
+    TicksRejected,
+    InvestmentsAdded,
+    InvestmentsMerged,
+    InvestmentsRemoved,
+    PositionsLoaded,
+    PositionsSkipped,
+    PositionsSaved,
+    PositionsExported,
+    AlertsTriggered,
+    Count
+};
+
+enum class MetricTimer : std::uint8_t {
+    UpdateStockPrice,
+    UpdateStockPrices,
+    AddInvestment,
+    RemoveInvestment,
+    RemoveShares,
+    LoadFromFile,
+    SaveToFile,
+    ExportToCSV,
+    ExportColumnar,
+    LoadColumnar,
+    StreamAggregate,
+    SnapshotSlice,
+    ScenarioRun,
+    HarvestScan,
+    OptionReprice,
+    RelativeAnalytics,
+    GetCurrentValue,
+    GetTotalGainLoss,
+    GetAverageReturn,
+    GetTopPerformers,
+    GetLosers,
+    SortInvestments,
+    GroupBy,
+    Query,
+    Count
+};
+
+struct HistogramSnapshot;
+
+// Log-linear histogram of nanosecond latencies. Values below 64ns are exact;
+// above that each power of two is split into 32 sub-buckets, bounding the
+// relative error of any reported percentile to about 3%.
+class LatencyHistogram {
+public:
+    static constexpr int kSubBucketBits = 5;
+    static constexpr int kSubBuckets = 1 << kSubBucketBits;
+    static constexpr int kMaxMagnitude = 44;  // ~4.9 hours in ns; larger values clamp
+    static constexpr int kBucketCount = 2 * kSubBuckets + (kMaxMagnitude - kSubBucketBits - 1) * kSubBuckets;
+
+private:
+    std::atomic<std::uint64_t> buckets[kBucketCount];
+    std::atomic<std::uint64_t> totalCount;
+    std::atomic<std::uint64_t> totalNs;
+    std::atomic<std::uint64_t> maxNs;
+
+public:
+    LatencyHistogram();
+
+    static int bucketIndex(std::uint64_t ns);
+    static std::uint64_t bucketUpperBound(int index);
+
+    // Single writer (the owning thread); readers may run concurrently.
+    void record(std::uint64_t ns) {
+        auto bump = [](std::atomic<std::uint64_t>& slot, std::uint64_t by) {
+            slot.store(slot.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+        };
+        bump(buckets[bucketIndex(ns)], 1);
+        bump(totalCount, 1);
+        bump(totalNs, ns);
+        if (ns > maxNs.load(std::memory_order_relaxed)) {
+            maxNs.store(ns, std::memory_order_relaxed);
+        }
+    }
+
+    // Adds this histogram's counts to a snapshot (sized to kBucketCount)
+    void mergeInto(HistogramSnapshot& snapshot) const;
+
+    friend class Metrics;
+};
+
+// Merged, immutable view of every thread's shard.
+struct HistogramSnapshot {
+    std::vector<std::uint64_t> buckets;
+    std::uint64_t count = 0;
+    std::uint64_t sumNs = 0;
+    std::uint64_t maxNs = 0;
+
+    double percentileNs(double percentile) const;
+    double meanNs() const;
+};
+
+struct MetricsSnapshot {
+    std::vector<std::uint64_t> counters;
+    std::vector<HistogramSnapshot> timers;
+
+    std::string toPrometheus() const;
+    std::string toJson() const;
+};
+
+class Metrics {
+public:
+    enum class Format { Prometheus, Json };
+
+    static void increment(MetricCounter counter, std::uint64_t by = 1);
+    static void recordLatency(MetricTimer timer, std::uint64_t ns);
+
+    static MetricsSnapshot snapshot();
+    static void reset();
+
+    static const char* counterName(MetricCounter counter);
+    static const char* timerName(MetricTimer timer);
+
+    // Writes a snapshot to a local file, replacing it atomically.
+    static bool exportToFile(const std::string& filename, Format format);
+    // Sends a snapshot to "unix:/path/to/socket" or "host:port" (TCP).
+    static bool exportToSocket(const std::string& address, Format format);
+};
+
+// Records the lifetime of the enclosing scope into a latency histogram.
+class ScopedMetricTimer {
+private:
+    MetricTimer timer;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    explicit ScopedMetricTimer(MetricTimer timer)
+        : timer(timer), start(std::chrono::steady_clock::now()) {}
+    ~ScopedMetricTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        Metrics::recordLatency(timer, static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+    ScopedMetricTimer(const ScopedMetricTimer&) = delete;
+    ScopedMetricTimer& operator=(const ScopedMetricTimer&) = delete;
+};
+
+#define PORTFOLIO_METRICS_CONCAT_INNER(a, b) a##b
+#define PORTFOLIO_METRICS_CONCAT(a, b) PORTFOLIO_METRICS_CONCAT_INNER(a, b)
+
+#ifdef PORTFOLIO_NO_METRICS
+#define METRIC_TIME_SCOPE(timer) do { } while (0)
+#define METRIC_INCREMENT(counter) do { } while (0)
+#define METRIC_ADD(counter, by) do { } while (0)
+#else
+#define METRIC_TIME_SCOPE(timer) \
+    ScopedMetricTimer PORTFOLIO_METRICS_CONCAT(metricScope_, __LINE__)(MetricTimer::timer)
+#define METRIC_INCREMENT(counter) Metrics::increment(MetricCounter::counter)
+#define METRIC_ADD(counter, by) Metrics::increment(MetricCounter::counter, (by))
+#endif
+
+#endif // METRICS_H
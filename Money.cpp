@@ -0,0 +1,237 @@
+#include "Money.h"
+#include <cctype>
+#include <cmath>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+
+namespace {
+
+using Wide = __int128;
+
+// Divides with round-half-to-even; the quotient must fit in 64 bits.
+std::int64_t divideRounded(Wide numerator, Wide denominator) {
+    Wide quotient = numerator / denominator;
+    Wide remainder = numerator % denominator;
+    if (remainder != 0) {
+        Wide twiceRemainder = remainder < 0 ? -2 * remainder : 2 * remainder;
+        Wide absDenominator = denominator < 0 ? -denominator : denominator;
+        if (twiceRemainder > absDenominator || (twiceRemainder == absDenominator && (quotient & 1) != 0)) {
+            quotient += ((numerator < 0) != (denominator < 0)) ? -1 : 1;
+        }
+    }
+    if (quotient > std::numeric_limits<std::int64_t>::max() ||
+        quotient < std::numeric_limits<std::int64_t>::min()) {
+        throw std::overflow_error("Money value out of range");
+    }
+    return static_cast<std::int64_t>(quotient);
+}
+
+std::string formatUnits(std::int64_t units, int decimals, std::int64_t scale) {
+    bool negative = units < 0;
+    std::uint64_t magnitude = negative ? 0 - static_cast<std::uint64_t>(units) : static_cast<std::uint64_t>(units);
+    std::uint64_t whole = magnitude / static_cast<std::uint64_t>(scale);
+    std::uint64_t fraction = magnitude % static_cast<std::uint64_t>(scale);
+
+    std::string text = negative ? "-" : "";
+    text += std::to_string(whole);
+    if (decimals > 0) {
+        std::string digits = std::to_string(fraction);
+        text += '.';
+        text.append(static_cast<size_t>(decimals) - digits.size(), '0');
+        text += digits;
+    }
+    return text;
+}
+
+} // namespace
+
+// Factories
+Money Money::fromDouble(double amount) {
+    if (!std::isfinite(amount)) {
+        throw std::invalid_argument("Money amount must be finite");
+    }
+    double scaled = std::nearbyint(amount * static_cast<double>(kScale));
+    if (std::fabs(scaled) >= 9.2e18) {
+        throw std::overflow_error("Money value out of range");
+    }
+    return Money(static_cast<std::int64_t>(scaled), true);
+}
+
+Money Money::fromString(const std::string& text) {
+    Money result;
+    if (!tryParse(text, result)) {
+        throw std::invalid_argument("Invalid money amount: " + text);
+    }
+    return result;
+}
+
+// Parses plain decimal text exactly; digits beyond kDecimals are rounded
+// half-to-even. Exponent notation (as written by older save files) goes through
+// double conversion.
+bool Money::tryParse(const std::string& text, Money& result) {
+    size_t pos = 0;
+    size_t end = text.size();
+    while (pos < end && std::isspace(static_cast<unsigned char>(text[pos]))) {
+        ++pos;
+    }
+    while (end > pos && std::isspace(static_cast<unsigned char>(text[end - 1]))) {
+        --end;
+    }
+    if (pos == end) {
+        return false;
+    }
+    if (text.find_first_of("eE", pos) < end) {
+        try {
+            size_t used = 0;
+            double value = std::stod(text.substr(pos, end - pos), &used);
+            if (used != end - pos) {
+                return false;
+            }
+            result = fromDouble(value);
+            return true;
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+
+    bool negative = false;
+    if (text[pos] == '-' || text[pos] == '+') {
+        negative = text[pos] == '-';
+        ++pos;
+    }
+
+    Wide value = 0;
+    int fractionDigits = 0;
+    bool sawDigit = false;
+    bool sawPoint = false;
+    int roundDigit = -1;      // first digit past kDecimals
+    bool stickyNonZero = false;  // any non-zero digit after roundDigit
+
+    for (; pos < end; ++pos) {
+        char c = text[pos];
+        if (c == '.') {
+            if (sawPoint) {
+                return false;
+            }
+            sawPoint = true;
+            continue;
+        }
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        sawDigit = true;
+        int digit = c - '0';
+        if (sawPoint && fractionDigits >= kDecimals) {
+            if (roundDigit < 0) {
+                roundDigit = digit;
+            } else if (digit != 0) {
+                stickyNonZero = true;
+            }
+            continue;
+        }
+        value = value * 10 + digit;
+        if (sawPoint) {
+            ++fractionDigits;
+        }
+        if (value > static_cast<Wide>(std::numeric_limits<std::int64_t>::max())) {
+            return false;
+        }
+    }
+    if (!sawDigit) {
+        return false;
+    }
+
+    for (; fractionDigits < kDecimals; ++fractionDigits) {
+        value *= 10;
+    }
+    if (roundDigit > 5 || (roundDigit == 5 && (stickyNonZero || (value & 1) != 0))) {
+        value += 1;
+    }
+    if (value > static_cast<Wide>(std::numeric_limits<std::int64_t>::max())) {
+        return false;
+    }
+
+    result = Money(static_cast<std::int64_t>(negative ? -value : value), true);
+    return true;
+}
+
+// Formatting
+std::string Money::toString() const {
+    std::string text = formatUnits(units, kDecimals, kScale);
+    if (kDecimals > 0) {
+        size_t last = text.find_last_not_of('0');
+        if (text[last] == '.') {
+            --last;
+        }
+        text.erase(last + 1);
+    }
+    return text;
+}
+
+std::string Money::toString(int decimals) const {
+    if (decimals < 0) {
+        decimals = 0;
+    }
+    if (decimals >= kDecimals) {
+        std::string text = formatUnits(units, kDecimals, kScale);
+        if (decimals > kDecimals) {
+            if (kDecimals == 0) {
+                text += '.';
+            }
+            text.append(static_cast<size_t>(decimals - kDecimals), '0');
+        }
+        return text;
+    }
+    std::int64_t rounded = divideRounded(units, moneyPow10(kDecimals - decimals));
+    return formatUnits(rounded, decimals, moneyPow10(decimals));
+}
+
+// Checked arithmetic
+Money Money::checkedAdd(Money other) const {
+    std::int64_t sum;
+    if (__builtin_add_overflow(units, other.units, &sum)) {
+        throw std::overflow_error("Money value out of range");
+    }
+    return Money(sum, true);
+}
+
+Money Money::checkedSubtract(Money other) const {
+    std::int64_t difference;
+    if (__builtin_sub_overflow(units, other.units, &difference)) {
+        throw std::overflow_error("Money value out of range");
+    }
+    return Money(difference, true);
+}
+
+Money Money::checkedMultiply(std::int64_t quantity) const {
+    std::int64_t product;
+    if (__builtin_mul_overflow(units, quantity, &product)) {
+        throw std::overflow_error("Money value out of range");
+    }
+    return Money(product, true);
+}
+
+// Rounded arithmetic
+Money Money::operator/(std::int64_t divisor) const {
+    if (divisor == 0) {
+        throw std::invalid_argument("Money division by zero");
+    }
+    return Money(divideRounded(units, divisor), true);
+}
+
+Money Money::mulDiv(std::int64_t numerator, std::int64_t denominator) const {
+    if (denominator == 0) {
+        throw std::invalid_argument("Money division by zero");
+    }
+    return Money(divideRounded(static_cast<Wide>(units) * numerator, denominator), true);
+}
+
+// Stream output: rounds to the stream precision under std::fixed, otherwise
+// prints the exact value.
+std::ostream& operator<<(std::ostream& os, Money amount) {
+    if (os.flags() & std::ios_base::fixed) {
+        return os << amount.toString(static_cast<int>(os.precision()));
+    }
+    return os << amount.toString();
+}
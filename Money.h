@@ -0,0 +1,96 @@
+#ifndef MONEY_H
+#define MONEY_H
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+// Number of decimal places stored by Money. Override at build time with
+// -DPORTFOLIO_MONEY_DECIMALS=N (0..9); the default of 6 gives micro-dollar
+// resolution and a range of about +/-9.2 trillion.
+#ifndef PORTFOLIO_MONEY_DECIMALS
+#define PORTFOLIO_MONEY_DECIMALS 6
+#endif
+
+constexpr std::int64_t moneyPow10(int exponent) {
+    return exponent <= 0 ? 1 : 10 * moneyPow10(exponent - 1);
+}
+
+// Fixed-point monetary amount stored as a signed 64-bit count of 10^-N units.
+// Addition, subtraction and multiplication by share counts are exact, so
+// aggregate totals are identical regardless of summation order. Division and
+// conversion from double round half-to-even; text output rounds to the
+// stream's precision only when std::fixed is set.
+class Money {
+public:
+    static constexpr int kDecimals = PORTFOLIO_MONEY_DECIMALS;
+    static_assert(kDecimals >= 0 && kDecimals <= 9, "PORTFOLIO_MONEY_DECIMALS must be in [0, 9]");
+
+    static constexpr std::int64_t kScale = moneyPow10(kDecimals);
+
+private:
+    std::int64_t units;
+
+    constexpr explicit Money(std::int64_t units, bool) : units(units) {}
+
+public:
+    constexpr Money() : units(0) {}
+
+    // Factories
+    static constexpr Money fromUnits(std::int64_t units) { return Money(units, true); }
+    static constexpr Money fromWhole(std::int64_t amount) { return Money(amount * kScale, true); }
+    static Money fromDouble(double amount);
+    static Money fromString(const std::string& text);
+    static bool tryParse(const std::string& text, Money& result);
+
+    // Accessors
+    constexpr std::int64_t raw() const { return units; }
+    double toDouble() const { return static_cast<double>(units) / static_cast<double>(kScale); }
+    constexpr bool isZero() const { return units == 0; }
+    constexpr bool isNegative() const { return units < 0; }
+
+    // Exact decimal text, trailing zeros trimmed ("150.25", "-3", "0.000001")
+    std::string toString() const;
+    // Rounded to the given number of decimals (half-to-even), zero padded
+    std::string toString(int decimals) const;
+
+    // Exact arithmetic
+    constexpr Money operator+(Money other) const { return Money(units + other.units, true); }
+    constexpr Money operator-(Money other) const { return Money(units - other.units, true); }
+    constexpr Money operator-() const { return Money(-units, true); }
+    constexpr Money operator*(std::int64_t quantity) const { return Money(units * quantity, true); }
+    Money& operator+=(Money other) { units += other.units; return *this; }
+    Money& operator-=(Money other) { units -= other.units; return *this; }
+
+    // Checked arithmetic: exact like the operators above, but throws
+    // std::overflow_error when the result does not fit instead of wrapping
+    Money checkedAdd(Money other) const;
+    Money checkedSubtract(Money other) const;
+    Money checkedMultiply(std::int64_t quantity) const;
+
+    // Rounded arithmetic (half-to-even, 128-bit intermediates)
+    Money operator/(std::int64_t divisor) const;
+    Money mulDiv(std::int64_t numerator, std::int64_t denominator) const;
+
+    // Ratio of two amounts as a double, 0 when the divisor is zero
+    static double ratio(Money numerator, Money denominator) {
+        return denominator.units == 0 ? 0.0
+                                      : static_cast<double>(numerator.units) / static_cast<double>(denominator.units);
+    }
+
+    // Comparison
+    constexpr bool operator==(Money other) const { return units == other.units; }
+    constexpr bool operator!=(Money other) const { return units != other.units; }
+    constexpr bool operator<(Money other) const { return units < other.units; }
+    constexpr bool operator<=(Money other) const { return units <= other.units; }
+    constexpr bool operator>(Money other) const { return units > other.units; }
+    constexpr bool operator>=(Money other) const { return units >= other.units; }
+};
+
+constexpr Money operator*(std::int64_t quantity, Money amount) {
+    return amount * quantity;
+}
+
+std::ostream& operator<<(std::ostream& os, Money amount);
+
+#endif // MONEY_H
@@ -0,0 +1,486 @@
+#include "OptionBook.h"
+#include "Calendar.h"
+#include "Metrics.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+constexpr double kDaysPerYear = 365.0;
+// Each underlying's rows start on a multiple of this and are padded out to
+// one, so the kernel runs whole vectors (8 doubles in a 512-bit register)
+// with no scalar remainder loop
+constexpr size_t kRowBlock = 8;
+constexpr size_t kPaddingRow = static_cast<size_t>(-1);
+
+size_t roundUp(size_t rows) {
+    return (rows + kRowBlock - 1) / kRowBlock * kRowBlock;
+}
+
+std::string trim(const std::string& text) {
+    size_t begin = 0;
+    size_t end = text.size();
+    while (begin < end && std::isspace(static_cast<unsigned char>(text[begin]))) {
+        ++begin;
+    }
+    while (end > begin && std::isspace(static_cast<unsigned char>(text[end - 1]))) {
+        --end;
+    }
+    return text.substr(begin, end - begin);
+}
+
+std::string lower(std::string text) {
+    for (char& c : text) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return text;
+}
+
+bool parseNumber(const std::string& text, double& value) {
+    if (text.empty()) {
+        return false;
+    }
+    char* end = nullptr;
+    value = std::strtod(text.c_str(), &end);
+    return *end == '\0';
+}
+
+} // namespace
+
+OptionBook::OptionBook() : riskFreeRate(0.0), valuationDay(calendar::today()), prepared(true), attached(nullptr) {}
+
+OptionBook::~OptionBook() {
+    detach();
+}
+
+std::uint32_t OptionBook::underlyingFor(const std::string& symbol) {
+    auto it = underlyingBySymbol.find(symbol);
+    if (it != underlyingBySymbol.end()) {
+        return it->second;
+    }
+    const std::uint32_t index = static_cast<std::uint32_t>(underlyings.size());
+    underlyings.emplace_back();
+    underlyings.back().symbol = symbol;
+    underlyingBySymbol.emplace(symbol, index);
+    return index;
+}
+
+void OptionBook::markDirty(std::uint32_t index) {
+    // Before prepare() runs every underlying is repriced anyway
+    if (prepared && !underlyings[index].dirty) {
+        underlyings[index].dirty = true;
+        dirtyUnderlyings.push_back(index);
+    }
+}
+
+void OptionBook::fillRow(size_t row) {
+    Position& position = positions[positionOf[row]];
+    const Underlying& underlying = underlyings[position.underlying];
+    const double t = (position.contract.expiryDay - valuationDay) / kDaysPerYear;
+    const optionpricing::BlackScholesRow inputs =
+        optionpricing::prepareRow(position.contract.type, position.contract.strike.toDouble(), t, riskFreeRate,
+                                  underlying.dividendYield, position.volatility);
+    sign[row] = inputs.sign;
+    logStrike[row] = inputs.logStrike;
+    drift[row] = inputs.drift;
+    volRootT[row] = inputs.volRootT;
+    strikeDiscount[row] = inputs.strikeDiscount;
+    spotDiscount[row] = inputs.spotDiscount;
+    years[row] = t;
+    invRootYears[row] = inputs.invRootYears;
+    if (position.contract.style == ExerciseStyle::American) {
+        position.american =
+            optionpricing::prepareAmericanRow(position.contract.type, position.contract.strike.toDouble(), t,
+                                              riskFreeRate, underlying.dividendYield, position.volatility);
+    }
+}
+
+// Lays the rows out grouped by underlying (in insertion order within each,
+// each group padded to kRowBlock rows) and fills every spot-independent column
+void OptionBook::prepare() {
+    std::vector<size_t> order(positions.size());
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::stable_sort(order.begin(), order.end(),
+                     [this](size_t a, size_t b) { return positions[a].underlying < positions[b].underlying; });
+
+    for (Underlying& underlying : underlyings) {
+        underlying.begin = underlying.end = 0;
+        underlying.hasAmerican = false;
+    }
+    positionOf.clear();
+    rowOf.resize(positions.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        const Position& position = positions[order[i]];
+        Underlying& underlying = underlyings[position.underlying];
+        if (i == 0 || position.underlying != positions[order[i - 1]].underlying) {
+            positionOf.resize(roundUp(positionOf.size()), kPaddingRow);
+            underlying.begin = positionOf.size();
+        }
+        rowOf[order[i]] = positionOf.size();
+        positionOf.push_back(order[i]);
+        underlying.end = positionOf.size();
+        underlying.hasAmerican |= position.contract.style == ExerciseStyle::American;
+    }
+    positionOf.resize(roundUp(positionOf.size()), kPaddingRow);
+
+    // Padding rows price as harmless expired calls
+    const size_t rows = positionOf.size();
+    for (std::vector<double>* column : {&sign, &volRootT, &invRootYears}) {
+        column->assign(rows, 1.0);
+    }
+    for (std::vector<double>* column : {&logStrike, &drift, &strikeDiscount, &spotDiscount, &years, &price,
+                                        &delta, &gamma, &vega, &theta, &rho}) {
+        column->assign(rows, 0.0);
+    }
+    prepared = true;
+    refillAll();
+}
+
+void OptionBook::priceUnderlying(std::uint32_t index) {
+    const Underlying& underlying = underlyings[index];
+    const size_t begin = underlying.begin;
+    const size_t end = underlying.end;
+    if (begin == end) {
+        return;
+    }
+    if (!underlying.hasSpot) {
+        for (std::vector<double>* column : {&price, &delta, &gamma, &vega, &theta, &rho}) {
+            std::fill(column->begin() + begin, column->begin() + end, 0.0);
+        }
+        return;
+    }
+
+    const double s = underlying.spot;
+    BlackScholesColumns columns;
+    columns.sign = sign.data();
+    columns.logStrike = logStrike.data();
+    columns.drift = drift.data();
+    columns.volRootT = volRootT.data();
+    columns.strikeDiscount = strikeDiscount.data();
+    columns.spotDiscount = spotDiscount.data();
+    columns.years = years.data();
+    columns.invRootYears = invRootYears.data();
+    columns.price = price.data();
+    columns.delta = delta.data();
+    columns.gamma = gamma.data();
+    columns.vega = vega.data();
+    columns.theta = theta.data();
+    columns.rho = rho.data();
+    optionpricing::blackScholesBatch(columns, s, riskFreeRate, underlying.dividendYield, begin,
+                                     begin + roundUp(end - begin));
+
+    if (!underlying.hasAmerican) {
+        return;
+    }
+    for (size_t row = begin; row < end; ++row) {
+        const Position& position = positions[positionOf[row]];
+        if (position.contract.style != ExerciseStyle::American) {
+            continue;
+        }
+        const OptionGreeks european{price[row], delta[row], gamma[row], vega[row], theta[row], rho[row]};
+        const OptionGreeks greeks = optionpricing::baroneAdesiWhaley(
+            position.contract.type, position.american, s, position.contract.strike.toDouble(), years[row],
+            riskFreeRate, underlying.dividendYield, position.volatility, european);
+        price[row] = greeks.price;
+        delta[row] = greeks.delta;
+        gamma[row] = greeks.gamma;
+        vega[row] = greeks.vega;
+        theta[row] = greeks.theta;
+        rho[row] = greeks.rho;
+    }
+}
+
+// Positions
+void OptionBook::addPosition(const OptionContract& contract, double contracts, Money premium,
+                             double volatility) {
+    if (contract.strike.raw() <= 0) {
+        throw std::invalid_argument("Option strike must be positive: " + contract.symbol);
+    }
+    if (contract.multiplier <= 0) {
+        throw std::invalid_argument("Option multiplier must be positive: " + contract.symbol);
+    }
+    if (!(volatility >= 0.0)) {
+        throw std::invalid_argument("Option volatility cannot be negative: " + contract.symbol);
+    }
+    Position position{contract, contracts, premium, volatility, underlyingFor(contract.underlying), {}};
+    auto it = positionBySymbol.find(contract.symbol);
+    if (it != positionBySymbol.end()) {
+        positions[it->second] = std::move(position);
+    } else {
+        positionBySymbol.emplace(contract.symbol, positions.size());
+        positions.push_back(std::move(position));
+    }
+    prepared = false;
+}
+
+bool OptionBook::removePosition(const std::string& symbol) {
+    auto it = positionBySymbol.find(symbol);
+    if (it == positionBySymbol.end()) {
+        return false;
+    }
+    const size_t index = it->second;
+    positionBySymbol.erase(it);
+    if (index + 1 != positions.size()) {
+        positions[index] = std::move(positions.back());
+        positionBySymbol[positions[index].contract.symbol] = index;
+    }
+    positions.pop_back();
+    prepared = false;
+    return true;
+}
+
+bool OptionBook::setVolatility(const std::string& symbol, double volatility) {
+    auto it = positionBySymbol.find(symbol);
+    if (it == positionBySymbol.end() || !(volatility >= 0.0)) {
+        return false;
+    }
+    Position& position = positions[it->second];
+    position.volatility = volatility;
+    if (prepared) {
+        fillRow(rowOf[it->second]);
+        markDirty(position.underlying);
+    }
+    return true;
+}
+
+void OptionBook::clear() {
+    positions.clear();
+    positionBySymbol.clear();
+    prepared = false;
+}
+
+// Market inputs
+void OptionBook::refillAll() {
+    if (prepared) {
+        for (std::uint32_t index = 0; index < underlyings.size(); ++index) {
+            for (size_t row = underlyings[index].begin; row < underlyings[index].end; ++row) {
+                fillRow(row);
+            }
+            markDirty(index);
+        }
+    }
+}
+
+void OptionBook::setRate(double rate) {
+    riskFreeRate = rate;
+    refillAll();
+}
+
+void OptionBook::setDividendYield(const std::string& underlyingSymbol, double yield) {
+    const std::uint32_t index = underlyingFor(underlyingSymbol);
+    underlyings[index].dividendYield = yield;
+    if (prepared) {
+        for (size_t row = underlyings[index].begin; row < underlyings[index].end; ++row) {
+            fillRow(row);
+        }
+        markDirty(index);
+    }
+}
+
+void OptionBook::setValuationDay(int day) {
+    valuationDay = day;
+    refillAll();
+}
+
+void OptionBook::setSpot(const std::string& underlyingSymbol, Money value) {
+    const std::uint32_t index = underlyingFor(underlyingSymbol);
+    underlyings[index].spot = value.toDouble();
+    underlyings[index].hasSpot = underlyings[index].spot > 0.0;
+    markDirty(index);
+}
+
+void OptionBook::attach(Portfolio& portfolio) {
+    detach();
+    attached = &portfolio;
+    portfolio.addTickListener(this);
+    for (const Investment& investment : static_cast<const Portfolio&>(portfolio)) {
+        const Stock* stock = investment.getStock().get();
+        if (stock && underlyingBySymbol.count(stock->getSymbol())) {
+            setSpot(stock->getSymbol(), stock->getCurrentPrice());
+        }
+    }
+    reprice();
+}
+
+void OptionBook::detach() {
+    if (attached) {
+        attached->removeTickListener(this);
+        attached = nullptr;
+    }
+}
+
+size_t OptionBook::reprice() {
+    METRIC_TIME_SCOPE(OptionReprice);
+    if (!prepared) {
+        prepare();
+    }
+    size_t rows = 0;
+    for (std::uint32_t index : dirtyUnderlyings) {
+        priceUnderlying(index);
+        underlyings[index].dirty = false;
+        rows += underlyings[index].end - underlyings[index].begin;
+    }
+    dirtyUnderlyings.clear();
+    return rows;
+}
+
+// Results
+OptionGreeks OptionBook::getGreeks(const std::string& symbol) const {
+    auto it = positionBySymbol.find(symbol);
+    return it == positionBySymbol.end() ? OptionGreeks() : getGreeks(it->second);
+}
+
+OptionGreeks OptionBook::getGreeks(size_t position) const {
+    OptionGreeks greeks;
+    if (!prepared) {
+        return greeks;
+    }
+    const size_t row = rowOf[position];
+    greeks.price = price[row];
+    greeks.delta = delta[row];
+    greeks.gamma = gamma[row];
+    greeks.vega = vega[row];
+    greeks.theta = theta[row];
+    greeks.rho = rho[row];
+    return greeks;
+}
+
+Money OptionBook::getMarketValue(size_t position) const {
+    if (!prepared) {
+        return Money();
+    }
+    const Position& held = positions[position];
+    return Money::fromDouble(price[rowOf[position]] * held.contracts * held.contract.multiplier);
+}
+
+Money OptionBook::getTotalValue() const {
+    Money total;
+    for (size_t position = 0; position < positions.size(); ++position) {
+        total += getMarketValue(position);
+    }
+    return total;
+}
+
+Money OptionBook::getTotalCost() const {
+    Money total;
+    for (const Position& position : positions) {
+        total += Money::fromDouble(position.premium.toDouble() * position.contracts * position.contract.multiplier);
+    }
+    return total;
+}
+
+double OptionBook::getNetDelta(const std::string& underlyingSymbol) const {
+    auto it = underlyingBySymbol.find(underlyingSymbol);
+    if (it == underlyingBySymbol.end() || !prepared) {
+        return 0.0;
+    }
+    const Underlying& underlying = underlyings[it->second];
+    double net = 0.0;
+    for (size_t row = underlying.begin; row < underlying.end; ++row) {
+        const Position& position = positions[positionOf[row]];
+        net += delta[row] * position.contracts * position.contract.multiplier;
+    }
+    return net;
+}
+
+bool OptionBook::loadFromCSV(const std::string& filename) {
+    std::ifstream file(filename);
+    std::string line;
+    if (!file.is_open() || !std::getline(file, line)) {
+        return false;
+    }
+
+    while (std::getline(file, line)) {
+        if (trim(line).empty()) {
+            continue;
+        }
+        std::stringstream ss(line);
+        std::vector<std::string> cells;
+        std::string cell;
+        while (std::getline(ss, cell, ',')) {
+            cells.push_back(trim(cell));
+        }
+        if (cells.size() != 9) {
+            return false;
+        }
+
+        OptionContract contract;
+        contract.symbol = cells[0];
+        contract.underlying = cells[1];
+        const std::string type = lower(cells[2]);
+        const std::string style = lower(cells[3]);
+        if (type == "call") {
+            contract.type = OptionType::Call;
+        } else if (type == "put") {
+            contract.type = OptionType::Put;
+        } else {
+            return false;
+        }
+        if (style == "european") {
+            contract.style = ExerciseStyle::European;
+        } else if (style == "american") {
+            contract.style = ExerciseStyle::American;
+        } else {
+            return false;
+        }
+        double strike = 0.0, contracts = 0.0, premium = 0.0, volatility = 0.0;
+        if (contract.symbol.empty() || contract.underlying.empty() || !parseNumber(cells[4], strike) ||
+            !calendar::parseDay(cells[5], contract.expiryDay) || !parseNumber(cells[6], contracts) ||
+            !parseNumber(cells[7], premium) || !parseNumber(cells[8], volatility)) {
+            return false;
+        }
+        contract.strike = Money::fromDouble(strike);
+        try {
+            addPosition(contract, contracts, Money::fromDouble(premium), volatility);
+        } catch (const std::invalid_argument&) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// TickListener
+void OptionBook::onTick(const Investment& investment, Money) {
+    const Stock* stock = investment.getStock().get();
+    if (!stock) {
+        return;
+    }
+    auto it = underlyingBySymbol.find(stock->getSymbol());
+    if (it != underlyingBySymbol.end()) {
+        underlyings[it->second].spot = stock->getCurrentPrice().toDouble();
+        underlyings[it->second].hasSpot = underlyings[it->second].spot > 0.0;
+        markDirty(it->second);
+    }
+}
+
+void OptionBook::onBatchEnd() {
+    reprice();
+}
+
+void OptionBook::onSplit(const Investment& investment, SplitRatio ratio) {
+    const Stock* stock = investment.getStock().get();
+    if (!stock) {
+        return;
+    }
+    auto it = underlyingBySymbol.find(stock->getSymbol());
+    if (it == underlyingBySymbol.end()) {
+        return;
+    }
+    const double scale = static_cast<double>(ratio.numerator) / static_cast<double>(ratio.denominator);
+    for (Position& position : positions) {
+        if (position.underlying == it->second) {
+            Money strike = position.contract.strike.mulDiv(ratio.denominator, ratio.numerator);
+            position.contract.strike = std::max(strike, Money::fromUnits(1));
+            position.premium = position.premium.mulDiv(ratio.denominator, ratio.numerator);
+            position.contracts *= scale;
+        }
+    }
+    prepared = false;  // Strikes feed the precomputed columns
+    onTick(investment, Money());
+}
@@ -0,0 +1,142 @@
+#ifndef OPTION_BOOK_H
+#define OPTION_BOOK_H
+
+#include "OptionPricing.h"
+#include "Portfolio.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// A listed option on a Stock the portfolio may hold. expiryDay counts days
+// since 1970-01-01 (see Calendar.h); multiplier is shares per contract.
+struct OptionContract {
+    std::string symbol;
+    std::string underlying;
+    OptionType type = OptionType::Call;
+    ExerciseStyle style = ExerciseStyle::European;
+    Money strike;
+    int expiryDay = 0;
+    int multiplier = 100;
+};
+
+// Option positions priced off their underlyings' live prices. Rows are kept
+// as columns grouped by underlying, with everything that does not depend on
+// the spot computed once, so a tick on one Stock reprices just that Stock's
+// contiguous range of options with the vectorized Black-Scholes kernel
+// (American rows then add the Barone-Adesi-Whaley early-exercise premium,
+// whose boundary is also solved once per contract). Attached to a Portfolio
+// it follows ticks as a TickListener: onTick records the new spot and
+// onBatchEnd reprices each underlying that moved. Splits of an underlying
+// adjust its contracts the way exchanges do (see onSplit). Amounts are in the
+// underlyings' quote currency; the book does not convert. Not thread-safe.
+class OptionBook : public TickListener {
+private:
+    struct Position {
+        OptionContract contract;
+        double contracts;
+        Money premium;  // Paid (or received, when short) per share
+        double volatility;
+        std::uint32_t underlying;
+        optionpricing::AmericanRow american;  // American contracts, once prepared
+    };
+
+    struct Underlying {
+        std::string symbol;
+        double spot = 0.0;
+        double dividendYield = 0.0;
+        size_t begin = 0, end = 0;  // Rows, once prepared
+        bool hasSpot = false;
+        bool dirty = false;
+        bool hasAmerican = false;
+    };
+
+    std::vector<Position> positions;
+    std::unordered_map<std::string, size_t> positionBySymbol;
+    std::vector<Underlying> underlyings;
+    std::unordered_map<std::string, std::uint32_t> underlyingBySymbol;
+    std::vector<std::uint32_t> dirtyUnderlyings;
+
+    // Row columns, ordered by underlying; rowOf maps position -> row
+    std::vector<size_t> rowOf;
+    std::vector<size_t> positionOf;
+    std::vector<double> sign, logStrike, drift, volRootT, strikeDiscount, spotDiscount, years, invRootYears;
+    std::vector<double> price, delta, gamma, vega, theta, rho;
+
+    double riskFreeRate;
+    int valuationDay;
+    bool prepared;  // Rows match positions (no add or remove since prepare)
+    Portfolio* attached;
+
+    std::uint32_t underlyingFor(const std::string& symbol);
+    void markDirty(std::uint32_t index);
+    void fillRow(size_t row);
+    void refillAll();
+    void prepare();
+    void priceUnderlying(std::uint32_t index);
+
+public:
+    OptionBook();
+    ~OptionBook() override;
+
+    OptionBook(const OptionBook&) = delete;
+    OptionBook& operator=(const OptionBook&) = delete;
+
+    // Positions. Negative contracts are short. Adding a symbol already held
+    // replaces it. Throws std::invalid_argument for a non-positive strike or
+    // multiplier, or a negative volatility.
+    void addPosition(const OptionContract& contract, double contracts, Money premium, double volatility);
+    bool removePosition(const std::string& symbol);
+    bool setVolatility(const std::string& symbol, double volatility);
+    void clear();
+    size_t size() const { return positions.size(); }
+    const OptionContract& getContract(size_t position) const { return positions[position].contract; }
+    double getContracts(size_t position) const { return positions[position].contracts; }
+
+    // Market inputs. Changing the rate, a dividend yield or the valuation day
+    // marks every affected row for the next reprice().
+    void setRate(double rate);
+    double getRate() const { return riskFreeRate; }
+    void setDividendYield(const std::string& underlying, double yield);
+    void setValuationDay(int day);
+    int getValuationDay() const { return valuationDay; }
+    // Spot for an underlying; marks its options for repricing
+    void setSpot(const std::string& underlying, Money price);
+
+    // Follows an (unowned) Portfolio's ticks, taking the current price of
+    // every underlying it holds. detach() is implied by destruction.
+    void attach(Portfolio& portfolio);
+    void detach();
+
+    // Reprices every underlying whose spot or inputs changed (all of them
+    // after structural changes); returns the number of rows priced
+    size_t reprice();
+
+    // Per-contract price and Greeks (per share, see OptionGreeks), as of the
+    // last reprice(). Zero for an unknown symbol, and for every position while
+    // an add or remove is waiting for reprice().
+    OptionGreeks getGreeks(const std::string& symbol) const;
+    OptionGreeks getGreeks(size_t position) const;
+    // price * contracts * multiplier
+    Money getMarketValue(size_t position) const;
+    Money getTotalValue() const;
+    Money getTotalCost() const;
+    // Share-equivalent exposure: sum of delta * contracts * multiplier
+    double getNetDelta(const std::string& underlying) const;
+
+    // CSV with a header and one row per position:
+    // symbol,underlying,type,style,strike,expiry,contracts,premium,volatility
+    // type is call/put, style european/american, expiry YYYY-MM-DD.
+    // Adds to the current positions; false if the file cannot be read or a
+    // row does not parse (rows before it are kept).
+    bool loadFromCSV(const std::string& filename);
+
+    // TickListener
+    void onTick(const Investment& investment, Money oldPrice) override;
+    void onBatchEnd() override;
+    // Strikes and premiums scale by old/new shares and the contract count by
+    // new/old, so each position's deliverable and cost stay the same
+    void onSplit(const Investment& investment, SplitRatio ratio) override;
+};
+
+#endif // OPTION_BOOK_H
@@ -0,0 +1,353 @@
+#include "OptionPricing.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace optionpricing {
+
+namespace {
+
+constexpr double kMinVolRootT = 1e-12;
+
+double referenceCdf(double x) {
+    return 0.5 * std::erfc(-x * 0.70710678118654752440);
+}
+
+double intrinsic(OptionType type, double spot, double strike) {
+    return std::max(0.0, type == OptionType::Call ? spot - strike : strike - spot);
+}
+
+// Value of the tree alone, and the nodes needed for delta, gamma and theta
+struct TreeResult {
+    double price = 0.0;
+    double up = 0.0, down = 0.0;                  // Step 1 values
+    double upUp = 0.0, middle = 0.0, downDown = 0.0;  // Step 2 values
+    double spotUp = 0.0, spotDown = 0.0, spotUpUp = 0.0, spotDownDown = 0.0;
+    double dt = 0.0;
+};
+
+TreeResult tree(OptionType type, ExerciseStyle style, double spot, double strike, double years, double rate,
+                double dividend, double volatility, int steps) {
+    TreeResult result;
+    steps = std::max(steps, 2);
+    const double dt = years / steps;
+    const double u = std::exp(volatility * std::sqrt(dt));
+    const double d = 1.0 / u;
+    const double growth = std::exp((rate - dividend) * dt);
+    const double p = std::min(1.0, std::max(0.0, (growth - d) / (u - d)));
+    const double discount = std::exp(-rate * dt);
+    const double sign = type == OptionType::Call ? 1.0 : -1.0;
+    const bool american = style == ExerciseStyle::American;
+
+    // values[j] is the node with j up moves at the current step
+    std::vector<double> values(static_cast<size_t>(steps) + 1);
+    const double u2 = u * u;
+    double nodeSpot = spot * std::pow(d, steps);
+    for (int j = 0; j <= steps; ++j) {
+        values[j] = std::max(0.0, sign * (nodeSpot - strike));
+        nodeSpot *= u2;
+    }
+    for (int step = steps - 1; step >= 0; --step) {
+        double lowest = spot * std::pow(d, step);
+        for (int j = 0; j <= step; ++j) {
+            double held = discount * (p * values[j + 1] + (1.0 - p) * values[j]);
+            values[j] = american ? std::max(held, sign * (lowest - strike)) : held;
+            lowest *= u2;
+        }
+        if (step == 2) {
+            result.downDown = values[0];
+            result.middle = values[1];
+            result.upUp = values[2];
+        } else if (step == 1) {
+            result.down = values[0];
+            result.up = values[1];
+        }
+    }
+    result.price = values[0];
+    result.spotUp = spot * u;
+    result.spotDown = spot * d;
+    result.spotUpUp = spot * u2;
+    result.spotDownDown = spot * d * d;
+    result.dt = dt;
+    return result;
+}
+
+} // namespace
+
+OptionGreeks blackScholes(OptionType type, double spot, double strike, double years, double rate,
+                          double dividend, double volatility) {
+    OptionGreeks greeks;
+    const double sign = type == OptionType::Call ? 1.0 : -1.0;
+    if (years <= 0.0 || volatility <= 0.0) {
+        // Expired, or deterministic: the forward's intrinsic value, discounted
+        const double forwardSpot = spot * std::exp(-dividend * std::max(years, 0.0));
+        const double forwardStrike = strike * std::exp(-rate * std::max(years, 0.0));
+        const bool inTheMoney = sign * (forwardSpot - forwardStrike) > 0.0;
+        greeks.price = inTheMoney ? sign * (forwardSpot - forwardStrike) : 0.0;
+        greeks.delta = inTheMoney ? sign * std::exp(-dividend * std::max(years, 0.0)) : 0.0;
+        greeks.rho = inTheMoney && years > 0.0 ? sign * forwardStrike * years : 0.0;
+        return greeks;
+    }
+    const double rootT = std::sqrt(years);
+    const double volRootT = volatility * rootT;
+    const double d1 = (std::log(spot / strike) + (rate - dividend + 0.5 * volatility * volatility) * years) / volRootT;
+    const double d2 = d1 - volRootT;
+    const double spotDiscount = std::exp(-dividend * years);
+    const double strikeDiscount = strike * std::exp(-rate * years);
+    const double nd1 = referenceCdf(sign * d1);
+    const double nd2 = referenceCdf(sign * d2);
+    const double density = 0.39894228040143267794 * std::exp(-0.5 * d1 * d1);
+
+    greeks.price = sign * (spot * spotDiscount * nd1 - strikeDiscount * nd2);
+    greeks.delta = sign * spotDiscount * nd1;
+    greeks.gamma = spotDiscount * density / (spot * volRootT);
+    greeks.vega = spot * spotDiscount * density * rootT;
+    greeks.theta = -spot * spotDiscount * density * volatility / (2.0 * rootT) - sign * rate * strikeDiscount * nd2 +
+                   sign * dividend * spot * spotDiscount * nd1;
+    greeks.rho = sign * strikeDiscount * years * nd2;
+    return greeks;
+}
+
+OptionGreeks binomial(OptionType type, ExerciseStyle style, double spot, double strike, double years,
+                      double rate, double dividend, double volatility, int steps) {
+    OptionGreeks greeks;
+    if (years <= 0.0 || volatility <= 0.0) {
+        if (style == ExerciseStyle::American || years <= 0.0) {
+            greeks = blackScholes(type, spot, strike, years, rate, dividend, volatility);
+            greeks.price = std::max(greeks.price, intrinsic(type, spot, strike));
+            return greeks;
+        }
+        return blackScholes(type, spot, strike, years, rate, dividend, volatility);
+    }
+    const TreeResult t = tree(type, style, spot, strike, years, rate, dividend, volatility, steps);
+    greeks.price = t.price;
+    greeks.delta = (t.up - t.down) / (t.spotUp - t.spotDown);
+    const double deltaUp = (t.upUp - t.middle) / (t.spotUpUp - spot);
+    const double deltaDown = (t.middle - t.downDown) / (spot - t.spotDownDown);
+    greeks.gamma = (deltaUp - deltaDown) / (0.5 * (t.spotUpUp - t.spotDownDown));
+    greeks.theta = (t.middle - t.price) / (2.0 * t.dt);
+
+    const double volBump = 1e-4;
+    const double rateBump = 1e-4;
+    greeks.vega = (tree(type, style, spot, strike, years, rate, dividend, volatility + volBump, steps).price -
+                   tree(type, style, spot, strike, years, rate, dividend, std::max(volatility - volBump, 1e-8), steps)
+                       .price) /
+                  (volatility + volBump - std::max(volatility - volBump, 1e-8));
+    greeks.rho = (tree(type, style, spot, strike, years, rate + rateBump, dividend, volatility, steps).price -
+                  tree(type, style, spot, strike, years, rate - rateBump, dividend, volatility, steps).price) /
+                 (2.0 * rateBump);
+    return greeks;
+}
+
+namespace {
+
+constexpr double kVolBump = 1e-4;
+constexpr double kRateBump = 1e-4;
+
+double bumpedDown(double volatility) {
+    return std::max(volatility - kVolBump, 1e-8);
+}
+
+// Price from a boundary at `spot`, given the European price there
+double americanPrice(OptionType type, const AmericanBoundary& boundary, double spot, double strike,
+                     double european) {
+    if (!boundary.early) {
+        return std::max(european, intrinsic(type, spot, strike));
+    }
+    const double sign = type == OptionType::Call ? 1.0 : -1.0;
+    if (sign * (spot - boundary.critical) >= 0.0) {
+        return sign * (spot - strike);
+    }
+    return european + boundary.coefficient * std::pow(spot / boundary.critical, boundary.exponent);
+}
+
+} // namespace
+
+AmericanBoundary americanBoundary(OptionType type, double strike, double years, double rate, double dividend,
+                                  double volatility) {
+    AmericanBoundary boundary;
+    const bool call = type == OptionType::Call;
+    // A call on a stock paying no dividend, or a put when money earns
+    // nothing, is never worth exercising early
+    if (years <= 0.0 || volatility <= 0.0 || (call ? dividend <= 0.0 : rate <= 0.0)) {
+        return boundary;
+    }
+    const double sign = call ? 1.0 : -1.0;
+    const double carry = rate - dividend;
+    const double variance = volatility * volatility;
+    const double m = 2.0 * rate / variance;
+    const double n = 2.0 * carry / variance - 1.0;
+    // m / (1 - exp(-rT)), which tends to 2 / (vol^2 T) as the rate goes to 0
+    const double mOverK = rate == 0.0 ? 2.0 / (variance * years) : m / -std::expm1(-rate * years);
+    const double exponent = 0.5 * (-n + sign * std::sqrt(n * n + 4.0 * mOverK));
+    const double volRootT = volatility * std::sqrt(years);
+    const double carryDiscount = std::exp(-dividend * years);
+
+    // Start from the perpetual option's boundary, pulled toward the strike
+    // (Barone-Adesi and Whaley's seed), then Newton on
+    // intrinsic(S*) = european(S*) + premium(S*)
+    const double perpetualExponent = 0.5 * (-n + sign * std::sqrt(n * n + 4.0 * m));
+    const double perpetual = strike / (1.0 - 1.0 / perpetualExponent);
+    double critical =
+        call ? strike + (perpetual - strike) *
+                            (1.0 - std::exp(-(carry * years + 2.0 * volRootT) * strike / (perpetual - strike)))
+             : perpetual + (strike - perpetual) *
+                               std::exp((carry * years - 2.0 * volRootT) * strike / (strike - perpetual));
+    double cdf = 0.0;
+    for (int iteration = 0; iteration < 100; ++iteration) {
+        const double d1 = (std::log(critical / strike) + (carry + 0.5 * variance) * years) / volRootT;
+        cdf = referenceCdf(sign * d1);
+        const double density = 0.39894228040143267794 * std::exp(-0.5 * d1 * d1);
+        const double european = blackScholes(type, critical, strike, years, rate, dividend, volatility).price;
+        const double mismatch =
+            sign * (critical - strike) - european - sign * (1.0 - carryDiscount * cdf) * critical / exponent;
+        if (std::abs(mismatch) < 1e-9 * strike) {
+            break;
+        }
+        const double slope = sign * carryDiscount * cdf * (1.0 - 1.0 / exponent) +
+                             sign * (1.0 - sign * carryDiscount * density / volRootT) / exponent;
+        const double next = critical - mismatch / (sign - slope);
+        // S* lies above the strike for a call and between 0 and it for a put
+        critical = call ? std::max(next, strike) : std::min(std::max(next, 1e-8 * strike), strike);
+    }
+    boundary.early = true;
+    boundary.critical = critical;
+    boundary.exponent = exponent;
+    boundary.coefficient = sign * critical / exponent * (1.0 - carryDiscount * cdf);
+    return boundary;
+}
+
+AmericanRow prepareAmericanRow(OptionType type, double strike, double years, double rate, double dividend,
+                               double volatility) {
+    AmericanRow row;
+    row.base = americanBoundary(type, strike, years, rate, dividend, volatility);
+    row.volUp = americanBoundary(type, strike, years, rate, dividend, volatility + kVolBump);
+    row.volDown = americanBoundary(type, strike, years, rate, dividend, bumpedDown(volatility));
+    row.rateUp = americanBoundary(type, strike, years, rate + kRateBump, dividend, volatility);
+    row.rateDown = americanBoundary(type, strike, years, rate - kRateBump, dividend, volatility);
+    return row;
+}
+
+OptionGreeks baroneAdesiWhaley(OptionType type, const AmericanRow& row, double spot, double strike, double years,
+                               double rate, double dividend, double volatility, const OptionGreeks& european) {
+    const double sign = type == OptionType::Call ? 1.0 : -1.0;
+    OptionGreeks greeks;
+    if (!row.base.early) {
+        greeks = european;
+        const double exercised = intrinsic(type, spot, strike);
+        if (exercised > greeks.price) {
+            greeks = OptionGreeks();
+            greeks.price = exercised;
+            greeks.delta = sign;
+        }
+        return greeks;
+    }
+    if (sign * (spot - row.base.critical) >= 0.0) {
+        // Exercised: worth intrinsic value, which only the spot moves
+        greeks.price = sign * (spot - strike);
+        greeks.delta = sign;
+        return greeks;
+    }
+    const AmericanBoundary& base = row.base;
+    const double premium = base.coefficient * std::pow(spot / base.critical, base.exponent);
+    greeks.price = european.price + premium;
+    greeks.delta = european.delta + base.exponent * premium / spot;
+    greeks.gamma = european.gamma + base.exponent * (base.exponent - 1.0) * premium / (spot * spot);
+    // Black-Scholes-Merton: dV/dt = rV - (r - q) S delta - vol^2 S^2 gamma / 2
+    greeks.theta = rate * greeks.price - (rate - dividend) * spot * greeks.delta -
+                   0.5 * volatility * volatility * spot * spot * greeks.gamma;
+
+    auto priceAt = [&](const AmericanBoundary& boundary, double r, double vol) {
+        const double europeanPrice = blackScholes(type, spot, strike, years, r, dividend, vol).price;
+        return americanPrice(type, boundary, spot, strike, europeanPrice);
+    };
+    greeks.vega = (priceAt(row.volUp, rate, volatility + kVolBump) -
+                   priceAt(row.volDown, rate, bumpedDown(volatility))) /
+                  (volatility + kVolBump - bumpedDown(volatility));
+    greeks.rho = (priceAt(row.rateUp, rate + kRateBump, volatility) -
+                  priceAt(row.rateDown, rate - kRateBump, volatility)) /
+                 (2.0 * kRateBump);
+    return greeks;
+}
+
+OptionGreeks baroneAdesiWhaley(OptionType type, double spot, double strike, double years, double rate,
+                               double dividend, double volatility) {
+    return baroneAdesiWhaley(type, prepareAmericanRow(type, strike, years, rate, dividend, volatility), spot, strike,
+                             years, rate, dividend, volatility,
+                             blackScholes(type, spot, strike, years, rate, dividend, volatility));
+}
+
+BlackScholesRow prepareRow(OptionType type, double strike, double years, double rate, double dividend,
+                           double volatility) {
+    const double t = std::max(years, 0.0);
+    const double vol = std::max(volatility, 0.0);
+    BlackScholesRow row;
+    row.sign = type == OptionType::Call ? 1.0 : -1.0;
+    row.logStrike = std::log(strike);
+    row.drift = (rate - dividend + 0.5 * vol * vol) * t;
+    row.volRootT = std::max(vol * std::sqrt(t), kMinVolRootT);
+    row.invRootYears = t > 0.0 ? 1.0 / std::sqrt(t) : 1.0;
+    row.strikeDiscount = strike * std::exp(-rate * t);
+    row.spotDiscount = std::exp(-dividend * t);
+    return row;
+}
+
+PORTFOLIO_MULTIVERSION
+void blackScholesBatch(const BlackScholesColumns& c, double spot, double rate, double dividend,
+                       std::size_t begin, std::size_t end) {
+    const double* sign = c.sign;
+    const double* logStrike = c.logStrike;
+    const double* drift = c.drift;
+    const double* volRootT = c.volRootT;
+    const double* strikeDiscount = c.strikeDiscount;
+    const double* spotDiscount = c.spotDiscount;
+    const double* years = c.years;
+    const double* invRootYears = c.invRootYears;
+    double* price = c.price;
+    double* delta = c.delta;
+    double* gamma = c.gamma;
+    double* vega = c.vega;
+    double* theta = c.theta;
+    double* rho = c.rho;
+    // At spot 0 log(spot) is -inf and d1, d2 go with it, which the CDF and
+    // the density handle; only 1 / spot^2 needs replacing (the density it
+    // multiplies is already 0)
+    const bool positive = spot > 0.0;
+    spot = positive ? spot : 0.0;
+    const double logSpot = positive ? std::log(spot) : -std::numeric_limits<double>::infinity();
+    const double invSpotSquared = positive ? 1.0 / (spot * spot) : 0.0;
+
+    // Every column is a distinct array; the pragma saves the alias checks
+    // GCC would otherwise give up on
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC ivdep
+#endif
+    for (std::size_t i = begin; i < end; ++i) {
+        const double s = sign[i];
+        const double invVolRootT = 1.0 / volRootT[i];
+        const double d1 = (logSpot - logStrike[i] + drift[i]) * invVolRootT;
+        const double d2 = d1 - volRootT[i];
+        // exp(-d^2 / 2) serves both the CDF and, for d1, the density
+        const double gaussian1 = fastmath::fastExp(-0.5 * d1 * d1);
+        const double nd1 = fastmath::normalCdf(s * d1, gaussian1);
+        const double nd2 = fastmath::normalCdf(s * d2, fastmath::fastExp(-0.5 * d2 * d2));
+        const double discountedSpot = spot * spotDiscount[i];
+        // Expired rows keep their intrinsic price and delta; the rest is zero
+        const double live = fastmath::select(years[i] > 0.0, 1.0, 0.0);
+        const double invRootT = invRootYears[i];
+        const double scaledDensity = live * discountedSpot * 0.39894228040143267794 * gaussian1;
+
+        price[i] = s * (discountedSpot * nd1 - strikeDiscount[i] * nd2);
+        delta[i] = s * spotDiscount[i] * nd1;
+        // Divisions are the slowest part of the loop, so sqrt(T) and 1 / T
+        // come from T and 1 / sqrt(T)
+        gamma[i] = scaledDensity * invSpotSquared * invVolRootT;
+        vega[i] = scaledDensity * years[i] * invRootT;
+        theta[i] = -0.5 * scaledDensity * volRootT[i] * invRootT * invRootT -
+                   live * s * (rate * strikeDiscount[i] * nd2 - dividend * discountedSpot * nd1);
+        rho[i] = live * s * strikeDiscount[i] * years[i] * nd2;
+    }
+}
+
+} // namespace optionpricing
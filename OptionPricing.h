@@ -0,0 +1,222 @@
+#ifndef OPTION_PRICING_H
+#define OPTION_PRICING_H
+
+#include "Platform.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+enum class OptionType : std::uint8_t { Call, Put };
+enum class ExerciseStyle : std::uint8_t { European, American };
+
+// Price and sensitivities of one option. Vega and rho are per 1.00 change in
+// volatility and rate (divide by 100 for per-point figures); theta is per year.
+struct OptionGreeks {
+    double price = 0.0;
+    double delta = 0.0;
+    double gamma = 0.0;
+    double vega = 0.0;
+    double theta = 0.0;
+    double rho = 0.0;
+};
+
+// Branch-free approximations the batch kernels are built from. Written as
+// straight-line arithmetic on doubles and their bit patterns, so loops calling
+// them vectorize (at -O3, which the Makefile uses for OptionPricing.o).
+// Measured against libm:
+//   fastExp     relative error < 5e-16   (x in [-708, 709]; clamped outside)
+//   normalCdf   absolute error < 3e-16, relative < 1e-8 in the lower tail
+//               (Hart's double-precision algorithm; 0 / 1 beyond |x| = 37)
+namespace fastmath {
+
+PORTFOLIO_ALWAYS_INLINE double fromBits(std::uint64_t bits) {
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+PORTFOLIO_ALWAYS_INLINE std::uint64_t toBits(double value) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// condition ? a : b as a bitwise blend; GCC does not if-convert every
+// ternary on doubles, and a branch in the loop stops it vectorizing
+PORTFOLIO_ALWAYS_INLINE double select(bool condition, double a, double b) {
+    const std::uint64_t mask = 0 - static_cast<std::uint64_t>(condition);
+    return fromBits((toBits(a) & mask) | (toBits(b) & ~mask));
+}
+
+// exp(x) = 2^k * exp(r), |r| <= ln2/2, with a degree-12 Taylor polynomial
+PORTFOLIO_ALWAYS_INLINE double fastExp(double x) {
+    const double kShift = 6755399441055744.0;  // 1.5 * 2^52: adding it rounds to an integer
+    x = select(x < -708.0, -708.0, x);
+    x = select(x > 709.0, 709.0, x);
+    const double shifted = x * 1.4426950408889634 + kShift;
+    const double k = shifted - kShift;
+    // Cody-Waite: ln2 split so k * ln2Hi is exact
+    const double r = (x - k * 6.93147180369123816490e-01) - k * 1.90821492927058770002e-10;
+    double p = 2.08767569878680989792e-09;  // 1/12!
+    p = p * r + 2.50521083854417187751e-08;
+    p = p * r + 2.75573192239858906526e-07;
+    p = p * r + 2.75573192239858906526e-06;
+    p = p * r + 2.48015873015873015873e-05;
+    p = p * r + 1.98412698412698412698e-04;
+    p = p * r + 1.38888888888888888889e-03;
+    p = p * r + 8.33333333333333333333e-03;
+    p = p * r + 4.16666666666666666667e-02;
+    p = p * r + 1.66666666666666666667e-01;
+    p = p * r + 0.5;
+    p = p * r + 1.0;
+    p = p * r + 1.0;
+    // The low bits of `shifted` hold k; move k + 1023 into the exponent field
+    const std::uint64_t scale = (toBits(shifted) + 1023) << 52;
+    return p * fromBits(scale);
+}
+
+// Standard normal density
+PORTFOLIO_ALWAYS_INLINE double normalPdf(double x) {
+    return 0.39894228040143267794 * fastExp(-0.5 * x * x);
+}
+
+// Standard normal CDF (Hart 1968, as given by West 2005): a rational
+// approximation for |x| < 7.07 and a continued fraction beyond; both are
+// computed and the right one selected, so there is no branch. gaussian is
+// exp(-x^2 / 2), passed in so a caller that also wants the density pays for
+// one exp.
+PORTFOLIO_ALWAYS_INLINE double normalCdf(double x, double gaussian) {
+    const double a = fromBits(toBits(x) & 0x7FFFFFFFFFFFFFFFULL);
+    const double clamped = select(a > 37.0, 37.0, a);
+
+    double n = 3.52624965998911e-02;
+    n = n * clamped + 0.700383064443688;
+    n = n * clamped + 6.37396220353165;
+    n = n * clamped + 33.912866078383;
+    n = n * clamped + 112.079291497871;
+    n = n * clamped + 221.213596169931;
+    n = n * clamped + 220.206867912376;
+    double d = 8.83883476483184e-02;
+    d = d * clamped + 1.75566716318264;
+    d = d * clamped + 16.064177579207;
+    d = d * clamped + 86.7807322029461;
+    d = d * clamped + 296.564248779674;
+    d = d * clamped + 637.333633378831;
+    d = d * clamped + 793.826512519948;
+    d = d * clamped + 440.413735824752;
+    // The continued fraction c + 1/(c + 2/(c + 3/(c + 4/(c + 0.65)))),
+    // evaluated as numerators over the previous level (f0 / f1), so either
+    // branch costs a single division
+    const double f4 = clamped + 0.65;
+    const double f3 = clamped * f4 + 4.0;
+    const double f2 = clamped * f3 + 3.0 * f4;
+    const double f1 = clamped * f2 + 2.0 * f3;
+    const double f0 = clamped * f1 + f2;
+
+    const bool central = clamped < 7.07106781186547;
+    double tail = gaussian * select(central, n, f1) / select(central, d, f0 * 2.5066282746310002);
+    tail = select(a >= 37.0, 0.0, tail);
+    return select(x > 0.0, 1.0 - tail, tail);
+}
+
+PORTFOLIO_ALWAYS_INLINE double normalCdf(double x) {
+    return normalCdf(x, fastExp(-0.5 * x * x));
+}
+
+} // namespace fastmath
+
+// Per-row Black-Scholes inputs for the batch kernel. Everything that does not
+// depend on the spot is precomputed once per contract, and the spot, rate and
+// dividend yield are shared by a batch (one underlying), so a spot move costs
+// one log per underlying and two exps per row, and the kernel streams only the
+// columns below.
+struct BlackScholesColumns {
+    // Inputs
+    const double* sign = nullptr;            // +1 call, -1 put
+    const double* logStrike = nullptr;
+    const double* drift = nullptr;           // (r - q + vol^2 / 2) * T
+    const double* volRootT = nullptr;        // vol * sqrt(T); > 0
+    const double* strikeDiscount = nullptr;  // K * exp(-r T)
+    const double* spotDiscount = nullptr;    // exp(-q T)
+    const double* years = nullptr;           // T; rows with T <= 0 are expired
+    const double* invRootYears = nullptr;    // 1 / sqrt(T), or 1 for expired rows
+    // Outputs
+    double* price = nullptr;
+    double* delta = nullptr;
+    double* gamma = nullptr;
+    double* vega = nullptr;
+    double* theta = nullptr;
+    double* rho = nullptr;
+};
+
+namespace optionpricing {
+
+// Reference Black-Scholes-Merton (libm, scalar). years <= 0 or vol <= 0
+// gives the intrinsic value with zero gamma, vega and theta.
+OptionGreeks blackScholes(OptionType type, double spot, double strike, double years, double rate,
+                          double dividend, double volatility);
+
+// Cox-Ross-Rubinstein tree, European or American. Delta, gamma and theta come
+// from the first nodes of the tree; vega and rho from repricing with bumped
+// inputs.
+OptionGreeks binomial(OptionType type, ExerciseStyle style, double spot, double strike, double years,
+                      double rate, double dividend, double volatility, int steps = 200);
+
+// Barone-Adesi-Whaley quadratic approximation of an American option: the
+// European price plus an early-exercise premium coefficient * (S / S*)^exponent
+// below (call) or above (put) the critical spot S*, and intrinsic value beyond
+// it. None of the three depends on the spot, so they are solved for (a few
+// Newton steps) once per contract rather than on every tick.
+struct AmericanBoundary {
+    bool early = false;  // Early exercise can pay; otherwise American == European
+    double critical = 0.0;
+    double coefficient = 0.0;
+    double exponent = 0.0;
+};
+
+// The boundary at a row's inputs, and with volatility and rate bumped for
+// vega and rho
+struct AmericanRow {
+    AmericanBoundary base, volUp, volDown, rateUp, rateDown;
+};
+
+AmericanBoundary americanBoundary(OptionType type, double strike, double years, double rate, double dividend,
+                                  double volatility);
+AmericanRow prepareAmericanRow(OptionType type, double strike, double years, double rate, double dividend,
+                               double volatility);
+
+// American greeks at `spot` from the row's European greeks there (as the
+// batch kernel gives them). Delta and gamma are analytic, theta comes from
+// the pricing equation, and vega and rho reprice at the bumped boundaries
+// (two scalar Black-Scholes prices each). Prices stay within 0.6% of the
+// strike of a 2000-step tree out to two years, the gap widest on long-dated
+// out-of-the-money puts at high rates; use binomial() where that matters.
+OptionGreeks baroneAdesiWhaley(OptionType type, const AmericanRow& row, double spot, double strike, double years,
+                               double rate, double dividend, double volatility, const OptionGreeks& european);
+OptionGreeks baroneAdesiWhaley(OptionType type, double spot, double strike, double years, double rate,
+                               double dividend, double volatility);
+
+// The spot-independent inputs of one row
+struct BlackScholesRow {
+    double sign = 1.0;
+    double logStrike = 0.0;
+    double drift = 0.0;
+    double volRootT = 0.0;
+    double invRootYears = 1.0;
+    double strikeDiscount = 0.0;
+    double spotDiscount = 1.0;
+};
+
+BlackScholesRow prepareRow(OptionType type, double strike, double years, double rate, double dividend,
+                           double volatility);
+
+// Prices rows [begin, end), all on one underlying at `spot`, with the
+// fastmath approximations; multiversioned and vectorized. rate and dividend
+// must be the ones the rows were prepared with. A spot of zero or below
+// prices as the limit at zero: no gamma or vega, rather than NaN.
+void blackScholesBatch(const BlackScholesColumns& columns, double spot, double rate, double dividend,
+                       std::size_t begin, std::size_t end);
+
+} // namespace optionpricing
+
+#endif // OPTION_PRICING_H
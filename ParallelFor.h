@@ -0,0 +1,59 @@
+#ifndef PARALLEL_FOR_H
+#define PARALLEL_FOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs work(item) for every item in [0, count) on up to `threads` threads
+// (the caller's included). Items are handed out one at a time from a shared
+// counter, so uneven items balance themselves. If work throws, no further
+// items are handed out and the first exception is rethrown on the caller's
+// thread once every worker has joined.
+template <typename Work>
+void parallelFor(std::size_t count, std::size_t threads, Work work) {
+    std::atomic<std::size_t> next(0);
+    std::mutex failureMutex;
+    std::exception_ptr failure;
+    auto drain = [&]() {
+        try {
+            for (std::size_t item = next.fetch_add(1); item < count; item = next.fetch_add(1)) {
+                work(item);
+            }
+        } catch (...) {
+            next.store(count);
+            std::lock_guard<std::mutex> lock(failureMutex);
+            if (!failure) {
+                failure = std::current_exception();
+            }
+        }
+    };
+    threads = std::min(threads, count);
+    std::vector<std::thread> pool;
+    try {
+        for (std::size_t t = 1; t < threads; ++t) {
+            pool.emplace_back(drain);
+        }
+    } catch (...) {
+        // Could not start a thread: the ones running finish the items
+        // between them and the caller
+    }
+    drain();
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+// 0 = one thread per hardware thread
+inline std::size_t workerThreads(std::size_t requested) {
+    return requested ? requested : std::max<std::size_t>(1, std::thread::hardware_concurrency());
+}
+
+#endif // PARALLEL_FOR_H
@@ -0,0 +1,33 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+// Compiler and CPU-dispatch helpers shared by the numeric kernels.
+
+// PORTFOLIO_MULTIVERSION compiles a function once per listed ISA level and
+// lets the loader pick the best clone for the running CPU (GNU ifunc), so one
+// release binary uses AVX-512 where available and still runs on older hosts.
+// Only enabled for x86-64 ELF targets; everywhere else it is a no-op.
+#if !defined(PORTFOLIO_NO_MULTIVERSION) && defined(__x86_64__) && defined(__ELF__) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define PORTFOLIO_MULTIVERSION __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define PORTFOLIO_MULTIVERSION
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PORTFOLIO_LIKELY(x) __builtin_expect(!!(x), 1)
+#define PORTFOLIO_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+#define PORTFOLIO_LIKELY(x) (x)
+#define PORTFOLIO_UNLIKELY(x) (x)
+#endif
+
+// Forces small math helpers into the vectorized loops that call them; a call
+// left in the loop body stops it vectorizing.
+#if defined(__GNUC__) || defined(__clang__)
+#define PORTFOLIO_ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define PORTFOLIO_ALWAYS_INLINE inline
+#endif
+
+#endif // PLATFORM_H
@@ -1,42 +1,364 @@
 #include "Portfolio.h"
+#include "Metrics.h"
+#include "AsyncPersistence.h"
+#include "Calendar.h"
+#include "ColumnarFile.h"
+#include "Kernels.h"
+#include "PositionQuery.h"
 #include <iostream>
 #include <iomanip>
+#include <limits>
 #include <fstream>
 #include <sstream>
 #include <thread>
 #include <numeric>
 #include <algorithm>
 #include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+
+namespace {
+
+// Row formats shared by the full and queried table and CSV output
+void printPositionHeader() {
+    std::cout << std::left << std::setw(8) << "Symbol"
+              << std::setw(25) << "Company"
+              << std::setw(8) << "Shares"
+              << std::setw(12) << "Avg Cost"
+              << std::setw(12) << "Curr Price"
+              << std::setw(12) << "Value"
+              << std::setw(12) << "Gain/Loss"
+              << "Return%" << "\n";
+    std::cout << std::string(100, '-') << "\n";
+    std::cout << std::fixed << std::setprecision(2);
+}
+
+void printPositionRow(const Investment& investment) {
+    if (investment.getStock()) {
+        std::cout << std::left << std::setw(8) << investment.getStock()->getSymbol()
+                  << std::setw(25) << investment.getStock()->getCompanyName().substr(0, 24)
+                  << std::setw(8) << investment.getSharesOwned()
+                  << "$" << std::setw(11) << investment.getPurchasePrice()
+                  << "$" << std::setw(11) << investment.getStock()->getCurrentPrice()
+                  << "$" << std::setw(11) << investment.getCurrentValue()
+                  << "$" << std::setw(11) << investment.getGainLoss()
+                  << investment.getPercentageReturn() << "%\n";
+    }
+}
+
+void writeCSVHeader(std::ostream& file) {
+    file << "Symbol,Company,Shares,Purchase Price,Current Price,Current Value,Gain/Loss,Return %,Currency,"
+            "Sector,Industry,Country\n";
+}
+
+void writeCSVRow(std::ostream& file, const Investment& investment) {
+    if (!investment.getStock()) {
+        return;
+    }
+    file << investment.getStock()->getSymbol() << ","
+         << investment.getStock()->getCompanyName() << ","
+         << investment.getSharesOwned() << ","
+         << std::fixed << std::setprecision(2) << investment.getPurchasePrice() << ","
+         << investment.getStock()->getCurrentPrice() << ","
+         << investment.getCurrentValue() << ","
+         << investment.getGainLoss() << ","
+         << investment.getPercentageReturn() << ","
+         << investment.getStock()->getCurrencyCode() << ","
+         << investment.getStock()->getSector() << ","
+         << investment.getStock()->getIndustry() << ","
+         << investment.getStock()->getCountry() << "\n";
+}
+
+} // namespace
 
 // Default constructor
-Portfolio::Portfolio() : portfolioName("My Portfolio"), totalInitialInvestment(0.0) {}
+Portfolio::Portfolio()
+    : portfolioName("My Portfolio"), totalInitialInvestment(), valuationCounter(std::make_shared<ValuationEpoch>()),
+      valuationEpoch(0), valuationValid(false),
+      symbolIndexValid(false), structureVersion(0), activeCapture(nullptr) {}
 
 // Parameterized constructor
-Portfolio::Portfolio(const std::string& name) : portfolioName(name), totalInitialInvestment(0.0) {}
+Portfolio::Portfolio(const std::string& name)
+    : portfolioName(name), totalInitialInvestment(), valuationCounter(std::make_shared<ValuationEpoch>()),
+      valuationEpoch(0), valuationValid(false),
+      symbolIndexValid(false), structureVersion(0), activeCapture(nullptr) {}
 
 // Copy constructor
 Portfolio::Portfolio(const Portfolio& other)
     : investments(other.investments), portfolioName(other.portfolioName), 
-      totalInitialInvestment(other.totalInitialInvestment) {}
+      totalInitialInvestment(other.totalInitialInvestment), fxRates(other.fxRates),
+      currencyTotals(other.currencyTotals), trackedGroups(other.trackedGroups), baseValue(other.baseValue),
+      valuationCounter(std::make_shared<ValuationEpoch>()), valuationEpoch(0), valuationValid(other.valuationFresh()),
+      returnThresholds(other.returnThresholds), symbolIndexValid(false), structureVersion(0),
+      activeCapture(nullptr) {
+    attachPositions();
+}
 
 // Destructor
 Portfolio::~Portfolio() {
-    // STL containers automatically handle cleanup
+    detachPositions();  // Stocks outliving the portfolio stop bumping its counter
 }
 
 // Private helper methods
 std::vector<Investment>::iterator Portfolio::findInvestment(const std::string& symbol) {
-    return std::find_if(investments.begin(), investments.end(),
-        [&symbol](const Investment& inv) {
-            return inv.getStock() && inv.getStock()->getSymbol() == symbol;
-        });
+    return investments.begin() + static_cast<std::ptrdiff_t>(indexOf(symbol));
 }
 
 std::vector<Investment>::const_iterator Portfolio::findInvestment(const std::string& symbol) const {
-    return std::find_if(investments.begin(), investments.end(),
-        [&symbol](const Investment& inv) {
-            return inv.getStock() && inv.getStock()->getSymbol() == symbol;
-        });
+    return investments.begin() + static_cast<std::ptrdiff_t>(indexOf(symbol));
+}
+
+size_t Portfolio::indexOf(const std::string& symbol) const {
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        if (!symbolIndexValid) {
+            rebuildSymbolIndex();
+        }
+        auto found = symbolIndex.find(symbol);
+        if (found == symbolIndex.end()) {
+            return investments.size();
+        }
+        size_t index = found->second;
+        if (index < investments.size() && investments[index].getStock() &&
+            investments[index].getStock()->getSymbol() == symbol) {
+            return index;
+        }
+        symbolIndexValid = false;  // Stale entry: a position was replaced in place
+    }
+    return investments.size();
+}
+
+void Portfolio::rebuildSymbolIndex() const {
+    symbolIndex.clear();
+    symbolIndex.reserve(investments.size());
+    for (size_t i = 0; i < investments.size(); ++i) {
+        if (investments[i].getStock()) {
+            symbolIndex.emplace(investments[i].getStock()->getSymbol(), i);  // First match wins
+        }
+    }
+    symbolIndexValid = true;
+}
+
+// Valuation bookkeeping
+// Points every position at this portfolio's counter and registers it with
+// their stocks; after anything that fills `investments` wholesale
+void Portfolio::attachPositions() {
+    for (Investment& investment : investments) {
+        investment.attachValuation(valuationCounter);
+    }
+    valuationEpoch = valuationCounter->current();
+}
+
+// Before positions are dropped wholesale. Bumps the counter: the totals no
+// longer describe the positions.
+void Portfolio::detachPositions() {
+    for (const Investment& investment : investments) {
+        if (investment.getStock()) {
+            investment.getStock()->unwatchValuation(valuationCounter.get());
+        }
+    }
+    valuationCounter->bump();
+}
+
+bool Portfolio::valuationFresh() const {
+    return valuationValid && valuationEpoch == valuationCounter->current();
+}
+
+void Portfolio::ensureValuation() const {
+    if (!valuationFresh()) {
+        rebuildValuation();
+    }
+}
+
+// Groups every position by currency in one pass, then converts each currency
+// total once instead of looking up a rate per position.
+void Portfolio::rebuildValuation() const {
+    size_t currencyCount = Currency::count();
+    std::vector<std::int64_t> valueUnits(currencyCount, 0);
+    std::vector<std::int64_t> costUnits(currencyCount, 0);
+    std::vector<std::uint32_t> positions(currencyCount, 0);
+    kernels::sumByCurrency(investments.data(), investments.size(),
+                           valueUnits.data(), costUnits.data(), positions.data(), currencyCount);
+
+    currencyTotals.assign(currencyCount, CurrencyTotals());
+    baseValue = Money();
+    for (size_t c = 0; c < currencyCount; ++c) {
+        CurrencyTotals& totals = currencyTotals[c];
+        totals.marketValue = Money::fromUnits(valueUnits[c]);
+        totals.costBasis = Money::fromUnits(costUnits[c]);
+        totals.positions = positions[c];
+        totals.baseValue = fxRates.convert(totals.marketValue, static_cast<CurrencyId>(c));
+        baseValue += totals.baseValue;
+    }
+    for (TrackedGroup& group : trackedGroups) {
+        computeGroupCells(group.field, group.cells);
+    }
+    valuationEpoch = valuationCounter->current();
+    valuationValid = true;
+}
+
+// One pass over the positions with dense [code][currency] accumulators; no
+// per-row hashing.
+void Portfolio::computeGroupCells(AttributeField field, std::vector<std::vector<GroupCell>>& cells) const {
+    size_t codeCount = Attributes::codeCount(field);
+    size_t currencyCount = Currency::count();
+    std::vector<std::int64_t> valueUnits(codeCount * currencyCount, 0);
+    std::vector<std::int64_t> costUnits(codeCount * currencyCount, 0);
+    std::vector<std::uint32_t> positions(codeCount * currencyCount, 0);
+    kernels::sumByGroup(investments.data(), investments.size(), field,
+                        valueUnits.data(), costUnits.data(), positions.data(), codeCount, currencyCount);
+
+    cells.assign(codeCount, std::vector<GroupCell>(currencyCount));
+    for (size_t code = 0; code < codeCount; ++code) {
+        for (size_t c = 0; c < currencyCount; ++c) {
+            size_t index = code * currencyCount + c;
+            cells[code][c] = {valueUnits[index], costUnits[index], positions[index]};
+        }
+    }
+}
+
+void Portfolio::applyValuationDelta(const Stock* stock, Money valueDelta, Money costDelta,
+                                    long positionDelta) const {
+    CurrencyId currency = stock ? stock->getCurrency() : Currency::kDefault;
+    if (currency >= currencyTotals.size()) {
+        currencyTotals.resize(static_cast<size_t>(currency) + 1);
+    }
+    CurrencyTotals& totals = currencyTotals[currency];
+    totals.marketValue += valueDelta;
+    totals.costBasis += costDelta;
+    totals.positions = static_cast<size_t>(static_cast<long>(totals.positions) + positionDelta);
+    convertCurrencyTotal(currency);
+
+    for (TrackedGroup& group : trackedGroups) {
+        AttributeCode code = stock ? stock->getAttributeCode(group.field) : Attributes::kUnset;
+        if (code >= group.cells.size()) {
+            group.cells.resize(static_cast<size_t>(code) + 1);
+        }
+        std::vector<GroupCell>& row = group.cells[code];
+        if (currency >= row.size()) {
+            row.resize(static_cast<size_t>(currency) + 1);
+        }
+        row[currency].valueUnits += valueDelta.raw();
+        row[currency].costUnits += costDelta.raw();
+        row[currency].positions = static_cast<std::uint32_t>(static_cast<long>(row[currency].positions) +
+                                                             positionDelta);
+    }
+}
+
+void Portfolio::convertCurrencyTotal(CurrencyId currency) const {
+    if (currency >= currencyTotals.size()) {
+        currencyTotals.resize(static_cast<size_t>(currency) + 1);
+    }
+    CurrencyTotals& totals = currencyTotals[currency];
+    Money converted = fxRates.convert(totals.marketValue, currency);
+    baseValue += converted - totals.baseValue;
+    totals.baseValue = converted;
+}
+
+// Keeps the incremental totals only if nothing but our own mutation (which
+// moved the epoch to expectedEpoch) happened since they were last valid.
+void Portfolio::finishValuationUpdate(bool wasFresh, std::uint64_t expectedEpoch) const {
+    std::uint64_t now = valuationCounter->current();
+    valuationValid = wasFresh && now == expectedEpoch;
+    valuationEpoch = now;
+}
+
+// Files without per-position booked costs (older text files, columnar files)
+// carry only the total: it is spread over the positions in proportion to
+// their cost converted at the loaded rates, so the parts add up to it.
+void Portfolio::spreadBookedCost() {
+    std::vector<Money> converted(investments.size());
+    Money convertedTotal;
+    for (size_t i = 0; i < investments.size(); ++i) {
+        const Investment& investment = investments[i];
+        CurrencyId currency = investment.getStock() ? investment.getStock()->getCurrency() : Currency::kDefault;
+        converted[i] = fxRates.convert(investment.getTotalInvested(), currency);
+        convertedTotal += converted[i];
+    }
+    Money remaining = totalInitialInvestment;
+    for (size_t i = 0; i < investments.size(); ++i) {
+        Money share = remaining;  // The last position takes the rounding
+        if (i + 1 < investments.size()) {
+            share = convertedTotal.isZero() ? Money()
+                                            : totalInitialInvestment.mulDiv(converted[i].raw(), convertedTotal.raw());
+        }
+        investments[i].setBookedCost(share);
+        remaining -= share;
+    }
+}
+
+// Applies one tick to a held position, keeping the valuation current and
+// queueing PriceChanged/ThresholdCrossed notifications when anyone listens.
+bool Portfolio::applyPrice(Investment& investment, Money newPrice) {
+    const std::shared_ptr<Stock>& stock = investment.getStock();
+    try {
+        bool fresh = valuationFresh();
+        std::uint64_t epoch = valuationCounter->current();
+        Money oldPrice = stock->getCurrentPrice();
+        Money valueBefore = investment.getCurrentValue();
+        bool watching = events && !returnThresholds.empty();
+        double returnBefore = watching ? investment.getPercentageReturn() : 0.0;
+        if (activeCapture && !newPrice.isNegative()) {
+            activeCapture->beforePriceChange(static_cast<size_t>(&investment - investments.data()));
+        }
+
+        stock->setCurrentPrice(newPrice);
+        if (fresh) {
+            applyValuationDelta(stock.get(), investment.getCurrentValue() - valueBefore, Money(), 0);
+        }
+        finishValuationUpdate(fresh, epoch + 1);
+        METRIC_INCREMENT(TicksApplied);
+
+        for (TickListener* listener : tickListeners) {
+            listener->onTick(investment, oldPrice);
+        }
+
+        if (events) {
+            ensureValuation();
+            PortfolioEvent event;
+            event.type = PortfolioEventType::PriceChanged;
+            event.symbol = stock->getSymbol();
+            event.oldPrice = oldPrice;
+            event.newPrice = newPrice;
+            event.portfolioValue = baseValue;
+
+            if (watching) {
+                double returnAfter = investment.getPercentageReturn();
+                for (double threshold : returnThresholds) {
+                    if ((returnBefore < threshold) != (returnAfter < threshold)) {
+                        PortfolioEvent crossed = event;
+                        crossed.type = PortfolioEventType::ThresholdCrossed;
+                        crossed.returnPercent = returnAfter;
+                        crossed.threshold = threshold;
+                        crossed.crossedBelow = returnAfter < threshold;
+                        events->publish(std::move(crossed));
+                    }
+                }
+            }
+            events->publish(std::move(event));
+        }
+        return true;
+    } catch (const std::exception&) {
+        METRIC_INCREMENT(TicksRejected);
+        return false;
+    }
+}
+
+void Portfolio::endTickBatch() {
+    for (TickListener* listener : tickListeners) {
+        listener->onBatchEnd();
+    }
+}
+
+void Portfolio::publishPositionEvent(PortfolioEventType type, const std::string& symbol) {
+    if (!events) {
+        return;
+    }
+    ensureValuation();
+    PortfolioEvent event;
+    event.type = type;
+    event.symbol = symbol;
+    event.portfolioValue = baseValue;
+    events->publish(std::move(event));
 }
 
 // Getters
@@ -48,28 +370,191 @@ size_t Portfolio::getInvestmentCount() const {
     return investments.size();
 }
 
-double Portfolio::getTotalInitialInvestment() const {
+Money Portfolio::getTotalInitialInvestment() const {
     return totalInitialInvestment;
 }
 
 // Setters
 void Portfolio::setPortfolioName(const std::string& name) {
     portfolioName = name;
+    structureChanged();
+}
+
+// Currencies and FX
+std::string Portfolio::getBaseCurrency() const {
+    return Currency::codeOf(fxRates.getBaseCurrency());
+}
+
+bool Portfolio::setBaseCurrency(const std::string& currencyCode) {
+    CurrencyId currency = Currency::idOf(currencyCode);
+    if (currency == fxRates.getBaseCurrency()) {
+        return true;
+    }
+    if (!investments.empty()) {
+        return false;
+    }
+    fxRates.setBaseCurrency(currency);
+    totalInitialInvestment = Money();
+    valuationValid = false;
+    structureChanged();
+    return true;
+}
+
+// O(1): only the affected currency's converted total changes.
+bool Portfolio::updateFxRate(const std::string& currencyCode, double rate) {
+    CurrencyId currency;
+    try {
+        currency = Currency::idOf(currencyCode);
+    } catch (const std::exception&) {
+        return false;
+    }
+
+    bool fresh = valuationFresh();
+    if (!fxRates.setRate(currency, rate)) {
+        return false;
+    }
+    // Not structural: a capture in progress keeps the table it started with
+    if (fresh) {
+        convertCurrencyTotal(currency);
+    }
+    return true;
+}
+
+const FxRateTable& Portfolio::getFxRates() const {
+    return fxRates;
+}
+
+std::vector<CurrencyExposure> Portfolio::getCurrencyExposures() const {
+    ensureValuation();
+    std::vector<CurrencyExposure> result;
+    for (size_t c = 0; c < currencyTotals.size(); ++c) {
+        const CurrencyTotals& totals = currencyTotals[c];
+        if (totals.positions == 0) {
+            continue;
+        }
+        CurrencyExposure exposure;
+        exposure.currencyCode = Currency::codeOf(static_cast<CurrencyId>(c));
+        exposure.positions = totals.positions;
+        exposure.marketValue = totals.marketValue;
+        exposure.costBasis = totals.costBasis;
+        exposure.baseValue = totals.baseValue;
+        exposure.fxRate = fxRates.getRate(static_cast<CurrencyId>(c));
+        result.push_back(exposure);
+    }
+    return result;
+}
+
+// Grouping
+// Value, cost and return per attribute value (e.g. per sector), in the base
+// currency, largest group first. Reads the maintained rollup when the field is
+// tracked, otherwise runs one dense pass.
+std::vector<GroupRollup> Portfolio::groupBy(const std::string& field) const {
+    METRIC_TIME_SCOPE(GroupBy);
+    AttributeField id;
+    if (!Attributes::findField(field, id)) {
+        return {};
+    }
+    ensureValuation();
+
+    std::vector<std::vector<GroupCell>> computed;
+    const std::vector<std::vector<GroupCell>>* cells = nullptr;
+    for (const TrackedGroup& group : trackedGroups) {
+        if (group.field == id) {
+            cells = &group.cells;
+            break;
+        }
+    }
+    if (!cells) {
+        computeGroupCells(id, computed);
+        cells = &computed;
+    }
+
+    std::vector<GroupRollup> result;
+    for (size_t code = 0; code < cells->size(); ++code) {
+        GroupRollup rollup;
+        const std::vector<GroupCell>& row = (*cells)[code];
+        for (size_t c = 0; c < row.size(); ++c) {
+            if (row[c].positions == 0) {
+                continue;
+            }
+            CurrencyId currency = static_cast<CurrencyId>(c);
+            rollup.positions += row[c].positions;
+            rollup.marketValue += fxRates.convert(Money::fromUnits(row[c].valueUnits), currency);
+            rollup.costBasis += fxRates.convert(Money::fromUnits(row[c].costUnits), currency);
+        }
+        if (rollup.positions == 0) {
+            continue;
+        }
+        rollup.group = Attributes::decode(id, static_cast<AttributeCode>(code));
+        rollup.gainLoss = rollup.marketValue - rollup.costBasis;
+        rollup.returnPercent = Money::ratio(rollup.gainLoss, rollup.costBasis) * 100.0;
+        rollup.weight = Money::ratio(rollup.marketValue, baseValue);
+        result.push_back(rollup);
+    }
+    std::sort(result.begin(), result.end(), [](const GroupRollup& a, const GroupRollup& b) {
+        return a.marketValue > b.marketValue || (a.marketValue == b.marketValue && a.group < b.group);
+    });
+    return result;
+}
+
+void Portfolio::trackGroupBy(const std::string& field) {
+    AttributeField id = Attributes::fieldOf(field);
+    for (const TrackedGroup& group : trackedGroups) {
+        if (group.field == id) {
+            return;
+        }
+    }
+    trackedGroups.push_back({id, {}});
+    valuationValid = false;  // Next read fills it in the rebuild pass
+}
+
+bool Portfolio::untrackGroupBy(const std::string& field) {
+    AttributeField id;
+    if (!Attributes::findField(field, id)) {
+        return false;
+    }
+    for (auto it = trackedGroups.begin(); it != trackedGroups.end(); ++it) {
+        if (it->field == id) {
+            trackedGroups.erase(it);
+            return true;
+        }
+    }
+    return false;
 }
 
 // Investment management
 bool Portfolio::addInvestment(const Investment& investment) {
+    METRIC_TIME_SCOPE(AddInvestment);
     if (!investment.getStock()) {
         return false;
     }
 
+    bool fresh = valuationFresh();
+    std::uint64_t epoch = valuationCounter->current();
+    CurrencyId currency = investment.getStock()->getCurrency();
+    if (!fxRates.hasRate(currency)) {
+        return false;
+    }
+    structureChanged();
+
     // Check if investment already exists
     auto it = findInvestment(investment.getStock()->getSymbol());
     if (it != investments.end()) {
         // Merge with existing investment
         try {
+            Money valueBefore = it->getCurrentValue();
+            Money costBefore = it->getTotalInvested();
             it->addShares(investment.getSharesOwned(), investment.getPurchasePrice());
-            totalInitialInvestment += investment.getTotalInvested();
+            Money booked = fxRates.convert(investment.getTotalInvested(), currency);
+            it->setBookedCost(it->getBookedCost() + booked);
+            totalInitialInvestment += booked;
+            if (fresh) {
+                applyValuationDelta(it->getStock().get(), it->getCurrentValue() - valueBefore,
+                                    it->getTotalInvested() - costBefore, 0);
+            }
+            finishValuationUpdate(fresh, epoch + 1);
+            METRIC_INCREMENT(InvestmentsMerged);
+            publishPositionEvent(PortfolioEventType::PositionAdded, it->getStock()->getSymbol());
             return true;
         } catch (const std::exception&) {
             return false;
@@ -77,64 +562,276 @@ bool Portfolio::addInvestment(const Investment& investment) {
     } else {
         // Add new investment
         investments.push_back(investment);
-        totalInitialInvestment += investment.getTotalInvested();
+        investments.back().attachValuation(valuationCounter);
+        if (symbolIndexValid) {
+            symbolIndex.emplace(investments.back().getStock()->getSymbol(), investments.size() - 1);
+        }
+        Money booked = fxRates.convert(investment.getTotalInvested(), currency);
+        investments.back().setBookedCost(booked);
+        if (investments.back().getAcquiredDay() == 0) {
+            investments.back().setAcquiredDay(calendar::today());
+        }
+        totalInitialInvestment += booked;
+        if (fresh) {
+            applyValuationDelta(investment.getStock().get(), investment.getCurrentValue(),
+                                investment.getTotalInvested(), 1);
+        }
+        finishValuationUpdate(fresh, epoch);
+        METRIC_INCREMENT(InvestmentsAdded);
+        publishPositionEvent(PortfolioEventType::PositionAdded, investment.getStock()->getSymbol());
         return true;
     }
 }
 
 bool Portfolio::removeInvestment(const std::string& symbol) {
+    METRIC_TIME_SCOPE(RemoveInvestment);
     auto it = findInvestment(symbol);
     if (it != investments.end()) {
-        totalInitialInvestment -= it->getTotalInvested();
+        bool fresh = valuationFresh();
+        totalInitialInvestment -= it->getBookedCost();
+        if (fresh) {
+            applyValuationDelta(it->getStock().get(), -it->getCurrentValue(), -it->getTotalInvested(), -1);
+        }
+        if (it->getStock()) {
+            it->getStock()->unwatchValuation(valuationCounter.get());
+        }
+        // Shifting the tail reassigns Investments (bumping the epoch) without
+        // changing any value, so the totals stay valid.
+        const size_t removed = static_cast<size_t>(it - investments.begin());
         investments.erase(it);
+        if (symbolIndexValid) {
+            // Repoint the shifted tail instead of rebuilding; a later row with
+            // the removed symbol becomes its first match
+            symbolIndex.erase(symbol);
+            for (size_t i = removed; i < investments.size(); ++i) {
+                const std::shared_ptr<Stock>& stock = investments[i].getStock();
+                if (!stock) {
+                    continue;
+                }
+                auto entry = symbolIndex.find(stock->getSymbol());
+                if (entry == symbolIndex.end()) {
+                    symbolIndex.emplace(stock->getSymbol(), i);
+                } else if (entry->second == i + 1) {
+                    entry->second = i;
+                }
+            }
+        }
+        structureChanged();
+        finishValuationUpdate(fresh, valuationCounter->current());
+        METRIC_INCREMENT(InvestmentsRemoved);
+        publishPositionEvent(PortfolioEventType::PositionRemoved, symbol);
         return true;
     }
     return false;
 }
 
-bool Portfolio::updateStockPrice(const std::string& symbol, double newPrice) {
+// Partial sale: the sold shares' share of the booked cost leaves
+// totalInitialInvestment, so it goes at the rates it was added at, as
+// removeInvestment does for whole positions.
+bool Portfolio::removeShares(const std::string& symbol, int shares) {
+    METRIC_TIME_SCOPE(RemoveShares);
+    auto it = findInvestment(symbol);
+    if (it == investments.end() || shares <= 0 || shares > it->getSharesOwned()) {
+        return false;
+    }
+    if (shares == it->getSharesOwned()) {
+        return removeInvestment(symbol);
+    }
+
+    bool fresh = valuationFresh();
+    std::uint64_t epoch = valuationCounter->current();
+    Money valueBefore = it->getCurrentValue();
+    Money costBefore = it->getTotalInvested();
+    Money bookedBefore = it->getBookedCost();
+    it->removeShares(shares);
+    structureChanged();
+    totalInitialInvestment -= bookedBefore - it->getBookedCost();
+    if (fresh) {
+        applyValuationDelta(it->getStock().get(), it->getCurrentValue() - valueBefore,
+                            it->getTotalInvested() - costBefore, 0);
+    }
+    finishValuationUpdate(fresh, epoch + 1);
+    publishPositionEvent(PortfolioEventType::PositionRemoved, symbol);
+    return true;
+}
+
+bool Portfolio::applySplit(const std::string& symbol, SplitRatio ratio, int exDay) {
+    if (ratio.numerator <= 0 || ratio.denominator <= 0) {
+        throw std::invalid_argument("Split ratio must be positive");
+    }
+    auto it = findInvestment(symbol);
+    if (it == investments.end() || !it->getStock()) {
+        return false;
+    }
+    ratio = ratio * SplitRatio();
+    if (static_cast<__int128>(it->getSharesOwned()) * ratio.numerator / ratio.denominator >
+        std::numeric_limits<int>::max()) {
+        return false;
+    }
+
+    // The fractional new share is paid out as cash in lieu: its cost leaves
+    // the position and totalInitialInvestment as for a sale. Otherwise value
+    // moves only by the price rounding, and the cost basis not at all.
+    Stock& stock = *it->getStock();
+    bool fresh = valuationFresh();
+    std::uint64_t epoch = valuationCounter->current();
+    Money valueBefore = it->getCurrentValue();
+    Money costBefore = it->getTotalInvested();
+    Money bookedBefore = it->getBookedCost();
+    Money oldPrice = stock.getCurrentPrice();
+    std::int64_t fraction = it->settleSplitFraction(ratio);
+    stock.applySplit(ratio, exDay);
+    Money cashInLieu = fxRates.convert(stock.getCurrentPrice().mulDiv(fraction, ratio.denominator),
+                                       stock.getCurrency());
+    totalInitialInvestment -= bookedBefore - it->getBookedCost();
+    structureChanged();
+    if (fresh) {
+        applyValuationDelta(&stock, it->getCurrentValue() - valueBefore, it->getTotalInvested() - costBefore, 0);
+    }
+    finishValuationUpdate(fresh, epoch + 1);
+
+    for (TickListener* listener : tickListeners) {
+        listener->onSplit(*it, ratio);
+    }
+    endTickBatch();
+    if (events) {
+        ensureValuation();
+        PortfolioEvent event;
+        event.type = PortfolioEventType::PositionSplit;
+        event.symbol = symbol;
+        event.oldPrice = oldPrice;
+        event.newPrice = stock.getCurrentPrice();
+        event.cashInLieu = cashInLieu;
+        event.portfolioValue = baseValue;
+        events->publish(std::move(event));
+    }
+    return true;
+}
+
+bool Portfolio::updateStockPrice(const std::string& symbol, Money newPrice) {
+    METRIC_TIME_SCOPE(UpdateStockPrice);
     auto it = findInvestment(symbol);
     if (it != investments.end() && it->getStock()) {
-        try {
-            it->getStock()->setCurrentPrice(newPrice);
-            return true;
-        } catch (const std::exception&) {
-            return false;
-        }
+        bool applied = applyPrice(*it, newPrice);
+        endTickBatch();
+        return applied;
     }
+    METRIC_INCREMENT(TicksRejected);
     return false;
 }
 
+bool Portfolio::updateStockPrice(const std::string& symbol, double newPrice) {
+    try {
+        return updateStockPrice(symbol, Money::fromDouble(newPrice));
+    } catch (const std::exception&) {
+        METRIC_INCREMENT(TicksRejected);
+        return false;
+    }
+}
+
+// Applies a burst of ticks through the symbol index. Subscribers see the
+// burst as one coalesced dispatch.
+size_t Portfolio::updateStockPrices(const std::vector<PriceUpdate>& updates) {
+    METRIC_TIME_SCOPE(UpdateStockPrices);
+    if (events) {
+        events->beginBatch();
+    }
+    size_t applied = 0;
+    for (const PriceUpdate& update : updates) {
+        size_t index = indexOf(update.symbol);
+        if (index == investments.size()) {
+            METRIC_INCREMENT(TicksRejected);
+            continue;
+        }
+        if (applyPrice(investments[index], update.price)) {
+            ++applied;
+        }
+    }
+    if (events) {
+        events->endBatch();
+    }
+    endTickBatch();
+    return applied;
+}
+
 Investment* Portfolio::getInvestment(const std::string& symbol) {
     auto it = findInvestment(symbol);
-    return (it != investments.end()) ? &(*it) : nullptr;
+    if (it == investments.end()) {
+        return nullptr;
+    }
+    symbolIndexValid = false;  // The caller may replace the position
+    return &(*it);
 }
 
 const Investment* Portfolio::getInvestment(const std::string& symbol) const {
     auto it = findInvestment(symbol);
     return (it != investments.end()) ? &(*it) : nullptr;
 }
+// Change notification
+SubscriptionId Portfolio::subscribe(PortfolioEventCallback callback, unsigned mask) {
+    if (!events) {
+        events = std::make_shared<EventDispatcher>();
+    }
+    return events->subscribe(std::move(callback), mask);
+}
+
+bool Portfolio::unsubscribe(SubscriptionId id) {
+    return events && events->unsubscribe(id);
+}
+
+void Portfolio::watchReturnThreshold(double percent) {
+    if (std::find(returnThresholds.begin(), returnThresholds.end(), percent) == returnThresholds.end()) {
+        returnThresholds.push_back(percent);
+    }
+}
+
+void Portfolio::clearReturnThresholds() {
+    returnThresholds.clear();
+}
+
+void Portfolio::addTickListener(TickListener* listener) {
+    if (listener && std::find(tickListeners.begin(), tickListeners.end(), listener) == tickListeners.end()) {
+        tickListeners.push_back(listener);
+    }
+}
+
+bool Portfolio::removeTickListener(TickListener* listener) {
+    auto it = std::find(tickListeners.begin(), tickListeners.end(), listener);
+    if (it == tickListeners.end()) {
+        return false;
+    }
+    tickListeners.erase(it);
+    return true;
+}
+
+// Blocks until every event queued so far has reached the subscribers
+void Portfolio::flushEvents() {
+    if (events) {
+        events->flush();
+    }
+}
+
 // Portfolio calculations
-double Portfolio::getCurrentValue() const {
-    return std::accumulate(investments.begin(), investments.end(), 0.0,
-        [](double sum, const Investment& inv) {
-            return sum + inv.getCurrentValue();
-        });
+// Base-currency value; O(1) while the incremental totals are valid.
+Money Portfolio::getCurrentValue() const {
+    METRIC_TIME_SCOPE(GetCurrentValue);
+    ensureValuation();
+    return baseValue;
 }
 
-double Portfolio::getTotalGainLoss() const {
+Money Portfolio::getTotalGainLoss() const {
+    METRIC_TIME_SCOPE(GetTotalGainLoss);
     return getCurrentValue() - totalInitialInvestment;
 }
 
 double Portfolio::getPercentageReturn() const {
-    if (totalInitialInvestment == 0.0) {
-        return 0.0;
-    }
-    return (getTotalGainLoss() / totalInitialInvestment) * 100.0;
+    return Money::ratio(getTotalGainLoss(), totalInitialInvestment) * 100.0;
 }
 
 // STL Algorithm usage
 void Portfolio::sortInvestmentsByValue(bool ascending) {
+    METRIC_TIME_SCOPE(SortInvestments);
+    bool fresh = valuationFresh();
     if (ascending) {
         std::sort(investments.begin(), investments.end(),
             [](const Investment& a, const Investment& b) {
@@ -146,13 +843,21 @@ void Portfolio::sortInvestmentsByValue(bool ascending) {
                 return a.getCurrentValue() > b.getCurrentValue();
             });
     }
+    symbolIndexValid = false;
+    structureChanged();
+    finishValuationUpdate(fresh, valuationCounter->current());  // Reordering keeps totals
 }
 
 void Portfolio::sortInvestmentsBySymbol() {
+    METRIC_TIME_SCOPE(SortInvestments);
+    bool fresh = valuationFresh();
     std::sort(investments.begin(), investments.end(),
         [](const Investment& a, const Investment& b) {
             return a.getStock()->getSymbol() < b.getStock()->getSymbol();
         });
+    symbolIndexValid = false;
+    structureChanged();
+    finishValuationUpdate(fresh, valuationCounter->current());  // Reordering keeps totals
 }
 
 Investment Portfolio::getTopPerformer() const {
@@ -181,6 +886,7 @@ Investment Portfolio::getWorstPerformer() const {
 
 // Portfolio analysis
 std::vector<Investment> Portfolio::getTopPerformers(size_t count) const {
+    METRIC_TIME_SCOPE(GetTopPerformers);
     std::vector<Investment> sorted_investments = investments;
 
     std::sort(sorted_investments.begin(), sorted_investments.end(),
@@ -194,29 +900,46 @@ std::vector<Investment> Portfolio::getTopPerformers(size_t count) const {
 }
 
 std::vector<Investment> Portfolio::getLosers() const {
+    METRIC_TIME_SCOPE(GetLosers);
     std::vector<Investment> losers;
 
     std::copy_if(investments.begin(), investments.end(), 
                  std::back_inserter(losers),
         [](const Investment& inv) {
-            return inv.getGainLoss() < 0;
+            return inv.getGainLoss().isNegative();
         });
 
     return losers;
 }
 
 double Portfolio::getAverageReturn() const {
+    METRIC_TIME_SCOPE(GetAverageReturn);
     if (investments.empty()) {
         return 0.0;
     }
 
-    double total_return = std::accumulate(investments.begin(), investments.end(), 0.0,
-        [](double sum, const Investment& inv) {
-            return sum + inv.getPercentageReturn();
-        });
-
+    double total_return = kernels::sumPercentageReturns(investments.data(), investments.size());
     return total_return / investments.size();
 }
+
+// Queries
+std::vector<size_t> Portfolio::query(const PositionQuery& query) const {
+    return query.execute(*this);
+}
+
+std::vector<size_t> Portfolio::query(const std::string& text) const {
+    return PositionQuery(text).execute(*this);
+}
+
+std::vector<const Investment*> Portfolio::select(const PositionQuery& query) const {
+    std::vector<size_t> rows = query.execute(*this);
+    std::vector<const Investment*> selected(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+        selected[i] = &investments[rows[i]];
+    }
+    return selected;
+}
+
 // Display methods
 void Portfolio::displayPortfolio() const {
     std::cout << "\n" << std::string(60, '=') << "\n";
@@ -228,28 +951,29 @@ void Portfolio::displayPortfolio() const {
         return;
     }
 
-    std::cout << std::left << std::setw(8) << "Symbol"
-              << std::setw(25) << "Company"
-              << std::setw(8) << "Shares"
-              << std::setw(12) << "Avg Cost"
-              << std::setw(12) << "Curr Price"
-              << std::setw(12) << "Value"
-              << std::setw(12) << "Gain/Loss"
-              << "Return%" << "\n";
-    std::cout << std::string(100, '-') << "\n";
-
-    std::cout << std::fixed << std::setprecision(2);
+    printPositionHeader();
     for (const auto& investment : investments) {
-        if (investment.getStock()) {
-            std::cout << std::left << std::setw(8) << investment.getStock()->getSymbol()
-                      << std::setw(25) << investment.getStock()->getCompanyName().substr(0, 24)
-                      << std::setw(8) << investment.getSharesOwned()
-                      << "$" << std::setw(11) << investment.getPurchasePrice()
-                      << "$" << std::setw(11) << investment.getStock()->getCurrentPrice()
-                      << "$" << std::setw(11) << investment.getCurrentValue()
-                      << "$" << std::setw(11) << investment.getGainLoss()
-                      << investment.getPercentageReturn() << "%\n";
-        }
+        printPositionRow(investment);
+    }
+}
+
+void Portfolio::displayPortfolio(const PositionQuery& query) const {
+    std::vector<size_t> rows = query.execute(*this);
+
+    std::cout << "\n" << std::string(60, '=') << "\n";
+    std::cout << "PORTFOLIO: " << portfolioName << "\n";
+    std::cout << "Query: " << query.getText() << " (" << rows.size() << " of "
+              << investments.size() << " positions)\n";
+    std::cout << std::string(60, '=') << "\n";
+
+    if (rows.empty()) {
+        std::cout << "No matching investments.\n";
+        return;
+    }
+
+    printPositionHeader();
+    for (size_t row : rows) {
+        printPositionRow(investments[row]);
     }
 }
 
@@ -264,6 +988,24 @@ void Portfolio::displaySummary() const {
     std::cout << "Total Gain/Loss: $" << getTotalGainLoss() << "\n";
     std::cout << "Portfolio Return: " << getPercentageReturn() << "%\n";
     std::cout << "Average Return: " << getAverageReturn() << "%\n";
+
+    auto exposures = getCurrencyExposures();
+    bool foreign = std::any_of(exposures.begin(), exposures.end(),
+        [this](const CurrencyExposure& e) { return e.currencyCode != getBaseCurrency(); });
+    if (foreign) {
+        std::cout << "Base Currency: " << getBaseCurrency() << "\n";
+        for (const auto& exposure : exposures) {
+            std::cout << "  " << exposure.currencyCode << ": " << exposure.positions << " positions, "
+                      << exposure.marketValue << " " << exposure.currencyCode;
+            if (exposure.fxRate > 0.0) {
+                std::cout << " = " << exposure.baseValue << " " << getBaseCurrency()
+                          << " @ " << std::setprecision(6) << exposure.fxRate << std::setprecision(2);
+            } else {
+                std::cout << " (no FX rate, excluded from value)";
+            }
+            std::cout << "\n";
+        }
+    }
 }
 
 void Portfolio::displayDetailedReport() const {
@@ -299,7 +1041,16 @@ bool Portfolio::saveToFile(const std::string& filename) const {
     if (!file.is_open()) {
         return false;
     }
+    return saveToStream(file);
+}
 
+bool Portfolio::saveToStream(std::ostream& file) const {
+    METRIC_TIME_SCOPE(SaveToFile);
+    // Money is written exactly only in the default format, so the caller's
+    // flags and precision are set aside here and restored on return
+    const std::ios_base::fmtflags callerFlags = file.flags();
+    const std::streamsize callerPrecision = file.precision();
+    file.flags(std::ios_base::dec);
     file << portfolioName << "\n";
     file << totalInitialInvestment << "\n";
     file << investments.size() << "\n";
@@ -312,12 +1063,52 @@ bool Portfolio::saveToFile(const std::string& filename) const {
                  << investment.getStock()->getPreviousPrice() << ","
                  << investment.getSharesOwned() << ","
                  << investment.getPurchasePrice() << ","
-                 << investment.getTotalInvested() << "\n";
+                 << investment.getTotalInvested() << ","
+                 << investment.getStock()->getCurrencyCode() << "\n";
         }
     }
+    METRIC_ADD(PositionsSaved, investments.size());
 
-    file.close();
-    return true;
+    // Trailer sections after the positions; older readers stop at the count
+    // above. Booked costs and dates first, before the stream switches to
+    // fixed output. SPLIT keeps corporate actions from being posted twice.
+    for (const auto& investment : investments) {
+        const std::shared_ptr<Stock>& stock = investment.getStock();
+        if (!stock) {
+            continue;
+        }
+        file << "COST," << stock->getSymbol() << "," << investment.getBookedCost() << "\n";
+        if (investment.getAcquiredDay() != 0) {
+            file << "ACQ," << stock->getSymbol() << "," << calendar::formatDay(investment.getAcquiredDay()) << "\n";
+        }
+        if (stock->getLastSplitDay() != 0) {
+            file << "SPLIT," << stock->getSymbol() << "," << calendar::formatDay(stock->getLastSplitDay()) << "\n";
+        }
+    }
+    file << "BASE," << getBaseCurrency() << "\n";
+    file << std::fixed << std::setprecision(FxRateTable::kRateDecimals);  // Exact rate units
+    for (CurrencyId currency : fxRates.getCurrencies()) {
+        if (currency != fxRates.getBaseCurrency()) {
+            file << "FX," << Currency::codeOf(currency) << "," << fxRates.getRate(currency) << "\n";
+        }
+    }
+
+    // Instrument attributes, one line per set field
+    for (const auto& investment : investments) {
+        const std::shared_ptr<Stock>& stock = investment.getStock();
+        if (!stock) {
+            continue;
+        }
+        for (AttributeField field : stock->getAttributeFields()) {
+            file << "ATTR," << stock->getSymbol() << "," << Attributes::fieldName(field) << ","
+                 << Attributes::decode(field, stock->getAttributeCode(field)) << "\n";
+        }
+    }
+
+    file.flush();
+    file.flags(callerFlags);
+    file.precision(callerPrecision);
+    return static_cast<bool>(file);
 }
 
 bool Portfolio::loadFromFile(const std::string& filename) {
@@ -325,8 +1116,17 @@ bool Portfolio::loadFromFile(const std::string& filename) {
     if (!file.is_open()) {
         return false;
     }
+    return loadFromStream(file);
+}
 
+bool Portfolio::loadFromStream(std::istream& file) {
+    METRIC_TIME_SCOPE(LoadFromFile);
+    detachPositions();
     investments.clear();
+    symbolIndexValid = false;
+    structureChanged();
+    fxRates = FxRateTable();
+    valuationValid = false;
 
     std::string line;
     if (!std::getline(file, portfolioName)) {
@@ -336,7 +1136,9 @@ bool Portfolio::loadFromFile(const std::string& filename) {
     if (!std::getline(file, line)) {
         return false;
     }
-    totalInitialInvestment = std::stod(line);
+    if (!Money::tryParse(line, totalInitialInvestment)) {
+        return false;
+    }
 
     if (!std::getline(file, line)) {
         return false;
@@ -350,7 +1152,7 @@ bool Portfolio::loadFromFile(const std::string& filename) {
 
         std::stringstream ss(line);
         std::string symbol, companyName, currentPriceStr, previousPriceStr;
-        std::string sharesStr, purchasePriceStr, totalInvestedStr;
+        std::string sharesStr, purchasePriceStr, totalInvestedStr, currencyStr;
 
         if (std::getline(ss, symbol, ',') &&
             std::getline(ss, companyName, ',') &&
@@ -358,26 +1160,87 @@ bool Portfolio::loadFromFile(const std::string& filename) {
             std::getline(ss, previousPriceStr, ',') &&
             std::getline(ss, sharesStr, ',') &&
             std::getline(ss, purchasePriceStr, ',') &&
-            std::getline(ss, totalInvestedStr)) {
+            std::getline(ss, totalInvestedStr, ',')) {
+            std::getline(ss, currencyStr);  // Optional; absent in older files
 
             try {
-                double currentPrice = std::stod(currentPriceStr);
-                double previousPrice = std::stod(previousPriceStr);
+                Money currentPrice = Money::fromString(currentPriceStr);
+                Money previousPrice = Money::fromString(previousPriceStr);
                 int shares = std::stoi(sharesStr);
-                double purchasePrice = std::stod(purchasePriceStr);
+                Money purchasePrice = Money::fromString(purchasePriceStr);
+                Money totalInvested = Money::fromString(totalInvestedStr);
 
-                auto stock = std::make_shared<Stock>(symbol, companyName, currentPrice);
+                auto stock = currencyStr.empty()
+                    ? std::make_shared<Stock>(symbol, companyName, currentPrice)
+                    : std::make_shared<Stock>(symbol, companyName, currentPrice, currencyStr);
                 stock->setPreviousPrice(previousPrice);
 
-                Investment investment(stock, shares, purchasePrice);
+                Investment investment(stock, shares, purchasePrice, totalInvested);
                 investments.push_back(investment);
+                investments.back().attachValuation(valuationCounter);
+                METRIC_INCREMENT(PositionsLoaded);
             } catch (const std::exception&) {
+                METRIC_INCREMENT(PositionsSkipped);
                 continue; // Skip invalid entries
             }
+        } else {
+            METRIC_INCREMENT(PositionsSkipped);
         }
     }
 
-    file.close();
+    std::unordered_map<std::string_view, Stock*> stockBySymbol;  // Built on the first ATTR line
+    bool bookedCosts = false;
+    while (std::getline(file, line)) {
+        std::stringstream ss(line);
+        std::string tag, code, rateStr;
+        if (!std::getline(ss, tag, ',') || !std::getline(ss, code, ',')) {
+            continue;
+        }
+        try {
+            if (tag == "BASE") {
+                fxRates.setBaseCurrency(Currency::idOf(code));
+            } else if (tag == "FX" && std::getline(ss, rateStr)) {
+                fxRates.setRate(Currency::idOf(code), std::stod(rateStr));
+            } else if (tag == "COST" && std::getline(ss, rateStr)) {
+                Money cost;
+                auto it = findInvestment(code);
+                if (Money::tryParse(rateStr, cost) && it != investments.end()) {
+                    it->setBookedCost(cost);
+                    bookedCosts = true;
+                }
+            } else if ((tag == "ACQ" || tag == "SPLIT") && std::getline(ss, rateStr)) {
+                int day = 0;
+                auto it = findInvestment(code);
+                if (calendar::parseDay(rateStr, day) && it != investments.end()) {
+                    if (tag == "ACQ") {
+                        it->setAcquiredDay(day);
+                    } else {
+                        it->getStock()->setLastSplitDay(day);
+                    }
+                }
+            } else if (tag == "ATTR") {
+                std::string field, value;
+                if (!std::getline(ss, field, ',')) {
+                    continue;
+                }
+                std::getline(ss, value);
+                if (stockBySymbol.empty()) {
+                    for (const auto& investment : investments) {
+                        stockBySymbol.emplace(investment.getStock()->getSymbol(), investment.getStock().get());
+                    }
+                }
+                auto found = stockBySymbol.find(code);
+                if (found != stockBySymbol.end()) {
+                    found->second->setAttribute(field, value);
+                }
+            }
+        } catch (const std::exception&) {
+            continue; // Skip invalid entries
+        }
+    }
+    if (!bookedCosts) {
+        spreadBookedCost();
+    }
     return true;
 }
 
@@ -386,32 +1249,107 @@ bool Portfolio::exportToCSV(const std::string& filename) const {
     if (!file.is_open()) {
         return false;
     }
+    return exportToCSV(file);
+}
 
-    file << "Symbol,Company,Shares,Purchase Price,Current Price,Current Value,Gain/Loss,Return %\n";
-
+bool Portfolio::exportToCSV(std::ostream& file) const {
+    METRIC_TIME_SCOPE(ExportToCSV);
+    writeCSVHeader(file);
     for (const auto& investment : investments) {
-        if (investment.getStock()) {
-            file << investment.getStock()->getSymbol() << ","
-                 << investment.getStock()->getCompanyName() << ","
-                 << investment.getSharesOwned() << ","
-                 << std::fixed << std::setprecision(2) << investment.getPurchasePrice() << ","
-                 << investment.getStock()->getCurrentPrice() << ","
-                 << investment.getCurrentValue() << ","
-                 << investment.getGainLoss() << ","
-                 << investment.getPercentageReturn() << "\n";
-        }
+        writeCSVRow(file, investment);
+    }
+    METRIC_ADD(PositionsExported, investments.size());
+
+    file.flush();
+    return static_cast<bool>(file);
+}
+
+bool Portfolio::exportToCSV(const std::string& filename, const PositionQuery& query) const {
+    METRIC_TIME_SCOPE(ExportToCSV);
+    std::vector<size_t> rows = query.execute(*this);
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        return false;
     }
 
+    writeCSVHeader(file);
+    for (size_t row : rows) {
+        writeCSVRow(file, investments[row]);
+    }
+    METRIC_ADD(PositionsExported, rows.size());
+
     file.close();
+    return static_cast<bool>(file);
+}
+
+bool Portfolio::exportToColumnar(const std::string& filename) const {
+    return ColumnarWriter::write(*this, filename);
+}
+
+bool Portfolio::exportToColumnar(std::ostream& out) const {
+    return ColumnarWriter::write(*this, out);
+}
+
+bool Portfolio::loadFromColumnar(const std::string& filename) {
+    METRIC_TIME_SCOPE(LoadColumnar);
+    ColumnarReader reader;
+    if (!reader.open(filename)) {
+        return false;
+    }
+
+    // Decode into a scratch vector so a damaged file leaves this portfolio
+    // intact. open() has checked the row count against the file's size.
+    std::vector<Investment> loaded;
+    loaded.reserve(static_cast<size_t>(reader.getRowCount()));
+    for (size_t group = 0; group < reader.getRowGroups().size(); ++group) {
+        if (!reader.readRowGroup(group, loaded)) {
+            return false;
+        }
+    }
+
+    FxRateTable rates;
+    try {
+        rates.setBaseCurrency(Currency::idOf(reader.getBaseCurrency()));
+        for (const auto& rate : reader.getFxRateUnits()) {
+            CurrencyId currency = Currency::idOf(rate.first);
+            if (currency != rates.getBaseCurrency()) {
+                rates.setRate(currency, static_cast<double>(rate.second) / FxRateTable::kRateScale);
+            }
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+
+    detachPositions();
+    investments.swap(loaded);
+    attachPositions();
+    symbolIndexValid = false;
+    structureChanged();
+    portfolioName = reader.getPortfolioName();
+    totalInitialInvestment = reader.getTotalInitialInvestment();
+    fxRates = rates;
+    spreadBookedCost();
+    valuationValid = false;
     return true;
 }
 
 // Operators
 Portfolio& Portfolio::operator=(const Portfolio& other) {
     if (this != &other) {
+        bool fresh = other.valuationFresh();
+        detachPositions();
         investments = other.investments;
+        attachPositions();
+        symbolIndexValid = false;
+        structureChanged();
         portfolioName = other.portfolioName;
         totalInitialInvestment = other.totalInitialInvestment;
+        fxRates = other.fxRates;
+        currencyTotals = other.currencyTotals;
+        trackedGroups = other.trackedGroups;
+        baseValue = other.baseValue;
+        valuationValid = fresh;
+        returnThresholds = other.returnThresholds;
     }
     return *this;
 }
@@ -420,6 +1358,7 @@ Investment& Portfolio::operator[](size_t index) {
     if (index >= investments.size()) {
         throw std::out_of_range("Index out of range");
     }
+    symbolIndexValid = false;  // The caller may replace the position
     return investments[index];
 }
 
@@ -432,10 +1371,12 @@ const Investment& Portfolio::operator[](size_t index) const {
 
 // Iterator support
 std::vector<Investment>::iterator Portfolio::begin() {
+    symbolIndexValid = false;
     return investments.begin();
 }
 
 std::vector<Investment>::iterator Portfolio::end() {
+    symbolIndexValid = false;
     return investments.end();
 }
 
@@ -2,21 +2,121 @@
 #define PORTFOLIO_H
 
 #include "Investment.h"
+#include "FxRateTable.h"
+#include "PortfolioEvents.h"
+#include "TickListener.h"
 #include <vector>
 #include <string>
 #include <algorithm>
 #include <fstream>
 #include <memory>
+#include <unordered_map>
+
+class PositionQuery;
+class SnapshotCapture;
+
+// Holdings in one currency, in that currency and converted to the base currency
+struct CurrencyExposure {
+    std::string currencyCode;
+    size_t positions = 0;
+    Money marketValue;
+    Money costBasis;
+    Money baseValue;
+    double fxRate = 0.0;
+};
+
+// Holdings sharing one attribute value (e.g. one sector), in the base currency
+struct GroupRollup {
+    std::string group;  // "" collects positions without a value
+    size_t positions = 0;
+    Money marketValue;
+    Money costBasis;
+    Money gainLoss;
+    double returnPercent = 0.0;
+    double weight = 0.0;  // Share of the portfolio value
+};
+
+// One entry of a batched price update
+struct PriceUpdate {
+    std::string symbol;
+    Money price;
+};
 
 class Portfolio {
 private:
     std::vector<Investment> investments;  // Composition - Portfolio composes Investment objects
     std::string portfolioName;
-    double totalInitialInvestment;
+    Money totalInitialInvestment;  // In the base currency, at the FX rate of each trade
+    FxRateTable fxRates;
+
+    // Valuation maintained incrementally by the mutators below and rebuilt in
+    // one grouped pass when ValuationEpoch shows an outside edit.
+    struct CurrencyTotals {
+        Money marketValue;
+        Money costBasis;
+        Money baseValue;
+        size_t positions = 0;
+    };
+    mutable std::vector<CurrencyTotals> currencyTotals;  // Indexed by CurrencyId
+
+    // Group-by rollups for tracked attribute fields, maintained with the same
+    // deltas as the currency totals. Local-currency units per [code][currency].
+    struct GroupCell {
+        std::int64_t valueUnits = 0;
+        std::int64_t costUnits = 0;
+        std::uint32_t positions = 0;
+    };
+    struct TrackedGroup {
+        AttributeField field;
+        std::vector<std::vector<GroupCell>> cells;
+    };
+    mutable std::vector<TrackedGroup> trackedGroups;
+    mutable Money baseValue;
+    ValuationEpochPtr valuationCounter;  // This portfolio's version; see ValuationEpoch.h
+    mutable std::uint64_t valuationEpoch;  // valuationCounter as of the totals above
+    mutable bool valuationValid;
+
+    // Change notification. The dispatcher is created on the first subscribe
+    // and belongs to this object only; copies start without subscribers.
+    std::shared_ptr<EventDispatcher> events;
+    std::vector<double> returnThresholds;  // Watched position returns, in percent
+    std::vector<TickListener*> tickListeners;  // Not owned, not copied
+
+    // Symbol -> position for findInvestment, so per-tick lookups are O(1).
+    // Rebuilt lazily after anything that can reorder or replace positions,
+    // including non-const element access and getInvestment. Keys are copies:
+    // a position replaced through a mutable reference may free its Stock.
+    mutable std::unordered_map<std::string, size_t> symbolIndex;
+    mutable bool symbolIndexValid;
+
+    // Background snapshots (see AsyncPersistence.h). structureVersion moves on
+    // every change the Portfolio makes other than a price or FX tick; an
+    // in-progress capture restarts when it does, and is told about ticks
+    // before they land. Element access is not a change: edits through the
+    // returned references are not tracked. Neither is copied.
+    std::uint64_t structureVersion;
+    SnapshotCapture* activeCapture;
+    friend class SnapshotCapture;
 
     // Private helper methods
     std::vector<Investment>::iterator findInvestment(const std::string& symbol);
     std::vector<Investment>::const_iterator findInvestment(const std::string& symbol) const;
+    size_t indexOf(const std::string& symbol) const;  // investments.size() when absent
+    void rebuildSymbolIndex() const;
+    bool valuationFresh() const;
+    void ensureValuation() const;
+    void rebuildValuation() const;
+    void applyValuationDelta(const Stock* stock, Money valueDelta, Money costDelta, long positionDelta) const;
+    void convertCurrencyTotal(CurrencyId currency) const;
+    void computeGroupCells(AttributeField field, std::vector<std::vector<GroupCell>>& cells) const;
+    void finishValuationUpdate(bool wasFresh, std::uint64_t expectedEpoch) const;
+    void spreadBookedCost();
+    void attachPositions();
+    void detachPositions();
+    bool applyPrice(Investment& investment, Money newPrice);
+    void publishPositionEvent(PortfolioEventType type, const std::string& symbol);
+    void endTickBatch();
+    void structureChanged() { ++structureVersion; }
 
 public:
     // Constructors and Destructor
@@ -28,21 +128,59 @@ public:
     // Getters
     std::string getPortfolioName() const;
     size_t getInvestmentCount() const;
-    double getTotalInitialInvestment() const;
+    Money getTotalInitialInvestment() const;
 
     // Setters
     void setPortfolioName(const std::string& name);
 
-    // Investment management
+    // Currencies and FX
+    std::string getBaseCurrency() const;
+    // Refused (false) while positions are held: their booked costs are in
+    // the current base currency
+    bool setBaseCurrency(const std::string& currencyCode);
+    bool updateFxRate(const std::string& currencyCode, double rate);
+    const FxRateTable& getFxRates() const;
+    std::vector<CurrencyExposure> getCurrencyExposures() const;
+
+    // Grouping by instrument attribute ("sector", "industry", "country", custom)
+    std::vector<GroupRollup> groupBy(const std::string& field) const;
+    void trackGroupBy(const std::string& field);  // Keep the rollup current on every tick
+    bool untrackGroupBy(const std::string& field);
+
+    // Investment management. Adds in a currency without an FX rate are
+    // refused: the cost is booked in the base currency at the trade's rate.
+    // A new position without an acquisition day is dated today; a top-up
+    // keeps the first purchase's day.
     bool addInvestment(const Investment& investment);
     bool removeInvestment(const std::string& symbol);
+    bool removeShares(const std::string& symbol, int shares);  // Closes the position at zero
+    bool updateStockPrice(const std::string& symbol, Money newPrice);
     bool updateStockPrice(const std::string& symbol, double newPrice);
+    size_t updateStockPrices(const std::vector<PriceUpdate>& updates);  // Returns ticks applied
+    // Posts a split or stock dividend to the holding's Stock (see
+    // Stock::applySplit), pays any fractional new share as cash in lieu and
+    // notifies tick listeners (onSplit, then onBatchEnd) and subscribers
+    // (PositionSplit). False if the symbol is not held or the split share
+    // count would not fit in an int; throws std::invalid_argument for a
+    // non-positive ratio.
+    bool applySplit(const std::string& symbol, SplitRatio ratio, int exDay = 0);
     Investment* getInvestment(const std::string& symbol);
     const Investment* getInvestment(const std::string& symbol) const;
 
+    // Change notification (callbacks run on a dispatcher thread)
+    SubscriptionId subscribe(PortfolioEventCallback callback, unsigned mask = kAllPortfolioEvents);
+    bool unsubscribe(SubscriptionId id);
+    void watchReturnThreshold(double percent);
+    void clearReturnThresholds();
+    void flushEvents();
+
+    // Synchronous per-tick hooks (run on the updating thread)
+    void addTickListener(TickListener* listener);
+    bool removeTickListener(TickListener* listener);
+
     // Portfolio calculations
-    double getCurrentValue() const;
-    double getTotalGainLoss() const;
+    Money getCurrentValue() const;
+    Money getTotalGainLoss() const;
     double getPercentageReturn() const;
 
     // STL Algorithm usage
@@ -56,8 +194,17 @@ public:
     std::vector<Investment> getLosers() const;
     double getAverageReturn() const;
 
+    // Queries, e.g. "sector = Energy and return < 0 sort value desc limit 10"
+    // (see PositionQuery.h). Both return rows in result order and stay valid
+    // until the portfolio is next modified. Throw std::invalid_argument on a
+    // malformed query.
+    std::vector<size_t> query(const PositionQuery& query) const;  // Indices for operator[]
+    std::vector<size_t> query(const std::string& text) const;
+    std::vector<const Investment*> select(const PositionQuery& query) const;
+
     // Display methods
     void displayPortfolio() const;
+    void displayPortfolio(const PositionQuery& query) const;
     void displaySummary() const;
     void displayDetailedReport() const;
 
@@ -65,6 +212,15 @@ public:
     bool saveToFile(const std::string& filename) const;
     bool loadFromFile(const std::string& filename);
     bool exportToCSV(const std::string& filename) const;
+    // The same formats on an open stream
+    bool saveToStream(std::ostream& out) const;
+    bool loadFromStream(std::istream& in);
+    bool exportToCSV(std::ostream& out) const;
+    bool exportToCSV(const std::string& filename, const PositionQuery& query) const;
+    // Typed, compressed column file with exact Money values (see ColumnarFile.h)
+    bool exportToColumnar(const std::string& filename) const;
+    bool exportToColumnar(std::ostream& out) const;
+    bool loadFromColumnar(const std::string& filename);
 
     // Operators
     Portfolio& operator=(const Portfolio& other);
@@ -0,0 +1,219 @@
+#include "PortfolioEvents.h"
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+
+// How long an idle worker sleeps before re-checking the queue when no
+// producer wake-up arrives.
+constexpr std::chrono::milliseconds kIdleWait(50);
+
+} // namespace
+
+// Constructors and destructor
+EventDispatcher::EventDispatcher() : EventDispatcher(Options()) {}
+
+EventDispatcher::EventDispatcher(const Options& options)
+    : options(options), queue(options.queueCapacity), published(0), processed(0),
+      dropped(0), latestValueUnits(0), batchDepth(0), idle(false), stopping(false), nextId(1),
+      pendingRaw(0) {
+    worker = std::thread(&EventDispatcher::run, this);
+}
+
+EventDispatcher::~EventDispatcher() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping.store(true, std::memory_order_release);
+    }
+    wake.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+// Subscription management
+SubscriptionId EventDispatcher::subscribe(PortfolioEventCallback callback, unsigned mask) {
+    std::lock_guard<std::mutex> lock(subscriberMutex);
+    SubscriptionId id = nextId++;
+    subscribers.push_back({id, mask, std::move(callback)});
+    return id;
+}
+
+bool EventDispatcher::unsubscribe(SubscriptionId id) {
+    std::lock_guard<std::mutex> lock(subscriberMutex);
+    auto it = std::find_if(subscribers.begin(), subscribers.end(),
+                           [id](const Subscriber& s) { return s.id == id; });
+    if (it == subscribers.end()) {
+        return false;
+    }
+    subscribers.erase(it);
+    return true;
+}
+
+// Producer side
+void EventDispatcher::publish(PortfolioEvent&& event) {
+    latestValueUnits.store(event.portfolioValue.raw(), std::memory_order_relaxed);
+    if (!queue.tryPush(std::move(event))) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    // Counted after the push so the worker never sees a published count that
+    // includes an event it cannot drain yet.
+    published.fetch_add(1, std::memory_order_release);
+    // Only pay for a notify when the worker is parked on its long idle wait;
+    // a missed wake-up costs at most kIdleWait of latency.
+    if (idle.load(std::memory_order_relaxed)) {
+        idle.store(false, std::memory_order_relaxed);
+        wake.notify_one();
+    }
+}
+
+void EventDispatcher::beginBatch() {
+    batchDepth.fetch_add(1, std::memory_order_relaxed);
+}
+
+void EventDispatcher::endBatch() {
+    // Release so the worker that sees the batch closed also sees its events
+    if (batchDepth.fetch_sub(1, std::memory_order_release) == 1) {
+        idle.store(false, std::memory_order_relaxed);
+        wake.notify_one();
+    }
+}
+
+void EventDispatcher::flush() {
+    std::uint64_t target = published.load(std::memory_order_acquire);
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    wake.notify_one();
+    drained.wait(lock, [&] {
+        return processed.load(std::memory_order_acquire) >= target ||
+               stopping.load(std::memory_order_acquire);
+    });
+}
+
+// Worker side
+void EventDispatcher::run() {
+    PortfolioEvent event;
+    std::chrono::steady_clock::time_point roundStart;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            if (pendingRaw > 0 || !queue.empty()) {
+                // Hold a round open for one coalescing window so a burst of
+                // ticks is folded into a single delivery.
+                wake.wait_for(lock, options.coalesceWindow,
+                              [&] { return stopping.load(std::memory_order_acquire); });
+            } else {
+                idle.store(true, std::memory_order_relaxed);
+                wake.wait_for(lock, kIdleWait, [&] {
+                    return stopping.load(std::memory_order_acquire) || !queue.empty();
+                });
+                idle.store(false, std::memory_order_relaxed);
+            }
+        }
+
+        // Read the batch state and published count before draining: anything
+        // they account for has already been pushed and is drained below.
+        bool batchOpen = batchDepth.load(std::memory_order_acquire) > 0;
+        std::uint64_t publishedSoFar = published.load(std::memory_order_acquire);
+        bool wasEmpty = pendingRaw == 0;
+        while (queue.tryPop(event)) {
+            fold(std::move(event));
+        }
+        if (wasEmpty && pendingRaw > 0) {
+            roundStart = std::chrono::steady_clock::now();
+        }
+
+        bool stop = stopping.load(std::memory_order_acquire);
+        bool windowElapsed = std::chrono::steady_clock::now() - roundStart >= options.coalesceWindow;
+        std::uint64_t droppedCount = 0;
+        if (!batchOpen && (windowElapsed || stop)) {
+            droppedCount = dropped.exchange(0, std::memory_order_relaxed);
+        }
+        if (droppedCount > 0 || (pendingRaw > 0 && !batchOpen && (windowElapsed || stop))) {
+            deliver(droppedCount);
+        }
+
+        if (pendingRaw == 0 && !batchOpen) {
+            {
+                std::lock_guard<std::mutex> lock(wakeMutex);
+                processed.store(publishedSoFar, std::memory_order_release);
+            }
+            drained.notify_all();
+        }
+
+        if (stop && queue.empty() && pendingRaw == 0) {
+            break;
+        }
+    }
+    drained.notify_all();
+}
+
+// Folds one raw event into the current round: price changes collapse to one
+// entry per symbol (first old price, last new price), everything else keeps
+// its arrival order.
+void EventDispatcher::fold(PortfolioEvent&& event) {
+    ++pendingRaw;
+    pendingValue = event.portfolioValue;
+    if (event.type == PortfolioEventType::PortfolioRevalued) {
+        return;
+    }
+    if (event.type == PortfolioEventType::PriceChanged) {
+        auto found = pendingPrices.find(event.symbol);
+        if (found != pendingPrices.end()) {
+            PortfolioEvent& existing = pending[found->second];
+            existing.newPrice = event.newPrice;
+            existing.portfolioValue = event.portfolioValue;
+            existing.coalescedCount += event.coalescedCount;
+            return;
+        }
+        pendingPrices.emplace(event.symbol, pending.size());
+    }
+    pending.push_back(std::move(event));
+}
+
+// Closes the round with one PortfolioRevalued event and hands it to every
+// subscriber whose mask matches.
+void EventDispatcher::deliver(std::uint64_t droppedCount) {
+    PortfolioEvent revalued;
+    revalued.type = PortfolioEventType::PortfolioRevalued;
+    // If everything this round was dropped, fall back to the value recorded by
+    // the producer on its last publish.
+    revalued.portfolioValue = pendingRaw > 0 ? pendingValue
+                                             : Money::fromUnits(latestValueUnits.load(std::memory_order_relaxed));
+    revalued.coalescedCount = pendingRaw;
+    revalued.droppedCount = static_cast<size_t>(droppedCount);
+    pending.push_back(std::move(revalued));
+
+    // Copy the subscriber list so callbacks run without holding the lock and
+    // may themselves subscribe or unsubscribe.
+    std::vector<Subscriber> targets;
+    {
+        std::lock_guard<std::mutex> lock(subscriberMutex);
+        targets = subscribers;
+    }
+
+    std::vector<PortfolioEvent> filtered;
+    for (const Subscriber& subscriber : targets) {
+        const std::vector<PortfolioEvent>* delivery = &pending;
+        if ((subscriber.mask & kAllPortfolioEvents) != kAllPortfolioEvents) {
+            filtered.clear();
+            for (const PortfolioEvent& event : pending) {
+                if (subscriber.mask & eventMask(event.type)) {
+                    filtered.push_back(event);
+                }
+            }
+            if (filtered.empty()) {
+                continue;
+            }
+            delivery = &filtered;
+        }
+        try {
+            subscriber.callback(*delivery);
+        } catch (...) {
+            // A failing subscriber must not take down the dispatch thread
+        }
+    }
+
+    pending.clear();
+    pendingPrices.clear();
+    pendingRaw = 0;
+}
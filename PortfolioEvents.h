@@ -0,0 +1,122 @@
+#ifndef PORTFOLIO_EVENTS_H
+#define PORTFOLIO_EVENTS_H
+
+#include "Money.h"
+#include "SpscQueue.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+enum class PortfolioEventType : std::uint8_t {
+    PositionAdded = 1 << 0,      // Position opened or increased
+    PositionRemoved = 1 << 1,    // Position reduced or closed
+    PriceChanged = 1 << 2,
+    ThresholdCrossed = 1 << 3,
+    PortfolioRevalued = 1 << 4,
+    PositionSplit = 1 << 5,      // Split or stock dividend posted
+};
+
+constexpr unsigned kAllPortfolioEvents = 0x3F;
+
+constexpr unsigned eventMask(PortfolioEventType type) {
+    return static_cast<unsigned>(type);
+}
+
+struct PortfolioEvent {
+    PortfolioEventType type = PortfolioEventType::PortfolioRevalued;
+    std::string symbol;          // Empty for PortfolioRevalued
+    Money oldPrice;              // PriceChanged: price before the first coalesced tick;
+                                 // PositionSplit: price before the split
+    Money newPrice;              // PriceChanged: latest price; PositionSplit: rescaled price
+    Money cashInLieu;            // PositionSplit: fractional share paid out, base currency
+    double returnPercent = 0.0;  // ThresholdCrossed: position return after the tick
+    double threshold = 0.0;      // ThresholdCrossed: the watched return level
+    bool crossedBelow = false;   // ThresholdCrossed: direction of the crossing
+    Money portfolioValue;        // Portfolio value after the (last) mutation
+    size_t coalescedCount = 1;   // Raw notifications folded into this event
+    size_t droppedCount = 0;     // PortfolioRevalued: notifications lost to queue overflow
+};
+
+// Subscribers receive one coalesced batch per dispatch round.
+using PortfolioEventCallback = std::function<void(const std::vector<PortfolioEvent>&)>;
+using SubscriptionId = std::uint64_t;
+
+// Moves notifications off the mutation thread. The producer only pushes into a
+// lock-free SPSC queue; a worker thread drains it, folds repeated price changes
+// per symbol and, once the coalescing window has passed and no batch is open,
+// delivers the round with a single trailing PortfolioRevalued event. If the
+// queue overflows, events are dropped and the next PortfolioRevalued reports
+// how many.
+class EventDispatcher {
+public:
+    struct Options {
+        size_t queueCapacity = 65536;
+        std::chrono::microseconds coalesceWindow = std::chrono::microseconds(2000);
+    };
+
+private:
+    struct Subscriber {
+        SubscriptionId id;
+        unsigned mask;
+        PortfolioEventCallback callback;
+    };
+
+    Options options;
+    SpscQueue<PortfolioEvent> queue;
+    std::atomic<std::uint64_t> published;
+    std::atomic<std::uint64_t> processed;
+    std::atomic<std::uint64_t> dropped;
+    std::atomic<std::int64_t> latestValueUnits;
+    std::atomic<int> batchDepth;
+    std::atomic<bool> idle;
+    std::atomic<bool> stopping;
+
+    std::mutex subscriberMutex;
+    std::vector<Subscriber> subscribers;
+    SubscriptionId nextId;
+
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    std::condition_variable drained;
+    std::thread worker;
+
+    // Round being coalesced; touched only by the worker thread
+    std::vector<PortfolioEvent> pending;
+    std::unordered_map<std::string, size_t> pendingPrices;  // Symbol -> index in pending
+    size_t pendingRaw;
+    Money pendingValue;
+
+    void run();
+    void fold(PortfolioEvent&& event);
+    void deliver(std::uint64_t droppedCount);
+
+public:
+    EventDispatcher();
+    explicit EventDispatcher(const Options& options);
+    ~EventDispatcher();
+
+    EventDispatcher(const EventDispatcher&) = delete;
+    EventDispatcher& operator=(const EventDispatcher&) = delete;
+
+    SubscriptionId subscribe(PortfolioEventCallback callback, unsigned mask = kAllPortfolioEvents);
+    bool unsubscribe(SubscriptionId id);
+
+    // Producer side: never blocks or allocates beyond moving the event in.
+    void publish(PortfolioEvent&& event);
+
+    // Events published between these calls are delivered in one round
+    void beginBatch();
+    void endBatch();
+
+    // Blocks until everything published so far has been delivered.
+    void flush();
+};
+
+#endif // PORTFOLIO_EVENTS_H
@@ -0,0 +1,284 @@
+#ifndef POSITION_BOOK_H
+#define POSITION_BOOK_H
+
+#include "Portfolio.h"
+#include "PositionPolicies.h"
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Storage backends. Both expose the same per-row accessors, so the book's
+// loops are written once and the compiler sees plain array walks: strided
+// over rows for AosStorage, unit-stride per column for SoaStorage, which the
+// valuation loops vectorize over.
+
+// Array of structs: one row per position, everything for a symbol together
+template <typename Traits>
+class AosStorage {
+private:
+    using Quantity = typename Traits::Quantity;
+    using Price = typename Traits::Price;
+    using CostState = typename Traits::CostState;
+
+    struct Row {
+        std::string symbol;
+        Quantity quantity;
+        Price price;
+        CostState cost;
+    };
+    std::vector<Row> rows;
+
+public:
+    size_t size() const { return rows.size(); }
+    void reserve(size_t capacity) { rows.reserve(capacity); }
+    void clear() { rows.clear(); }
+
+    size_t append(const std::string& symbol) {
+        rows.push_back(Row{symbol, Quantity(), Price(), CostState()});
+        return rows.size() - 1;
+    }
+    // Moves the last row into slot i
+    void swapRemove(size_t i) {
+        if (i + 1 != rows.size()) {
+            rows[i] = std::move(rows.back());
+        }
+        rows.pop_back();
+    }
+
+    const std::string& symbol(size_t i) const { return rows[i].symbol; }
+    Quantity& quantity(size_t i) { return rows[i].quantity; }
+    Quantity quantity(size_t i) const { return rows[i].quantity; }
+    Price& price(size_t i) { return rows[i].price; }
+    Price price(size_t i) const { return rows[i].price; }
+    CostState& cost(size_t i) { return rows[i].cost; }
+    const CostState& cost(size_t i) const { return rows[i].cost; }
+};
+
+// Struct of arrays: one vector per field
+template <typename Traits>
+class SoaStorage {
+private:
+    using Quantity = typename Traits::Quantity;
+    using Price = typename Traits::Price;
+    using CostState = typename Traits::CostState;
+
+    std::vector<std::string> symbols;
+    std::vector<Quantity> quantities;
+    std::vector<Price> prices;
+    std::vector<CostState> costs;
+
+    template <typename Column>
+    static void swapRemove(Column& column, size_t i) {
+        if (i + 1 != column.size()) {
+            column[i] = std::move(column.back());
+        }
+        column.pop_back();
+    }
+
+public:
+    size_t size() const { return symbols.size(); }
+    void reserve(size_t capacity) {
+        symbols.reserve(capacity);
+        quantities.reserve(capacity);
+        prices.reserve(capacity);
+        costs.reserve(capacity);
+    }
+    void clear() {
+        symbols.clear();
+        quantities.clear();
+        prices.clear();
+        costs.clear();
+    }
+
+    size_t append(const std::string& symbol) {
+        symbols.push_back(symbol);
+        quantities.push_back(Quantity());
+        prices.push_back(Price());
+        costs.push_back(CostState());
+        return symbols.size() - 1;
+    }
+    void swapRemove(size_t i) {
+        swapRemove(symbols, i);
+        swapRemove(quantities, i);
+        swapRemove(prices, i);
+        swapRemove(costs, i);
+    }
+
+    const std::string& symbol(size_t i) const { return symbols[i]; }
+    Quantity& quantity(size_t i) { return quantities[i]; }
+    Quantity quantity(size_t i) const { return quantities[i]; }
+    Price& price(size_t i) { return prices[i]; }
+    Price price(size_t i) const { return prices[i]; }
+    CostState& cost(size_t i) { return costs[i]; }
+    const CostState& cost(size_t i) const { return costs[i]; }
+};
+
+// Single-currency position book specialised at compile time on its quantity,
+// price and cost-basis policies (bundled as PositionTraits) and its storage
+// backend. It is the lean core for desks that need a different arithmetic or
+// layout than Portfolio's; it does not carry Portfolio's FX conversion,
+// change events, attributes or persistence. Amounts are in the positions' own
+// currency, as Investment's are. Like Investment, invalid quantities and
+// prices throw std::invalid_argument, and a buy that would take the quantity
+// held past what the quantity type holds throws std::overflow_error (before
+// changing anything); lookups by symbol return false or npos.
+template <typename Traits, template <typename> class Storage = AosStorage>
+class BasicPositionBook {
+public:
+    using Quantity = typename Traits::Quantity;
+    using Price = typename Traits::Price;
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+private:
+    Storage<Traits> rows;
+    std::unordered_map<std::string, size_t> index;
+
+public:
+    size_t size() const { return rows.size(); }
+    bool empty() const { return rows.size() == 0; }
+    void reserve(size_t capacity) {
+        rows.reserve(capacity);
+        index.reserve(capacity);
+    }
+    void clear() {
+        rows.clear();
+        index.clear();
+    }
+
+    size_t find(const std::string& symbol) const {
+        auto it = index.find(symbol);
+        return it == index.end() ? npos : it->second;
+    }
+
+    // Adds a lot costing `cost` in total, opening the position at
+    // `marketPrice` if it is new; an existing position keeps its price.
+    void buy(const std::string& symbol, Quantity quantity, Price marketPrice, Price cost) {
+        std::int64_t units = Traits::raw(quantity);
+        if (units <= 0) {
+            throw std::invalid_argument("Quantity to buy must be positive");
+        }
+        if (Traits::isNegative(marketPrice) || Traits::isNegative(cost)) {
+            throw std::invalid_argument("Price cannot be negative");
+        }
+        size_t i = find(symbol);
+        const std::int64_t held = i == npos ? 0 : Traits::raw(rows.quantity(i));
+        if (units > Traits::kMaxQuantity - held) {
+            throw std::overflow_error("Quantity held in " + symbol + " would be out of range");
+        }
+        if (i == npos) {
+            i = rows.append(symbol);
+            index.emplace(symbol, i);
+            rows.price(i) = marketPrice;
+        }
+        Traits::buy(rows.cost(i), units, cost);
+        rows.quantity(i) = Traits::fromRaw(held + units);
+    }
+
+    void buy(const std::string& symbol, Quantity quantity, Price pricePerUnit) {
+        buy(symbol, quantity, pricePerUnit, Traits::extend(pricePerUnit, Traits::raw(quantity)));
+    }
+
+    // Returns the realized gain at the current price. Selling the whole
+    // quantity leaves an empty position, which stays until remove().
+    Price sell(const std::string& symbol, Quantity quantity) {
+        std::int64_t units = Traits::raw(quantity);
+        size_t i = find(symbol);
+        if (i == npos) {
+            throw std::invalid_argument("No position in " + symbol);
+        }
+        std::int64_t held = Traits::raw(rows.quantity(i));
+        if (units <= 0) {
+            throw std::invalid_argument("Quantity to sell must be positive");
+        }
+        if (units > held) {
+            throw std::invalid_argument("Cannot sell more than held");
+        }
+        Price basis = Traits::sell(rows.cost(i), units, held);
+        rows.quantity(i) = Traits::fromRaw(held - units);
+        return Traits::extend(rows.price(i), units) - basis;
+    }
+
+    bool remove(const std::string& symbol) {
+        size_t i = find(symbol);
+        if (i == npos) {
+            return false;
+        }
+        index.erase(symbol);
+        size_t last = rows.size() - 1;
+        if (i != last) {
+            index[rows.symbol(last)] = i;
+        }
+        rows.swapRemove(i);
+        return true;
+    }
+
+    bool updatePrice(const std::string& symbol, Price price) {
+        size_t i = find(symbol);
+        if (i == npos || Traits::isNegative(price)) {
+            return false;
+        }
+        rows.price(i) = price;
+        return true;
+    }
+
+    // Per-position accessors
+    const std::string& symbol(size_t i) const { return rows.symbol(i); }
+    Quantity quantity(size_t i) const { return rows.quantity(i); }
+    Price price(size_t i) const { return rows.price(i); }
+    Price costBasis(size_t i) const { return Traits::cost(rows.cost(i)); }
+    Price averageCost(size_t i) const { return Traits::perUnit(costBasis(i), Traits::raw(rows.quantity(i))); }
+    Price value(size_t i) const { return Traits::extend(rows.price(i), Traits::raw(rows.quantity(i))); }
+    Price gainLoss(size_t i) const { return value(i) - costBasis(i); }
+
+    // Aggregates, recomputed on each call
+    Price totalValue() const {
+        Price total{};
+        const size_t n = rows.size();
+        for (size_t i = 0; i < n; ++i) {
+            total += Traits::extend(rows.price(i), Traits::raw(rows.quantity(i)));
+        }
+        return total;
+    }
+
+    Price totalCost() const {
+        Price total{};
+        const size_t n = rows.size();
+        for (size_t i = 0; i < n; ++i) {
+            total += Traits::cost(rows.cost(i));
+        }
+        return total;
+    }
+
+    Price totalGainLoss() const { return totalValue() - totalCost(); }
+
+    // Replaces the book's contents with a snapshot of a portfolio's stock
+    // positions at their current prices and exact cost bases
+    void assign(const Portfolio& portfolio) {
+        clear();
+        reserve(portfolio.getInvestmentCount());
+        for (const Investment& investment : portfolio) {
+            if (!investment.getStock() || investment.getSharesOwned() <= 0) {
+                continue;
+            }
+            std::int64_t units = static_cast<std::int64_t>(investment.getSharesOwned()) * Traits::kQuantityScale;
+            buy(investment.getStock()->getSymbol(), Traits::fromRaw(units),
+                Traits::fromMoney(investment.getStock()->getCurrentPrice()),
+                Traits::fromMoney(investment.getTotalInvested()));
+        }
+    }
+};
+
+// Default instantiation: Investment's arithmetic (32-bit whole shares, Money,
+// weighted-average cost), so its values match Portfolio's to the unit.
+using DefaultPositionTraits = PositionTraits<Int32Quantity, MoneyPrice, AverageCost>;
+using DefaultPositionBook = BasicPositionBook<DefaultPositionTraits, AosStorage>;
+
+// Equities: the same arithmetic, column-major for valuation scans
+using EquityPositionBook = BasicPositionBook<DefaultPositionTraits, SoaStorage>;
+
+// Crypto: fractional quantities with FIFO lots
+using CryptoPositionBook = BasicPositionBook<PositionTraits<FractionalQuantity, MoneyPrice, FifoCost>, AosStorage>;
+
+#endif // POSITION_BOOK_H
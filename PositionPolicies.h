@@ -0,0 +1,229 @@
+#ifndef POSITION_POLICIES_H
+#define POSITION_POLICIES_H
+
+#include "Money.h"
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Policy types for BasicPositionBook. Each policy is a stateless struct whose
+// static members are inlined into the book's loops; picking a combination is
+// a compile-time decision, so no position operation branches on it at run
+// time.
+//
+// Quantities are exchanged with the price and cost-basis policies as raw
+// int64 counts of 1/kScale units (kScale is 1 for whole shares), so a price
+// policy can extend a price by any quantity type without knowing it. kMaxRaw
+// is the largest count the quantity type can hold.
+
+// Quantity policies
+template <typename Int>
+struct IntegerQuantity {
+    using type = Int;
+    static constexpr std::int64_t kScale = 1;
+    static constexpr std::int64_t kMaxRaw = std::numeric_limits<Int>::max();
+
+    static constexpr std::int64_t raw(type quantity) { return quantity; }
+    static constexpr type fromRaw(std::int64_t units) { return static_cast<type>(units); }
+};
+
+using Int32Quantity = IntegerQuantity<std::int32_t>;
+using Int64Quantity = IntegerQuantity<std::int64_t>;
+
+// Quantity held in 10^-8 units (satoshi resolution), exact under addition
+struct FractionalShares {
+    std::int64_t units = 0;
+
+    static FractionalShares fromDouble(double amount) {
+        return FractionalShares{static_cast<std::int64_t>(std::llround(amount * 1e8))};
+    }
+    double toDouble() const { return static_cast<double>(units) * 1e-8; }
+
+    bool operator==(FractionalShares other) const { return units == other.units; }
+    bool operator!=(FractionalShares other) const { return units != other.units; }
+    bool operator<(FractionalShares other) const { return units < other.units; }
+};
+
+struct FractionalQuantity {
+    using type = FractionalShares;
+    static constexpr std::int64_t kScale = 100000000;
+    static constexpr std::int64_t kMaxRaw = std::numeric_limits<std::int64_t>::max();
+
+    static constexpr std::int64_t raw(type quantity) { return quantity.units; }
+    static constexpr type fromRaw(std::int64_t units) { return type{units}; }
+};
+
+// Price policies
+//
+// extend(price, units) is the value of `units` raw quantity units at `price`;
+// prorate(amount, part, whole) is amount * part / whole; perUnit(amount,
+// units) is the per-whole-unit price of an amount spread over `units`.
+
+// Fixed-point Money: exact sums, half-to-even rounding on every division
+struct MoneyPrice {
+    using type = Money;
+
+    template <std::int64_t Scale>
+    static Money extend(Money price, std::int64_t units) {
+        if constexpr (Scale == 1) {
+            return price * units;
+        } else {
+            return price.mulDiv(units, Scale);
+        }
+    }
+    static Money prorate(Money amount, std::int64_t part, std::int64_t whole) {
+        return amount.mulDiv(part, whole);
+    }
+    template <std::int64_t Scale>
+    static Money perUnit(Money amount, std::int64_t units) {
+        return units == 0 ? Money() : amount.mulDiv(Scale, units);
+    }
+    static Money fromMoney(Money amount) { return amount; }
+    static double toDouble(Money amount) { return amount.toDouble(); }
+    static bool isNegative(Money amount) { return amount.isNegative(); }
+};
+
+// Binary floating point: cheapest arithmetic, sums depend on order
+struct DoublePrice {
+    using type = double;
+
+    template <std::int64_t Scale>
+    static double extend(double price, std::int64_t units) {
+        if constexpr (Scale == 1) {
+            return price * static_cast<double>(units);
+        } else {
+            return price * (static_cast<double>(units) / static_cast<double>(Scale));
+        }
+    }
+    static double prorate(double amount, std::int64_t part, std::int64_t whole) {
+        return amount * (static_cast<double>(part) / static_cast<double>(whole));
+    }
+    template <std::int64_t Scale>
+    static double perUnit(double amount, std::int64_t units) {
+        return units == 0 ? 0.0 : amount * static_cast<double>(Scale) / static_cast<double>(units);
+    }
+    static double fromMoney(Money amount) { return amount.toDouble(); }
+    static double toDouble(double amount) { return amount; }
+    static bool isNegative(double amount) { return amount < 0.0; }
+};
+
+// Cost-basis policies
+//
+// State<Price> is the per-position bookkeeping. buy() adds a lot of `units`
+// costing `cost` in total; sell() removes `units` out of `held` and returns
+// the cost basis they carried; cost() is the basis of what is still held.
+
+// Weighted-average cost, as Investment keeps it: one running total, and a
+// sale removes its pro-rata share rounded once, so selling everything always
+// leaves exactly zero.
+struct AverageCost {
+    template <typename Price>
+    struct State {
+        Price total{};
+    };
+
+    template <typename Price>
+    static void buy(State<Price>& state, std::int64_t, Price cost) {
+        state.total += cost;
+    }
+    template <typename PricePolicy, typename Price>
+    static Price sell(State<Price>& state, std::int64_t units, std::int64_t held) {
+        Price removed = units == held ? state.total : PricePolicy::prorate(state.total, units, held);
+        state.total -= removed;
+        return removed;
+    }
+    template <typename Price>
+    static Price cost(const State<Price>& state) {
+        return state.total;
+    }
+};
+
+// First-in first-out lots: sales consume the oldest lots first, splitting
+// the last one pro rata
+struct FifoCost {
+    template <typename Price>
+    struct Lot {
+        std::int64_t units;
+        Price cost;
+    };
+
+    template <typename Price>
+    struct State {
+        std::vector<Lot<Price>> lots;
+        size_t head = 0;  // First open lot; consumed lots are compacted away lazily
+        Price total{};
+    };
+
+    template <typename Price>
+    static void buy(State<Price>& state, std::int64_t units, Price cost) {
+        state.lots.push_back(Lot<Price>{units, cost});
+        state.total += cost;
+    }
+    template <typename PricePolicy, typename Price>
+    static Price sell(State<Price>& state, std::int64_t units, std::int64_t) {
+        Price removed{};
+        while (units > 0 && state.head < state.lots.size()) {
+            Lot<Price>& lot = state.lots[state.head];
+            if (lot.units <= units) {
+                removed += lot.cost;
+                units -= lot.units;
+                ++state.head;
+            } else {
+                Price part = PricePolicy::prorate(lot.cost, units, lot.units);
+                lot.cost -= part;
+                lot.units -= units;
+                removed += part;
+                units = 0;
+            }
+        }
+        if (state.head == state.lots.size()) {
+            state.lots.clear();
+            state.head = 0;
+        } else if (state.head > 32 && state.head * 2 > state.lots.size()) {
+            state.lots.erase(state.lots.begin(), state.lots.begin() + static_cast<std::ptrdiff_t>(state.head));
+            state.head = 0;
+        }
+        state.total -= removed;
+        return removed;
+    }
+    template <typename Price>
+    static Price cost(const State<Price>& state) {
+        return state.total;
+    }
+};
+
+// Bundles the three arithmetic policies; BasicPositionBook only talks to
+// these members.
+template <typename QuantityPolicy, typename PricePolicy, typename CostBasisPolicy>
+struct PositionTraits {
+    using Quantity = typename QuantityPolicy::type;
+    using Price = typename PricePolicy::type;
+    using CostState = typename CostBasisPolicy::template State<Price>;
+
+    static constexpr std::int64_t kQuantityScale = QuantityPolicy::kScale;
+    static constexpr std::int64_t kMaxQuantity = QuantityPolicy::kMaxRaw;
+
+    static std::int64_t raw(Quantity quantity) { return QuantityPolicy::raw(quantity); }
+    static Quantity fromRaw(std::int64_t units) { return QuantityPolicy::fromRaw(units); }
+
+    static Price extend(Price price, std::int64_t units) {
+        return PricePolicy::template extend<kQuantityScale>(price, units);
+    }
+    static Price perUnit(Price amount, std::int64_t units) {
+        return PricePolicy::template perUnit<kQuantityScale>(amount, units);
+    }
+    static Price fromMoney(Money amount) { return PricePolicy::fromMoney(amount); }
+    static double toDouble(Price amount) { return PricePolicy::toDouble(amount); }
+    static bool isNegative(Price amount) { return PricePolicy::isNegative(amount); }
+
+    static void buy(CostState& state, std::int64_t units, Price cost) {
+        CostBasisPolicy::buy(state, units, cost);
+    }
+    static Price sell(CostState& state, std::int64_t units, std::int64_t held) {
+        return CostBasisPolicy::template sell<PricePolicy>(state, units, held);
+    }
+    static Price cost(const CostState& state) { return CostBasisPolicy::cost(state); }
+};
+
+#endif // POSITION_POLICIES_H
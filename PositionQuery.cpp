@@ -0,0 +1,586 @@
+#include "PositionQuery.h"
+#include "Metrics.h"
+#include "Portfolio.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+constexpr size_t kBlockRows = 1024;
+
+std::string lower(const std::string& value) {
+    std::string result = value;
+    for (char& c : result) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return result;
+}
+
+std::string upper(const std::string& value) {
+    std::string result = value;
+    for (char& c : result) {
+        c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+    return result;
+}
+
+bool isNumeric(PositionQuery::Field field) {
+    return field < PositionQuery::Field::Symbol;
+}
+
+bool isWordChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.' || c == '-' || c == '&' || c == '/';
+}
+
+enum class TokenKind { Word, Number, String, Compare, LeftParen, RightParen, Comma, End };
+
+struct Token {
+    TokenKind kind;
+    std::string text;
+    double number = 0.0;
+    kernels::CompareOp compare = kernels::CompareOp::Equal;
+    size_t position = 0;
+};
+
+// One snapshot column: numbers for numeric fields, dictionary codes for
+// currency and attributes, symbol pointers for the symbol field.
+struct ColumnData {
+    std::vector<double> numbers;
+    std::vector<std::uint32_t> codes;
+    std::vector<const std::string*> symbols;
+};
+
+} // namespace
+
+// Recursive-descent parser emitting the postfix program directly
+class PositionQuery::Parser {
+private:
+    PositionQuery& query;
+    const std::string& source;
+    size_t offset;
+    Token current;
+
+    [[noreturn]] void fail(const std::string& message, size_t position) const {
+        throw std::invalid_argument("Query error at " + std::to_string(position + 1) + ": " + message);
+    }
+
+    Token lexNumber() {
+        Token token{TokenKind::Number, "", 0.0, kernels::CompareOp::Equal, offset};
+        bool negative = false;
+        if (source[offset] == '-') {
+            negative = true;
+            ++offset;
+        }
+        if (offset < source.size() && source[offset] == '$') {
+            ++offset;
+        }
+        size_t start = offset;
+        while (offset < source.size() && (std::isdigit(static_cast<unsigned char>(source[offset])) || source[offset] == '.')) {
+            ++offset;
+        }
+        std::string digits = source.substr(start, offset - start);
+        size_t used = 0;
+        try {
+            token.number = std::stod(digits, &used);
+        } catch (const std::exception&) {
+            used = 0;
+        }
+        if (digits.empty() || used != digits.size()) {
+            fail("invalid number", token.position);
+        }
+        if (offset < source.size()) {
+            switch (std::tolower(static_cast<unsigned char>(source[offset]))) {
+                case 'k': token.number *= 1e3; ++offset; break;
+                case 'm': token.number *= 1e6; ++offset; break;
+                case 'b': token.number *= 1e9; ++offset; break;
+                case '%': ++offset; break;
+                default: break;
+            }
+        }
+        if (offset < source.size() && isWordChar(source[offset])) {
+            fail("invalid number", token.position);
+        }
+        if (negative) {
+            token.number = -token.number;
+        }
+        token.text = source.substr(token.position, offset - token.position);
+        return token;
+    }
+
+    Token lex() {
+        while (offset < source.size() && std::isspace(static_cast<unsigned char>(source[offset]))) {
+            ++offset;
+        }
+        Token token{TokenKind::End, "", 0.0, kernels::CompareOp::Equal, offset};
+        if (offset >= source.size()) {
+            return token;
+        }
+        char c = source[offset];
+        char next = offset + 1 < source.size() ? source[offset + 1] : '\0';
+        if (std::isdigit(static_cast<unsigned char>(c)) || c == '$' ||
+            (c == '.' && std::isdigit(static_cast<unsigned char>(next))) ||
+            (c == '-' && (std::isdigit(static_cast<unsigned char>(next)) || next == '$' || next == '.'))) {
+            return lexNumber();
+        }
+        if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+            size_t start = offset;
+            while (offset < source.size() && isWordChar(source[offset])) {
+                ++offset;
+            }
+            token.kind = TokenKind::Word;
+            token.text = source.substr(start, offset - start);
+            return token;
+        }
+        if (c == '\'' || c == '"') {
+            size_t close = source.find(c, offset + 1);
+            if (close == std::string::npos) {
+                fail("unterminated string", offset);
+            }
+            token.kind = TokenKind::String;
+            token.text = source.substr(offset + 1, close - offset - 1);
+            offset = close + 1;
+            return token;
+        }
+        ++offset;
+        switch (c) {
+            case '(': token.kind = TokenKind::LeftParen; return token;
+            case ')': token.kind = TokenKind::RightParen; return token;
+            case ',': token.kind = TokenKind::Comma; return token;
+            case '<':
+                token.kind = TokenKind::Compare;
+                if (next == '=') {
+                    token.compare = kernels::CompareOp::LessEqual;
+                    ++offset;
+                } else if (next == '>') {
+                    token.compare = kernels::CompareOp::NotEqual;
+                    ++offset;
+                } else {
+                    token.compare = kernels::CompareOp::Less;
+                }
+                return token;
+            case '>':
+                token.kind = TokenKind::Compare;
+                token.compare = next == '=' ? kernels::CompareOp::GreaterEqual : kernels::CompareOp::Greater;
+                offset += next == '=';
+                return token;
+            case '=':
+                token.kind = TokenKind::Compare;
+                token.compare = kernels::CompareOp::Equal;
+                offset += next == '=';
+                return token;
+            case '!':
+                if (next == '=') {
+                    token.kind = TokenKind::Compare;
+                    token.compare = kernels::CompareOp::NotEqual;
+                    ++offset;
+                    return token;
+                }
+                break;
+            default:
+                break;
+        }
+        fail(std::string("unexpected '") + c + "'", token.position);
+    }
+
+    void advance() {
+        current = lex();
+    }
+
+    bool atKeyword(const char* keyword) const {
+        return current.kind == TokenKind::Word && lower(current.text) == keyword;
+    }
+
+    bool atClauseEnd() const {
+        return current.kind == TokenKind::End || atKeyword("sort") || atKeyword("order") || atKeyword("limit");
+    }
+
+    size_t columnFor(const Token& token) {
+        static const struct {
+            const char* name;
+            Field field;
+        } kFields[] = {
+            {"shares", Field::Shares},           {"price", Field::Price},
+            {"prev_price", Field::PreviousPrice}, {"previous_price", Field::PreviousPrice},
+            {"avg_cost", Field::AverageCost},    {"purchase_price", Field::AverageCost},
+            {"invested", Field::CostBasis},      {"cost_basis", Field::CostBasis},
+            {"value", Field::Value},             {"gain", Field::GainLoss},
+            {"gain_loss", Field::GainLoss},      {"return", Field::Return},
+            {"change", Field::Change},           {"weight", Field::Weight},
+            {"symbol", Field::Symbol},           {"currency", Field::Currency},
+        };
+        if (token.kind != TokenKind::Word) {
+            fail("expected a field name", token.position);
+        }
+        std::string name = lower(token.text);
+        Column column{Field::Attribute, 0};
+        bool known = false;
+        for (const auto& entry : kFields) {
+            if (name == entry.name) {
+                column.field = entry.field;
+                known = true;
+                break;
+            }
+        }
+        if (!known && !Attributes::findField(name, column.attribute)) {
+            fail("unknown field '" + token.text + "'", token.position);
+        }
+        auto found = std::find(query.columns.begin(), query.columns.end(), column);
+        if (found != query.columns.end()) {
+            return static_cast<size_t>(found - query.columns.begin());
+        }
+        query.columns.push_back(column);
+        return query.columns.size() - 1;
+    }
+
+    void parseComparison() {
+        Token fieldToken = current;
+        size_t column = columnFor(fieldToken);
+        advance();
+        if (current.kind != TokenKind::Compare) {
+            fail("expected a comparison after '" + fieldToken.text + "'", current.position);
+        }
+        Instruction instruction{OpCode::CompareNumber, column, current.compare, 0.0, ""};
+        advance();
+
+        Field field = query.columns[column].field;
+        if (isNumeric(field)) {
+            if (current.kind != TokenKind::Number) {
+                fail("'" + fieldToken.text + "' compares with a number", current.position);
+            }
+            instruction.number = current.number;
+        } else {
+            if (instruction.compare != kernels::CompareOp::Equal && instruction.compare != kernels::CompareOp::NotEqual) {
+                fail("'" + fieldToken.text + "' supports only = and !=", current.position);
+            }
+            if (current.kind != TokenKind::Word && current.kind != TokenKind::String &&
+                current.kind != TokenKind::Number) {
+                fail("expected a value for '" + fieldToken.text + "'", current.position);
+            }
+            instruction.op = OpCode::CompareText;
+            // Symbols and currency codes are stored upper case
+            instruction.text = field == Field::Attribute ? current.text : upper(current.text);
+        }
+        query.program.push_back(std::move(instruction));
+        advance();
+    }
+
+    void parseUnary() {
+        if (atKeyword("not")) {
+            advance();
+            parseUnary();
+            query.program.push_back({OpCode::Not, 0, kernels::CompareOp::Equal, 0.0, ""});
+        } else if (current.kind == TokenKind::LeftParen) {
+            advance();
+            parseOr();
+            if (current.kind != TokenKind::RightParen) {
+                fail("expected ')'", current.position);
+            }
+            advance();
+        } else {
+            parseComparison();
+        }
+    }
+
+    void parseAnd() {
+        parseUnary();
+        while (atKeyword("and")) {
+            advance();
+            parseUnary();
+            query.program.push_back({OpCode::And, 0, kernels::CompareOp::Equal, 0.0, ""});
+        }
+    }
+
+    void parseOr() {
+        parseAnd();
+        while (atKeyword("or")) {
+            advance();
+            parseAnd();
+            query.program.push_back({OpCode::Or, 0, kernels::CompareOp::Equal, 0.0, ""});
+        }
+    }
+
+    void parseSortKeys() {
+        do {
+            advance();
+            SortKey key{columnFor(current), false};
+            advance();
+            if (atKeyword("asc") || atKeyword("desc")) {
+                key.descending = atKeyword("desc");
+                advance();
+            }
+            query.sortKeys.push_back(key);
+        } while (current.kind == TokenKind::Comma);
+    }
+
+public:
+    Parser(PositionQuery& query, const std::string& source)
+        : query(query), source(source), offset(0) {
+        advance();
+    }
+
+    void parse() {
+        if (atKeyword("where")) {
+            advance();
+        }
+        if (!atClauseEnd()) {
+            parseOr();
+        }
+        if (atKeyword("order")) {
+            advance();
+            if (!atKeyword("by")) {
+                fail("expected 'by' after 'order'", current.position);
+            }
+            parseSortKeys();
+        } else if (atKeyword("sort")) {
+            Token sort = current;
+            advance();
+            if (!atKeyword("by")) {
+                // "sort" without "by": the key starts here
+                current = sort;
+                offset = sort.position + sort.text.size();
+            }
+            parseSortKeys();
+        }
+        if (atKeyword("limit")) {
+            advance();
+            if (current.kind != TokenKind::Number || current.number < 0.0 ||
+                current.number != std::floor(current.number)) {
+                fail("limit takes a whole number", current.position);
+            }
+            query.limit = static_cast<size_t>(current.number);
+            advance();
+        }
+        if (current.kind != TokenKind::End) {
+            fail("unexpected '" + current.text + "'", current.position);
+        }
+
+        size_t depth = 0;
+        for (const Instruction& instruction : query.program) {
+            if (instruction.op == OpCode::CompareNumber || instruction.op == OpCode::CompareText) {
+                query.stackDepth = std::max(query.stackDepth, ++depth);
+            } else if (instruction.op != OpCode::Not) {
+                --depth;
+            }
+        }
+    }
+};
+
+// Constructors
+PositionQuery::PositionQuery() : limit(kNoLimit), stackDepth(0) {}
+
+PositionQuery::PositionQuery(const std::string& text) : text(text), limit(kNoLimit), stackDepth(0) {
+    Parser(*this, text).parse();
+}
+
+// Getters
+const std::string& PositionQuery::getText() const {
+    return text;
+}
+
+bool PositionQuery::hasFilter() const {
+    return !program.empty();
+}
+
+bool PositionQuery::hasSort() const {
+    return !sortKeys.empty();
+}
+
+size_t PositionQuery::getLimit() const {
+    return limit;
+}
+
+// Execution
+std::vector<size_t> PositionQuery::execute(const Portfolio& portfolio) const {
+    METRIC_TIME_SCOPE(Query);
+    size_t rows = portfolio.getInvestmentCount();
+    const Investment* investments = rows > 0 ? &portfolio[0] : nullptr;
+
+    // Snapshot the referenced fields, one column at a time
+    std::vector<std::uint8_t> held(rows);
+    for (size_t i = 0; i < rows; ++i) {
+        held[i] = investments[i].getStock() != nullptr;
+    }
+    std::vector<ColumnData> data(columns.size());
+    double invPortfolioValue = 0.0;
+    for (size_t c = 0; c < columns.size(); ++c) {
+        const Column& column = columns[c];
+        ColumnData& out = data[c];
+        if (column.field == Field::Weight) {
+            double total = portfolio.getCurrentValue().toDouble();
+            invPortfolioValue = total != 0.0 ? 100.0 / total : 0.0;
+        }
+        if (column.field == Field::Symbol) {
+            out.symbols.resize(rows);
+        } else if (isNumeric(column.field)) {
+            out.numbers.resize(rows);
+        } else {
+            out.codes.resize(rows);
+        }
+        for (size_t i = 0; i < rows; ++i) {
+            if (!held[i]) {
+                continue;
+            }
+            const Investment& investment = investments[i];
+            const Stock& stock = *investment.getStock();
+            switch (column.field) {
+                case Field::Shares:        out.numbers[i] = investment.getSharesOwned(); break;
+                case Field::Price:         out.numbers[i] = stock.getCurrentPrice().toDouble(); break;
+                case Field::PreviousPrice: out.numbers[i] = stock.getPreviousPrice().toDouble(); break;
+                case Field::AverageCost:   out.numbers[i] = investment.getPurchasePrice().toDouble(); break;
+                case Field::CostBasis:     out.numbers[i] = investment.getTotalInvested().toDouble(); break;
+                case Field::Value:         out.numbers[i] = investment.getCurrentValue().toDouble(); break;
+                case Field::GainLoss:      out.numbers[i] = investment.getGainLoss().toDouble(); break;
+                case Field::Return:        out.numbers[i] = investment.getPercentageReturn(); break;
+                case Field::Change:        out.numbers[i] = stock.getPercentageChange(); break;
+                case Field::Weight:
+                    out.numbers[i] = portfolio.getFxRates().convert(investment.getCurrentValue(), stock.getCurrency())
+                                         .toDouble() * invPortfolioValue;
+                    break;
+                case Field::Symbol:        out.symbols[i] = &stock.getSymbol(); break;
+                case Field::Currency:      out.codes[i] = stock.getCurrency(); break;
+                case Field::Attribute:     out.codes[i] = stock.getAttributeCode(column.attribute); break;
+            }
+        }
+    }
+
+    // Text literals resolve to dictionary codes once per run; a value never
+    // interned cannot match any row.
+    std::vector<std::uint32_t> literalCodes(program.size(), 0);
+    std::vector<std::uint8_t> literalKnown(program.size(), 0);
+    for (size_t p = 0; p < program.size(); ++p) {
+        const Instruction& instruction = program[p];
+        if (instruction.op != OpCode::CompareText) {
+            continue;
+        }
+        const Column& column = columns[instruction.column];
+        if (column.field == Field::Currency) {
+            for (size_t id = 0; id < Currency::count(); ++id) {
+                if (Currency::codeOf(static_cast<CurrencyId>(id)) == instruction.text) {
+                    literalCodes[p] = static_cast<std::uint32_t>(id);
+                    literalKnown[p] = 1;
+                    break;
+                }
+            }
+        } else if (column.field == Field::Attribute) {
+            AttributeCode code = 0;
+            literalKnown[p] = Attributes::find(column.attribute, instruction.text, code);
+            literalCodes[p] = code;
+        }
+    }
+
+    // Filter block by block; masks for one block stay in cache across the program
+    std::vector<size_t> result(rows);
+    size_t matched = 0;
+    if (program.empty()) {
+        matched = kernels::maskToIndices(held.data(), rows, 0, result.data());
+    } else {
+        std::vector<std::uint8_t> stack(stackDepth * kBlockRows);
+        for (size_t start = 0; start < rows; start += kBlockRows) {
+            size_t count = std::min(kBlockRows, rows - start);
+            size_t top = 0;
+            for (size_t p = 0; p < program.size(); ++p) {
+                const Instruction& instruction = program[p];
+                std::uint8_t* mask = stack.data() + top * kBlockRows;
+                std::uint8_t* below = top >= 1 ? mask - kBlockRows : nullptr;
+                std::uint8_t* second = top >= 2 ? below - kBlockRows : nullptr;
+                bool equal = instruction.compare == kernels::CompareOp::Equal;
+                switch (instruction.op) {
+                    case OpCode::CompareNumber:
+                        kernels::compareDoubles(data[instruction.column].numbers.data() + start, count,
+                                                instruction.compare, instruction.number, mask);
+                        ++top;
+                        break;
+                    case OpCode::CompareText:
+                        if (columns[instruction.column].field == Field::Symbol) {
+                            const std::string* const* symbols = data[instruction.column].symbols.data() + start;
+                            for (size_t i = 0; i < count; ++i) {
+                                mask[i] = (symbols[i] && *symbols[i] == instruction.text) == equal;
+                            }
+                        } else if (literalKnown[p]) {
+                            kernels::compareCodes(data[instruction.column].codes.data() + start, count, equal,
+                                                  literalCodes[p], mask);
+                        } else {
+                            std::fill(mask, mask + count, static_cast<std::uint8_t>(!equal));
+                        }
+                        ++top;
+                        break;
+                    case OpCode::And:
+                        kernels::maskAnd(second, below, count);
+                        --top;
+                        break;
+                    case OpCode::Or:
+                        kernels::maskOr(second, below, count);
+                        --top;
+                        break;
+                    case OpCode::Not:
+                        kernels::maskNot(below, count);
+                        break;
+                }
+            }
+            kernels::maskAnd(stack.data(), held.data() + start, count);
+            matched += kernels::maskToIndices(stack.data(), count, start, result.data() + matched);
+        }
+    }
+    result.resize(matched);
+
+    if (sortKeys.empty()) {
+        if (result.size() > limit) {
+            result.resize(limit);
+        }
+        return result;
+    }
+
+    // Text sort keys order by decoded value: rank each dictionary code once
+    std::vector<std::vector<std::uint32_t>> ranks(columns.size());
+    for (const SortKey& key : sortKeys) {
+        const Column& column = columns[key.column];
+        if (column.field != Field::Currency && column.field != Field::Attribute) {
+            continue;
+        }
+        size_t codes = column.field == Field::Currency ? Currency::count() : Attributes::codeCount(column.attribute);
+        std::vector<std::string> values(codes);
+        std::vector<std::uint32_t> order(codes);
+        for (size_t code = 0; code < codes; ++code) {
+            values[code] = column.field == Field::Currency ? Currency::codeOf(static_cast<CurrencyId>(code))
+                                                           : Attributes::decode(column.attribute,
+                                                                                static_cast<AttributeCode>(code));
+            order[code] = static_cast<std::uint32_t>(code);
+        }
+        std::sort(order.begin(), order.end(),
+                  [&](std::uint32_t a, std::uint32_t b) { return values[a] < values[b]; });
+        ranks[key.column].resize(codes);
+        for (size_t r = 0; r < codes; ++r) {
+            ranks[key.column][order[r]] = static_cast<std::uint32_t>(r);
+        }
+    }
+
+    auto before = [&](size_t a, size_t b) {
+        for (const SortKey& key : sortKeys) {
+            const Column& column = columns[key.column];
+            const ColumnData& values = data[key.column];
+            int order = 0;
+            if (column.field == Field::Symbol) {
+                order = values.symbols[a]->compare(*values.symbols[b]);
+            } else if (isNumeric(column.field)) {
+                order = values.numbers[a] < values.numbers[b] ? -1 : (values.numbers[b] < values.numbers[a] ? 1 : 0);
+            } else {
+                std::uint32_t ra = ranks[key.column][values.codes[a]];
+                std::uint32_t rb = ranks[key.column][values.codes[b]];
+                order = ra < rb ? -1 : (rb < ra ? 1 : 0);
+            }
+            if (order != 0) {
+                return key.descending ? order > 0 : order < 0;
+            }
+        }
+        return a < b;
+    };
+    if (result.size() > limit) {
+        std::partial_sort(result.begin(), result.begin() + static_cast<std::ptrdiff_t>(limit), result.end(), before);
+        result.resize(limit);
+    } else {
+        std::sort(result.begin(), result.end(), before);
+    }
+    return result;
+}
@@ -0,0 +1,85 @@
+#ifndef POSITION_QUERY_H
+#define POSITION_QUERY_H
+
+#include "Attributes.h"
+#include "Kernels.h"
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+class Portfolio;
+
+// A filter / sort / limit expression over position fields, e.g.
+//
+//   sector = Technology and (return < -5% or weight > 10) sort value desc limit 20
+//
+// Grammar: [where] [filter] [sort|order by field [asc|desc] {, field ...}] [limit N]
+// Filters combine comparisons (< <= > >= = == != <>) with and, or, not and
+// parentheses. Numeric fields: shares, price, prev_price, avg_cost, invested,
+// value, gain, return, change, weight. Prices and amounts are in each
+// position's own currency; return, change and weight are percents, weight of
+// the base-currency portfolio value. Numbers may carry $, % and k/m/b. Text
+// fields (symbol, currency, sector, industry, country and custom attributes)
+// take = and != against a word or a quoted string. Keywords and field names
+// are case-insensitive.
+//
+// The text is parsed once into a postfix program. Each run snapshots only the
+// referenced fields of the portfolio as columns and evaluates the filter in
+// blocks with the vectorized compare and mask kernels. Results are row indices
+// into the portfolio, valid until it is next modified; nothing is copied.
+class PositionQuery {
+public:
+    enum class Field : std::uint8_t {
+        Shares, Price, PreviousPrice, AverageCost, CostBasis, Value, GainLoss, Return, Change, Weight,
+        Symbol, Currency, Attribute,
+    };
+
+    struct Column {
+        Field field;
+        AttributeField attribute;  // For Field::Attribute
+        bool operator==(const Column& other) const {
+            return field == other.field && (field != Field::Attribute || attribute == other.attribute);
+        }
+    };
+
+    static constexpr size_t kNoLimit = std::numeric_limits<size_t>::max();
+
+    PositionQuery();                                  // Every position, in portfolio order
+    explicit PositionQuery(const std::string& text);  // Throws std::invalid_argument
+
+    const std::string& getText() const;
+    bool hasFilter() const;
+    bool hasSort() const;
+    size_t getLimit() const;
+
+    std::vector<size_t> execute(const Portfolio& portfolio) const;
+
+private:
+    enum class OpCode : std::uint8_t { CompareNumber, CompareText, And, Or, Not };
+
+    struct Instruction {
+        OpCode op;
+        size_t column;           // Index into columns
+        kernels::CompareOp compare;
+        double number;
+        std::string text;
+    };
+
+    struct SortKey {
+        size_t column;
+        bool descending;
+    };
+
+    std::string text;
+    std::vector<Column> columns;       // Distinct fields referenced
+    std::vector<Instruction> program;  // Postfix filter; empty matches all
+    std::vector<SortKey> sortKeys;
+    size_t limit;
+    size_t stackDepth;
+
+    class Parser;
+    friend class Parser;
+};
+
+#endif // POSITION_QUERY_H
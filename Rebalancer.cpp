@@ -0,0 +1,313 @@
+#include "Rebalancer.h"
+#include "Kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string_view>
+
+namespace {
+
+// Column view of the tradable universe: held positions first, then candidates
+// not yet held. Weight math runs over the double columns.
+struct Universe {
+    std::vector<std::shared_ptr<Stock>> stocks;
+    std::vector<std::int64_t> shares;
+    std::vector<Money> basePrice;  // Per share, in the base currency
+    std::vector<double> price;
+    std::vector<double> value;
+    std::vector<double> target;
+    std::vector<int> lot;
+    std::unordered_map<std::string_view, size_t> rowBySymbol;
+
+    void add(const std::shared_ptr<Stock>& stock, std::int64_t owned, const FxRateTable& fxRates) {
+        Money converted = fxRates.convert(stock->getCurrentPrice(), stock->getCurrency());
+        rowBySymbol.emplace(stock->getSymbol(), stocks.size());
+        stocks.push_back(stock);
+        shares.push_back(owned);
+        basePrice.push_back(converted);
+        price.push_back(converted.toDouble());
+        value.push_back(converted.toDouble() * static_cast<double>(owned));
+    }
+};
+
+Universe buildUniverse(const Portfolio& portfolio, const RebalanceOptions& options) {
+    Universe universe;
+    const FxRateTable& fxRates = portfolio.getFxRates();
+    size_t rows = portfolio.getInvestmentCount() + options.candidates.size();
+    universe.stocks.reserve(rows);
+    universe.shares.reserve(rows);
+    universe.basePrice.reserve(rows);
+    universe.price.reserve(rows);
+    universe.value.reserve(rows);
+    universe.rowBySymbol.reserve(rows);
+
+    for (const Investment& investment : portfolio) {
+        if (investment.getStock() && !universe.rowBySymbol.count(investment.getStock()->getSymbol())) {
+            universe.add(investment.getStock(), investment.getSharesOwned(), fxRates);
+        }
+    }
+    for (const std::shared_ptr<Stock>& candidate : options.candidates) {
+        if (candidate && !universe.rowBySymbol.count(candidate->getSymbol())) {
+            universe.add(candidate, 0, fxRates);
+        }
+    }
+
+    universe.lot.assign(universe.stocks.size(), std::max(1, options.defaultLotSize));
+    for (const auto& entry : options.lotSizes) {
+        auto found = universe.rowBySymbol.find(entry.first);
+        if (found != universe.rowBySymbol.end()) {
+            universe.lot[found->second] = std::max(1, entry.second);
+        }
+    }
+    return universe;
+}
+
+Money tradeCost(Money notional, const RebalanceOptions& options) {
+    return Money::fromDouble(notional.toDouble() * options.costRate) + options.costPerTrade;
+}
+
+struct BuyOrder {
+    size_t row;
+    std::int64_t lots;
+    double remainder;     // Fractional lot left after rounding down
+    std::int64_t maxLots;  // Keeps the position within Investment's int share count
+};
+
+} // namespace
+
+RebalancePlan Rebalancer::plan(const Portfolio& portfolio,
+                               const std::unordered_map<std::string, double>& targetWeights,
+                               const RebalanceOptions& options) {
+    RebalancePlan result;
+    Universe u = buildUniverse(portfolio, options);
+    size_t rows = u.stocks.size();
+
+    double invested = 0.0;
+    for (size_t i = 0; i < rows; ++i) {
+        invested += u.value[i];
+    }
+    double total = invested + options.cash.toDouble();
+    result.totalValue = Money::fromDouble(total);
+    if (total <= 0.0) {
+        result.cashAfter = options.cash;
+        return result;
+    }
+    double invTotal = 1.0 / total;
+
+    // Sparse targets: untargeted rows default to zero (sell) or their current
+    // weight (hold); only the named rows are touched afterwards.
+    if (options.sellUntargeted) {
+        u.target.assign(rows, 0.0);
+    } else {
+        u.target.resize(rows);
+        for (size_t i = 0; i < rows; ++i) {
+            u.target[i] = u.value[i] * invTotal;
+        }
+    }
+    for (const auto& entry : targetWeights) {
+        auto found = u.rowBySymbol.find(entry.first);
+        if (found == u.rowBySymbol.end()) {
+            result.unpriced.push_back(entry.first);
+            continue;
+        }
+        u.target[found->second] = std::max(0.0, entry.second);
+    }
+    std::sort(result.unpriced.begin(), result.unpriced.end());
+
+    std::vector<double> drift(rows);
+    result.maxDriftBefore = kernels::weightDrift(u.value.data(), u.target.data(), rows, invTotal, drift.data());
+
+    std::vector<std::int64_t> delta(rows, 0);
+    Money budget = options.cash;
+
+    // Sells: to target, rounded to the nearest lot; a zero target closes the
+    // position including any odd lot.
+    std::vector<size_t> buyRows;
+    for (size_t i = 0; i < rows; ++i) {
+        if (std::fabs(drift[i]) <= options.tolerance || u.price[i] <= 0.0) {
+            continue;
+        }
+        if (drift[i] < 0.0) {
+            buyRows.push_back(i);
+            continue;
+        }
+        std::int64_t sell;
+        if (u.target[i] == 0.0) {
+            sell = u.shares[i];
+        } else {
+            double excessShares = drift[i] * total / u.price[i];
+            sell = static_cast<std::int64_t>(std::llround(excessShares / u.lot[i])) * u.lot[i];
+            sell = std::min(sell, u.shares[i]);
+        }
+        if (sell <= 0) {
+            continue;
+        }
+        Money notional = u.basePrice[i] * sell;
+        budget += notional - tradeCost(notional, options);
+        delta[i] = -sell;
+    }
+
+    // Buys: scale every shortfall down uniformly if cash cannot cover them all,
+    // round down to whole lots, then spend what is left on the largest
+    // remainders.
+    double wanted = 0.0;
+    for (size_t i : buyRows) {
+        wanted += -drift[i] * total;
+    }
+    double fixedCosts = options.costPerTrade.toDouble() * static_cast<double>(buyRows.size());
+    double spendable = std::max(0.0, budget.toDouble() - fixedCosts);
+    double scale = wanted > 0.0 ? std::min(1.0, spendable / (wanted * (1.0 + options.costRate))) : 0.0;
+
+    std::vector<BuyOrder> buys;
+    buys.reserve(buyRows.size());
+    for (size_t i : buyRows) {
+        double lotsWanted = -drift[i] * total * scale / (u.price[i] * u.lot[i]);
+        double whole = std::floor(lotsWanted);
+        std::int64_t maxLots = (std::numeric_limits<int>::max() - u.shares[i]) / u.lot[i];
+        if (whole >= static_cast<double>(maxLots)) {
+            buys.push_back({i, maxLots, 0.0, maxLots});
+        } else {
+            buys.push_back({i, static_cast<std::int64_t>(whole), lotsWanted - whole, maxLots});
+        }
+    }
+
+    Money spent;
+    for (const BuyOrder& order : buys) {
+        if (order.lots > 0) {
+            Money notional = u.basePrice[order.row] * (order.lots * u.lot[order.row]);
+            spent += notional + tradeCost(notional, options);
+        }
+    }
+    // Per-trade cost rounding can push the floor pass a few units over budget
+    std::sort(buys.begin(), buys.end(),
+              [](const BuyOrder& a, const BuyOrder& b) { return a.remainder > b.remainder; });
+    for (auto it = buys.rbegin(); spent > budget && it != buys.rend(); ++it) {
+        while (it->lots > 0 && spent > budget) {
+            Money before = u.basePrice[it->row] * (it->lots * u.lot[it->row]);
+            --it->lots;
+            Money after = u.basePrice[it->row] * (it->lots * u.lot[it->row]);
+            spent -= (before + tradeCost(before, options));
+            if (it->lots > 0) {
+                spent += after + tradeCost(after, options);
+            }
+        }
+    }
+    for (BuyOrder& order : buys) {
+        if (order.remainder <= 0.0) {
+            break;
+        }
+        if (order.lots >= order.maxLots) {
+            continue;
+        }
+        Money before = u.basePrice[order.row] * (order.lots * u.lot[order.row]);
+        Money after = u.basePrice[order.row] * ((order.lots + 1) * u.lot[order.row]);
+        Money extra = after + tradeCost(after, options);
+        if (order.lots > 0) {
+            extra -= before + tradeCost(before, options);
+        }
+        if (spent + extra <= budget) {
+            ++order.lots;
+            spent += extra;
+        }
+    }
+    for (const BuyOrder& order : buys) {
+        delta[order.row] = order.lots * u.lot[order.row];
+    }
+
+    // Emit sells before buys so applying the plan never needs more cash than
+    // it has.
+    for (int pass = 0; pass < 2; ++pass) {
+        for (size_t i = 0; i < rows; ++i) {
+            if (delta[i] == 0 || (pass == 0) != (delta[i] < 0)) {
+                continue;
+            }
+            RebalanceTrade trade;
+            trade.stock = u.stocks[i];
+            // Sells are bounded by the int shares held, buys by maxLots
+            trade.shares = static_cast<int>(delta[i]);
+            trade.notional = u.basePrice[i] * (delta[i] < 0 ? -delta[i] : delta[i]);
+            trade.cost = tradeCost(trade.notional, options);
+            trade.currentWeight = u.value[i] * invTotal;
+            trade.targetWeight = u.target[i];
+            result.totalCost += trade.cost;
+            result.trades.push_back(std::move(trade));
+        }
+    }
+
+    result.cashAfter = budget - spent;
+    for (size_t i = 0; i < rows; ++i) {
+        u.value[i] = u.price[i] * static_cast<double>(u.shares[i] + delta[i]);
+    }
+    double totalAfter = total - result.totalCost.toDouble();
+    result.maxDriftAfter = totalAfter > 0.0
+        ? kernels::weightDrift(u.value.data(), u.target.data(), rows, 1.0 / totalAfter, drift.data())
+        : 0.0;
+    return result;
+}
+
+RebalancePlan Rebalancer::planByGroup(const Portfolio& portfolio,
+                                      const std::unordered_map<std::string, double>& groupWeights,
+                                      const GroupFunction& groupOf,
+                                      const RebalanceOptions& options) {
+    struct GroupTotals {
+        double value = 0.0;
+        size_t members = 0;
+    };
+    Universe u = buildUniverse(portfolio, options);
+    std::vector<std::string> groups(u.stocks.size());
+    std::unordered_map<std::string, GroupTotals> totals;
+    for (size_t i = 0; i < u.stocks.size(); ++i) {
+        groups[i] = groupOf(*u.stocks[i]);
+        GroupTotals& group = totals[groups[i]];
+        group.value += u.value[i];
+        group.members += 1;
+    }
+
+    std::unordered_map<std::string, double> symbolWeights;
+    symbolWeights.reserve(u.stocks.size());
+    for (size_t i = 0; i < u.stocks.size(); ++i) {
+        auto weight = groupWeights.find(groups[i]);
+        if (weight == groupWeights.end()) {
+            continue;
+        }
+        const GroupTotals& group = totals[groups[i]];
+        double share = group.value > 0.0 ? u.value[i] / group.value : 1.0 / static_cast<double>(group.members);
+        symbolWeights[u.stocks[i]->getSymbol()] = weight->second * share;
+    }
+
+    RebalancePlan result = plan(portfolio, symbolWeights, options);
+    for (const auto& entry : groupWeights) {
+        if (!totals.count(entry.first)) {
+            result.unpriced.push_back(entry.first);
+        }
+    }
+    return result;
+}
+
+RebalancePlan Rebalancer::planByGroup(const Portfolio& portfolio,
+                                      const std::unordered_map<std::string, double>& groupWeights,
+                                      const std::string& attributeField,
+                                      const RebalanceOptions& options) {
+    AttributeField field = Attributes::fieldOf(attributeField);
+    return planByGroup(portfolio, groupWeights,
+                       [field](const Stock& stock) {
+                           return Attributes::decode(field, stock.getAttributeCode(field));
+                       },
+                       options);
+}
+
+size_t Rebalancer::apply(Portfolio& portfolio, const RebalancePlan& plan) {
+    size_t applied = 0;
+    for (const RebalanceTrade& trade : plan.trades) {
+        if (!trade.stock || trade.shares == 0) {
+            continue;
+        }
+        bool ok = trade.shares < 0
+            ? portfolio.removeShares(trade.stock->getSymbol(), -trade.shares)
+            : portfolio.addInvestment(Investment(trade.stock, trade.shares, trade.stock->getCurrentPrice()));
+        if (ok) {
+            ++applied;
+        }
+    }
+    return applied;
+}
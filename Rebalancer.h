@@ -0,0 +1,74 @@
+#ifndef REBALANCER_H
+#define REBALANCER_H
+
+#include "Portfolio.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct RebalanceOptions {
+    Money cash;                          // Uninvested cash, in the base currency
+    double tolerance = 0.0025;           // Weight drift left untraded (absolute, 0.25%)
+    double costRate = 0.0;               // Proportional cost as a fraction of notional
+    Money costPerTrade;                  // Fixed cost per trade, in the base currency
+    int defaultLotSize = 1;
+    std::unordered_map<std::string, int> lotSizes;  // Per-symbol overrides
+    bool sellUntargeted = true;          // Without a target: sell (true) or hold (false)
+    // Instruments that may be bought without being held yet
+    std::vector<std::shared_ptr<Stock>> candidates;
+};
+
+struct RebalanceTrade {
+    std::shared_ptr<Stock> stock;
+    int shares = 0;              // Positive buys, negative sells
+    Money notional;              // |shares| x price, in the base currency
+    Money cost;                  // Transaction cost, in the base currency
+    double currentWeight = 0.0;
+    double targetWeight = 0.0;
+};
+
+struct RebalancePlan {
+    std::vector<RebalanceTrade> trades;   // Sells first, then buys
+    std::vector<std::string> unpriced;    // Targets with no held or candidate instrument
+    Money totalValue;                     // Positions plus cash before trading
+    Money cashAfter;
+    Money totalCost;
+    double maxDriftBefore = 0.0;
+    double maxDriftAfter = 0.0;
+};
+
+// Computes the trades that bring a portfolio to target weights. Only names
+// whose weight is outside the tolerance band trade; each goes to its target,
+// rounded to whole lots. Buys are sized to the cash available after sells and
+// costs: every buy is first rounded down to whole lots, then leftover cash
+// goes one lot at a time to the names whose rounding dropped the largest
+// fraction of a lot (largest-remainder rounding). A buy never takes a position
+// past the int share count Investment holds. Weights come from base-currency
+// values; trades are applied with addInvestment/removeShares.
+class Rebalancer {
+public:
+    using GroupFunction = std::function<std::string(const Stock&)>;
+
+    static RebalancePlan plan(const Portfolio& portfolio,
+                              const std::unordered_map<std::string, double>& targetWeights,
+                              const RebalanceOptions& options = RebalanceOptions());
+
+    // Group (e.g. sector) targets: each group's weight is split over its held
+    // members in proportion to their value, or equally if none has value.
+    static RebalancePlan planByGroup(const Portfolio& portfolio,
+                                     const std::unordered_map<std::string, double>& groupWeights,
+                                     const GroupFunction& groupOf,
+                                     const RebalanceOptions& options = RebalanceOptions());
+    // Groups by an instrument attribute, e.g. "sector"
+    static RebalancePlan planByGroup(const Portfolio& portfolio,
+                                     const std::unordered_map<std::string, double>& groupWeights,
+                                     const std::string& attributeField,
+                                     const RebalanceOptions& options = RebalanceOptions());
+
+    // Executes a plan at the current prices; returns the trades applied.
+    static size_t apply(Portfolio& portfolio, const RebalancePlan& plan);
+};
+
+#endif // REBALANCER_H
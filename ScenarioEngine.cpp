@@ -0,0 +1,362 @@
+#include "ScenarioEngine.h"
+#include "Kernels.h"
+#include "Metrics.h"
+#include "ParallelFor.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+constexpr size_t kPositionChunk = 65536;  // Positions per exposure work item
+constexpr std::int32_t kNoFactor = -1;
+
+std::string trim(const std::string& text) {
+    size_t begin = 0;
+    size_t end = text.size();
+    while (begin < end && std::isspace(static_cast<unsigned char>(text[begin]))) {
+        ++begin;
+    }
+    while (end > begin && std::isspace(static_cast<unsigned char>(text[end - 1]))) {
+        --end;
+    }
+    return text.substr(begin, end - begin);
+}
+
+// Normalizes a factor key, throwing for malformed ones. Dimensions are
+// case-insensitive; values are kept as given.
+std::string normalizeKey(const std::string& key) {
+    std::string text = trim(key);
+    if (text == "*") {
+        return text;
+    }
+    size_t colon = text.find(':');
+    if (colon == std::string::npos || colon == 0 || colon + 1 == text.size()) {
+        throw std::invalid_argument("Scenario factor must be \"*\" or \"<dimension>:<value>\": " + key);
+    }
+    std::string dimension = trim(text.substr(0, colon));
+    std::transform(dimension.begin(), dimension.end(), dimension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    std::string value = trim(text.substr(colon + 1));
+    if (dimension.empty() || value.empty()) {
+        throw std::invalid_argument("Scenario factor must be \"*\" or \"<dimension>:<value>\": " + key);
+    }
+    if (dimension == "currency") {
+        Currency::idOf(value);  // Validates the code
+        std::transform(value.begin(), value.end(), value.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+    }
+    return dimension + ":" + value;
+}
+
+// The factors each position belongs to, resolved once per run
+struct FactorMap {
+    std::int32_t market = kNoFactor;
+    std::unordered_map<std::string, std::int32_t> symbols;
+    std::vector<std::int32_t> currencies;  // By CurrencyId
+    std::vector<std::pair<AttributeField, std::vector<std::int32_t>>> attributes;  // Code -> factor
+    size_t factorCount = 0;
+
+    explicit FactorMap(const ScenarioSet& set) : factorCount(set.factorCount()) {
+        for (size_t f = 0; f < set.factorCount(); ++f) {
+            const std::string& key = set.factorKey(f);
+            const std::int32_t column = static_cast<std::int32_t>(f);
+            if (key == "*") {
+                market = column;
+                continue;
+            }
+            size_t colon = key.find(':');
+            const std::string dimension = key.substr(0, colon);
+            const std::string value = key.substr(colon + 1);
+            if (dimension == "symbol") {
+                symbols.emplace(value, column);
+            } else if (dimension == "currency") {
+                CurrencyId id = Currency::idOf(value);
+                if (currencies.size() <= id) {
+                    currencies.resize(static_cast<size_t>(id) + 1, kNoFactor);
+                }
+                currencies[id] = column;
+            } else {
+                AttributeField field;
+                AttributeCode code;
+                // A value no instrument has is never interned and moves nothing
+                if (!Attributes::findField(dimension, field) || !Attributes::find(field, value, code)) {
+                    continue;
+                }
+                auto it = std::find_if(attributes.begin(), attributes.end(),
+                                       [field](const std::pair<AttributeField, std::vector<std::int32_t>>& entry) {
+                                           return entry.first == field;
+                                       });
+                if (it == attributes.end()) {
+                    attributes.emplace_back(field, std::vector<std::int32_t>());
+                    it = attributes.end() - 1;
+                }
+                if (it->second.size() <= code) {
+                    it->second.resize(static_cast<size_t>(code) + 1, kNoFactor);
+                }
+                it->second[code] = column;
+            }
+        }
+    }
+
+    // Calls add(factor) for every factor the stock belongs to
+    template <typename Add>
+    void forEachFactor(const Stock& stock, Add add) const {
+        if (market != kNoFactor) {
+            add(market);
+        }
+        if (!symbols.empty()) {
+            auto it = symbols.find(stock.getSymbol());
+            if (it != symbols.end()) {
+                add(it->second);
+            }
+        }
+        CurrencyId currency = stock.getCurrency();
+        if (currency < currencies.size() && currencies[currency] != kNoFactor) {
+            add(currencies[currency]);
+        }
+        for (const auto& entry : attributes) {
+            AttributeCode code = stock.getAttributeCode(entry.first);
+            if (code < entry.second.size() && entry.second[code] != kNoFactor) {
+                add(entry.second[code]);
+            }
+        }
+    }
+};
+
+} // namespace
+
+// ScenarioSet
+size_t ScenarioSet::addFactor(const std::string& key) {
+    const std::string normalized = normalizeKey(key);
+    auto it = std::find(factors.begin(), factors.end(), normalized);
+    if (it != factors.end()) {
+        return static_cast<size_t>(it - factors.begin());
+    }
+    const size_t oldCount = factors.size();
+    factors.push_back(normalized);
+    std::vector<double> widened(scenarioNames.size() * factors.size(), 0.0);
+    for (size_t s = 0; s < scenarioNames.size(); ++s) {
+        std::copy(shocks.begin() + s * oldCount, shocks.begin() + (s + 1) * oldCount,
+                  widened.begin() + s * factors.size());
+    }
+    shocks.swap(widened);
+    return oldCount;
+}
+
+size_t ScenarioSet::addScenario(const std::string& name) {
+    scenarioNames.push_back(name);
+    shocks.resize(shocks.size() + factors.size(), 0.0);
+    return scenarioNames.size() - 1;
+}
+
+size_t ScenarioSet::addScenario(const std::string& name, const std::vector<double>& row) {
+    if (row.size() > factors.size()) {
+        throw std::invalid_argument("Scenario has more shocks than factors");
+    }
+    size_t scenario = addScenario(name);
+    std::copy(row.begin(), row.end(), shocks.begin() + scenario * factors.size());
+    return scenario;
+}
+
+void ScenarioSet::setShock(size_t scenario, const std::string& factorKey, double shock) {
+    if (scenario >= scenarioNames.size()) {
+        throw std::invalid_argument("No such scenario");
+    }
+    size_t factor = addFactor(factorKey);
+    shocks[scenario * factors.size() + factor] = shock;
+}
+
+double ScenarioSet::getShock(size_t scenario, size_t factor) const {
+    return shocks[scenario * factors.size() + factor];
+}
+
+bool ScenarioSet::loadFromCSV(const std::string& filename) {
+    std::ifstream file(filename);
+    std::string line;
+    if (!file.is_open() || !std::getline(file, line)) {
+        return false;
+    }
+
+    ScenarioSet loaded;
+    std::stringstream header(line);
+    std::string cell;
+    std::getline(header, cell, ',');  // "scenario"
+    try {
+        while (std::getline(header, cell, ',')) {
+            loaded.addFactor(cell);
+        }
+    } catch (const std::invalid_argument&) {
+        return false;
+    }
+
+    std::vector<double> row;
+    while (std::getline(file, line)) {
+        if (trim(line).empty()) {
+            continue;
+        }
+        std::stringstream ss(line);
+        std::string name;
+        std::getline(ss, name, ',');
+        row.clear();
+        while (std::getline(ss, cell, ',')) {
+            const std::string text = trim(cell);
+            char* end = nullptr;
+            double shock = text.empty() ? 0.0 : std::strtod(text.c_str(), &end);
+            if (!text.empty() && *end != '\0') {
+                return false;
+            }
+            row.push_back(shock);
+        }
+        if (row.size() > loaded.factorCount()) {
+            return false;
+        }
+        loaded.addScenario(trim(name), row);
+    }
+    *this = std::move(loaded);
+    return true;
+}
+
+// ScenarioResults
+size_t ScenarioResults::worstScenario(size_t portfolio) const {
+    const size_t count = scenarios.size();
+    const double* row = pnl.data() + portfolio * count;
+    return static_cast<size_t>(std::min_element(row, row + count) - row);
+}
+
+// ScenarioEngine
+ScenarioResults ScenarioEngine::run(const std::vector<const Portfolio*>& portfolios, const ScenarioSet& set,
+                                    const ScenarioOptions& options) {
+    METRIC_TIME_SCOPE(ScenarioRun);
+    auto start = std::chrono::steady_clock::now();
+    const size_t portfolioCount = portfolios.size();
+    const size_t scenarioCount = set.scenarioCount();
+    const size_t factorCount = set.factorCount();
+    const size_t threads = workerThreads(options.threads);
+    const size_t currencyCount = Currency::count();
+
+    ScenarioResults results;
+    results.pnl.assign(portfolioCount * scenarioCount, 0.0);
+    for (size_t s = 0; s < scenarioCount; ++s) {
+        results.scenarios.push_back(set.scenarioName(s));
+    }
+
+    // Exposures: each portfolio's value per factor, summed exactly in Money
+    // units per currency (column factorCount holds the whole portfolio) and
+    // converted once per currency, as Portfolio converts its totals.
+    const FactorMap map(set);
+    const size_t columns = factorCount + 1;
+    std::vector<std::int64_t> units(portfolioCount * columns * currencyCount, 0);
+    std::vector<std::mutex> locks(portfolioCount);
+    std::vector<std::pair<size_t, size_t>> items;  // (portfolio, first position)
+    for (size_t p = 0; p < portfolioCount; ++p) {
+        const Portfolio& portfolio = *portfolios[p];
+        results.portfolios.push_back(portfolio.getPortfolioName());
+        results.baseCurrencies.push_back(portfolio.getBaseCurrency());
+        for (size_t first = 0; first < portfolio.getInvestmentCount(); first += kPositionChunk) {
+            items.emplace_back(p, first);
+        }
+    }
+    parallelFor(items.size(), threads, [&](size_t item) {
+        const size_t p = items[item].first;
+        const Portfolio& portfolio = *portfolios[p];
+        const size_t end = std::min(portfolio.getInvestmentCount(), items[item].second + kPositionChunk);
+        std::vector<std::int64_t> local(columns * currencyCount, 0);
+        for (size_t i = items[item].second; i < end; ++i) {
+            const Investment& investment = portfolio[i];
+            const Stock* stock = investment.getStock().get();
+            if (!stock || stock->getCurrency() >= currencyCount) {
+                continue;
+            }
+            const std::int64_t value = investment.getCurrentValue().raw();
+            std::int64_t* byCurrency = local.data() + stock->getCurrency();
+            byCurrency[factorCount * currencyCount] += value;
+            map.forEachFactor(*stock, [&](std::int32_t factor) {
+                byCurrency[static_cast<size_t>(factor) * currencyCount] += value;
+            });
+        }
+        std::lock_guard<std::mutex> lock(locks[p]);
+        std::int64_t* shared = units.data() + p * columns * currencyCount;
+        for (size_t k = 0; k < local.size(); ++k) {
+            shared[k] += local[k];
+        }
+    });
+
+    std::vector<double> exposures(portfolioCount * factorCount, 0.0);
+    results.baseValues.resize(portfolioCount);
+    for (size_t p = 0; p < portfolioCount; ++p) {
+        const FxRateTable& rates = portfolios[p]->getFxRates();
+        const std::int64_t* cells = units.data() + p * columns * currencyCount;
+        for (size_t f = 0; f < columns; ++f) {
+            Money total;
+            for (size_t c = 0; c < currencyCount; ++c) {
+                if (cells[f * currencyCount + c] != 0) {
+                    total += rates.convert(Money::fromUnits(cells[f * currencyCount + c]), static_cast<CurrencyId>(c));
+                }
+            }
+            if (f == factorCount) {
+                results.baseValues[p] = total;
+            } else {
+                exposures[p * factorCount + f] = total.toDouble();
+            }
+        }
+    }
+
+    // P&L = exposures x shocks^T, tiled so a block of shocks is reused across
+    // a block of portfolios while it is in cache
+    std::vector<double> shocks(factorCount * scenarioCount);
+    for (size_t s = 0; s < scenarioCount; ++s) {
+        for (size_t f = 0; f < factorCount; ++f) {
+            shocks[f * scenarioCount + s] = set.getShock(s, f);
+        }
+    }
+    const size_t scenarioBlock = std::max<size_t>(1, options.scenarioBlock);
+    const size_t portfolioBlock = std::max<size_t>(1, options.portfolioBlock);
+    const size_t scenarioTiles = (scenarioCount + scenarioBlock - 1) / scenarioBlock;
+    const size_t portfolioTiles = (portfolioCount + portfolioBlock - 1) / portfolioBlock;
+    parallelFor(scenarioTiles * portfolioTiles, threads, [&](size_t tile) {
+        const size_t firstScenario = (tile % scenarioTiles) * scenarioBlock;
+        const size_t scenarios = std::min(scenarioBlock, scenarioCount - firstScenario);
+        const size_t firstPortfolio = (tile / scenarioTiles) * portfolioBlock;
+        const size_t lastPortfolio = std::min(portfolioCount, firstPortfolio + portfolioBlock);
+        for (size_t p = firstPortfolio; p < lastPortfolio; ++p) {
+            kernels::shockPnl(shocks.data() + firstScenario, scenarioCount, exposures.data() + p * factorCount,
+                              factorCount, scenarios, results.pnl.data() + p * scenarioCount + firstScenario);
+        }
+    });
+
+    results.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return results;
+}
+
+ScenarioResults ScenarioEngine::run(const Portfolio& portfolio, const ScenarioSet& set,
+                                    const ScenarioOptions& options) {
+    return run(std::vector<const Portfolio*>{&portfolio}, set, options);
+}
+
+bool ScenarioEngine::exportToCSV(const ScenarioResults& results, const std::string& filename) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        return false;
+    }
+    file << "Portfolio,Currency,Value";
+    for (const std::string& scenario : results.scenarios) {
+        file << "," << scenario;
+    }
+    file << "\n";
+    for (size_t p = 0; p < results.portfolios.size(); ++p) {
+        file << results.portfolios[p] << "," << results.baseCurrencies[p] << "," << results.baseValues[p];
+        for (size_t s = 0; s < results.scenarios.size(); ++s) {
+            file << "," << results.getPnl(p, s);
+        }
+        file << "\n";
+    }
+    file.flush();
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,88 @@
+#ifndef SCENARIO_ENGINE_H
+#define SCENARIO_ENGINE_H
+
+#include "Portfolio.h"
+#include <string>
+#include <vector>
+
+// A matrix of shock vectors: one row per scenario, one column per factor.
+// A factor is a key naming the positions it moves:
+//   "*"                  every position (market-wide move)
+//   "symbol:AAPL"        one instrument
+//   "currency:EUR"       positions quoted in a currency (FX move)
+//   "<field>:<value>"    an instrument attribute, e.g. "sector:Technology"
+// Shocks are fractional returns (-0.15 for -15%). A position's return under a
+// scenario is the sum of the shocks of every factor it belongs to, so a
+// Technology stock under {"*": -0.02, "sector:Technology": -0.15} moves
+// -17%.
+class ScenarioSet {
+private:
+    std::vector<std::string> factors;
+    std::vector<std::string> scenarioNames;
+    std::vector<double> shocks;  // Scenario-major, scenarios x factors
+
+public:
+    // Returns the factor's column, adding it (zero in every scenario) if new.
+    // Throws std::invalid_argument for a malformed key.
+    size_t addFactor(const std::string& key);
+    // Adds a scenario with every shock zero; returns its row
+    size_t addScenario(const std::string& name);
+    // Adds a scenario from a dense row in factor order; missing trailing
+    // shocks are zero. Throws std::invalid_argument if the row is too long.
+    size_t addScenario(const std::string& name, const std::vector<double>& row);
+    void setShock(size_t scenario, const std::string& factorKey, double shock);
+    double getShock(size_t scenario, size_t factor) const;
+
+    size_t scenarioCount() const { return scenarioNames.size(); }
+    size_t factorCount() const { return factors.size(); }
+    const std::string& scenarioName(size_t scenario) const { return scenarioNames[scenario]; }
+    const std::string& factorKey(size_t factor) const { return factors[factor]; }
+
+    // CSV with a header "scenario,<factor>,<factor>,..." and one row per
+    // scenario. Replaces the current contents; false if the file cannot be
+    // read or a factor key or shock does not parse.
+    bool loadFromCSV(const std::string& filename);
+};
+
+struct ScenarioOptions {
+    size_t threads = 0;           // 0 = one per hardware thread
+    size_t scenarioBlock = 1024;  // Scenarios per tile (one P&L block stays in L1)
+    size_t portfolioBlock = 32;   // Portfolios per tile (reuse each shock block)
+};
+
+// P&L of every portfolio under every scenario, in each portfolio's base
+// currency
+struct ScenarioResults {
+    std::vector<std::string> scenarios;
+    std::vector<std::string> portfolios;
+    std::vector<std::string> baseCurrencies;
+    std::vector<Money> baseValues;  // Current value of each portfolio
+    std::vector<double> pnl;        // Portfolio-major: pnl[portfolio * scenarios.size() + scenario]
+    double seconds = 0.0;
+
+    Money getPnl(size_t portfolio, size_t scenario) const {
+        return Money::fromDouble(pnl[portfolio * scenarios.size() + scenario]);
+    }
+    size_t worstScenario(size_t portfolio) const;
+};
+
+// Evaluates scenario sets against many portfolios without touching any live
+// price. Positions are first reduced to each portfolio's base-currency value
+// per factor (its exposures, one pass over the positions, exact integer
+// sums); the P&L for all scenarios is then the product of the shock matrix
+// with each exposure vector, computed in cache-sized scenario x portfolio
+// tiles spread over worker threads. Portfolios are only read, so they must
+// not be modified while run() is in progress.
+class ScenarioEngine {
+public:
+    static ScenarioResults run(const std::vector<const Portfolio*>& portfolios, const ScenarioSet& scenarios,
+                               const ScenarioOptions& options = ScenarioOptions());
+    static ScenarioResults run(const Portfolio& portfolio, const ScenarioSet& scenarios,
+                               const ScenarioOptions& options = ScenarioOptions());
+
+    // One row per portfolio: name, currency, value, then one column per
+    // scenario
+    static bool exportToCSV(const ScenarioResults& results, const std::string& filename);
+};
+
+#endif // SCENARIO_ENGINE_H
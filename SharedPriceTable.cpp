@@ -0,0 +1,619 @@
+#include "SharedPriceTable.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr std::uint64_t kControlMagic = 0x4C5254434650524FULL;  // "ORPFCTRL"
+constexpr std::uint64_t kDataMagic = 0x415441444650524FULL;  // "ORPFDATA"
+constexpr std::uint32_t kLayoutVersion = 1;
+constexpr int kReadRetries = 1 << 16;
+
+// The segments are shared between processes, so everything in them is
+// fixed-size and every atomic must be lock-free (address-free).
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "shared slots need lock-free 32-bit atomics");
+static_assert(std::atomic<std::int64_t>::is_always_lock_free, "shared slots need lock-free 64-bit atomics");
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "shared slots need lock-free 64-bit atomics");
+
+struct ControlBlock {
+    std::uint64_t magic;
+    std::uint32_t layoutVersion;
+    std::uint32_t moneyDecimals;
+    std::atomic<std::uint32_t> generation;  // Data segment readers should map
+    std::atomic<std::int32_t> writerPid;    // Informational; the flock decides ownership
+};
+
+struct alignas(64) DataHeader {
+    std::uint64_t magic;
+    std::uint32_t layoutVersion;
+    std::uint32_t capacity;
+    std::atomic<std::uint32_t> symbolCount;     // Slots below this have their symbol set
+    std::atomic<std::uint64_t> publishCount;  // Bumped after every publish
+};
+
+// One cache line per symbol, so publishing one never disturbs readers of another
+struct alignas(64) Slot {
+    std::atomic<std::uint32_t> sequence;  // Odd while the writer is updating
+    char symbol[SharedPriceWriter::kMaxSymbolLength + 1];  // Set once, before symbolCount covers it
+    std::atomic<std::int64_t> price;
+    std::atomic<std::int64_t> previousPrice;
+    std::atomic<std::int64_t> updatedNs;
+};
+
+static_assert(sizeof(Slot) == 64, "Slot must fill exactly one cache line");
+
+size_t dataSize(size_t capacity) {
+    return sizeof(DataHeader) + capacity * sizeof(Slot);
+}
+
+DataHeader* headerOf(void* data) {
+    return static_cast<DataHeader*>(data);
+}
+
+const DataHeader* headerOf(const void* data) {
+    return static_cast<const DataHeader*>(data);
+}
+
+Slot* slotsOf(void* data) {
+    return reinterpret_cast<Slot*>(static_cast<char*>(data) + sizeof(DataHeader));
+}
+
+const Slot* slotsOf(const void* data) {
+    return reinterpret_cast<const Slot*>(static_cast<const char*>(data) + sizeof(DataHeader));
+}
+
+// POSIX shm names are a single path component starting with '/'
+bool validName(const std::string& name) {
+    return !name.empty() && name.size() < 200 && name.find('/') == std::string::npos;
+}
+
+std::string controlName(const std::string& name) {
+    return "/" + name;
+}
+
+std::string dataName(const std::string& name, std::uint32_t generation) {
+    return "/" + name + "." + std::to_string(generation);
+}
+
+std::int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+#ifndef _WIN32
+
+// SharedPriceWriter
+SharedPriceWriter::SharedPriceWriter()
+    : controlFd(-1), control(nullptr), data(nullptr), dataBytes(0), generation(0) {}
+
+SharedPriceWriter::~SharedPriceWriter() {
+    close();
+}
+
+bool SharedPriceWriter::mapData(std::uint32_t newGeneration, size_t capacity, bool create) {
+    const std::string segment = dataName(name, newGeneration);
+    int fd = shm_open(segment.c_str(), create ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDWR, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    size_t bytes = dataSize(capacity);
+    if (!create) {
+        struct stat info;
+        if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(DataHeader)) {
+            ::close(fd);
+            return false;
+        }
+        bytes = static_cast<size_t>(info.st_size);
+    } else if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+        ::close(fd);
+        shm_unlink(segment.c_str());
+        return false;
+    }
+    void* mapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        if (create) {
+            shm_unlink(segment.c_str());
+        }
+        return false;
+    }
+    DataHeader* header = headerOf(mapping);
+    if (create) {
+        // A fresh segment is zero-filled: every sequence starts even
+        header->magic = kDataMagic;
+        header->layoutVersion = kLayoutVersion;
+        header->capacity = static_cast<std::uint32_t>(capacity);
+    } else if (header->magic != kDataMagic || header->layoutVersion != kLayoutVersion ||
+               dataSize(header->capacity) > bytes) {
+        munmap(mapping, bytes);
+        return false;
+    }
+    data = mapping;
+    dataBytes = bytes;
+    generation = newGeneration;
+    return true;
+}
+
+void SharedPriceWriter::unmapData() {
+    if (data) {
+        munmap(data, dataBytes);
+        data = nullptr;
+        dataBytes = 0;
+    }
+}
+
+bool SharedPriceWriter::create(const std::string& tableName, size_t initialCapacity) {
+    close();
+    if (!validName(tableName)) {
+        return false;
+    }
+    name = tableName;
+    const std::string segment = controlName(name);
+    int fd = shm_open(segment.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    // One writer per table. The lock belongs to this descriptor, so the
+    // kernel drops it if the writer dies.
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        ::close(fd);
+        return false;
+    }
+    struct stat info;
+    bool fresh = fstat(fd, &info) == 0 && info.st_size == 0;
+    if ((fresh && ftruncate(fd, sizeof(ControlBlock)) != 0) ||
+        (!fresh && static_cast<size_t>(info.st_size) < sizeof(ControlBlock))) {
+        ::close(fd);
+        return false;
+    }
+    void* mapping = mmap(nullptr, sizeof(ControlBlock), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        ::close(fd);
+        return false;
+    }
+    ControlBlock* block = static_cast<ControlBlock*>(mapping);
+    controlFd = fd;
+    control = mapping;
+
+    std::uint32_t current = block->generation.load(std::memory_order_acquire);
+    if (fresh || current == 0) {
+        block->magic = kControlMagic;
+        block->layoutVersion = kLayoutVersion;
+        block->moneyDecimals = Money::kDecimals;
+        if (!mapData(1, std::max<size_t>(initialCapacity, 16), true)) {
+            close();
+            return false;
+        }
+        block->generation.store(1, std::memory_order_release);
+    } else {
+        if (block->magic != kControlMagic || block->layoutVersion != kLayoutVersion ||
+            block->moneyDecimals != static_cast<std::uint32_t>(Money::kDecimals) ||
+            !mapData(current, 0, false)) {
+            close();
+            return false;
+        }
+        // Take over from the previous writer: reopen any slot it died in the
+        // middle of publishing, and rebuild the symbol index.
+        DataHeader* header = headerOf(data);
+        Slot* slots = slotsOf(data);
+        const std::uint32_t count = header->symbolCount.load(std::memory_order_acquire);
+        for (std::uint32_t i = 0; i < count; ++i) {
+            std::uint32_t sequence = slots[i].sequence.load(std::memory_order_relaxed);
+            if (sequence & 1u) {
+                slots[i].sequence.store(sequence + 1, std::memory_order_release);
+            }
+            index.emplace(std::string(slots[i].symbol), i);
+        }
+    }
+    block->writerPid.store(static_cast<std::int32_t>(getpid()), std::memory_order_relaxed);
+    return true;
+}
+
+void SharedPriceWriter::close() {
+    unmapData();
+    if (control) {
+        static_cast<ControlBlock*>(control)->writerPid.store(0, std::memory_order_relaxed);
+        munmap(control, sizeof(ControlBlock));
+        control = nullptr;
+    }
+    if (controlFd >= 0) {
+        ::close(controlFd);  // Releases the writer lock
+        controlFd = -1;
+    }
+    index.clear();
+    generation = 0;
+}
+
+bool SharedPriceWriter::grow() {
+    void* oldData = data;
+    const size_t oldBytes = dataBytes;
+    const std::uint32_t oldGeneration = generation;
+    const DataHeader* oldHeader = headerOf(oldData);
+    const std::uint32_t count = oldHeader->symbolCount.load(std::memory_order_relaxed);
+
+    data = nullptr;
+    if (!mapData(oldGeneration + 1, static_cast<size_t>(oldHeader->capacity) * 2, true)) {
+        data = oldData;
+        dataBytes = oldBytes;
+        generation = oldGeneration;
+        return false;
+    }
+    // Only this process writes, so the old slots are stable while copied.
+    // Sequences carry over, so readers' change tracking survives the move.
+    DataHeader* header = headerOf(data);
+    Slot* slots = slotsOf(data);
+    const Slot* oldSlots = slotsOf(oldData);
+    for (std::uint32_t i = 0; i < count; ++i) {
+        slots[i].sequence.store(oldSlots[i].sequence.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        std::memcpy(slots[i].symbol, oldSlots[i].symbol, sizeof(slots[i].symbol));
+        slots[i].price.store(oldSlots[i].price.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        slots[i].previousPrice.store(oldSlots[i].previousPrice.load(std::memory_order_relaxed),
+                                     std::memory_order_relaxed);
+        slots[i].updatedNs.store(oldSlots[i].updatedNs.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    header->publishCount.store(oldHeader->publishCount.load(std::memory_order_relaxed) + 1,
+                               std::memory_order_relaxed);
+    header->symbolCount.store(count, std::memory_order_release);
+    static_cast<ControlBlock*>(control)->generation.store(generation, std::memory_order_release);
+
+    munmap(oldData, oldBytes);
+    shm_unlink(dataName(name, oldGeneration).c_str());
+    return true;
+}
+
+std::uint32_t SharedPriceWriter::slotFor(const std::string& symbol) {
+    auto it = index.find(symbol);
+    if (it != index.end()) {
+        return it->second;
+    }
+    if (symbol.empty() || symbol.size() > kMaxSymbolLength) {
+        return npos;
+    }
+    DataHeader* header = headerOf(data);
+    std::uint32_t slot = header->symbolCount.load(std::memory_order_relaxed);
+    if (slot == header->capacity) {
+        if (!grow()) {
+            return npos;
+        }
+        header = headerOf(data);
+    }
+    Slot& entry = slotsOf(data)[slot];
+    std::memset(entry.symbol, 0, sizeof(entry.symbol));
+    std::memcpy(entry.symbol, symbol.data(), symbol.size());
+    header->symbolCount.store(slot + 1, std::memory_order_release);  // Publishes the symbol
+    index.emplace(symbol, slot);
+    return slot;
+}
+
+bool SharedPriceWriter::publish(const std::string& symbol, Money price, std::int64_t updatedNs) {
+    if (!data || price.isNegative()) {
+        return false;
+    }
+    std::uint32_t slot = slotFor(symbol);
+    if (slot == npos) {
+        return false;
+    }
+    Slot& entry = slotsOf(data)[slot];
+    std::uint32_t sequence = entry.sequence.load(std::memory_order_relaxed);
+    entry.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    entry.previousPrice.store(entry.price.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    entry.price.store(price.raw(), std::memory_order_relaxed);
+    entry.updatedNs.store(updatedNs, std::memory_order_relaxed);
+    entry.sequence.store(sequence + 2, std::memory_order_release);
+
+    DataHeader* header = headerOf(data);
+    header->publishCount.store(header->publishCount.load(std::memory_order_relaxed) + 1,
+                               std::memory_order_release);
+    return true;
+}
+
+bool SharedPriceWriter::publish(const std::string& symbol, Money price) {
+    return publish(symbol, price, nowNs());
+}
+
+bool SharedPriceWriter::remove(const std::string& tableName) {
+    if (!validName(tableName)) {
+        return false;
+    }
+    const std::string segment = controlName(tableName);
+    int fd = shm_open(segment.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+    std::uint32_t current = 0;
+    void* mapping = mmap(nullptr, sizeof(ControlBlock), PROT_READ, MAP_SHARED, fd, 0);
+    if (mapping != MAP_FAILED) {
+        current = static_cast<const ControlBlock*>(mapping)->generation.load(std::memory_order_acquire);
+        munmap(mapping, sizeof(ControlBlock));
+    }
+    ::close(fd);
+    if (current != 0) {
+        shm_unlink(dataName(tableName, current).c_str());
+    }
+    return shm_unlink(segment.c_str()) == 0;
+}
+
+// SharedPriceReader
+SharedPriceReader::SharedPriceReader()
+    : control(nullptr), data(nullptr), dataBytes(0), generation(0), lastPublishCount(0) {}
+
+SharedPriceReader::~SharedPriceReader() {
+    close();
+}
+
+bool SharedPriceReader::mapData(std::uint32_t newGeneration) {
+    int fd = shm_open(dataName(name, newGeneration).c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(DataHeader)) {
+        ::close(fd);
+        return false;
+    }
+    const size_t bytes = static_cast<size_t>(info.st_size);
+    void* mapping = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    const DataHeader* header = headerOf(static_cast<const void*>(mapping));
+    if (header->magic != kDataMagic || header->layoutVersion != kLayoutVersion ||
+        dataSize(header->capacity) > bytes) {
+        munmap(mapping, bytes);
+        return false;
+    }
+    unmapData();
+    data = mapping;
+    dataBytes = bytes;
+    generation = newGeneration;
+    return true;
+}
+
+void SharedPriceReader::unmapData() {
+    if (data) {
+        munmap(const_cast<void*>(data), dataBytes);
+        data = nullptr;
+        dataBytes = 0;
+    }
+}
+
+bool SharedPriceReader::open(const std::string& tableName) {
+    close();
+    if (!validName(tableName)) {
+        return false;
+    }
+    name = tableName;
+    int fd = shm_open(controlName(name).c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(ControlBlock)) {
+        ::close(fd);
+        return false;
+    }
+    void* mapping = mmap(nullptr, sizeof(ControlBlock), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    const ControlBlock* block = static_cast<const ControlBlock*>(mapping);
+    if (block->magic != kControlMagic || block->layoutVersion != kLayoutVersion ||
+        block->moneyDecimals != static_cast<std::uint32_t>(Money::kDecimals)) {
+        munmap(mapping, sizeof(ControlBlock));
+        return false;
+    }
+    control = mapping;
+    if (!refresh()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void SharedPriceReader::close() {
+    unmapData();
+    if (control) {
+        munmap(const_cast<void*>(control), sizeof(ControlBlock));
+        control = nullptr;
+    }
+    generation = 0;
+    lastPublishCount = 0;
+    symbols.clear();
+    lastSequence.clear();
+    index.clear();
+}
+
+bool SharedPriceReader::refresh() {
+    if (!control) {
+        return false;
+    }
+    const ControlBlock* block = static_cast<const ControlBlock*>(control);
+    // The writer may grow again between reading the generation and opening
+    // its segment, which it has then unlinked: re-read and retry.
+    for (int attempt = 0; attempt < 8; ++attempt) {
+        std::uint32_t current = block->generation.load(std::memory_order_acquire);
+        if (current == generation && data) {
+            return true;
+        }
+        if (current != 0 && mapData(current)) {
+            return true;
+        }
+    }
+    return data != nullptr;  // Keep the old mapping rather than none
+}
+
+void SharedPriceReader::scanSymbols() {
+    const DataHeader* header = headerOf(data);
+    const Slot* slots = slotsOf(data);
+    const std::uint32_t count = header->symbolCount.load(std::memory_order_acquire);
+    for (std::uint32_t i = static_cast<std::uint32_t>(symbols.size()); i < count; ++i) {
+        symbols.emplace_back(slots[i].symbol, strnlen(slots[i].symbol, sizeof(slots[i].symbol)));
+        lastSequence.push_back(0);
+        index.emplace(symbols.back(), i);
+    }
+}
+
+std::uint32_t SharedPriceReader::find(const std::string& symbol) {
+    auto it = index.find(symbol);
+    if (it != index.end()) {
+        return it->second;
+    }
+    if (!refresh()) {
+        return npos;
+    }
+    scanSymbols();
+    it = index.find(symbol);
+    return it == index.end() ? npos : it->second;
+}
+
+bool SharedPriceReader::read(std::uint32_t handle, SharedPrice& result) const {
+    if (!data || handle >= headerOf(data)->symbolCount.load(std::memory_order_acquire)) {
+        return false;
+    }
+    const Slot& entry = slotsOf(data)[handle];
+    for (int attempt = 0; attempt < kReadRetries; ++attempt) {
+        std::uint32_t before = entry.sequence.load(std::memory_order_acquire);
+        if (before & 1u) {
+            continue;
+        }
+        std::int64_t price = entry.price.load(std::memory_order_relaxed);
+        std::int64_t previous = entry.previousPrice.load(std::memory_order_relaxed);
+        std::int64_t updated = entry.updatedNs.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (entry.sequence.load(std::memory_order_relaxed) == before) {
+            result.price = Money::fromUnits(price);
+            result.previousPrice = Money::fromUnits(previous);
+            result.updatedNs = updated;
+            result.sequence = before;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SharedPriceReader::getPrice(const std::string& symbol, Money& price) {
+    std::uint32_t handle = find(symbol);
+    SharedPrice entry;
+    if (handle == npos || !read(handle, entry)) {
+        return false;
+    }
+    price = entry.price;
+    return true;
+}
+
+size_t SharedPriceReader::poll(Portfolio& portfolio) {
+    if (!refresh()) {
+        return 0;
+    }
+    const std::uint64_t published = headerOf(data)->publishCount.load(std::memory_order_acquire);
+    if (published == lastPublishCount) {
+        return 0;
+    }
+    // Publishes that land during the scan bump the count again and are
+    // picked up (or caught already) by the next poll
+    lastPublishCount = published;
+    scanSymbols();
+
+    batch.clear();
+    const Slot* slots = slotsOf(data);
+    const size_t count = symbols.size();
+    for (size_t i = 0; i < count; ++i) {
+        std::uint32_t sequence = slots[i].sequence.load(std::memory_order_relaxed);
+        if (sequence == lastSequence[i]) {
+            continue;
+        }
+        SharedPrice entry;
+        if (!read(static_cast<std::uint32_t>(i), entry)) {
+            continue;
+        }
+        lastSequence[i] = entry.sequence;
+        if (static_cast<const Portfolio&>(portfolio).getInvestment(symbols[i])) {
+            batch.push_back(PriceUpdate{symbols[i], entry.price});
+        }
+    }
+    return batch.empty() ? 0 : portfolio.updateStockPrices(batch);
+}
+
+size_t SharedPriceReader::size() const {
+    return data ? headerOf(data)->symbolCount.load(std::memory_order_acquire) : 0;
+}
+
+#else // _WIN32
+
+SharedPriceWriter::SharedPriceWriter()
+    : controlFd(-1), control(nullptr), data(nullptr), dataBytes(0), generation(0) {}
+SharedPriceWriter::~SharedPriceWriter() {}
+bool SharedPriceWriter::mapData(std::uint32_t, size_t, bool) { return false; }
+void SharedPriceWriter::unmapData() {}
+bool SharedPriceWriter::grow() { return false; }
+std::uint32_t SharedPriceWriter::slotFor(const std::string&) { return npos; }
+bool SharedPriceWriter::create(const std::string&, size_t) { return false; }
+void SharedPriceWriter::close() {}
+bool SharedPriceWriter::publish(const std::string&, Money, std::int64_t) { return false; }
+bool SharedPriceWriter::publish(const std::string&, Money) { return false; }
+bool SharedPriceWriter::remove(const std::string&) { return false; }
+
+SharedPriceReader::SharedPriceReader()
+    : control(nullptr), data(nullptr), dataBytes(0), generation(0), lastPublishCount(0) {}
+SharedPriceReader::~SharedPriceReader() {}
+bool SharedPriceReader::mapData(std::uint32_t) { return false; }
+void SharedPriceReader::unmapData() {}
+void SharedPriceReader::scanSymbols() {}
+bool SharedPriceReader::open(const std::string&) { return false; }
+void SharedPriceReader::close() {}
+bool SharedPriceReader::refresh() { return false; }
+std::uint32_t SharedPriceReader::find(const std::string&) { return npos; }
+bool SharedPriceReader::read(std::uint32_t, SharedPrice&) const { return false; }
+bool SharedPriceReader::getPrice(const std::string&, Money&) { return false; }
+size_t SharedPriceReader::poll(Portfolio&) { return 0; }
+size_t SharedPriceReader::size() const { return 0; }
+
+#endif // _WIN32
+
+// SharedPricePublisher
+SharedPricePublisher::SharedPricePublisher(Portfolio& portfolio, SharedPriceWriter& writer)
+    : portfolio(portfolio), writer(writer), failures(0) {
+    portfolio.addTickListener(this);
+}
+
+SharedPricePublisher::~SharedPricePublisher() {
+    portfolio.removeTickListener(this);
+}
+
+size_t SharedPricePublisher::publishAll() {
+    size_t published = 0;
+    const std::int64_t now = nowNs();
+    for (const Investment& investment : static_cast<const Portfolio&>(portfolio)) {
+        const Stock* stock = investment.getStock().get();
+        if (!stock) {
+            continue;
+        }
+        if (writer.publish(stock->getSymbol(), stock->getCurrentPrice(), now)) {
+            ++published;
+        } else {
+            ++failures;
+        }
+    }
+    return published;
+}
+
+void SharedPricePublisher::onTick(const Investment& investment, Money) {
+    if (!writer.publish(investment.getStock()->getSymbol(), investment.getStock()->getCurrentPrice())) {
+        ++failures;
+    }
+}
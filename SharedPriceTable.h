@@ -0,0 +1,161 @@
+#ifndef SHARED_PRICE_TABLE_H
+#define SHARED_PRICE_TABLE_H
+
+#include "Money.h"
+#include "Portfolio.h"
+#include "TickListener.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Per-symbol prices published by one process and read by others on the same
+// host through POSIX shared memory, so only the writer has to ingest the feed.
+//
+// A table named "prices" is a small control segment (/prices) holding the
+// current generation, plus a data segment (/prices.<generation>) of fixed
+// 64-byte slots. Each slot is guarded by a seqlock: the writer makes the
+// sequence odd, stores the price fields, then makes it even again, and a
+// reader retries until it sees the same even sequence before and after its
+// loads. Readers map the segments read-only and never write, so nothing
+// they do (including crashing) can block or corrupt the writer or other
+// readers.
+//
+// Symbols are only ever appended, so a symbol's slot index is stable for the
+// table's lifetime. When the data segment fills up the writer copies it into
+// a segment twice the size, bumps the generation and unlinks the old one;
+// readers notice the new generation and remap, and a reader still on the old
+// mapping keeps valid (if ageing) data until it does.
+//
+// Prices are Money units, in the currency each symbol is quoted in; both
+// sides must be built with the same PORTFOLIO_MONEY_DECIMALS, which open()
+// checks. POSIX only: elsewhere open() and create() return false.
+
+// One consistent read of a slot
+struct SharedPrice {
+    Money price;
+    Money previousPrice;
+    std::int64_t updatedNs = 0;   // Writer's system_clock time of the last publish
+    std::uint32_t sequence = 0;   // Even; advances by 2 on every publish
+};
+
+class SharedPriceWriter {
+private:
+    std::string name;
+    int controlFd;
+    void* control;
+    void* data;
+    size_t dataBytes;
+    std::uint32_t generation;
+    std::unordered_map<std::string, std::uint32_t> index;
+
+    bool mapData(std::uint32_t generation, size_t capacity, bool create);
+    void unmapData();
+    bool grow();
+    std::uint32_t slotFor(const std::string& symbol);
+
+public:
+    static constexpr std::uint32_t npos = static_cast<std::uint32_t>(-1);
+    static constexpr size_t kMaxSymbolLength = 27;
+
+    SharedPriceWriter();
+    ~SharedPriceWriter();  // Unmaps; the segments stay for readers and the next writer
+
+    SharedPriceWriter(const SharedPriceWriter&) = delete;
+    SharedPriceWriter& operator=(const SharedPriceWriter&) = delete;
+
+    // Creates the table, or takes over an existing one (for instance after
+    // the previous writer crashed; a slot it left mid-update is reopened with
+    // whatever it had stored). Returns false if another writer holds it, the
+    // name is invalid or the segment was built with different Money decimals.
+    bool create(const std::string& name, size_t initialCapacity = 4096);
+    bool isOpen() const { return control != nullptr; }
+    void close();
+
+    // Adds the symbol if needed. Returns false for symbols longer than
+    // kMaxSymbolLength, negative prices, or when growing the table fails.
+    bool publish(const std::string& symbol, Money price, std::int64_t updatedNs);
+    bool publish(const std::string& symbol, Money price);  // Stamped with the current time
+
+    size_t size() const { return index.size(); }
+    std::uint32_t getGeneration() const { return generation; }
+
+    // Unlinks the table's segments; mappings that are open stay valid
+    static bool remove(const std::string& name);
+};
+
+class SharedPriceReader {
+private:
+    std::string name;
+    const void* control;
+    const void* data;
+    size_t dataBytes;
+    std::uint32_t generation;
+    std::uint64_t lastPublishCount;
+    std::vector<std::string> symbols;        // Slot index -> symbol, for the slots seen so far
+    std::vector<std::uint32_t> lastSequence;  // Per slot, as of the last poll
+    std::unordered_map<std::string, std::uint32_t> index;
+    std::vector<PriceUpdate> batch;
+
+    bool mapData(std::uint32_t generation);
+    void unmapData();
+    void scanSymbols();
+
+public:
+    static constexpr std::uint32_t npos = static_cast<std::uint32_t>(-1);
+
+    SharedPriceReader();
+    ~SharedPriceReader();
+
+    SharedPriceReader(const SharedPriceReader&) = delete;
+    SharedPriceReader& operator=(const SharedPriceReader&) = delete;
+
+    // Maps an existing table read-only
+    bool open(const std::string& name);
+    bool isOpen() const { return control != nullptr; }
+    void close();
+
+    // Follows the writer to a grown segment; false if the table is gone
+    bool refresh();
+
+    // Slot handle for a symbol, or npos if it has not been published
+    std::uint32_t find(const std::string& symbol);
+
+    // Seqlock read of a slot straight from the mapping. Returns false for a
+    // bad handle, or if the slot stayed mid-update for the whole retry budget
+    // (a writer that died while publishing it).
+    bool read(std::uint32_t handle, SharedPrice& result) const;
+    bool getPrice(const std::string& symbol, Money& price);
+
+    // Applies every slot published since the last poll whose symbol the
+    // portfolio holds, as one updateStockPrices batch, so valuations, events
+    // and tick listeners behave as for a local feed. Returns ticks applied.
+    size_t poll(Portfolio& portfolio);
+
+    size_t size() const;
+    std::uint32_t getGeneration() const { return generation; }
+};
+
+// Mirrors every tick a portfolio applies into a shared table, making that
+// process the host's feed writer
+class SharedPricePublisher : public TickListener {
+private:
+    Portfolio& portfolio;
+    SharedPriceWriter& writer;
+    size_t failures;
+
+public:
+    SharedPricePublisher(Portfolio& portfolio, SharedPriceWriter& writer);
+    ~SharedPricePublisher() override;
+
+    SharedPricePublisher(const SharedPricePublisher&) = delete;
+    SharedPricePublisher& operator=(const SharedPricePublisher&) = delete;
+
+    // Publishes every current position price, e.g. right after create()
+    size_t publishAll();
+    size_t getFailures() const { return failures; }
+
+    void onTick(const Investment& investment, Money oldPrice) override;
+};
+
+#endif // SHARED_PRICE_TABLE_H
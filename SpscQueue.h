@@ -0,0 +1,73 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Bounded lock-free single-producer/single-consumer ring buffer. tryPush is
+// only called from the producer thread and tryPop from the consumer thread;
+// neither ever blocks. Capacity is rounded up to a power of two.
+template <typename T>
+class SpscQueue {
+private:
+    static constexpr size_t kCacheLine = 64;
+
+    std::vector<T> slots;
+    size_t mask;
+    alignas(kCacheLine) std::atomic<size_t> head;  // Next slot to pop (consumer)
+    alignas(kCacheLine) std::atomic<size_t> tail;  // Next slot to push (producer)
+    alignas(kCacheLine) size_t cachedHead;         // Producer's view of head
+    alignas(kCacheLine) size_t cachedTail;         // Consumer's view of tail
+
+    static size_t roundUp(size_t n) {
+        size_t capacity = 2;
+        while (capacity < n) {
+            capacity <<= 1;
+        }
+        return capacity;
+    }
+
+public:
+    explicit SpscQueue(size_t capacity)
+        : slots(roundUp(capacity)), mask(roundUp(capacity) - 1),
+          head(0), tail(0), cachedHead(0), cachedTail(0) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    size_t capacity() const { return slots.size(); }
+
+    bool tryPush(T value) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - cachedHead == slots.size()) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (t - cachedHead == slots.size()) {
+                return false;
+            }
+        }
+        slots[t & mask] = std::move(value);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& value) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (h == cachedTail) {
+                return false;
+            }
+        }
+        value = std::move(slots[h & mask]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+};
+
+#endif // SPSC_QUEUE_H
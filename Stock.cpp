@@ -1,23 +1,68 @@
 #include "Stock.h"
+#include <algorithm>
 #include <iomanip>
+#include <limits>
 #include <stdexcept>
 #include <thread>
 
+namespace {
+
+using Wide = __int128;
+
+Wide greatestCommonDivisor(Wide a, Wide b) {
+    while (b != 0) {
+        Wide r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+} // namespace
+
+SplitRatio operator*(SplitRatio a, SplitRatio b) {
+    Wide numerator = static_cast<Wide>(a.numerator) * b.numerator;
+    Wide denominator = static_cast<Wide>(a.denominator) * b.denominator;
+    const Wide common = greatestCommonDivisor(numerator, denominator);
+    if (common > 1) {
+        numerator /= common;
+        denominator /= common;
+    }
+    const Wide limit = std::numeric_limits<std::int64_t>::max();
+    while (numerator > limit || denominator > limit) {
+        numerator = (numerator + 1) / 2;
+        denominator = (denominator + 1) / 2;
+    }
+    return {static_cast<std::int64_t>(numerator), static_cast<std::int64_t>(denominator)};
+}
+
 // Default constructor
-Stock::Stock() : symbol(""), companyName(""), currentPrice(0.0), previousPrice(0.0) {}
+Stock::Stock()
+    : symbol(""), companyName(""), currentPrice(), previousPrice(), currency(Currency::kDefault), lastSplitDay(0) {}
 
-// Parameterized constructor
-Stock::Stock(const std::string& symbol, const std::string& companyName, double currentPrice)
-    : symbol(symbol), companyName(companyName), currentPrice(currentPrice), previousPrice(currentPrice) {
-    if (currentPrice < 0) {
+// Parameterized constructors
+Stock::Stock(const std::string& symbol, const std::string& companyName, Money currentPrice)
+    : symbol(symbol), companyName(companyName), currentPrice(currentPrice), previousPrice(currentPrice),
+      currency(Currency::kDefault), lastSplitDay(0) {
+    if (currentPrice.isNegative()) {
         throw std::invalid_argument("Stock price cannot be negative");
     }
 }
 
+Stock::Stock(const std::string& symbol, const std::string& companyName, double currentPrice)
+    : Stock(symbol, companyName, Money::fromDouble(currentPrice)) {}
+
+Stock::Stock(const std::string& symbol, const std::string& companyName, Money currentPrice,
+             const std::string& currencyCode)
+    : Stock(symbol, companyName, currentPrice) {
+    currency = Currency::idOf(currencyCode);
+}
+
 // Copy constructor
 Stock::Stock(const Stock& other)
     : symbol(other.symbol), companyName(other.companyName), 
-      currentPrice(other.currentPrice), previousPrice(other.previousPrice) {}
+      currentPrice(other.currentPrice), previousPrice(other.previousPrice), currency(other.currency),
+      attributes(other.attributes), splits(other.splits), lastSplitDay(other.lastSplitDay) {}
 
 // Destructor
 Stock::~Stock() {
@@ -25,7 +70,7 @@ Stock::~Stock() {
 }
 
 // Getters
-std::string Stock::getSymbol() const {
+const std::string& Stock::getSymbol() const {
     return symbol;
 }
 
@@ -33,44 +78,149 @@ std::string Stock::getCompanyName() const {
     return companyName;
 }
 
-double Stock::getCurrentPrice() const {
+Money Stock::getCurrentPrice() const {
     return currentPrice;
 }
 
-double Stock::getPreviousPrice() const {
+Money Stock::getPreviousPrice() const {
     return previousPrice;
 }
 
+CurrencyId Stock::getCurrency() const {
+    return currency;
+}
+
+std::string Stock::getCurrencyCode() const {
+    return Currency::codeOf(currency);
+}
+
 // Setters
-void Stock::setCurrentPrice(double price) {
-    if (price < 0) {
+void Stock::setCurrentPrice(Money price) {
+    if (price.isNegative()) {
         throw std::invalid_argument("Stock price cannot be negative");
     }
     previousPrice = currentPrice;
     currentPrice = price;
+    bumpWatchers();
 }
 
-void Stock::setPreviousPrice(double price) {
-    if (price < 0) {
+void Stock::setCurrentPrice(double price) {
+    setCurrentPrice(Money::fromDouble(price));
+}
+
+void Stock::setPreviousPrice(Money price) {
+    if (price.isNegative()) {
         throw std::invalid_argument("Stock price cannot be negative");
     }
     previousPrice = price;
 }
 
+void Stock::setPreviousPrice(double price) {
+    setPreviousPrice(Money::fromDouble(price));
+}
+
 void Stock::setCompanyName(const std::string& name) {
     companyName = name;
 }
 
+void Stock::setCurrency(const std::string& currencyCode) {
+    currency = Currency::idOf(currencyCode);
+    bumpWatchers();
+}
+
+// Attributes
+AttributeCode Stock::getAttributeCode(AttributeField field) const {
+    return field < attributes.size() ? attributes[field] : Attributes::kUnset;
+}
+
+std::string Stock::getAttribute(const std::string& field) const {
+    AttributeField id;
+    if (!Attributes::findField(field, id)) {
+        return "";
+    }
+    return Attributes::decode(id, getAttributeCode(id));
+}
+
+std::string Stock::getSector() const {
+    return Attributes::decode(Attributes::kSector, getAttributeCode(Attributes::kSector));
+}
+
+std::string Stock::getIndustry() const {
+    return Attributes::decode(Attributes::kIndustry, getAttributeCode(Attributes::kIndustry));
+}
+
+std::string Stock::getCountry() const {
+    return Attributes::decode(Attributes::kCountry, getAttributeCode(Attributes::kCountry));
+}
+
+std::vector<AttributeField> Stock::getAttributeFields() const {
+    std::vector<AttributeField> fields;
+    for (size_t i = 0; i < attributes.size(); ++i) {
+        if (attributes[i] != Attributes::kUnset) {
+            fields.push_back(static_cast<AttributeField>(i));
+        }
+    }
+    return fields;
+}
+
+// Group rollups are keyed by attribute codes, so a change invalidates them
+void Stock::setAttribute(AttributeField field, const std::string& value) {
+    AttributeCode code = Attributes::encode(field, value);
+    if (field >= attributes.size()) {
+        if (code == Attributes::kUnset) {
+            return;
+        }
+        attributes.resize(static_cast<size_t>(field) + 1, Attributes::kUnset);
+    }
+    attributes[field] = code;
+    bumpWatchers();
+}
+
+void Stock::setAttribute(const std::string& field, const std::string& value) {
+    setAttribute(Attributes::fieldOf(field), value);
+}
+
+void Stock::setSector(const std::string& sector) {
+    setAttribute(Attributes::kSector, sector);
+}
+
+void Stock::setIndustry(const std::string& industry) {
+    setAttribute(Attributes::kIndustry, industry);
+}
+
+void Stock::setCountry(const std::string& country) {
+    setAttribute(Attributes::kCountry, country);
+}
+
+// Valuation watchers
+void Stock::bumpWatchers() {
+    for (const ValuationEpochPtr& epoch : watchers) {
+        epoch->bump();
+    }
+}
+
+void Stock::watchValuation(const ValuationEpochPtr& epoch) {
+    watchers.erase(std::remove_if(watchers.begin(), watchers.end(),
+                                  [](const ValuationEpochPtr& watcher) { return watcher.use_count() == 1; }),
+                   watchers.end());
+    if (std::find(watchers.begin(), watchers.end(), epoch) == watchers.end()) {
+        watchers.push_back(epoch);
+    }
+}
+
+void Stock::unwatchValuation(const ValuationEpoch* epoch) {
+    watchers.erase(std::remove_if(watchers.begin(), watchers.end(),
+                                  [epoch](const ValuationEpochPtr& watcher) { return watcher.get() == epoch; }),
+                   watchers.end());
+}
+
 // Utility methods
-double Stock::getPriceChange() const {
+Money Stock::getPriceChange() const {
     return currentPrice - previousPrice;
 }
 
 double Stock::getPercentageChange() const {
-    if (previousPrice == 0.0) {
-        return 0.0;
-    }
-    return ((currentPrice - previousPrice) / previousPrice) * 100.0;
+    return Money::ratio(currentPrice - previousPrice, previousPrice) * 100.0;
 }
 
 // Assignment operator
@@ -80,10 +230,48 @@ Stock& Stock::operator=(const Stock& other) {
         companyName = other.companyName;
         currentPrice = other.currentPrice;
         previousPrice = other.previousPrice;
+        currency = other.currency;
+        attributes = other.attributes;
+        splits = other.splits;
+        lastSplitDay = other.lastSplitDay;
+        bumpWatchers();
     }
     return *this;
 }
 
+// Corporate actions
+void Stock::applySplit(SplitRatio ratio, int exDay) {
+    if (ratio.numerator <= 0 || ratio.denominator <= 0) {
+        throw std::invalid_argument("Split ratio must be positive");
+    }
+    ratio = ratio * SplitRatio();
+    currentPrice = currentPrice.mulDiv(ratio.denominator, ratio.numerator);
+    previousPrice = previousPrice.mulDiv(ratio.denominator, ratio.numerator);
+    splits.push_back(ratio);
+    lastSplitDay = std::max(lastSplitDay, exDay);
+    bumpWatchers();
+}
+
+std::uint32_t Stock::getSplitCount() const {
+    return static_cast<std::uint32_t>(splits.size());
+}
+
+int Stock::getLastSplitDay() const {
+    return lastSplitDay;
+}
+
+void Stock::setLastSplitDay(int exDay) {
+    lastSplitDay = exDay;
+}
+
+SplitRatio Stock::getSplitRatioSince(std::uint32_t count) const {
+    SplitRatio combined;
+    for (size_t i = count; i < splits.size(); ++i) {
+        combined = combined * splits[i];
+    }
+    return combined;
+}
+
 // Equality operator
 bool Stock::operator==(const Stock& other) const {
     return symbol == other.symbol;
@@ -1,36 +1,99 @@
 #ifndef STOCK_H
 #define STOCK_H
 
+#include "Attributes.h"
+#include "Currency.h"
+#include "Money.h"
+#include "ValuationEpoch.h"
+#include <cstdint>
 #include <string>
 #include <iostream>
+#include <vector>
+
+// New shares per old share: 2/1 for a 2-for-1 split, 1/10 for a 1-for-10
+// reverse split, 21/20 for a 5% stock dividend
+struct SplitRatio {
+    std::int64_t numerator = 1;
+    std::int64_t denominator = 1;
+};
+
+// Product in lowest terms; when that does not fit in 64 bits, the nearest
+// ratio that does (only odd stock dividends compound that far)
+SplitRatio operator*(SplitRatio a, SplitRatio b);
 
 class Stock {
 private:
     std::string symbol;
     std::string companyName;
-    double currentPrice;
-    double previousPrice;
+    Money currentPrice;
+    Money previousPrice;
+    CurrencyId currency;  // Currency the price is quoted in
+    std::vector<AttributeCode> attributes;  // Indexed by AttributeField; missing = unset
+    std::vector<SplitRatio> splits;  // Applied splits, oldest first
+    int lastSplitDay;                // Ex-day of the latest one; 0 = none
+    // Valuation counters of the portfolios holding this stock, bumped on every
+    // change to its value. Not copied: a copy is held by nobody yet.
+    std::vector<ValuationEpochPtr> watchers;
+
+    void bumpWatchers();
 
 public:
     // Constructors and Destructor
     Stock();
+    Stock(const std::string& symbol, const std::string& companyName, Money currentPrice);
     Stock(const std::string& symbol, const std::string& companyName, double currentPrice);
+    Stock(const std::string& symbol, const std::string& companyName, Money currentPrice,
+          const std::string& currencyCode);
     Stock(const Stock& other);  // Copy constructor
     ~Stock();
 
     // Getters (const methods for encapsulation)
-    std::string getSymbol() const;
+    const std::string& getSymbol() const;
     std::string getCompanyName() const;
-    double getCurrentPrice() const;
-    double getPreviousPrice() const;
+    Money getCurrentPrice() const;
+    Money getPreviousPrice() const;
+    CurrencyId getCurrency() const;
+    std::string getCurrencyCode() const;
+    AttributeCode getAttributeCode(AttributeField field) const;
+    std::string getAttribute(const std::string& field) const;
+    std::string getSector() const;
+    std::string getIndustry() const;
+    std::string getCountry() const;
+    std::vector<AttributeField> getAttributeFields() const;  // Fields with a value
 
     // Setters
+    void setCurrentPrice(Money price);
     void setCurrentPrice(double price);
+    void setPreviousPrice(Money price);
     void setPreviousPrice(double price);
     void setCompanyName(const std::string& name);
+    void setCurrency(const std::string& currencyCode);
+    void setAttribute(AttributeField field, const std::string& value);
+    void setAttribute(const std::string& field, const std::string& value);
+    void setSector(const std::string& sector);
+    void setIndustry(const std::string& industry);
+    void setCountry(const std::string& country);
+
+    // Splits and stock dividends. Prices are rescaled at once; holdings
+    // recorded before a split are adjusted when next read (see Investment),
+    // so posting one costs the same however many positions hold the stock.
+    // Throws std::invalid_argument for a non-positive ratio.
+    void applySplit(SplitRatio ratio, int exDay = 0);
+    std::uint32_t getSplitCount() const;
+    int getLastSplitDay() const;
+    // As restored from a saved portfolio, whose figures already reflect the
+    // splits up to that day; rescales nothing
+    void setLastSplitDay(int exDay);
+    // Combined ratio of the splits after the first `count`, in lowest terms
+    SplitRatio getSplitRatioSince(std::uint32_t count) const;
+
+    // Registration by holding portfolios (see ValuationEpoch.h). Counters no
+    // portfolio holds any more are dropped on the next watch.
+    void watchValuation(const ValuationEpochPtr& epoch);
+    void unwatchValuation(const ValuationEpoch* epoch);
 
     // Utility methods
-    double getPriceChange() const;
+    Money getPriceChange() const;
     double getPercentageChange() const;
 
     // Operators
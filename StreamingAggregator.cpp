@@ -0,0 +1,529 @@
+#include "StreamingAggregator.h"
+#include "FxRateTable.h"
+#include "Metrics.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string_view>
+#include <thread>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Batch {
+    std::vector<StreamedPosition> positions;  // Slots are reused, so strings keep their capacity
+    size_t count = 0;
+};
+
+// Blocking hand-off between the reader and the aggregator. Batches travel
+// full from reader to aggregator and back empty, so the pool never grows.
+class BatchQueue {
+private:
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<Batch*> items;
+    bool closed = false;
+
+public:
+    void push(Batch* batch) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            items.push_back(batch);
+        }
+        ready.notify_one();
+    }
+
+    // False once the queue is closed and drained
+    bool pop(Batch*& batch) {
+        std::unique_lock<std::mutex> lock(mutex);
+        ready.wait(lock, [this] { return closed || !items.empty(); });
+        if (items.empty()) {
+            return false;
+        }
+        batch = items.front();
+        items.pop_front();
+        return true;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        ready.notify_all();
+    }
+};
+
+// What the reader learns besides the positions themselves
+struct ParseResult {
+    bool ok = false;
+    std::string portfolioName;
+    Money totalInitialInvestment;
+    size_t declared = 0;
+    size_t parsed = 0;
+    size_t skipped = 0;
+    FxRateTable fxRates;
+    std::uint64_t bytesRead = 0;
+};
+
+// Splits a position line the way Portfolio::loadFromFile does: seven
+// comma-separated fields, then the optional currency as the rest of the line.
+class PositionParser {
+private:
+    std::string scratch;
+    std::string lastCurrencyCode;
+    CurrencyId lastCurrency = Currency::kDefault;
+
+    bool parseMoney(std::string_view text, Money& value) {
+        scratch.assign(text.data(), text.size());
+        return Money::tryParse(scratch, value);
+    }
+
+    // std::stoi semantics: leading digits count, trailing text is ignored
+    bool parseShares(std::string_view text, int& value) {
+        scratch.assign(text.data(), text.size());
+        char* end = nullptr;
+        errno = 0;
+        long parsed = std::strtol(scratch.c_str(), &end, 10);
+        if (end == scratch.c_str() || errno == ERANGE || parsed < INT_MIN || parsed > INT_MAX) {
+            return false;
+        }
+        value = static_cast<int>(parsed);
+        return true;
+    }
+
+public:
+    bool parse(std::string_view line, StreamedPosition& position) {
+        std::string_view fields[7];
+        for (int f = 0; f < 7; ++f) {
+            size_t comma = line.find(',');
+            if (comma == std::string_view::npos) {
+                if (f < 6) {
+                    return false;
+                }
+                fields[f] = line;
+                line = std::string_view();
+            } else {
+                fields[f] = line.substr(0, comma);
+                line.remove_prefix(comma + 1);
+            }
+        }
+
+        if (!parseMoney(fields[2], position.currentPrice) || !parseMoney(fields[3], position.previousPrice) ||
+            !parseShares(fields[4], position.sharesOwned) || !parseMoney(fields[5], position.purchasePrice) ||
+            !parseMoney(fields[6], position.totalInvested)) {
+            return false;
+        }
+        // The checks Stock's and Investment's constructors make
+        if (position.currentPrice.isNegative() || position.sharesOwned < 0 ||
+            position.purchasePrice.isNegative() || position.totalInvested.isNegative()) {
+            return false;
+        }
+
+        if (line.empty()) {
+            position.currency = Currency::kDefault;
+        } else {
+            if (line != lastCurrencyCode) {
+                try {
+                    std::string code(line);
+                    lastCurrency = Currency::idOf(code);
+                    lastCurrencyCode = code;
+                } catch (const std::exception&) {
+                    return false;
+                }
+            }
+            position.currency = lastCurrency;
+        }
+        position.symbol.assign(fields[0].data(), fields[0].size());
+        position.companyName.assign(fields[1].data(), fields[1].size());
+        return true;
+    }
+};
+
+// Reader thread: chunked reads, line splitting and parsing. Closes `full`
+// when done, whatever the outcome.
+void readPositions(std::ifstream& file, const StreamingOptions& options, BatchQueue& empty, BatchQueue& full,
+                   ParseResult& result) {
+    try {
+        std::vector<char> buffer(std::max<size_t>(options.chunkBytes, 4096));
+        std::string carry;  // A line split across two chunks
+        PositionParser parser;
+        size_t lineNumber = 0;
+        Batch* batch = nullptr;
+        bool stop = false;
+
+        auto handleLine = [&](std::string_view line) {
+            size_t n = lineNumber++;
+            if (n == 0) {
+                result.portfolioName.assign(line.data(), line.size());
+                return true;
+            }
+            if (n == 1) {
+                return Money::tryParse(std::string(line), result.totalInitialInvestment);
+            }
+            if (n == 2) {
+                std::string text(line);
+                char* end = nullptr;
+                result.declared = std::strtoul(text.c_str(), &end, 10);
+                return end != text.c_str();
+            }
+            if (n - 3 < result.declared) {
+                if (!batch && !empty.pop(batch)) {
+                    return false;
+                }
+                if (batch->positions.size() < options.batchPositions) {
+                    batch->positions.resize(options.batchPositions);
+                }
+                if (parser.parse(line, batch->positions[batch->count])) {
+                    ++batch->count;
+                    ++result.parsed;
+                } else {
+                    ++result.skipped;
+                }
+                if (batch->count == batch->positions.size()) {
+                    full.push(batch);
+                    batch = nullptr;
+                }
+                return true;
+            }
+
+            // Trailer: FX rates matter for the totals; attributes are skipped
+            size_t comma = line.find(',');
+            if (comma == std::string_view::npos) {
+                return true;
+            }
+            std::string_view tag = line.substr(0, comma);
+            std::string_view rest = line.substr(comma + 1);
+            try {
+                if (tag == "BASE") {
+                    result.fxRates.setBaseCurrency(Currency::idOf(std::string(rest.substr(0, rest.find(',')))));
+                } else if (tag == "FX") {
+                    size_t split = rest.find(',');
+                    if (split != std::string_view::npos) {
+                        result.fxRates.setRate(Currency::idOf(std::string(rest.substr(0, split))),
+                                               std::stod(std::string(rest.substr(split + 1))));
+                    }
+                }
+            } catch (const std::exception&) {
+                // Skip invalid entries, as loadFromFile does
+            }
+            return true;
+        };
+
+        while (!stop && file) {
+            file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            size_t length = static_cast<size_t>(file.gcount());
+            if (length == 0) {
+                break;
+            }
+            result.bytesRead += length;
+            const char* cursor = buffer.data();
+            const char* end = cursor + length;
+            while (!stop) {
+                const char* newline = static_cast<const char*>(std::memchr(cursor, '\n', static_cast<size_t>(end - cursor)));
+                if (!newline) {
+                    carry.append(cursor, end);
+                    break;
+                }
+                if (carry.empty()) {
+                    stop = !handleLine(std::string_view(cursor, static_cast<size_t>(newline - cursor)));
+                } else {
+                    carry.append(cursor, newline);
+                    stop = !handleLine(carry);
+                    carry.clear();
+                }
+                cursor = newline + 1;
+            }
+        }
+        if (!stop && !carry.empty()) {
+            stop = !handleLine(carry);
+        }
+        if (batch && batch->count > 0) {
+            full.push(batch);
+        }
+        result.ok = !stop && lineNumber >= 3 && lineNumber - 3 >= result.declared;
+    } catch (const std::exception&) {
+        result.ok = false;
+    }
+    full.close();
+}
+
+struct CurrencyTotals {
+    size_t positions = 0;
+    Money marketValue;
+    Money costBasis;
+    Money losses;
+};
+
+struct Ranked {
+    double percentageReturn;
+    StreamedPosition position;
+};
+
+// Keeps the `limit` positions that rank first under `better`. The heap's
+// root is the weakest kept entry; replacing it reuses its strings.
+template <typename Better>
+class TopN {
+private:
+    std::vector<Ranked> heap;
+    size_t limit;
+    Better better;
+
+    static bool weaker(const Ranked& a, const Ranked& b) {
+        return Better()(a.percentageReturn, b.percentageReturn);
+    }
+
+public:
+    explicit TopN(size_t limit) : limit(limit) { heap.reserve(limit); }
+
+    void offer(double percentageReturn, const StreamedPosition& position) {
+        if (limit == 0) {
+            return;
+        }
+        if (heap.size() < limit) {
+            heap.push_back(Ranked{percentageReturn, position});
+            std::push_heap(heap.begin(), heap.end(), weaker);
+        } else if (better(percentageReturn, heap.front().percentageReturn)) {
+            std::pop_heap(heap.begin(), heap.end(), weaker);
+            heap.back().percentageReturn = percentageReturn;
+            heap.back().position = position;
+            std::push_heap(heap.begin(), heap.end(), weaker);
+        }
+    }
+
+    std::vector<StreamedPosition> take() {
+        std::sort_heap(heap.begin(), heap.end(), weaker);
+        std::vector<StreamedPosition> ordered;
+        ordered.reserve(heap.size());
+        for (Ranked& entry : heap) {
+            ordered.push_back(std::move(entry.position));
+        }
+        heap.clear();
+        return ordered;
+    }
+};
+
+// Portfolio::exportToCSV's columns; attributes are not known yet when a
+// position streams past, so their columns stay empty
+void writeCSVHeader(std::ostream& file) {
+    file << "Symbol,Company,Shares,Purchase Price,Current Price,Current Value,Gain/Loss,Return %,Currency,"
+            "Sector,Industry,Country\n";
+}
+
+void writeCSVRow(std::ostream& file, const StreamedPosition& position, Money value, Money gainLoss,
+                 double percentageReturn, const std::string& currencyCode) {
+    file << position.symbol << ","
+         << position.companyName << ","
+         << position.sharesOwned << ","
+         << position.purchasePrice << ","
+         << position.currentPrice << ","
+         << value << ","
+         << gainLoss << ","
+         << percentageReturn << ","
+         << currencyCode << ",,,\n";
+}
+
+bool openCSV(std::ofstream& file, const std::string& filename) {
+    if (filename.empty()) {
+        return true;
+    }
+    file.open(filename);
+    if (!file.is_open()) {
+        return false;
+    }
+    file << std::fixed << std::setprecision(2);
+    writeCSVHeader(file);
+    return true;
+}
+
+} // namespace
+
+bool StreamingAggregator::run(const std::string& filename, const StreamingOptions& options,
+                              StreamingSummary& summary) {
+    METRIC_TIME_SCOPE(StreamAggregate);
+    summary = StreamingSummary();
+    Clock::time_point start = Clock::now();
+
+    std::ifstream file(filename, std::ios::binary);
+    std::ofstream csv, losersCsv;
+    if (!file.is_open() || !openCSV(csv, options.csvFile) || !openCSV(losersCsv, options.losersFile)) {
+        return false;
+    }
+
+    StreamingOptions effective = options;
+    effective.batchPositions = std::max<size_t>(1, options.batchPositions);
+    std::vector<Batch> pool(std::max<size_t>(2, options.batchesInFlight));
+    BatchQueue empty, full;
+    for (Batch& batch : pool) {
+        empty.push(&batch);
+    }
+
+    ParseResult parsed;
+    std::thread reader(readPositions, std::ref(file), std::cref(effective), std::ref(empty), std::ref(full),
+                       std::ref(parsed));
+
+    std::vector<CurrencyTotals> totals;
+    std::vector<std::string> currencyCodes;
+    TopN<std::greater<double>> best(options.topCount);
+    TopN<std::less<double>> worst(options.topCount);
+    double sumReturns = 0.0;
+    size_t exported = 0;
+
+    // Sums are checked: a total that overflows stops the aggregation, and
+    // the error is rethrown once the reader has been drained and joined
+    std::exception_ptr overflow;
+    Batch* batch;
+    while (full.pop(batch)) {
+        for (size_t i = 0; i < batch->count && !overflow; ++i) {
+            const StreamedPosition& position = batch->positions[i];
+            try {
+                Money value = position.currentPrice.checkedMultiply(position.sharesOwned);
+                Money gainLoss = value.checkedSubtract(position.totalInvested);
+                double percentageReturn = Money::ratio(gainLoss, position.totalInvested) * 100.0;
+
+                if (position.currency >= totals.size()) {
+                    totals.resize(static_cast<size_t>(position.currency) + 1);
+                    while (currencyCodes.size() < totals.size()) {
+                        currencyCodes.push_back(Currency::codeOf(static_cast<CurrencyId>(currencyCodes.size())));
+                    }
+                }
+                CurrencyTotals& bucket = totals[position.currency];
+                bucket.positions += 1;
+                bucket.marketValue = bucket.marketValue.checkedAdd(value);
+                bucket.costBasis = bucket.costBasis.checkedAdd(position.totalInvested);
+                sumReturns += percentageReturn;
+
+                if (csv.is_open()) {
+                    writeCSVRow(csv, position, value, gainLoss, percentageReturn, currencyCodes[position.currency]);
+                    ++exported;
+                }
+                if (gainLoss.isNegative()) {
+                    bucket.losses = bucket.losses.checkedAdd(gainLoss);
+                    summary.losers += 1;
+                    if (losersCsv.is_open()) {
+                        writeCSVRow(losersCsv, position, value, gainLoss, percentageReturn,
+                                    currencyCodes[position.currency]);
+                    }
+                }
+                best.offer(percentageReturn, position);
+                worst.offer(percentageReturn, position);
+            } catch (const std::overflow_error&) {
+                overflow = std::current_exception();
+            }
+        }
+        batch->count = 0;
+        empty.push(batch);
+    }
+    reader.join();
+    if (overflow) {
+        std::rethrow_exception(overflow);
+    }
+
+    // Base-currency totals, now that the FX section has been read
+    const FxRateTable& fx = parsed.fxRates;
+    summary.portfolioName = parsed.portfolioName;
+    summary.totalInitialInvestment = parsed.totalInitialInvestment;
+    summary.baseCurrency = Currency::codeOf(fx.getBaseCurrency());
+    summary.positions = parsed.parsed;
+    summary.skipped = parsed.skipped;
+    for (size_t c = 0; c < totals.size(); ++c) {
+        if (totals[c].positions == 0) {
+            continue;
+        }
+        CurrencyId currency = static_cast<CurrencyId>(c);
+        CurrencyExposure exposure;
+        exposure.currencyCode = currencyCodes[c];
+        exposure.positions = totals[c].positions;
+        exposure.marketValue = totals[c].marketValue;
+        exposure.costBasis = totals[c].costBasis;
+        exposure.baseValue = fx.convert(totals[c].marketValue, currency);
+        exposure.fxRate = fx.getRate(currency);
+        summary.currentValue = summary.currentValue.checkedAdd(exposure.baseValue);
+        summary.losses = summary.losses.checkedAdd(fx.convert(totals[c].losses, currency));
+        summary.exposures.push_back(exposure);
+    }
+    summary.totalGainLoss = summary.currentValue.checkedSubtract(summary.totalInitialInvestment);
+    summary.percentageReturn = Money::ratio(summary.totalGainLoss, summary.totalInitialInvestment) * 100.0;
+    summary.averageReturn = summary.positions == 0 ? 0.0 : sumReturns / summary.positions;
+    summary.topPerformers = best.take();
+    summary.worstPerformers = worst.take();
+    summary.bytesRead = parsed.bytesRead;
+    summary.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    METRIC_ADD(PositionsLoaded, summary.positions);
+    METRIC_ADD(PositionsSkipped, summary.skipped);
+    METRIC_ADD(PositionsExported, exported);
+
+    bool written = true;
+    for (std::ofstream* output : {&csv, &losersCsv}) {
+        if (output->is_open()) {
+            output->close();
+            written = written && !output->fail();
+        }
+    }
+    return parsed.ok && written;
+}
+
+void StreamingAggregator::display(const StreamingSummary& summary) {
+    std::cout << "\n" << std::string(50, '=') << "\n";
+    std::cout << "STREAMED SUMMARY: " << summary.portfolioName << "\n";
+    std::cout << std::string(50, '=') << "\n";
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Total Investments: " << summary.positions;
+    if (summary.skipped > 0) {
+        std::cout << " (" << summary.skipped << " invalid lines skipped)";
+    }
+    std::cout << "\n";
+    std::cout << "Total Invested: $" << summary.totalInitialInvestment << "\n";
+    std::cout << "Current Value: $" << summary.currentValue << "\n";
+    std::cout << "Total Gain/Loss: $" << summary.totalGainLoss << "\n";
+    std::cout << "Portfolio Return: " << summary.percentageReturn << "%\n";
+    std::cout << "Average Return: " << summary.averageReturn << "%\n";
+    std::cout << "Losing Investments: " << summary.losers << " ($" << summary.losses << ")\n";
+
+    bool foreign = std::any_of(summary.exposures.begin(), summary.exposures.end(),
+        [&summary](const CurrencyExposure& e) { return e.currencyCode != summary.baseCurrency; });
+    if (foreign) {
+        std::cout << "Base Currency: " << summary.baseCurrency << "\n";
+        for (const auto& exposure : summary.exposures) {
+            std::cout << "  " << exposure.currencyCode << ": " << exposure.positions << " positions, "
+                      << exposure.marketValue << " " << exposure.currencyCode;
+            if (exposure.fxRate > 0.0) {
+                std::cout << " = " << exposure.baseValue << " " << summary.baseCurrency
+                          << " @ " << std::setprecision(6) << exposure.fxRate << std::setprecision(2);
+            } else {
+                std::cout << " (no FX rate, excluded from value)";
+            }
+            std::cout << "\n";
+        }
+    }
+
+    auto printRanked = [](const char* title, const std::vector<StreamedPosition>& positions) {
+        if (positions.empty()) {
+            return;
+        }
+        std::cout << "\n" << title << ":\n";
+        for (const StreamedPosition& position : positions) {
+            std::cout << "  " << position.symbol << " (" << position.companyName << "): "
+                      << position.getPercentageReturn() << "%\n";
+        }
+    };
+    printRanked("Top Performers", summary.topPerformers);
+    printRanked("Worst Performers", summary.worstPerformers);
+
+    std::cout << std::setprecision(1);
+    std::cout << "\nStreamed " << summary.bytesRead / 1048576.0 << " MiB in " << summary.seconds << " s\n";
+    std::cout << std::setprecision(2);
+}
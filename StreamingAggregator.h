@@ -0,0 +1,77 @@
+#ifndef STREAMING_AGGREGATOR_H
+#define STREAMING_AGGREGATOR_H
+
+#include "Currency.h"
+#include "Money.h"
+#include "Portfolio.h"
+#include <string>
+#include <vector>
+
+// One position as read from a save file, without the shared Stock an
+// Investment would allocate. Calculations match Investment's.
+struct StreamedPosition {
+    std::string symbol;
+    std::string companyName;
+    CurrencyId currency = Currency::kDefault;
+    Money currentPrice;
+    Money previousPrice;
+    int sharesOwned = 0;
+    Money purchasePrice;
+    Money totalInvested;
+
+    Money getCurrentValue() const { return currentPrice * sharesOwned; }
+    Money getGainLoss() const { return getCurrentValue() - totalInvested; }
+    double getPercentageReturn() const { return Money::ratio(getGainLoss(), totalInvested) * 100.0; }
+};
+
+struct StreamingOptions {
+    size_t topCount = 10;          // Best and worst performers kept
+    size_t chunkBytes = 4 << 20;   // File read size
+    size_t batchPositions = 8192;  // Parsed positions handed to the aggregator at a time
+    size_t batchesInFlight = 4;    // Bounds memory: at most this many batches exist
+    std::string csvFile;           // When set, every position is exported here
+    std::string losersFile;        // When set, losing positions are exported here
+};
+
+// Same figures as Portfolio::displaySummary/displayDetailedReport
+struct StreamingSummary {
+    std::string portfolioName;
+    Money totalInitialInvestment;  // From the file header, as Portfolio keeps it
+    std::string baseCurrency;
+    size_t positions = 0;
+    size_t skipped = 0;  // Position lines that did not parse
+    size_t losers = 0;
+    Money losses;  // Sum of losing positions' gain/loss, in the base currency
+    Money currentValue;
+    Money totalGainLoss;
+    double percentageReturn = 0.0;
+    double averageReturn = 0.0;
+    std::vector<CurrencyExposure> exposures;
+    std::vector<StreamedPosition> topPerformers;    // Best return first
+    std::vector<StreamedPosition> worstPerformers;  // Worst return first
+    std::uint64_t bytesRead = 0;
+    double seconds = 0.0;
+};
+
+// Single-pass, bounded-memory aggregation over a save file (the
+// Portfolio::saveToFile format) too large to load. A reader thread reads the
+// file in chunks and parses position lines into batches; the calling thread
+// aggregates each batch and writes the CSV outputs while the next one is
+// parsed. Batches are recycled through a fixed pool, so memory use depends on
+// the options, not on the file size.
+//
+// The FX section follows the positions in the file, so totals are kept per
+// currency and converted once at the end. Attributes come last too, so the
+// CSV export leaves the sector, industry and country columns empty.
+class StreamingAggregator {
+public:
+    // Returns false if the file cannot be read, its header is invalid or it
+    // ends before the declared number of positions, or an output cannot be
+    // written. Throws std::overflow_error if a position's value or a total
+    // does not fit in Money.
+    static bool run(const std::string& filename, const StreamingOptions& options, StreamingSummary& summary);
+
+    static void display(const StreamingSummary& summary);
+};
+
+#endif // STREAMING_AGGREGATOR_H
@@ -0,0 +1,486 @@
+#include "TaxLossHarvester.h"
+#include "Calendar.h"
+#include "Metrics.h"
+#include "ParallelFor.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+constexpr std::int64_t kNoPrice = -1;
+constexpr size_t kMinChunkLots = 4096;  // Smallest unit of parallel work
+constexpr size_t kChunksPerThread = 8;  // Spare chunks to even out uneven accounts
+
+std::uint64_t pairKey(AccountId account, LotSymbolId symbol) {
+    return (static_cast<std::uint64_t>(account) << 32) | symbol;
+}
+
+std::string trim(const std::string& text) {
+    size_t begin = 0;
+    size_t end = text.size();
+    while (begin < end && std::isspace(static_cast<unsigned char>(text[begin]))) {
+        ++begin;
+    }
+    while (end > begin && std::isspace(static_cast<unsigned char>(text[end - 1]))) {
+        --end;
+    }
+    return text.substr(begin, end - begin);
+}
+
+// Splits a CSV row into exactly `count` trimmed cells
+bool splitRow(const std::string& line, size_t count, std::vector<std::string>& cells) {
+    cells.clear();
+    std::stringstream ss(line);
+    std::string cell;
+    while (std::getline(ss, cell, ',')) {
+        cells.push_back(trim(cell));
+    }
+    return cells.size() == count;
+}
+
+bool parseShares(const std::string& text, std::int64_t& shares) {
+    if (text.empty()) {
+        return false;
+    }
+    char* end = nullptr;
+    shares = std::strtoll(text.c_str(), &end, 10);
+    return *end == '\0';
+}
+
+// Applies a permutation to one column
+template <typename T>
+void permute(std::vector<T>& column, const std::vector<size_t>& order) {
+    std::vector<T> sorted;
+    sorted.reserve(column.size());
+    for (size_t index : order) {
+        sorted.push_back(column[index]);
+    }
+    column.swap(sorted);
+}
+
+} // namespace
+
+// TaxLotLedger
+TaxLotLedger::TaxLotLedger() : lotsSorted(true), tradesSorted(true) {}
+
+AccountId TaxLotLedger::accountFor(const std::string& name) {
+    auto it = accountIds.find(name);
+    if (it != accountIds.end()) {
+        return it->second;
+    }
+    const AccountId id = static_cast<AccountId>(accountNames.size());
+    accountNames.push_back(name);
+    accountIds.emplace(name, id);
+    return id;
+}
+
+LotSymbolId TaxLotLedger::symbolFor(const std::string& symbol) {
+    auto it = symbolIds.find(symbol);
+    if (it != symbolIds.end()) {
+        return it->second;
+    }
+    const LotSymbolId id = static_cast<LotSymbolId>(symbolNames.size());
+    symbolNames.push_back(symbol);
+    symbolIds.emplace(symbol, id);
+    prices.push_back(kNoPrice);
+    return id;
+}
+
+void TaxLotLedger::addLot(const std::string& account, const std::string& symbol, int acquiredDay,
+                          std::int64_t shares, Money cost) {
+    if (shares <= 0) {
+        throw std::invalid_argument("Lot shares must be positive: " + account + " " + symbol);
+    }
+    if (cost.isNegative()) {
+        throw std::invalid_argument("Lot cost cannot be negative: " + account + " " + symbol);
+    }
+    const AccountId accountId = accountFor(account);
+    const LotSymbolId symbolId = symbolFor(symbol);
+    if (lotsSorted && !lotAccount.empty()) {
+        const size_t last = lotAccount.size() - 1;
+        lotsSorted = std::make_pair(pairKey(lotAccount[last], lotSymbol[last]), lotAcquired[last]) <=
+                     std::make_pair(pairKey(accountId, symbolId), acquiredDay);
+    }
+    lotAccount.push_back(accountId);
+    lotSymbol.push_back(symbolId);
+    lotAcquired.push_back(acquiredDay);
+    lotShares.push_back(shares);
+    lotCost.push_back(cost.raw());
+}
+
+void TaxLotLedger::recordTrade(const std::string& account, const std::string& symbol, int day,
+                               std::int64_t shares) {
+    const std::uint64_t key = pairKey(accountFor(account), symbolFor(symbol));
+    if (tradesSorted && !tradeKey.empty()) {
+        tradesSorted = std::make_pair(tradeKey.back(), tradeDay.back()) <= std::make_pair(key, day);
+    }
+    tradeKey.push_back(key);
+    tradeDay.push_back(day);
+    tradeShares.push_back(shares);
+}
+
+void TaxLotLedger::addPortfolio(const std::string& account, const Portfolio& portfolio, int acquiredDay) {
+    for (const Investment& investment : portfolio) {
+        const Stock* stock = investment.getStock().get();
+        if (!stock || investment.getSharesOwned() <= 0) {
+            continue;
+        }
+        addLot(account, stock->getSymbol(), acquiredDay, investment.getSharesOwned(), investment.getTotalInvested());
+        recordTrade(account, stock->getSymbol(), acquiredDay, investment.getSharesOwned());
+        setPrice(stock->getSymbol(), stock->getCurrentPrice());
+    }
+}
+
+void TaxLotLedger::clear() {
+    *this = TaxLotLedger();
+}
+
+void TaxLotLedger::setPrice(const std::string& symbol, Money price) {
+    prices[symbolFor(symbol)] = price.isNegative() ? kNoPrice : price.raw();
+}
+
+size_t TaxLotLedger::updatePrices(const Portfolio& portfolio) {
+    size_t priced = 0;
+    for (const Investment& investment : portfolio) {
+        const Stock* stock = investment.getStock().get();
+        if (!stock) {
+            continue;
+        }
+        auto it = symbolIds.find(stock->getSymbol());
+        if (it != symbolIds.end()) {
+            prices[it->second] = stock->getCurrentPrice().raw();
+            ++priced;
+        }
+    }
+    return priced;
+}
+
+std::int64_t TaxLotLedger::boughtBetween(std::uint64_t key, int from, int to, size_t& cursor) const {
+    const size_t count = tradeKey.size();
+    while (cursor < count && tradeKey[cursor] < key) {
+        ++cursor;
+    }
+    std::int64_t bought = 0;
+    for (size_t i = cursor; i < count && tradeKey[i] == key && tradeDay[i] <= to; ++i) {
+        if (tradeDay[i] >= from) {
+            bought += std::max<std::int64_t>(tradeShares[i], 0);
+        }
+    }
+    return bought;
+}
+
+std::int64_t TaxLotLedger::sharesBought(AccountId account, LotSymbolId symbol, int from, int to) {
+    prepare();
+    const std::uint64_t key = pairKey(account, symbol);
+    size_t cursor = static_cast<size_t>(std::lower_bound(tradeKey.begin(), tradeKey.end(), key) - tradeKey.begin());
+    return boughtBetween(key, from, to, cursor);
+}
+
+bool TaxLotLedger::loadLotsFromCSV(const std::string& filename) {
+    std::ifstream file(filename);
+    std::string line;
+    if (!file.is_open() || !std::getline(file, line)) {
+        return false;
+    }
+    std::vector<std::string> cells;
+    while (std::getline(file, line)) {
+        if (trim(line).empty()) {
+            continue;
+        }
+        int day = 0;
+        std::int64_t shares = 0;
+        Money cost;
+        if (!splitRow(line, 5, cells) || cells[0].empty() || cells[1].empty() ||
+            !calendar::parseDay(cells[2], day) || !parseShares(cells[3], shares) || shares <= 0 ||
+            !Money::tryParse(cells[4], cost) || cost.isNegative()) {
+            return false;
+        }
+        addLot(cells[0], cells[1], day, shares, cost);
+    }
+    return true;
+}
+
+bool TaxLotLedger::loadTradesFromCSV(const std::string& filename) {
+    std::ifstream file(filename);
+    std::string line;
+    if (!file.is_open() || !std::getline(file, line)) {
+        return false;
+    }
+    std::vector<std::string> cells;
+    while (std::getline(file, line)) {
+        if (trim(line).empty()) {
+            continue;
+        }
+        int day = 0;
+        std::int64_t shares = 0;
+        if (!splitRow(line, 4, cells) || cells[0].empty() || cells[1].empty() ||
+            !calendar::parseDay(cells[2], day) || !parseShares(cells[3], shares)) {
+            return false;
+        }
+        recordTrade(cells[0], cells[1], day, shares);
+    }
+    return true;
+}
+
+void TaxLotLedger::prepare() {
+    if (!lotsSorted) {
+        std::vector<size_t> order(lotShares.size());
+        std::iota(order.begin(), order.end(), size_t(0));
+        std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+            return std::make_pair(pairKey(lotAccount[a], lotSymbol[a]), lotAcquired[a]) <
+                   std::make_pair(pairKey(lotAccount[b], lotSymbol[b]), lotAcquired[b]);
+        });
+        permute(lotAccount, order);
+        permute(lotSymbol, order);
+        permute(lotAcquired, order);
+        permute(lotShares, order);
+        permute(lotCost, order);
+        lotsSorted = true;
+    }
+    if (!tradesSorted) {
+        std::vector<size_t> order(tradeShares.size());
+        std::iota(order.begin(), order.end(), size_t(0));
+        std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+            return std::make_pair(tradeKey[a], tradeDay[a]) < std::make_pair(tradeKey[b], tradeDay[b]);
+        });
+        permute(tradeKey, order);
+        permute(tradeDay, order);
+        permute(tradeShares, order);
+        tradesSorted = true;
+    }
+}
+
+// HarvestResults
+std::pair<size_t, size_t> HarvestResults::sellList(AccountId account) const {
+    if (account + 1 >= accountStart.size()) {
+        return std::make_pair(size_t(0), size_t(0));
+    }
+    return std::make_pair(accountStart[account], accountStart[account + 1]);
+}
+
+// TaxLossHarvester
+HarvestResults TaxLossHarvester::scan(TaxLotLedger& ledger, const HarvestOptions& options) {
+    METRIC_TIME_SCOPE(HarvestScan);
+    auto start = std::chrono::steady_clock::now();
+    ledger.prepare();
+
+    HarvestResults results;
+    results.scanDay = options.scanDay ? options.scanDay : calendar::today();
+    results.repurchaseDay = results.scanDay + options.washSaleDays + 1;
+    results.accounts = ledger.accountNames;
+    results.symbols = ledger.symbolNames;
+    results.lotsScanned = ledger.lotCount();
+
+    // Non-empty chunks of lots, each starting on an account boundary. Split
+    // points inside the last account run off the end and are dropped; an
+    // empty ledger has no chunks.
+    const size_t lots = ledger.lotCount();
+    const size_t threads = workerThreads(options.threads);
+    const size_t chunkCount =
+        std::max<size_t>(1, std::min(threads * kChunksPerThread, lots / kMinChunkLots));
+    std::vector<size_t> bounds;
+    for (size_t c = 0; c < chunkCount; ++c) {
+        size_t begin = lots * c / chunkCount;
+        while (begin > 0 && begin < lots && ledger.lotAccount[begin] == ledger.lotAccount[begin - 1]) {
+            ++begin;
+        }
+        if (begin < lots && (bounds.empty() || begin > bounds.back())) {
+            bounds.push_back(begin);
+        }
+    }
+    bounds.push_back(lots);
+    const size_t chunks = bounds.size() - 1;
+
+    const TaxLotLedger& book = ledger;
+    const int scanDay = results.scanDay;
+    const int washFrom = scanDay - options.washSaleDays;
+    const int washTo = scanDay + options.washSaleDays;
+    std::vector<std::vector<HarvestCandidate>> found(chunks);
+    std::vector<size_t> washed(chunks, 0);
+    std::vector<std::vector<std::pair<double, size_t>>> ranked(chunks);  // (-benefit, index in chunk), sorted
+
+    parallelFor(chunks, threads, [&](size_t chunk) {
+        const size_t begin = bounds[chunk];
+        const size_t end = bounds[chunk + 1];
+        const size_t count = end - begin;
+        const std::int64_t* shares = book.lotShares.data() + begin;
+        const std::int64_t* cost = book.lotCost.data() + begin;
+        const LotSymbolId* symbol = book.lotSymbol.data() + begin;
+        const std::int64_t* price = book.prices.data();
+
+        // Columnar pass: every lot's value and unrealized P&L
+        std::vector<std::int64_t> value(count);
+        std::vector<std::int64_t> pnl(count);
+        for (size_t i = 0; i < count; ++i) {
+            value[i] = price[symbol[i]] * shares[i];
+            pnl[i] = value[i] - cost[i];
+        }
+
+        std::vector<HarvestCandidate>& out = found[chunk];
+        std::vector<size_t> selling;
+        size_t cursor = static_cast<size_t>(
+            std::lower_bound(book.tradeKey.begin(), book.tradeKey.end(), pairKey(book.lotAccount[begin], 0)) -
+            book.tradeKey.begin());
+        for (size_t runBegin = 0; runBegin < count;) {
+            const AccountId account = book.lotAccount[begin + runBegin];
+            const LotSymbolId runSymbol = symbol[runBegin];
+            size_t runEnd = runBegin + 1;
+            while (runEnd < count && symbol[runEnd] == runSymbol && book.lotAccount[begin + runEnd] == account) {
+                ++runEnd;
+            }
+
+            // Losing lots past the thresholds, oldest first
+            selling.clear();
+            if (price[runSymbol] != kNoPrice) {
+                for (size_t i = runBegin; i < runEnd; ++i) {
+                    const std::int64_t loss = -pnl[i];
+                    if (loss > 0 && loss >= options.minLoss.raw() &&
+                        static_cast<double>(loss) >= options.minLossPercent / 100.0 * static_cast<double>(cost[i])) {
+                        selling.push_back(i);
+                    }
+                }
+            }
+            if (selling.empty()) {
+                runBegin = runEnd;
+                continue;
+            }
+
+            // Buys in the window replace sold shares, except the buys of
+            // the lots being sold themselves
+            const std::int64_t bought = book.boughtBetween(pairKey(account, runSymbol), washFrom, washTo, cursor);
+            std::int64_t ownBuys = 0;
+            for (size_t i : selling) {
+                const int acquired = book.lotAcquired[begin + i];
+                if (acquired >= washFrom && acquired <= scanDay) {
+                    ownBuys += shares[i];
+                }
+            }
+            std::int64_t replacement = std::max<std::int64_t>(0, bought - ownBuys);
+
+            for (size_t i : selling) {
+                // A lot the replacement shares would wash entirely is kept,
+                // and the shares go on to the next lot
+                const std::int64_t washShares = std::min(replacement, shares[i]);
+                if (washShares == shares[i]) {
+                    ++washed[chunk];
+                    continue;
+                }
+                replacement -= washShares;
+
+                HarvestCandidate candidate;
+                candidate.account = account;
+                candidate.symbol = runSymbol;
+                candidate.acquiredDay = book.lotAcquired[begin + i];
+                candidate.shares = shares[i];
+                candidate.cost = Money::fromUnits(cost[i]);
+                candidate.value = Money::fromUnits(value[i]);
+                candidate.loss = Money::fromUnits(-pnl[i]);
+                if (washShares > 0) {
+                    candidate.disallowedLoss = candidate.loss.mulDiv(washShares, shares[i]);
+                }
+                candidate.longTerm = scanDay - candidate.acquiredDay > options.longTermDays;
+                candidate.taxBenefit = (candidate.loss - candidate.disallowedLoss).toDouble() *
+                                       (candidate.longTerm ? options.longTermRate : options.shortTermRate);
+                out.push_back(candidate);
+            }
+            runBegin = runEnd;
+        }
+
+        // Each account's sell list best first (ties in lot order), then
+        // the chunk's own ranking, so only a merge is left for the caller
+        for (size_t listBegin = 0; listBegin < out.size();) {
+            size_t listEnd = listBegin + 1;
+            while (listEnd < out.size() && out[listEnd].account == out[listBegin].account) {
+                ++listEnd;
+            }
+            // stable_sort would allocate a buffer per account
+            std::sort(out.begin() + static_cast<std::ptrdiff_t>(listBegin),
+                      out.begin() + static_cast<std::ptrdiff_t>(listEnd),
+                      [](const HarvestCandidate& a, const HarvestCandidate& b) {
+                          if (a.taxBenefit != b.taxBenefit) {
+                              return a.taxBenefit > b.taxBenefit;
+                          }
+                          return a.symbol != b.symbol ? a.symbol < b.symbol : a.acquiredDay < b.acquiredDay;
+                      });
+            listBegin = listEnd;
+        }
+        std::vector<std::pair<double, size_t>>& keys = ranked[chunk];
+        keys.resize(out.size());
+        for (size_t i = 0; i < out.size(); ++i) {
+            keys[i] = std::make_pair(-out[i].taxBenefit, i);
+        }
+        std::sort(keys.begin(), keys.end());
+    });
+
+    // Chunks are in account order, so appending them keeps every account's
+    // sell list contiguous
+    std::vector<size_t> offset(chunks + 1, 0);
+    for (size_t c = 0; c < chunks; ++c) {
+        offset[c + 1] = offset[c] + found[c].size();
+        results.washSaleLots += washed[c];
+    }
+    results.candidates.reserve(offset[chunks]);
+    for (std::vector<HarvestCandidate>& part : found) {
+        results.candidates.insert(results.candidates.end(), part.begin(), part.end());
+        std::vector<HarvestCandidate>().swap(part);
+    }
+    results.accountStart.assign(results.accounts.size() + 1, 0);
+    for (const HarvestCandidate& candidate : results.candidates) {
+        ++results.accountStart[candidate.account + 1];
+        results.totalLoss += candidate.loss - candidate.disallowedLoss;
+        results.totalBenefit += candidate.taxBenefit;
+    }
+    std::partial_sum(results.accountStart.begin(), results.accountStart.end(), results.accountStart.begin());
+
+    // Merge the chunk rankings; ties go to the earlier chunk, and within a
+    // chunk to the earlier candidate
+    std::vector<size_t> head(chunks, 0);
+    auto later = [&](size_t a, size_t b) {
+        const std::pair<double, size_t>& left = ranked[a][head[a]];
+        const std::pair<double, size_t>& right = ranked[b][head[b]];
+        return left.first != right.first ? left.first > right.first : a > b;
+    };
+    std::vector<size_t> heap;
+    for (size_t c = 0; c < chunks; ++c) {
+        if (!ranked[c].empty()) {
+            heap.push_back(c);
+        }
+    }
+    std::make_heap(heap.begin(), heap.end(), later);
+    results.ranking.reserve(results.candidates.size());
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), later);
+        const size_t c = heap.back();
+        results.ranking.push_back(offset[c] + ranked[c][head[c]].second);
+        if (++head[c] < ranked[c].size()) {
+            std::push_heap(heap.begin(), heap.end(), later);
+        } else {
+            heap.pop_back();
+        }
+    }
+
+    results.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return results;
+}
+
+bool TaxLossHarvester::exportToCSV(const HarvestResults& results, const std::string& filename) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        return false;
+    }
+    file << "rank,account,symbol,acquired,term,shares,cost,value,loss,disallowed_loss,tax_benefit\n";
+    for (size_t i = 0; i < results.ranking.size(); ++i) {
+        const HarvestCandidate& c = results.candidates[results.ranking[i]];
+        file << (i + 1) << "," << results.accounts[c.account] << "," << results.symbols[c.symbol] << ","
+             << calendar::formatDay(c.acquiredDay) << "," << (c.longTerm ? "long" : "short") << "," << c.shares << ","
+             << c.cost << "," << c.value << "," << c.loss << "," << c.disallowedLoss << ","
+             << Money::fromDouble(c.taxBenefit) << "\n";
+    }
+    return file.good();
+}
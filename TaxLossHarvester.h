@@ -0,0 +1,157 @@
+#ifndef TAX_LOSS_HARVESTER_H
+#define TAX_LOSS_HARVESTER_H
+
+#include "Portfolio.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using AccountId = std::uint32_t;
+using LotSymbolId = std::uint32_t;
+
+// Open tax lots and trade history for any number of accounts, held as
+// columns. Lots are kept sorted by (account, symbol, acquisition day) and
+// trades by (account, symbol, day), so every (account, symbol) pair is one
+// contiguous run in each and a scan touches the lots in memory order.
+// Accounts and symbols are interned to dense ids; days count from
+// 1970-01-01 (see Calendar.h).
+class TaxLotLedger {
+private:
+    std::vector<std::string> accountNames;
+    std::unordered_map<std::string, AccountId> accountIds;
+    std::vector<std::string> symbolNames;
+    std::unordered_map<std::string, LotSymbolId> symbolIds;
+    std::vector<std::int64_t> prices;  // Money units per symbol; -1 = no price
+
+    // Lots
+    std::vector<AccountId> lotAccount;
+    std::vector<LotSymbolId> lotSymbol;
+    std::vector<int> lotAcquired;
+    std::vector<std::int64_t> lotShares;
+    std::vector<std::int64_t> lotCost;  // Money units for the whole lot
+
+    // Trades: shares > 0 bought, < 0 sold. tradeKey is (account << 32 | symbol).
+    std::vector<std::uint64_t> tradeKey;
+    std::vector<int> tradeDay;
+    std::vector<std::int64_t> tradeShares;
+
+    bool lotsSorted;
+    bool tradesSorted;
+
+    // Shares bought in one (account, symbol) run on days [from, to]. Trades
+    // must be sorted; cursor is a trade index at or before the run, and is
+    // left at its start, so visiting runs in key order is a merge join.
+    std::int64_t boughtBetween(std::uint64_t key, int from, int to, size_t& cursor) const;
+
+    friend class TaxLossHarvester;
+
+public:
+    TaxLotLedger();
+
+    AccountId accountFor(const std::string& name);
+    LotSymbolId symbolFor(const std::string& symbol);
+    const std::string& accountName(AccountId account) const { return accountNames[account]; }
+    const std::string& symbolName(LotSymbolId symbol) const { return symbolNames[symbol]; }
+    size_t accountCount() const { return accountNames.size(); }
+    size_t lotCount() const { return lotShares.size(); }
+    size_t tradeCount() const { return tradeShares.size(); }
+
+    // Throws std::invalid_argument for non-positive shares or a negative cost
+    void addLot(const std::string& account, const std::string& symbol, int acquiredDay, std::int64_t shares,
+                Money cost);
+    // The history is expected to include the buys that opened the lots: a
+    // lot's own buy never counts as a replacement for it
+    void recordTrade(const std::string& account, const std::string& symbol, int day, std::int64_t shares);
+    // Each position as a single lot acquired on acquiredDay (Portfolio keeps
+    // no lot dates), recorded as a buy on that day, and its current price
+    void addPortfolio(const std::string& account, const Portfolio& portfolio, int acquiredDay);
+    void clear();
+
+    void setPrice(const std::string& symbol, Money price);
+    // Current prices of every symbol the portfolio holds; returns how many
+    // of the ledger's symbols were priced
+    size_t updatePrices(const Portfolio& portfolio);
+
+    // Shares of a symbol the account bought on days [from, to]
+    std::int64_t sharesBought(AccountId account, LotSymbolId symbol, int from, int to);
+
+    // "account,symbol,acquired,shares,cost" (cost is the whole lot's) and
+    // "account,symbol,date,shares" (negative for sells), each with a header
+    // row and dates as YYYY-MM-DD. Rows are added to the current contents;
+    // false if the file cannot be read or a row does not parse (rows before
+    // it are kept).
+    bool loadLotsFromCSV(const std::string& filename);
+    bool loadTradesFromCSV(const std::string& filename);
+
+    // Sorts lots and trades if anything was added since the last call
+    void prepare();
+};
+
+struct HarvestOptions {
+    int scanDay = 0;                // Sale date; 0 = today
+    double shortTermRate = 0.37;    // Tax rate saved per unit of short-term loss
+    double longTermRate = 0.20;     // ... and of long-term loss
+    int longTermDays = 365;         // Held longer than this is long-term
+    int washSaleDays = 30;          // Buys this close to the sale replace the sold shares
+    Money minLoss;                  // Smallest loss worth harvesting, per lot
+    double minLossPercent = 0.0;    // ... and as a percent of the lot's cost
+    size_t threads = 0;             // 0 = one per hardware thread
+};
+
+// One lot worth selling. Losses are positive amounts.
+struct HarvestCandidate {
+    AccountId account = 0;
+    LotSymbolId symbol = 0;
+    int acquiredDay = 0;
+    std::int64_t shares = 0;
+    Money cost;
+    Money value;
+    Money loss;            // cost - value
+    Money disallowedLoss;  // Part of the loss a wash sale would defer
+    bool longTerm = false;
+    double taxBenefit = 0.0;  // (loss - disallowedLoss) * rate
+};
+
+struct HarvestResults {
+    std::vector<HarvestCandidate> candidates;  // By account, each account's best first
+    std::vector<size_t> ranking;               // Indexes into candidates, highest tax benefit first
+    std::vector<std::string> accounts;         // Names by AccountId
+    std::vector<std::string> symbols;          // Names by LotSymbolId
+    int scanDay = 0;
+    int repurchaseDay = 0;    // First day the sold symbols can be bought back without a wash sale
+    size_t lotsScanned = 0;
+    size_t washSaleLots = 0;  // Losing lots skipped because a wash sale disallows the whole loss
+    Money totalLoss;          // Allowed losses over all candidates
+    double totalBenefit = 0.0;
+    double seconds = 0.0;
+
+    // Sell list for one account: the [first, second) range of candidates
+    std::pair<size_t, size_t> sellList(AccountId account) const;
+
+private:
+    std::vector<size_t> accountStart;  // accountStart[a] .. accountStart[a + 1] in candidates
+    friend class TaxLossHarvester;
+};
+
+// Finds harvestable losses across every account in a ledger. Lots are split
+// into chunks on account boundaries and scanned in parallel: one columnar
+// pass prices every lot, then each (account, symbol) run with a losing lot
+// checks its trade history for buys within the wash-sale window around the
+// sale. Buys that are not themselves being sold replace sold shares one for
+// one, oldest losing lot first, and defer that part of the loss. Whatever is
+// left is valued at the short- or long-term rate by holding period, and the
+// lots are ranked by that tax benefit: each chunk sorts its own candidates,
+// and the chunk rankings are merged. Lots without a price are skipped.
+// Chunks never split an account, so a ledger dominated by one large account
+// is scanned mostly on one thread.
+class TaxLossHarvester {
+public:
+    static HarvestResults scan(TaxLotLedger& ledger, const HarvestOptions& options = HarvestOptions());
+
+    // One row per candidate in rank order
+    static bool exportToCSV(const HarvestResults& results, const std::string& filename);
+};
+
+#endif // TAX_LOSS_HARVESTER_H
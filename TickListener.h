@@ -0,0 +1,26 @@
+#ifndef TICK_LISTENER_H
+#define TICK_LISTENER_H
+
+#include "Investment.h"
+
+// Synchronous hook into Portfolio price updates, for consumers that must see
+// every individual tick (alerting, derived pricing) rather than the coalesced
+// stream delivered to event subscribers.
+class TickListener {
+public:
+    virtual ~TickListener() = default;
+
+    // Called on the mutation thread right after a tick has been applied
+    virtual void onTick(const Investment& investment, Money oldPrice) = 0;
+
+    // Called once at the end of each updateStockPrice/updateStockPrices call
+    // (and after each applySplit)
+    virtual void onBatchEnd() {}
+
+    // Called after a split or stock dividend has been posted; the stock's
+    // prices are already rescaled, so per-share levels kept by the listener
+    // should be scaled by denominator / numerator of the ratio
+    virtual void onSplit(const Investment&, SplitRatio) {}
+};
+
+#endif // TICK_LISTENER_H
@@ -0,0 +1,26 @@
+#ifndef VALUATION_EPOCH_H
+#define VALUATION_EPOCH_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// One Portfolio's valuation version, bumped by every mutation that can change
+// one of its positions' value (price, share count, currency). The Portfolio
+// keeps incrementally maintained totals and compares versions to detect edits
+// made directly through Stock/Investment pointers, falling back to a full
+// recompute in that case. Each held Investment points at its portfolio's
+// counter, and each Stock at the counters of every portfolio holding it, so
+// an edit only invalidates the portfolios it can affect.
+class ValuationEpoch {
+private:
+    std::atomic<std::uint64_t> counter{0};
+
+public:
+    std::uint64_t current() const { return counter.load(std::memory_order_relaxed); }
+    void bump() { counter.fetch_add(1, std::memory_order_relaxed); }
+};
+
+using ValuationEpochPtr = std::shared_ptr<ValuationEpoch>;
+
+#endif // VALUATION_EPOCH_H
@@ -0,0 +1,147 @@
+// Feed replay driver
+//
+// Replays a recorded tick file against a portfolio and reports sustained
+// throughput and the tick-to-valuation latency distribution. With
+// --generate=N a synthetic random-walk tick file is written first, so the
+// tool can be run without recorded data:
+//
+//   bench/feed_replay --positions=10000 --generate=1000000 --ticks=/tmp/ticks.csv
+//   bench/feed_replay --portfolio=my.pfc --ticks=recorded.csv --speed=10 --batch=64
+
+#include "../FeedReplay.h"
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+struct ToolOptions {
+    std::string portfolioFile;
+    std::string ticksFile = "/tmp/portfolio_ticks.csv";
+    size_t positions = 1000;    // Synthetic portfolio size when no --portfolio is given
+    size_t generate = 0;        // Ticks to generate into ticksFile before replaying
+    double generateRate = 1e6;  // Recorded ticks per second in generated files
+    ReplayOptions replay;
+};
+
+bool endsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Same approach as the benchmark fixture: write the save-file format and bulk
+// load it.
+bool buildSyntheticPortfolio(Portfolio& portfolio, size_t positions) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> price(5.0, 500.0);
+    std::uniform_int_distribution<int> shares(1, 1000);
+    const std::string path = "/tmp/feed_replay_portfolio.txt";
+    {
+        std::ofstream file(path);
+        file << std::setprecision(10) << "Replay Portfolio\n0\n" << positions << "\n";
+        for (size_t i = 0; i < positions; ++i) {
+            double p = price(rng);
+            int owned = shares(rng);
+            file << "SYM" << i << ",Synthetic Company " << i << "," << p << "," << p << ","
+                 << owned << "," << p << "," << owned * p << "\n";
+        }
+    }
+    bool loaded = portfolio.loadFromFile(path);
+    std::remove(path.c_str());
+    return loaded;
+}
+
+bool parseArgs(int argc, char** argv, ToolOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&arg](const std::string& prefix) { return arg.substr(prefix.size()); };
+
+        if (arg.rfind("--portfolio=", 0) == 0) {
+            options.portfolioFile = value("--portfolio=");
+        } else if (arg.rfind("--ticks=", 0) == 0) {
+            options.ticksFile = value("--ticks=");
+        } else if (arg.rfind("--positions=", 0) == 0) {
+            options.positions = std::stoul(value("--positions="));
+        } else if (arg.rfind("--generate=", 0) == 0) {
+            options.generate = std::stoul(value("--generate="));
+        } else if (arg.rfind("--rate=", 0) == 0) {
+            options.generateRate = std::stod(value("--rate="));
+        } else if (arg.rfind("--speed=", 0) == 0) {
+            options.replay.speed = std::stod(value("--speed="));
+        } else if (arg.rfind("--batch=", 0) == 0) {
+            options.replay.batchSize = std::stoul(value("--batch="));
+        } else if (arg.rfind("--max-ticks=", 0) == 0) {
+            options.replay.maxTicks = std::stoul(value("--max-ticks="));
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--portfolio=FILE|--positions=N] [--ticks=FILE] [--generate=N] [--rate=TICKS_PER_SEC]"
+                      << " [--speed=X] [--batch=N] [--max-ticks=N]\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+void printReport(const ReplayReport& report) {
+    const HistogramSnapshot& latency = report.latency;
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "Ticks:        " << report.ticks << " (" << report.applied << " applied, " << report.rejected
+              << " rejected, " << report.malformed << " malformed lines)\n";
+    std::cout << "Batches:      " << report.batches << "\n";
+    std::cout << "Wall time:    " << report.wallSeconds << " s (feed covered " << report.feedSeconds << " s)\n";
+    std::cout << std::setprecision(0);
+    std::cout << "Throughput:   " << report.ticksPerSecond << " ticks/s\n";
+    std::cout << std::setprecision(2);
+    std::cout << "Latency (us): mean " << latency.meanNs() / 1e3 << "  p50 " << latency.percentileNs(0.5) / 1e3
+              << "  p90 " << latency.percentileNs(0.9) / 1e3 << "  p99 " << latency.percentileNs(0.99) / 1e3
+              << "  p99.9 " << latency.percentileNs(0.999) / 1e3 << "  max " << latency.maxNs / 1e3 << "\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    ToolOptions options;
+    try {
+        if (!parseArgs(argc, argv, options)) {
+            return 2;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Invalid argument: " << e.what() << "\n";
+        return 2;
+    }
+
+    Portfolio portfolio;
+    bool loaded;
+    if (options.portfolioFile.empty()) {
+        loaded = buildSyntheticPortfolio(portfolio, options.positions);
+    } else if (endsWith(options.portfolioFile, ".pfc")) {
+        loaded = portfolio.loadFromColumnar(options.portfolioFile);
+    } else {
+        loaded = portfolio.loadFromFile(options.portfolioFile);
+    }
+    if (!loaded) {
+        std::cerr << "Failed to load portfolio\n";
+        return 1;
+    }
+
+    if (options.generate > 0) {
+        if (!FeedReplay::writeSyntheticFile(portfolio, options.ticksFile, options.generate, options.generateRate)) {
+            std::cerr << "Failed to write " << options.ticksFile << "\n";
+            return 1;
+        }
+        std::cout << "Wrote " << options.generate << " ticks to " << options.ticksFile << "\n";
+    }
+
+    ReplayReport report;
+    if (!FeedReplay::run(portfolio, options.ticksFile, options.replay, report)) {
+        std::cerr << "Failed to open " << options.ticksFile << "\n";
+        return 1;
+    }
+    std::cout << "Replayed " << options.ticksFile << " against " << portfolio.getInvestmentCount()
+              << " positions\n";
+    printReport(report);
+    return 0;
+}
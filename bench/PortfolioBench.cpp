@@ -0,0 +1,921 @@
+// Portfolio benchmark suite
+//
+// A small Google-Benchmark-style harness: each benchmark is a function taking a
+// BenchState and looping `for (auto _ : state)`. The runner makes one untimed
+// warm-up call (so lazy one-off work such as index rebuilds is not reported as
+// per-op cost), then grows the iteration count until the timed region exceeds
+// --min-time over at least kMinIterations, and reports ns/op, allocations/op
+// and bytes/op. Results are written as JSON for
+// bench/compare_bench.py.
+
+#include "../Portfolio.h"
+#include "../AlertEngine.h"
+#include "../BenchmarkAnalytics.h"
+#include "../OptionBook.h"
+#include "../PositionBook.h"
+#include "../SharedPriceTable.h"
+#include "../Calendar.h"
+#include "../CorporateActions.h"
+#include "../TaxLossHarvester.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// Allocation accounting
+// ---------------------------------------------------------------------------
+
+namespace {
+std::atomic<unsigned long long> g_allocCount{0};
+std::atomic<unsigned long long> g_allocBytes{0};
+}
+
+void* operator new(std::size_t size) {
+    g_allocCount.fetch_add(1, std::memory_order_relaxed);
+    g_allocBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    g_allocCount.fetch_add(1, std::memory_order_relaxed);
+    g_allocBytes.fetch_add(size, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+    return ::operator new(size, tag);
+}
+
+// Kept out of line: GCC otherwise pairs the inlined free() with the library's
+// operator new at call sites and emits -Wmismatched-new-delete.
+#if defined(__GNUC__)
+#define BENCH_NOINLINE __attribute__((noinline))
+#else
+#define BENCH_NOINLINE
+#endif
+
+BENCH_NOINLINE void operator delete(void* p) noexcept { std::free(p); }
+BENCH_NOINLINE void operator delete[](void* p) noexcept { std::free(p); }
+BENCH_NOINLINE void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+BENCH_NOINLINE void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+BENCH_NOINLINE void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+BENCH_NOINLINE void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+namespace {
+
+template <typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// Benchmark state and runner
+// ---------------------------------------------------------------------------
+
+using Clock = std::chrono::steady_clock;
+
+class BenchState {
+private:
+    size_t positions;
+    unsigned long long maxIterations;
+    unsigned long long remaining;
+    Clock::time_point started;
+    Clock::duration elapsed;
+    unsigned long long allocCountAtStart;
+    unsigned long long allocBytesAtStart;
+    unsigned long long allocCount;
+    unsigned long long allocBytes;
+    bool paused;
+
+    void startTimer() {
+        allocCountAtStart = g_allocCount.load(std::memory_order_relaxed);
+        allocBytesAtStart = g_allocBytes.load(std::memory_order_relaxed);
+        started = Clock::now();
+    }
+
+    void stopTimer() {
+        elapsed += Clock::now() - started;
+        allocCount += g_allocCount.load(std::memory_order_relaxed) - allocCountAtStart;
+        allocBytes += g_allocBytes.load(std::memory_order_relaxed) - allocBytesAtStart;
+    }
+
+public:
+    BenchState(size_t positions, unsigned long long iterations)
+        : positions(positions), maxIterations(iterations), remaining(iterations),
+          elapsed(Clock::duration::zero()), allocCountAtStart(0), allocBytesAtStart(0),
+          allocCount(0), allocBytes(0), paused(false) {}
+
+    size_t size() const { return positions; }
+    unsigned long long iterations() const { return maxIterations; }
+    unsigned long long iteration() const { return maxIterations - remaining; }
+    double elapsedNs() const {
+        return std::chrono::duration<double, std::nano>(elapsed).count();
+    }
+    unsigned long long allocations() const { return allocCount; }
+    unsigned long long allocatedBytes() const { return allocBytes; }
+
+    // Exclude setup/teardown inside the loop body from the measurement.
+    void pauseTiming() {
+        if (!paused) {
+            stopTimer();
+            paused = true;
+        }
+    }
+
+    void resumeTiming() {
+        if (paused) {
+            startTimer();
+            paused = false;
+        }
+    }
+
+    bool keepRunning() {
+        if (remaining == maxIterations) {
+            startTimer();
+        }
+        if (remaining == 0) {
+            if (!paused) {
+                stopTimer();
+            }
+            return false;
+        }
+        --remaining;
+        return true;
+    }
+
+    // Range-for support: `for (auto _ : state) { ... }`
+    // Value has a non-trivial destructor so the unused loop variable does not
+    // trigger -Wunused-variable.
+    struct Value {
+        ~Value() {}
+    };
+
+    struct Iterator {
+        BenchState* state;
+        bool running;
+        bool operator!=(const Iterator&) const { return running; }
+        void operator++() { running = state->keepRunning(); }
+        Value operator*() const { return Value(); }
+    };
+
+    Iterator begin() { return Iterator{this, keepRunning()}; }
+    Iterator end() { return Iterator{this, false}; }
+};
+
+struct BenchResult {
+    std::string name;
+    size_t positions;
+    unsigned long long iterations;
+    double nsPerOp;
+    double allocsPerOp;
+    double bytesPerOp;
+};
+
+struct BenchOptions {
+    size_t minSize = 10;
+    size_t maxSize = 10000000;
+    double minTimeSeconds = 0.5;
+    std::string filter;
+    std::string outFile;
+    std::string tmpDir = "/tmp";
+};
+
+using BenchFunction = std::function<void(BenchState&)>;
+
+struct BenchDefinition {
+    std::string name;
+    BenchFunction function;
+};
+
+constexpr unsigned long long kMinIterations = 10;
+
+BenchResult runBenchmark(const BenchDefinition& def, size_t positions, double minTimeSeconds) {
+    const double minTimeNs = minTimeSeconds * 1e9;
+    {
+        BenchState warmUp(positions, 1);
+        def.function(warmUp);
+    }
+    unsigned long long iterations = 1;
+
+    while (true) {
+        BenchState state(positions, iterations);
+        def.function(state);
+
+        const double elapsedNs = state.elapsedNs();
+        if ((elapsedNs >= minTimeNs && iterations >= kMinIterations) || iterations >= 1000000000ULL) {
+            BenchResult result;
+            result.name = def.name + "/" + std::to_string(positions);
+            result.positions = positions;
+            result.iterations = iterations;
+            result.nsPerOp = elapsedNs / iterations;
+            result.allocsPerOp = static_cast<double>(state.allocations()) / iterations;
+            result.bytesPerOp = static_cast<double>(state.allocatedBytes()) / iterations;
+            return result;
+        }
+
+        // Predict the count needed to reach the minimum time, growing by at
+        // most 10x per trial like Google Benchmark does.
+        double multiplier = elapsedNs > 0.0 ? (minTimeNs * 1.4) / elapsedNs : 10.0;
+        multiplier = std::min(10.0, std::max(2.0, multiplier));
+        iterations = std::max(kMinIterations, static_cast<unsigned long long>(iterations * multiplier));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Synthetic portfolios
+// ---------------------------------------------------------------------------
+
+std::string symbolFor(size_t index) {
+    std::ostringstream ss;
+    ss << "S" << std::setw(8) << std::setfill('0') << index;
+    return ss.str();
+}
+
+std::string g_tmpDir = "/tmp";
+
+std::string tmpPath(const std::string& name) {
+    return g_tmpDir + "/portfolio_bench_" + name;
+}
+
+class Fixture {
+private:
+    size_t positions;
+    Portfolio portfolio;
+    std::vector<std::string> lookupSymbols;
+    // Attached to portfolio, so declared after it: destroyed (and detached) first
+    std::unique_ptr<OptionBook> optionBook;
+
+public:
+    explicit Fixture(size_t positions) : positions(positions), portfolio("Benchmark Portfolio") {
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<double> price(5.0, 500.0);
+        std::uniform_real_distribution<double> drift(0.7, 1.3);
+        std::uniform_int_distribution<int> shares(1, 1000);
+
+        // Large portfolios are generated in the save-file format and bulk
+        // loaded, which is much faster than one addInvestment() per position.
+        std::ostringstream body;
+        body << std::setprecision(10);
+        double totalInvested = 0.0;
+        for (size_t i = 0; i < positions; ++i) {
+            double purchasePrice = price(rng);
+            double currentPrice = purchasePrice * drift(rng);
+            int owned = shares(rng);
+            totalInvested += owned * purchasePrice;
+            body << symbolFor(i) << ",Synthetic Company " << i << ","
+                 << currentPrice << "," << currentPrice << ","
+                 << owned << "," << purchasePrice << "," << owned * purchasePrice << "\n";
+        }
+
+        const std::string path = tmpPath("fixture.txt");
+        {
+            std::ofstream file(path);
+            file << std::setprecision(10);
+            file << "Benchmark Portfolio\n" << totalInvested << "\n" << positions << "\n";
+            file << body.str();
+        }
+        if (!portfolio.loadFromFile(path) || portfolio.getInvestmentCount() != positions) {
+            throw std::runtime_error("Failed to build benchmark fixture");
+        }
+        std::remove(path.c_str());
+
+        std::uniform_int_distribution<size_t> pick(0, positions - 1);
+        lookupSymbols.reserve(4096);
+        for (size_t i = 0; i < 4096; ++i) {
+            lookupSymbols.push_back(symbolFor(pick(rng)));
+        }
+    }
+
+    size_t size() const { return positions; }
+    Portfolio& get() { return portfolio; }
+    std::unique_ptr<OptionBook>& options() { return optionBook; }
+    const std::string& lookupSymbol(unsigned long long i) const {
+        return lookupSymbols[i % lookupSymbols.size()];
+    }
+};
+
+// Only one fixture is alive at a time so the 10M case fits in memory.
+std::unique_ptr<Fixture> g_fixture;
+
+Fixture& fixture(size_t positions) {
+    if (!g_fixture || g_fixture->size() != positions) {
+        g_fixture.reset();
+        g_fixture.reset(new Fixture(positions));
+    }
+    return *g_fixture;
+}
+
+// ---------------------------------------------------------------------------
+// Benchmarks
+// ---------------------------------------------------------------------------
+
+void BM_FindInvestment(BenchState& state) {
+    Fixture& f = fixture(state.size());
+    const Portfolio& portfolio = f.get();
+    for (auto _ : state) {
+        const Investment* inv = portfolio.getInvestment(f.lookupSymbol(state.iteration()));
+        doNotOptimize(inv);
+    }
+}
+
+void BM_AddInvestmentMerge(BenchState& state) {
+    Fixture& f = fixture(state.size());
+    auto stock = static_cast<const Portfolio&>(f.get()).getInvestment(f.lookupSymbol(0))->getStock();
+    Investment lot(stock, 1, 100.0);
+    for (auto _ : state) {
+        bool added = f.get().addInvestment(lot);
+        doNotOptimize(added);
+    }
+}
+
+void BM_AddInvestmentNew(BenchState& state) {
+    Fixture& f = fixture(state.size());
+    Investment lot(std::make_shared<Stock>("NEWPOS", "New Position Inc.", 10.0), 10, 9.5);
+    for (auto _ : state) {
+        bool added = f.get().addInvestment(lot);
+        doNotOptimize(added);
+        state.pauseTiming();
+        f.get().removeInvestment("NEWPOS");
+        state.resumeTiming();
+    }
+}
+
+void BM_UpdateStockPrice(BenchState& state) {
+    Fixture& f = fixture(state.size());
+    for (auto _ : state) {
+        bool updated = f.get().updateStockPrice(f.lookupSymbol(state.iteration()),
+                                                50.0 + static_cast<double>(state.iteration() % 100));
+        doNotOptimize(updated);
+    }
+}
+
+void BM_GetCurrentValue(BenchState& state) {
+    Fixture& f = fixture(state.size());
+    for (auto _ : state) {
+        auto value = f.get().getCurrentValue();
+        doNotOptimize(value);
+    }
+}
+
+void BM_SortInvestmentsByValue(BenchState& state) {
+    Fixture& f = fixture(state.size());
+    for (auto _ : state) {
+        // Alternate direction so every iteration does real work.
+        f.get().sortInvestmentsByValue(state.iteration() % 2 == 0);
+    }
+}
+
+void BM_GetTopPerformers(BenchState& state) {
+    Fixture& f = fixture(state.size());
+    for (auto _ : state) {
+        auto top = f.get().getTopPerformers(10);
+        doNotOptimize(top);
+    }
+}
+
+void BM_SaveToFile(BenchState& state) {
+    Fixture& f = fixture(state.size());
+    const std::string path = tmpPath("save.txt");
+    for (auto _ : state) {
+        bool saved = f.get().saveToFile(path);
+        doNotOptimize(saved);
+    }
+    std::remove(path.c_str());
+}
+
+void BM_LoadFromFile(BenchState& state) {
+    Fixture& f = fixture(state.size());
+    const std::string path = tmpPath("load.txt");
+    f.get().saveToFile(path);
+    Portfolio loaded;
+    for (auto _ : state) {
+        bool ok = loaded.loadFromFile(path);
+        doNotOptimize(ok);
+    }
+    std::remove(path.c_str());
+}
+
+void BM_ExportToCSV(BenchState& state) {
+    Fixture& f = fixture(state.size());
+    const std::string path = tmpPath("export.csv");
+    for (auto _ : state) {
+        bool exported = f.get().exportToCSV(path);
+        doNotOptimize(exported);
+    }
+    std::remove(path.c_str());
+}
+
+// 1M price/return rules spread over the fixture's symbols; each tick moves one
+// price by up to +/-0.5%, so only rules in that band should be touched.
+void BM_AlertEngineTick(BenchState& state) {
+    constexpr size_t kRules = 1000000;
+    static std::unique_ptr<AlertEngine> engine;
+    static size_t engineSize = 0;
+    Fixture& f = fixture(state.size());
+    if (!engine || engineSize != f.size()) {
+        engine.reset(new AlertEngine());
+        engineSize = f.size();
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<double> level(5.0, 500.0);
+        std::uniform_real_distribution<double> percent(-50.0, 50.0);
+        for (size_t i = 0; i < kRules; ++i) {
+            const std::string symbol = symbolFor(i % f.size());
+            switch (i % 4) {
+                case 0: engine->addStopLoss(symbol, Money::fromDouble(level(rng))); break;
+                case 1: engine->addTakeProfit(symbol, Money::fromDouble(level(rng))); break;
+                case 2: engine->addReturnAbove(symbol, percent(rng)); break;
+                default: engine->addReturnBelow(symbol, percent(rng)); break;
+            }
+        }
+        engine->prepare();
+    }
+
+    for (auto _ : state) {
+        const Investment* inv = &f.get()[(state.iteration() * 7919) % f.size()];
+        Money oldPrice = inv->getStock()->getCurrentPrice();
+        Money newPrice = oldPrice.mulDiv(995 + static_cast<std::int64_t>(state.iteration() % 11), 1000);
+        size_t fired = engine->evaluate(inv->getStock()->getSymbol(), oldPrice, newPrice,
+                                        inv->getSharesOwned(), inv->getTotalInvested());
+        doNotOptimize(fired);
+        if (engine->getPendingCount() > 4096) {
+            engine->takeAlerts();
+        }
+    }
+}
+
+// The fixture snapshotted into a policy-specialised book; rebuilt when the
+// fixture size changes.
+template <typename Book>
+Book& bookFor(Fixture& f) {
+    static Book book;
+    static size_t bookSize = 0;
+    if (bookSize != f.size()) {
+        book.assign(f.get());
+        bookSize = f.size();
+    }
+    return book;
+}
+
+template <typename Book>
+void BM_BookTotalValue(BenchState& state) {
+    Book& book = bookFor<Book>(fixture(state.size()));
+    for (auto _ : state) {
+        auto value = book.totalValue();
+        doNotOptimize(value);
+    }
+}
+
+template <typename Book>
+void BM_BookUpdatePrice(BenchState& state) {
+    Fixture& f = fixture(state.size());
+    Book& book = bookFor<Book>(f);
+    for (auto _ : state) {
+        bool updated = book.updatePrice(f.lookupSymbol(state.iteration()),
+                                        book.price(0));
+        doNotOptimize(updated);
+    }
+}
+
+// Seqlock reads of the fixture's prices from a shared table, as a reader
+// process does them; the writer lives in this process for the benchmark.
+void BM_SharedPriceRead(BenchState& state) {
+    static SharedPriceWriter writer;
+    static SharedPriceReader reader;
+    static std::vector<std::uint32_t> handles;
+    static size_t tableSize = 0;
+    Fixture& f = fixture(state.size());
+    if (tableSize != f.size()) {
+        const std::string name = "portfolio_bench_prices";
+        SharedPriceWriter::remove(name);
+        if (!writer.create(name) || !reader.open(name)) {
+            throw std::runtime_error("Shared memory is not available");
+        }
+        SharedPriceWriter::remove(name);  // The mappings stay valid
+        // Only the looked-up symbols are published, so the segment stays
+        // small at the 10M size
+        const Portfolio& portfolio = f.get();
+        handles.clear();
+        for (size_t i = 0; i < 4096; ++i) {
+            const std::string& symbol = f.lookupSymbol(i);
+            writer.publish(symbol, portfolio.getInvestment(symbol)->getStock()->getCurrentPrice());
+            handles.push_back(reader.find(symbol));
+        }
+        tableSize = f.size();
+    }
+    SharedPrice price;
+    for (auto _ : state) {
+        bool found = reader.read(handles[state.iteration() % handles.size()], price);
+        doNotOptimize(found);
+    }
+}
+
+// 100k options of one exercise style, 100 per underlying on the fixture's
+// first symbols, attached to the fixture portfolio. Owned by the fixture, so
+// it is detached before the portfolio goes away; asking for the other style
+// replaces it, so only one book follows the ticks.
+OptionBook& optionBookFor(Fixture& f, ExerciseStyle style = ExerciseStyle::European) {
+    constexpr size_t kOptions = 100000;
+    constexpr size_t kPerUnderlying = 100;
+    std::unique_ptr<OptionBook>& book = f.options();
+    if (!book || book->getContract(0).style != style) {
+        book.reset(new OptionBook());
+        book->setRate(0.04);
+        std::mt19937 rng(11);
+        std::uniform_real_distribution<double> moneyness(0.7, 1.3);
+        std::uniform_real_distribution<double> volatility(0.1, 0.6);
+        std::uniform_real_distribution<double> dividendYield(0.0, 0.04);
+        const Portfolio& portfolio = f.get();
+        for (size_t i = 0; i < kOptions; ++i) {
+            const Investment& underlying = portfolio[(i / kPerUnderlying) % f.size()];
+            OptionContract contract;
+            contract.underlying = underlying.getStock()->getSymbol();
+            contract.symbol = contract.underlying + "_O" + std::to_string(i);
+            contract.type = i % 2 ? OptionType::Put : OptionType::Call;
+            contract.style = style;
+            contract.strike =
+                Money::fromDouble(underlying.getStock()->getCurrentPrice().toDouble() * moneyness(rng));
+            contract.expiryDay = book->getValuationDay() + 7 + static_cast<int>(i % 104) * 7;
+            book->addPosition(contract, 1.0, Money::fromWhole(1), volatility(rng));
+            if (i % kPerUnderlying == 0) {
+                // Dividends, so American calls have an early-exercise premium too
+                book->setDividendYield(contract.underlying, dividendYield(rng));
+            }
+        }
+        book->attach(f.get());
+    }
+    return *book;
+}
+
+// One underlying ticks; its 100 options are repriced through onBatchEnd
+void BM_OptionTick(BenchState& state) {
+    Fixture& f = fixture(state.size());
+    optionBookFor(f);
+    Portfolio& portfolio = f.get();
+    const Portfolio& positions = portfolio;  // Non-const access would rebuild the symbol index
+    const size_t underlyings = std::min<size_t>(f.size(), 1000);
+    std::vector<PriceUpdate> update(1);
+    for (auto _ : state) {
+        const Investment& inv = positions[state.iteration() % underlyings];
+        update[0].symbol = inv.getStock()->getSymbol();
+        update[0].price = inv.getStock()->getCurrentPrice();
+        size_t applied = portfolio.updateStockPrices(update);
+        doNotOptimize(applied);
+    }
+}
+
+// As BM_OptionTick, with every option American
+void BM_OptionTickAmerican(BenchState& state) {
+    Fixture& f = fixture(state.size());
+    optionBookFor(f, ExerciseStyle::American);
+    Portfolio& portfolio = f.get();
+    const Portfolio& positions = portfolio;
+    const size_t underlyings = std::min<size_t>(f.size(), 1000);
+    std::vector<PriceUpdate> update(1);
+    for (auto _ : state) {
+        const Investment& inv = positions[state.iteration() % underlyings];
+        update[0].symbol = inv.getStock()->getSymbol();
+        update[0].price = inv.getStock()->getCurrentPrice();
+        size_t applied = portfolio.updateStockPrices(update);
+        doNotOptimize(applied);
+    }
+}
+
+// Every underlying moves: the whole 100k-option book is repriced
+void BM_OptionRepriceAll(BenchState& state) {
+    Fixture& f = fixture(state.size());
+    OptionBook& book = optionBookFor(f);
+    const Portfolio& portfolio = f.get();
+    const size_t underlyings = std::min<size_t>(f.size(), 1000);
+    for (auto _ : state) {
+        for (size_t i = 0; i < underlyings; ++i) {
+            book.setSpot(portfolio[i].getStock()->getSymbol(), portfolio[i].getStock()->getCurrentPrice());
+        }
+        size_t rows = book.reprice();
+        doNotOptimize(rows);
+    }
+}
+
+using DoubleSoaBook = BasicPositionBook<PositionTraits<Int32Quantity, DoublePrice, AverageCost>, SoaStorage>;
+
+TaxLotLedger& ledgerFor(Fixture& f) {
+    constexpr size_t kMaxAccounts = 100000;
+    constexpr size_t kLotsPerAccount = 20;
+    static std::unique_ptr<TaxLotLedger> ledger;
+    static size_t ledgerSize = 0;
+    if (!ledger || ledgerSize != f.size()) {
+        ledger.reset(new TaxLotLedger());
+        ledgerSize = f.size();
+        std::mt19937 rng(13);
+        std::uniform_int_distribution<int> age(1, 1500);
+        std::uniform_real_distribution<double> move(0.6, 1.4);
+        const Portfolio& portfolio = f.get();
+        const int today = calendar::today();
+        const size_t accounts = std::min(f.size(), kMaxAccounts);
+        for (size_t a = 0; a < accounts; ++a) {
+            const std::string account = "ACC" + std::to_string(a);
+            for (size_t l = 0; l < kLotsPerAccount; ++l) {
+                const Stock& stock = *portfolio[rng() % f.size()].getStock();
+                const int acquired = today - age(rng);
+                ledger->addLot(account, stock.getSymbol(), acquired, 100,
+                               Money::fromDouble(100 * stock.getCurrentPrice().toDouble() * move(rng)));
+                ledger->recordTrade(account, stock.getSymbol(), acquired, 100);
+            }
+        }
+        ledger->updatePrices(portfolio);
+        ledger->prepare();
+    }
+    return *ledger;
+}
+
+void BM_HarvestScan(BenchState& state) {
+    TaxLotLedger& ledger = ledgerFor(fixture(state.size()));
+    for (auto _ : state) {
+        HarvestResults results = TaxLossHarvester::scan(ledger);
+        doNotOptimize(results.totalBenefit);
+    }
+}
+
+// A price series `size` points long over ten years, with a split or
+// dividend every quarter
+void BM_AdjustPriceHistory(BenchState& state) {
+    constexpr int kSpanDays = 3650;
+    const size_t points = state.size();
+    const int first = calendar::today() - kSpanDays;
+    std::vector<int> days(points);
+    for (size_t i = 0; i < points; ++i) {
+        days[i] = first + static_cast<int>(i * kSpanDays / points);
+    }
+    CorporateActions actions;
+    for (int quarter = 0; quarter < kSpanDays / 91; ++quarter) {
+        if (quarter % 8 == 7) {
+            actions.addSplit("SERIES", first + quarter * 91, 2, 1);
+        } else {
+            actions.addCashDividend("SERIES", first + quarter * 91, Money::fromDouble(0.5), Money::fromWhole(100));
+        }
+    }
+    // Adjusted as read: the stored series is copied out, then scaled
+    const std::vector<double> stored(points, 100.0);
+    std::vector<double> prices(points);
+    for (auto _ : state) {
+        std::copy(stored.begin(), stored.end(), prices.begin());
+        actions.adjustPrices("SERIES", days.data(), prices.data(), points);
+        doNotOptimize(prices[0]);
+    }
+}
+
+// 1,000 portfolios of 50 holdings drawn from a 500-name, 11-sector
+// benchmark over the fixture's first symbols, with five years of daily
+// returns; rebuilt when the fixture size changes.
+struct RelativeFixture {
+    std::vector<Portfolio> portfolios;
+    std::vector<const Portfolio*> views;
+    BenchmarkIndex benchmark;
+    ReturnHistory history;
+};
+
+RelativeFixture& relativeFor(Fixture& f) {
+    constexpr size_t kConstituents = 500;
+    constexpr size_t kPeriods = 1260;
+    constexpr size_t kPortfolios = 1000;
+    constexpr size_t kHoldings = 50;
+    static const char* const kSectors[] = {"Technology", "Financials", "Health Care", "Industrials",
+                                           "Consumer Discretionary", "Communication", "Consumer Staples",
+                                           "Energy", "Utilities", "Real Estate", "Materials"};
+    static std::unique_ptr<RelativeFixture> relative;
+    static size_t relativeSize = 0;
+    if (!relative || relativeSize != f.size()) {
+        relative.reset(new RelativeFixture());
+        relativeSize = f.size();
+        std::mt19937 rng(17);
+        std::normal_distribution<double> daily(0.0004, 0.015);
+        std::uniform_real_distribution<double> weight(0.5, 5.0);
+        const Portfolio& source = f.get();
+        const size_t names = std::min(f.size(), kConstituents);
+
+        std::vector<std::string> labels(kPeriods);
+        for (size_t t = 0; t < kPeriods; ++t) {
+            labels[t] = "T" + std::to_string(t);
+        }
+        relative->history.setPeriods(labels);
+        std::vector<double> series(kPeriods);
+        for (size_t i = 0; i < names; ++i) {
+            const std::string& symbol = source[i].getStock()->getSymbol();
+            relative->benchmark.addConstituent(symbol, weight(rng), kSectors[i % 11]);
+            for (double& value : series) {
+                value = daily(rng);
+            }
+            relative->history.setSeries(symbol, series);
+        }
+
+        relative->portfolios.resize(kPortfolios);
+        for (Portfolio& portfolio : relative->portfolios) {
+            for (size_t h = 0; h < kHoldings; ++h) {
+                const Investment& held = source[rng() % names];
+                if (!static_cast<const Portfolio&>(portfolio).getInvestment(held.getStock()->getSymbol())) {
+                    portfolio.addInvestment(Investment(held.getStock(), 10 + static_cast<int>(rng() % 100), 50.0));
+                }
+            }
+            relative->views.push_back(&portfolio);
+        }
+    }
+    return *relative;
+}
+
+void BM_RelativeAnalytics(BenchState& state) {
+    RelativeFixture& relative = relativeFor(fixture(state.size()));
+    for (auto _ : state) {
+        RelativeResults results = RelativeAnalytics::run(relative.views, relative.benchmark, relative.history);
+        doNotOptimize(results.portfolios.back().trackingError);
+    }
+}
+
+const std::vector<BenchDefinition>& registry() {
+    static const std::vector<BenchDefinition> benchmarks = {
+        {"BM_FindInvestment", BM_FindInvestment},
+        {"BM_AddInvestmentMerge", BM_AddInvestmentMerge},
+        {"BM_AddInvestmentNew", BM_AddInvestmentNew},
+        {"BM_UpdateStockPrice", BM_UpdateStockPrice},
+        {"BM_GetCurrentValue", BM_GetCurrentValue},
+        {"BM_SortInvestmentsByValue", BM_SortInvestmentsByValue},
+        {"BM_GetTopPerformers", BM_GetTopPerformers},
+        {"BM_SaveToFile", BM_SaveToFile},
+        {"BM_LoadFromFile", BM_LoadFromFile},
+        {"BM_ExportToCSV", BM_ExportToCSV},
+        {"BM_AlertEngineTick", BM_AlertEngineTick},
+        {"BM_BookTotalValue<Default>", BM_BookTotalValue<DefaultPositionBook>},
+        {"BM_BookTotalValue<Equity>", BM_BookTotalValue<EquityPositionBook>},
+        {"BM_BookTotalValue<DoubleSoa>", BM_BookTotalValue<DoubleSoaBook>},
+        {"BM_BookTotalValue<Crypto>", BM_BookTotalValue<CryptoPositionBook>},
+        {"BM_BookUpdatePrice<Default>", BM_BookUpdatePrice<DefaultPositionBook>},
+        {"BM_BookUpdatePrice<Equity>", BM_BookUpdatePrice<EquityPositionBook>},
+        {"BM_SharedPriceRead", BM_SharedPriceRead},
+        {"BM_OptionTick", BM_OptionTick},
+        {"BM_OptionTickAmerican", BM_OptionTickAmerican},
+        {"BM_OptionRepriceAll", BM_OptionRepriceAll},
+        {"BM_HarvestScan", BM_HarvestScan},
+        {"BM_AdjustPriceHistory", BM_AdjustPriceHistory},
+        {"BM_RelativeAnalytics", BM_RelativeAnalytics},
+    };
+    return benchmarks;
+}
+
+// ---------------------------------------------------------------------------
+// Reporting
+// ---------------------------------------------------------------------------
+
+std::string jsonEscape(const std::string& text) {
+    std::string out;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out;
+}
+
+void writeJson(std::ostream& os, const std::vector<BenchResult>& results) {
+    std::time_t now = std::time(nullptr);
+    char date[32];
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+    os << "{\n";
+    os << "  \"context\": {\n";
+    os << "    \"date\": \"" << date << "\",\n";
+    os << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n";
+#if defined(__VERSION__)
+    os << "    \"compiler\": \"" << jsonEscape(__VERSION__) << "\",\n";
+#endif
+#if defined(NDEBUG)
+    os << "    \"build_type\": \"release\"\n";
+#else
+    os << "    \"build_type\": \"default\"\n";
+#endif
+    os << "  },\n";
+    os << "  \"benchmarks\": [\n";
+    os << std::setprecision(6) << std::fixed;
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        os << "    {\"name\": \"" << jsonEscape(r.name) << "\""
+           << ", \"positions\": " << r.positions
+           << ", \"iterations\": " << r.iterations
+           << ", \"ns_per_op\": " << r.nsPerOp
+           << ", \"allocs_per_op\": " << r.allocsPerOp
+           << ", \"bytes_per_op\": " << r.bytesPerOp << "}"
+           << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n";
+    os << "}\n";
+}
+
+void printResult(const BenchResult& r) {
+    std::cout << std::left << std::setw(40) << r.name
+              << std::right << std::fixed << std::setprecision(1)
+              << std::setw(16) << r.nsPerOp << " ns/op"
+              << std::setw(12) << r.allocsPerOp << " allocs/op"
+              << std::setw(14) << r.bytesPerOp << " B/op"
+              << std::setw(12) << r.iterations << " iters\n";
+    std::cout.flush();
+}
+
+bool parseArgs(int argc, char** argv, BenchOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&arg](const std::string& prefix) { return arg.substr(prefix.size()); };
+
+        if (arg.rfind("--min-size=", 0) == 0) {
+            options.minSize = std::stoul(value("--min-size="));
+        } else if (arg.rfind("--max-size=", 0) == 0) {
+            options.maxSize = std::stoul(value("--max-size="));
+        } else if (arg.rfind("--min-time=", 0) == 0) {
+            options.minTimeSeconds = std::stod(value("--min-time="));
+        } else if (arg.rfind("--filter=", 0) == 0) {
+            options.filter = value("--filter=");
+        } else if (arg.rfind("--out=", 0) == 0) {
+            options.outFile = value("--out=");
+        } else if (arg.rfind("--tmpdir=", 0) == 0) {
+            options.tmpDir = value("--tmpdir=");
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--min-size=N] [--max-size=N] [--min-time=SECONDS]"
+                      << " [--filter=REGEX] [--out=FILE.json] [--tmpdir=DIR]\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    try {
+        if (!parseArgs(argc, argv, options)) {
+            return 2;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Invalid argument: " << e.what() << "\n";
+        return 2;
+    }
+    g_tmpDir = options.tmpDir;
+
+    std::regex filter(options.filter.empty() ? ".*" : options.filter);
+    std::vector<BenchResult> results;
+
+    // Sizes run in the outer loop so each synthetic portfolio is built once.
+    for (size_t size = 10; size <= options.maxSize; size *= 10) {
+        if (size < options.minSize) {
+            continue;
+        }
+        for (const auto& def : registry()) {
+            std::string name = def.name + "/" + std::to_string(size);
+            if (!std::regex_search(name, filter)) {
+                continue;
+            }
+            BenchResult result = runBenchmark(def, size, options.minTimeSeconds);
+            printResult(result);
+            results.push_back(result);
+        }
+        g_fixture.reset();
+    }
+
+    if (!options.outFile.empty()) {
+        std::ofstream out(options.outFile);
+        if (!out.is_open()) {
+            std::cerr << "Failed to write " << options.outFile << "\n";
+            return 1;
+        }
+        writeJson(out, results);
+        std::cout << "Results written to " << options.outFile << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,79 @@
+#!/usr/bin/env python3
+"""Compare two portfolio_bench JSON result files and flag regressions.
+
+Usage:
+    python3 bench/compare_bench.py BASELINE.json CURRENT.json [--threshold=10]
+
+A benchmark regresses when its ns/op grows by more than the threshold
+(percent), or when it allocates more per operation than the baseline.
+Exits with status 1 if any regression is found.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load_results(path):
+    with open(path) as f:
+        data = json.load(f)
+    return {b["name"]: b for b in data.get("benchmarks", [])}
+
+
+def percent_change(old, new):
+    if old == 0:
+        return 0.0 if new == 0 else float("inf")
+    return (new - old) / old * 100.0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="allowed ns/op slowdown in percent (default 10)")
+    args = parser.parse_args()
+
+    baseline = load_results(args.baseline)
+    current = load_results(args.current)
+
+    regressions = []
+    print(f"{'Benchmark':<40}{'Base ns/op':>14}{'New ns/op':>14}{'Change':>10}"
+          f"{'Base allocs':>13}{'New allocs':>12}")
+    print("-" * 103)
+
+    for name, new in current.items():
+        old = baseline.get(name)
+        if old is None:
+            print(f"{name:<40}{'-':>14}{new['ns_per_op']:>14.1f}{'new':>10}")
+            continue
+
+        change = percent_change(old["ns_per_op"], new["ns_per_op"])
+        flags = []
+        if change > args.threshold:
+            flags.append("SLOWER")
+        if new["allocs_per_op"] > old["allocs_per_op"] + 0.5:
+            flags.append("MORE ALLOCS")
+
+        print(f"{name:<40}{old['ns_per_op']:>14.1f}{new['ns_per_op']:>14.1f}"
+              f"{change:>+9.1f}%{old['allocs_per_op']:>13.1f}{new['allocs_per_op']:>12.1f}"
+              f"  {' '.join(flags)}")
+        if flags:
+            regressions.append((name, flags))
+
+    missing = sorted(set(baseline) - set(current))
+    for name in missing:
+        print(f"{name:<40}{'(not run)':>14}")
+
+    if regressions:
+        print(f"\n{len(regressions)} regression(s) over {args.threshold:.1f}% threshold:")
+        for name, flags in regressions:
+            print(f"  {name}: {', '.join(flags)}")
+        return 1
+
+    print("\nNo regressions.")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,16 +1,39 @@
 #include "Portfolio.h"
+#include "AsyncPersistence.h"
+#include "BenchmarkAnalytics.h"
+#include "Dashboard.h"
+#include "OptionBook.h"
+#include "PositionQuery.h"
+#include "ScenarioEngine.h"
+#include "SharedPriceTable.h"
+#include "StreamingAggregator.h"
+#include "TaxLossHarvester.h"
+#include "Calendar.h"
+#include "CorporateActions.h"
+#include "Metrics.h"
 #include <iostream>
 #include <memory>
 #include <limits>
 #include <random>
+#include <sstream>
 #include <chrono>
 #include <iomanip>
 #include <thread>
-#include <windows.h>
+#include <utility>
+#include <vector>
 using namespace std;
 class StockPortfolioManager {
 private:
     Portfolio portfolio;
+    AsyncPersistence persistence;
+    std::vector<std::pair<std::string, std::future<bool>>> pendingSaves;  // Writes still in flight
+    // Shared price table: this process either publishes its ticks or reads
+    // other processes' prices
+    std::unique_ptr<SharedPriceWriter> priceWriter;
+    std::unique_ptr<SharedPricePublisher> pricePublisher;
+    std::unique_ptr<SharedPriceReader> priceReader;
+    // Options on the portfolio's stocks, repriced as their prices tick
+    std::unique_ptr<OptionBook> options;
     std::mt19937 rng;
 
     // Utility methods
@@ -29,27 +52,28 @@ private:
         std::cout << "\nSimulating real-time price updates...\n";
         for (int i = 0; i < 5; ++i) {
             // Update prices for all stocks in portfolio
-            for (size_t j = 0; j < portfolio.getInvestmentCount(); ++j) {
+            const Portfolio& positions = portfolio;
+            for (size_t j = 0; j < positions.getInvestmentCount(); ++j) {
                 try {
-                    Investment& inv = portfolio[j];
+                    const Investment& inv = positions[j];
                     if (inv.getStock()) {
-                        double currentPrice = inv.getStock()->getCurrentPrice();
+                        double currentPrice = inv.getStock()->getCurrentPrice().toDouble();
                         double newPrice = getRandomPrice(currentPrice, 0.05);
-                        inv.getStock()->setCurrentPrice(newPrice);
+                        portfolio.updateStockPrice(inv.getStock()->getSymbol(), newPrice);
                     }
                 } catch (const std::exception&) {
                     continue;
                 }
             }
 
-            Sleep(1000);
+            std::this_thread::sleep_for(std::chrono::seconds(1));
             std::cout << "Update " << (i + 1) << "/5 completed...\n";
         }
         std::cout << "Real-time updates completed!\n";
     }
 
 public:
-    StockPortfolioManager() : portfolio("My Investment Portfolio"), rng(std::random_device{}()) {}
+    StockPortfolioManager() : portfolio("My Investment Portfolio"), persistence(portfolio), rng(std::random_device{}()) {}
 
     void displayMenu() {
         std::cout << "\n" << std::string(50, '=') << "\n";
@@ -70,6 +94,16 @@ public:
         std::cout << "13. Load Portfolio\n";
         std::cout << "14. Export to CSV\n";
         std::cout << "15. Load Sample Data\n";
+        std::cout << "16. Export Metrics\n";
+        std::cout << "17. Query Positions\n";
+        std::cout << "18. Live Dashboard\n";
+        std::cout << "19. Summarize Large Portfolio File\n";
+        std::cout << "20. Share Prices Between Processes\n";
+        std::cout << "21. Run Stress Scenarios\n";
+        std::cout << "22. Price Options\n";
+        std::cout << "23. Scan Tax-Loss Harvesting\n";
+        std::cout << "24. Apply Corporate Actions\n";
+        std::cout << "25. Benchmark-Relative Analytics\n";
         std::cout << "0.  Exit\n";
         std::cout << std::string(50, '-') << "\n";
         std::cout << "Enter your choice: ";
@@ -193,16 +227,39 @@ public:
         }
     }
 
+    static bool isColumnarFile(const std::string& filename) {
+        return filename.size() > 4 && filename.compare(filename.size() - 4, 4, ".pfc") == 0;
+    }
+
+    // The snapshot is taken before returning; the file is written in the
+    // background and reported from the menu once it is done
+    void queueSave(const std::string& filename, SnapshotFormat format) {
+        pendingSaves.emplace_back(filename, persistence.save(filename, format));
+        persistence.finishCapture();
+        std::cout << "Saving to " << filename << " in the background...\n";
+    }
+
+    void reportFinishedSaves() {
+        for (auto it = pendingSaves.begin(); it != pendingSaves.end();) {
+            if (it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                ++it;
+                continue;
+            }
+            if (it->second.get()) {
+                std::cout << "Saved " << it->first << ".\n";
+            } else {
+                std::cout << "Failed to save " << it->first << ".\n";
+            }
+            it = pendingSaves.erase(it);
+        }
+    }
+
     void savePortfolio() {
         std::string filename;
-        std::cout << "\nEnter filename to save: ";
+        std::cout << "\nEnter filename to save (.pfc for the columnar format): ";
         std::cin >> filename;
 
-        if (portfolio.saveToFile(filename)) {
-            std::cout << "Portfolio saved successfully!\n";
-        } else {
-            std::cout << "Failed to save portfolio.\n";
-        }
+        queueSave(filename, isColumnarFile(filename) ? SnapshotFormat::Columnar : SnapshotFormat::Text);
     }
 
     void loadPortfolio() {
@@ -210,7 +267,17 @@ public:
         std::cout << "\nEnter filename to load: ";
         std::cin >> filename;
 
-        if (portfolio.loadFromFile(filename)) {
+        bool loaded = false;
+        if (isColumnarFile(filename)) {
+            loaded = portfolio.loadFromColumnar(filename);
+        } else {
+            std::unique_ptr<Portfolio> result = persistence.load(filename).get();
+            if (result) {
+                portfolio = *result;
+                loaded = true;
+            }
+        }
+        if (loaded) {
             std::cout << "Portfolio loaded successfully!\n";
         } else {
             std::cout << "Failed to load portfolio.\n";
@@ -222,10 +289,349 @@ public:
         std::cout << "\nEnter CSV filename: ";
         std::cin >> filename;
 
-        if (portfolio.exportToCSV(filename)) {
-            std::cout << "Portfolio exported to CSV successfully!\n";
+        queueSave(filename, SnapshotFormat::CSV);
+    }
+
+    void exportMetrics() {
+        char destination, format;
+        std::string target;
+        std::cout << "\nExport to (f)ile or (s)ocket? ";
+        std::cin >> destination;
+        std::cout << "Format: (p)rometheus or (j)son? ";
+        std::cin >> format;
+
+        bool toSocket = destination == 's' || destination == 'S';
+        std::cout << (toSocket ? "Enter unix:/socket/path or host:port: " : "Enter filename: ");
+        std::cin >> target;
+
+        Metrics::Format fmt = (format == 'j' || format == 'J') ? Metrics::Format::Json
+                                                               : Metrics::Format::Prometheus;
+        bool ok = toSocket ? Metrics::exportToSocket(target, fmt) : Metrics::exportToFile(target, fmt);
+
+        if (ok) {
+            std::cout << "Metrics exported successfully!\n";
+        } else {
+            std::cout << "Failed to export metrics.\n";
+        }
+    }
+
+    void queryPositions() {
+        std::string text, filename;
+        std::cout << "\nFields: shares price prev_price avg_cost invested value gain return change weight\n"
+                  << "        symbol currency sector industry country\n"
+                  << "Example: sector = Technology and return < 0 sort value desc limit 10\n"
+                  << "Enter query: ";
+        clearInputBuffer();
+        std::getline(std::cin, text);
+
+        try {
+            PositionQuery query(text);
+            portfolio.displayPortfolio(query);
+
+            std::cout << "\nExport results to CSV (filename, or Enter to skip): ";
+            std::getline(std::cin, filename);
+            if (!filename.empty()) {
+                if (portfolio.exportToCSV(filename, query)) {
+                    std::cout << "Query results exported to CSV successfully!\n";
+                } else {
+                    std::cout << "Failed to export query results.\n";
+                }
+            }
+        } catch (const std::exception& e) {
+            std::cout << "Error: " << e.what() << "\n";
+        }
+    }
+
+    void liveDashboard() {
+        std::string text;
+        std::cout << "\nEnter query to filter the view (or Enter for all positions): ";
+        clearInputBuffer();
+        std::getline(std::cin, text);
+
+        try {
+            Dashboard dashboard(portfolio);
+            if (!text.empty()) {
+                dashboard.setQuery(PositionQuery(text));
+            }
+            // Simulated feed: a random walk on a handful of positions per frame
+            dashboard.setFeed([this](Portfolio& target) {
+                size_t count = target.getInvestmentCount();
+                if (count == 0) {
+                    return;
+                }
+                const Portfolio& view = target;  // Const access keeps the symbol index
+                std::uniform_int_distribution<size_t> pick(0, count - 1);
+                std::vector<PriceUpdate> updates;
+                for (size_t i = 0; i < std::min<size_t>(count, 8); ++i) {
+                    const Investment& inv = view[pick(rng)];
+                    if (inv.getStock()) {
+                        double currentPrice = inv.getStock()->getCurrentPrice().toDouble();
+                        updates.push_back({inv.getStock()->getSymbol(),
+                                           Money::fromDouble(getRandomPrice(currentPrice, 0.01))});
+                    }
+                }
+                target.updateStockPrices(updates);
+            });
+
+            if (dashboard.run()) {
+                std::cout << "Dashboard closed after " << dashboard.getFramesDrawn() << " frames ("
+                          << dashboard.getBytesWritten() / 1024 << " KB written).\n";
+            } else {
+                std::cout << "The live dashboard needs an interactive terminal.\n";
+            }
+        } catch (const std::exception& e) {
+            std::cout << "Error: " << e.what() << "\n";
+        }
+    }
+
+    // Streams a saved portfolio too large to load, without replacing the
+    // current one
+    void summarizeLargeFile() {
+        std::string filename;
+        StreamingOptions options;
+        std::cout << "\nEnter portfolio filename: ";
+        clearInputBuffer();
+        std::getline(std::cin, filename);
+        std::cout << "Export positions to CSV (filename, or Enter to skip): ";
+        std::getline(std::cin, options.csvFile);
+
+        StreamingSummary summary;
+        try {
+            if (StreamingAggregator::run(filename, options, summary)) {
+                StreamingAggregator::display(summary);
+            } else {
+                std::cout << "Failed to read portfolio file.\n";
+            }
+        } catch (const std::exception& e) {
+            std::cout << "Error: " << e.what() << "\n";
+        }
+    }
+
+    void sharePrices() {
+        std::string name;
+        char role;
+        std::cout << "\nShared price table name: ";
+        std::cin >> name;
+        std::cout << "(p)ublish this portfolio's prices or (r)ead another process's? ";
+        std::cin >> role;
+
+        pricePublisher.reset();
+        priceWriter.reset();
+        priceReader.reset();
+        if (role == 'p' || role == 'P') {
+            priceWriter.reset(new SharedPriceWriter());
+            if (!priceWriter->create(name)) {
+                std::cout << "Could not create the table (is another process publishing it?).\n";
+                priceWriter.reset();
+                return;
+            }
+            pricePublisher.reset(new SharedPricePublisher(portfolio, *priceWriter));
+            std::cout << "Publishing " << pricePublisher->publishAll() << " prices; later ticks follow.\n";
         } else {
-            std::cout << "Failed to export portfolio.\n";
+            priceReader.reset(new SharedPriceReader());
+            if (!priceReader->open(name)) {
+                std::cout << "No shared price table named " << name << ".\n";
+                priceReader.reset();
+                return;
+            }
+            std::cout << "Reading " << priceReader->size() << " shared prices; "
+                      << priceReader->poll(portfolio) << " positions updated.\n";
+        }
+    }
+
+    void pollSharedPrices() {
+        if (priceReader) {
+            size_t applied = priceReader->poll(portfolio);
+            if (applied > 0) {
+                std::cout << applied << " prices updated from the shared table.\n";
+            }
+        }
+    }
+
+    // Shocks from a CSV (a "scenario" column, then one column per factor key)
+    // applied to the current portfolio; live prices are left alone
+    void runStressScenarios() {
+        std::string filename;
+        std::cout << "\nEnter scenario CSV filename: ";
+        std::cin >> filename;
+
+        ScenarioSet scenarios;
+        if (!scenarios.loadFromCSV(filename) || scenarios.scenarioCount() == 0) {
+            std::cout << "Failed to load scenarios.\n";
+            return;
+        }
+        ScenarioResults results = ScenarioEngine::run(portfolio, scenarios);
+        std::cout << "\n" << std::left << std::setw(30) << "Scenario" << std::right << std::setw(18)
+                  << ("P&L (" + results.baseCurrencies[0] + ")") << std::setw(10) << "Return\n";
+        std::cout << std::string(58, '-') << "\n";
+        const double value = results.baseValues[0].toDouble();
+        for (size_t s = 0; s < results.scenarios.size(); ++s) {
+            Money pnl = results.getPnl(0, s);
+            std::ostringstream amount;
+            amount << pnl;
+            std::cout << std::left << std::setw(30) << results.scenarios[s] << std::right << std::setw(18)
+                      << amount.str() << std::setw(9) << std::fixed
+                      << std::setprecision(2) << (value != 0.0 ? pnl.toDouble() / value * 100.0 : 0.0) << "%\n";
+        }
+        std::cout << "Worst: " << results.scenarios[results.worstScenario(0)] << "\n";
+    }
+
+    // Loads option positions from a CSV (see OptionBook::loadFromCSV) and
+    // keeps them priced off the portfolio's live prices
+    void priceOptions() {
+        std::string filename;
+        double rate;
+        std::cout << "\nEnter options CSV filename: ";
+        std::cin >> filename;
+        std::cout << "Risk-free rate (e.g. 0.04): ";
+        std::cin >> rate;
+
+        std::unique_ptr<OptionBook> book(new OptionBook());
+        book->setRate(rate);
+        if (!book->loadFromCSV(filename) || book->size() == 0) {
+            std::cout << "Failed to load options.\n";
+            return;
+        }
+        book->attach(portfolio);
+        options = std::move(book);
+
+        std::cout << "\n" << std::left << std::setw(16) << "Option" << std::setw(10) << "Underlying" << std::right
+                  << std::setw(10) << "Price" << std::setw(9) << "Delta" << std::setw(9) << "Gamma" << std::setw(9)
+                  << "Vega" << std::setw(10) << "Theta" << std::setw(16) << "Value" << "\n";
+        std::cout << std::string(89, '-') << "\n";
+        for (size_t i = 0; i < options->size(); ++i) {
+            const OptionContract& contract = options->getContract(i);
+            OptionGreeks greeks = options->getGreeks(i);
+            std::ostringstream value;
+            value << options->getMarketValue(i);
+            std::cout << std::left << std::setw(16) << contract.symbol << std::setw(10) << contract.underlying
+                      << std::right << std::fixed << std::setprecision(4) << std::setw(10) << greeks.price
+                      << std::setw(9) << greeks.delta << std::setw(9) << greeks.gamma << std::setw(9)
+                      << greeks.vega / 100.0 << std::setw(10) << greeks.theta / 365.0 << std::setw(16)
+                      << value.str() << "\n";
+        }
+        std::cout << "Vega per vol point, theta per day. Total value: " << options->getTotalValue()
+                  << "; repriced on every tick from now on.\n";
+    }
+
+    // Scans tax lots from a CSV (see TaxLotLedger) for losses worth
+    // harvesting today, valued at the portfolio's current prices
+    void harvestTaxLosses() {
+        std::string lotsFile, tradesFile, exportFile;
+        std::cout << "\nEnter tax lots CSV filename: ";
+        clearInputBuffer();
+        std::getline(std::cin, lotsFile);
+        std::cout << "Trade history CSV (filename, or Enter to skip): ";
+        std::getline(std::cin, tradesFile);
+        std::cout << "Export candidates to CSV (filename, or Enter to skip): ";
+        std::getline(std::cin, exportFile);
+
+        TaxLotLedger ledger;
+        if (!ledger.loadLotsFromCSV(lotsFile) || ledger.lotCount() == 0) {
+            std::cout << "Failed to load tax lots.\n";
+            return;
+        }
+        if (!tradesFile.empty() && !ledger.loadTradesFromCSV(tradesFile)) {
+            std::cout << "Failed to load trade history.\n";
+            return;
+        }
+        ledger.updatePrices(portfolio);
+        HarvestResults results = TaxLossHarvester::scan(ledger);
+
+        const size_t shown = std::min<size_t>(results.ranking.size(), 20);
+        std::cout << "\n" << std::left << std::setw(12) << "Account" << std::setw(8) << "Symbol" << std::setw(12)
+                  << "Acquired" << std::setw(7) << "Term" << std::right << std::setw(10) << "Shares" << std::setw(16)
+                  << "Loss" << std::setw(16) << "Disallowed" << std::setw(12) << "Benefit" << "\n";
+        std::cout << std::string(93, '-') << "\n";
+        for (size_t i = 0; i < shown; ++i) {
+            const HarvestCandidate& c = results.candidates[results.ranking[i]];
+            std::ostringstream loss, disallowed;
+            loss << c.loss;
+            disallowed << c.disallowedLoss;
+            std::cout << std::left << std::setw(12) << results.accounts[c.account] << std::setw(8)
+                      << results.symbols[c.symbol] << std::setw(12) << calendar::formatDay(c.acquiredDay)
+                      << std::setw(7) << (c.longTerm ? "long" : "short") << std::right << std::setw(10) << c.shares
+                      << std::setw(16) << loss.str() << std::setw(16) << disallowed.str() << std::setw(12)
+                      << std::fixed << std::setprecision(2) << c.taxBenefit << "\n";
+        }
+        std::cout << results.ranking.size() << " lots to sell from " << results.lotsScanned << " scanned ("
+                  << results.washSaleLots << " held back by wash sales). Allowed loss: " << results.totalLoss
+                  << ", tax benefit: " << std::fixed << std::setprecision(2) << results.totalBenefit
+                  << ". Buy back from " << calendar::formatDay(results.repurchaseDay) << ".\n";
+        if (!exportFile.empty() && !TaxLossHarvester::exportToCSV(results, exportFile)) {
+            std::cout << "Failed to export candidates.\n";
+        }
+    }
+
+    // Loads splits and dividends from a CSV (see CorporateActions) and posts
+    // the ones that have gone ex to the holdings
+    void applyCorporateActions() {
+        std::string filename;
+        std::cout << "\nEnter corporate actions CSV filename: ";
+        std::cin >> filename;
+
+        CorporateActions actions;
+        if (!actions.loadFromCSV(filename)) {
+            std::cout << "Failed to load corporate actions.\n";
+            return;
+        }
+        size_t posted = actions.applyTo(portfolio, calendar::today());
+        std::cout << "Loaded " << actions.size() << " actions; posted " << posted
+                  << " splits and stock dividends to holdings.\n";
+        if (posted > 0) {
+            portfolio.displayPortfolio();
+        }
+    }
+
+    // Measures the portfolio against a benchmark's constituents (see
+    // BenchmarkIndex) over a history of periodic returns (see ReturnHistory)
+    void compareToBenchmark() {
+        std::string benchmarkFile, returnsFile, exportFile;
+        std::cout << "\nEnter benchmark constituents CSV filename: ";
+        clearInputBuffer();
+        std::getline(std::cin, benchmarkFile);
+        std::cout << "Enter return history CSV filename: ";
+        std::getline(std::cin, returnsFile);
+        std::cout << "Export attribution to CSV (filename, or Enter to skip): ";
+        std::getline(std::cin, exportFile);
+
+        BenchmarkIndex benchmark(benchmarkFile);
+        if (!benchmark.loadFromCSV(benchmarkFile) || benchmark.size() == 0) {
+            std::cout << "Failed to load benchmark constituents.\n";
+            return;
+        }
+        ReturnHistory history;
+        if (!history.loadFromCSV(returnsFile) || history.periodCount() < 2) {
+            std::cout << "Failed to load return history (at least two periods are needed).\n";
+            return;
+        }
+        RelativeResults results = RelativeAnalytics::run(portfolio, benchmark, history);
+        const RelativePerformance& p = results.portfolios.front();
+
+        std::cout << "\n" << std::left << std::setw(24) << "Sector" << std::right << std::setw(9) << "Weight"
+                  << std::setw(9) << "Bench" << std::setw(9) << "Active" << std::setw(10) << "Return" << std::setw(10)
+                  << "Bench Ret" << std::setw(11) << "Allocation" << std::setw(10) << "Selection" << std::setw(12)
+                  << "Interaction" << "\n";
+        std::cout << std::string(104, '-') << "\n";
+        std::cout << std::fixed << std::setprecision(2);
+        for (const GroupAttribution& g : p.groups) {
+            std::cout << std::left << std::setw(24) << (g.group.empty() ? "(none)" : g.group) << std::right
+                      << std::setw(8) << g.portfolioWeight * 100.0 << "%" << std::setw(8) << g.benchmarkWeight * 100.0
+                      << "%" << std::setw(8) << g.activeWeight * 100.0 << "%" << std::setw(9)
+                      << g.portfolioReturn * 100.0 << "%" << std::setw(9) << g.benchmarkReturn * 100.0 << "%"
+                      << std::setw(10) << g.allocation * 100.0 << "%" << std::setw(9) << g.selection * 100.0 << "%"
+                      << std::setw(11) << g.interaction * 100.0 << "%\n";
+        }
+        std::cout << "Over " << results.periods << " periods: return " << p.portfolioReturn * 100.0
+                  << "% vs " << p.benchmarkReturn * 100.0 << "% (active " << p.activeReturn * 100.0 << "%).\n";
+        std::cout << "Tracking error " << p.trackingError * 100.0 << "%, beta " << std::setprecision(3) << p.beta
+                  << ", information ratio " << p.informationRatio << ", active share " << std::setprecision(2)
+                  << p.activeShare * 100.0 << "%.\n";
+        if (p.missingWeight > 0.0) {
+            std::cout << p.missingWeight * 100.0 << "% of the portfolio has no return history and is taken as flat.\n";
+        }
+        if (!exportFile.empty() && !RelativeAnalytics::exportToCSV(results, exportFile)) {
+            std::cout << "Failed to export attribution.\n";
         }
     }
 
@@ -263,6 +669,8 @@ public:
         std::cout << "Demonstrating Object-Oriented Programming Principles\n";
 
         do {
+            reportFinishedSaves();
+            pollSharedPrices();
             displayMenu();
             std::cin >> choice;
 
@@ -285,6 +693,16 @@ public:
                 case 13: loadPortfolio(); break;
                 case 14: exportToCSV(); break;
                 case 15: loadSampleData(); break;
+                case 16: exportMetrics(); break;
+                case 17: queryPositions(); break;
+                case 18: liveDashboard(); break;
+                case 19: summarizeLargeFile(); break;
+                case 20: sharePrices(); break;
+                case 21: runStressScenarios(); break;
+                case 22: priceOptions(); break;
+                case 23: harvestTaxLosses(); break;
+                case 24: applyCorporateActions(); break;
+                case 25: compareToBenchmark(); break;
                 case 0: 
                     std::cout << "\nThank you for using Stock Portfolio Manager!\n";
                     break;
@@ -0,0 +1,210 @@
+#include "TestHarness.h"
+#include "../ColumnarFile.h"
+#include "../Portfolio.h"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr size_t kPositions = 300;
+constexpr size_t kRowGroupSize = 128;
+
+// Distinct prices over a few bytes' range (bit-packed), a constant share
+// count (one run) and a currency column with repeats (dictionary)
+Portfolio samplePortfolio() {
+    Portfolio portfolio("Columnar Test");
+    portfolio.updateFxRate("EUR", 1.085);
+    for (size_t i = 0; i < kPositions; ++i) {
+        char symbol[16];
+        std::snprintf(symbol, sizeof(symbol), "S%03zu", i);
+        Money price = Money::fromUnits(1000000 + static_cast<std::int64_t>(i) * 104723);
+        auto stock = std::make_shared<Stock>(symbol, std::string("Company ") + symbol, price,
+                                             i % 3 == 0 ? "EUR" : "USD");
+        Money purchase = Money::fromUnits(500000 + static_cast<std::int64_t>(i) * 3);
+        portfolio.addInvestment(Investment(stock, 100, purchase));
+    }
+    return portfolio;
+}
+
+std::string writeSample(const std::string& name) {
+    std::string path = testing::tempPath(name);
+    ColumnarWriteOptions options;
+    options.rowGroupSize = kRowGroupSize;
+    CHECK(ColumnarWriter::write(samplePortfolio(), path, options));
+    return path;
+}
+
+std::string readBytes(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void writeBytes(const std::string& path, const std::string& bytes) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+std::uint32_t footerLength(const std::string& bytes) {
+    std::uint32_t length = 0;
+    for (int i = 0; i < 4; ++i) {
+        length |= static_cast<std::uint32_t>(static_cast<std::uint8_t>(bytes[bytes.size() - 12 + i])) << (8 * i);
+    }
+    return length;
+}
+
+void setFooterLength(std::string& bytes, std::uint32_t length) {
+    for (int i = 0; i < 4; ++i) {
+        bytes[bytes.size() - 12 + i] = static_cast<char>((length >> (8 * i)) & 0xFF);
+    }
+}
+
+// A reader that opened must decode every group or report failure, never
+// crash or over-allocate
+void readEverything(ColumnarReader& reader) {
+    std::vector<Investment> rows;
+    for (size_t group = 0; group < reader.getRowGroups().size(); ++group) {
+        if (!reader.readRowGroup(group, rows)) {
+            return;
+        }
+    }
+}
+
+} // namespace
+
+TEST(ColumnarRoundTripUsesRunLengthAndBitPacking) {
+    const std::string path = writeSample("columnar_roundtrip.pfc");
+    const Portfolio original = samplePortfolio();
+
+    ColumnarReader reader;
+    CHECK(reader.open(path));
+    CHECK_EQ(reader.getRowCount(), kPositions);
+    CHECK_EQ(reader.getRowGroups().size(), (kPositions + kRowGroupSize - 1) / kRowGroupSize);
+
+    const int shares = reader.findColumn("shares");
+    const int price = reader.findColumn("price");
+    CHECK(shares >= 0 && price >= 0);
+    if (shares < 0 || price < 0) {
+        return;
+    }
+    size_t row = 0;
+    for (size_t group = 0; group < reader.getRowGroups().size(); ++group) {
+        const RowGroupInfo& info = reader.getRowGroups()[group];
+        CHECK(info.columns[shares].encoding == ColumnEncoding::RunLength);
+        CHECK(info.columns[price].encoding == ColumnEncoding::BitPacked);
+
+        std::vector<std::int64_t> values;
+        CHECK(reader.readIntColumn(group, static_cast<size_t>(shares), values));
+        CHECK_EQ(values.size(), info.rows);
+        for (std::int64_t value : values) {
+            CHECK_EQ(value, 100);
+        }
+        CHECK(reader.readIntColumn(group, static_cast<size_t>(price), values));
+        CHECK_EQ(values.size(), info.rows);
+        for (size_t i = 0; i < values.size(); ++i, ++row) {
+            CHECK_EQ(values[i], original[row].getStock()->getCurrentPrice().raw());
+        }
+    }
+
+    Portfolio loaded("Empty");
+    CHECK(loaded.loadFromColumnar(path));
+    CHECK_EQ(loaded.getPortfolioName(), std::string("Columnar Test"));
+    CHECK_EQ(loaded.getInvestmentCount(), kPositions);
+    for (size_t i = 0; i < loaded.getInvestmentCount() && i < kPositions; ++i) {
+        const Investment& a = loaded[i];
+        const Investment& b = original[i];
+        CHECK_EQ(a.getStock()->getSymbol(), b.getStock()->getSymbol());
+        CHECK_EQ(a.getStock()->getCurrencyCode(), b.getStock()->getCurrencyCode());
+        CHECK_EQ(a.getStock()->getCurrentPrice(), b.getStock()->getCurrentPrice());
+        CHECK_EQ(a.getSharesOwned(), b.getSharesOwned());
+        CHECK_EQ(a.getPurchasePrice(), b.getPurchasePrice());
+        CHECK_EQ(a.getTotalInvested(), b.getTotalInvested());
+    }
+    std::remove(path.c_str());
+}
+
+TEST(ColumnarBitPackingKeepsWideValues) {
+    // 54-bit offsets: each packed value straddles several bytes and the
+    // 64-bit buffer's boundary
+    Portfolio portfolio("Wide");
+    std::vector<Money> prices;
+    for (int i = 0; i < 40; ++i) {
+        prices.push_back(Money::fromUnits(10000000000000000 + (i * 7919 % 40) * 250000000000000LL + i));
+        auto stock = std::make_shared<Stock>("W" + std::to_string(i), "Wide", prices.back());
+        portfolio.addInvestment(Investment(stock, 1, prices.back()));
+    }
+    const std::string path = testing::tempPath("columnar_wide.pfc");
+    CHECK(ColumnarWriter::write(portfolio, path));
+
+    ColumnarReader reader;
+    CHECK(reader.open(path));
+    const int price = reader.findColumn("price");
+    CHECK(price >= 0 && reader.getRowGroups().size() == 1);
+    if (price < 0 || reader.getRowGroups().size() != 1) {
+        return;
+    }
+    CHECK(reader.getRowGroups()[0].columns[price].encoding == ColumnEncoding::BitPacked);
+    std::vector<std::int64_t> values;
+    CHECK(reader.readIntColumn(0, static_cast<size_t>(price), values));
+    CHECK_EQ(values.size(), prices.size());
+    for (size_t i = 0; i < values.size() && i < prices.size(); ++i) {
+        CHECK_EQ(values[i], prices[i].raw());
+    }
+    std::remove(path.c_str());
+}
+
+TEST(ColumnarRejectsCorruptFooter) {
+    const std::string path = writeSample("columnar_corrupt.pfc");
+    const std::string good = readBytes(path);
+    const std::string damaged = testing::tempPath("columnar_damaged.pfc");
+    ColumnarReader reader;
+
+    std::string bytes = good;
+    setFooterLength(bytes, 0xFFFFFFF0u);
+    writeBytes(damaged, bytes);
+    CHECK(!reader.open(damaged));
+
+    bytes = good;
+    setFooterLength(bytes, 0);
+    writeBytes(damaged, bytes);
+    CHECK(!reader.open(damaged));
+
+    bytes = good;
+    bytes[bytes.size() - 1] ^= 0x5A;  // Trailing magic
+    writeBytes(damaged, bytes);
+    CHECK(!reader.open(damaged));
+
+    writeBytes(damaged, good.substr(0, good.size() - 1));
+    CHECK(!reader.open(damaged));
+
+    // Footer cut short: the length says it starts later than it does
+    bytes = good;
+    setFooterLength(bytes, footerLength(good) / 2);
+    writeBytes(damaged, bytes);
+    CHECK(!reader.open(damaged));
+
+    // Every single-byte change to the footer either fails open() or leaves a
+    // file that decodes (or fails) without crashing
+    const size_t footerStart = good.size() - 12 - footerLength(good);
+    for (size_t at = footerStart; at < good.size() - 12; ++at) {
+        bytes = good;
+        bytes[at] = static_cast<char>(bytes[at] ^ 0xFF);
+        writeBytes(damaged, bytes);
+        if (reader.open(damaged)) {
+            readEverything(reader);
+        }
+    }
+
+    Portfolio portfolio("Untouched");
+    bytes = good;
+    setFooterLength(bytes, 0);
+    writeBytes(damaged, bytes);
+    CHECK(!portfolio.loadFromColumnar(damaged));
+    CHECK_EQ(portfolio.getPortfolioName(), std::string("Untouched"));
+
+    std::remove(damaged.c_str());
+    std::remove(path.c_str());
+}
@@ -0,0 +1,182 @@
+#include "TestHarness.h"
+#include "../CorporateActions.h"
+#include "../Portfolio.h"
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+Investment holding(const std::string& symbol, int shares, Money purchasePrice, Money currentPrice,
+                   int acquiredDay) {
+    Investment investment(std::make_shared<Stock>(symbol, symbol, currentPrice), shares, purchasePrice);
+    investment.setAcquiredDay(acquiredDay);
+    return investment;
+}
+
+} // namespace
+
+// Holdings pick splits up through their Stock when read, without being
+// touched: shares round down and the cost basis stays put
+TEST(InvestmentReadsSplitsLazily) {
+    auto stock = std::make_shared<Stock>("ABC", "ABC Corp", Money::fromWhole(90));
+    Investment investment(stock, 100, Money::fromWhole(60));
+
+    stock->applySplit({3, 2});
+    CHECK_EQ(stock->getCurrentPrice(), Money::fromWhole(60));
+    CHECK_EQ(investment.getSharesOwned(), 150);
+    CHECK_EQ(investment.getPurchasePrice(), Money::fromWhole(40));
+    CHECK_EQ(investment.getTotalInvested(), Money::fromWhole(6000));
+    CHECK_EQ(investment.getCurrentValue(), Money::fromWhole(9000));
+
+    // Reverse split: 150 -> 15
+    stock->applySplit({1, 10});
+    CHECK_EQ(investment.getSharesOwned(), 15);
+    CHECK_EQ(investment.getPurchasePrice(), Money::fromWhole(400));
+    CHECK_EQ(investment.getTotalInvested(), Money::fromWhole(6000));
+
+    // A mutation settles both splits before applying itself
+    investment.addShares(5, Money::fromWhole(600));
+    CHECK_EQ(investment.getSharesOwned(), 20);
+    CHECK_EQ(investment.getTotalInvested(), Money::fromWhole(9000));
+    CHECK_EQ(investment.getPurchasePrice(), Money::fromWhole(450));
+
+    // A holding opened after a split starts from the split figures
+    Investment later(stock, 10, Money::fromWhole(600));
+    stock->applySplit({2, 1});
+    CHECK_EQ(later.getSharesOwned(), 20);
+    CHECK_EQ(later.getPurchasePrice(), Money::fromWhole(300));
+    CHECK_EQ(investment.getSharesOwned(), 40);
+}
+
+// 101 shares split 3:2 are 151.5: the half share is paid in cash at the
+// split price, and its cost leaves the position as for a sale
+TEST(PortfolioSplitPaysCashInLieu) {
+    Portfolio portfolio("Splits");
+    portfolio.addInvestment(holding("ABC", 101, Money::fromWhole(10), Money::fromWhole(30), 0));
+    const Money investedBefore = portfolio.getTotalInitialInvestment();
+
+    std::vector<PortfolioEvent> splits;
+    portfolio.subscribe(
+        [&](const std::vector<PortfolioEvent>& events) {
+            for (const PortfolioEvent& event : events) {
+                if (event.type == PortfolioEventType::PositionSplit) {
+                    splits.push_back(event);
+                }
+            }
+        },
+        eventMask(PortfolioEventType::PositionSplit));
+
+    CHECK(portfolio.applySplit("ABC", {3, 2}));
+    portfolio.flushEvents();
+    const Investment* investment = portfolio.getInvestment("ABC");
+    CHECK(investment != nullptr);
+    if (!investment) {
+        return;
+    }
+    CHECK_EQ(investment->getSharesOwned(), 151);
+    CHECK_EQ(investment->getStock()->getCurrentPrice(), Money::fromWhole(20));
+    // 1010 less the half share's cost, 1010 / 303
+    const Money writeOff = Money::fromUnits(Money::fromWhole(1010).raw() / 303);
+    CHECK_EQ(investment->getTotalInvested(), Money::fromWhole(1010) - writeOff);
+    CHECK_EQ(portfolio.getTotalInitialInvestment(), investedBefore - writeOff);
+    CHECK_EQ(portfolio.getCurrentValue(), Money::fromWhole(20 * 151));
+
+    CHECK_EQ(splits.size(), 1u);
+    if (splits.size() == 1) {
+        CHECK_EQ(splits[0].symbol, std::string("ABC"));
+        CHECK_EQ(splits[0].oldPrice, Money::fromWhole(30));
+        CHECK_EQ(splits[0].newPrice, Money::fromWhole(20));
+        CHECK_EQ(splits[0].cashInLieu, Money::fromWhole(10));
+    }
+
+    // An even split pays nothing and writes nothing off
+    splits.clear();
+    const Money invested = investment->getTotalInvested();
+    CHECK(portfolio.applySplit("ABC", {2, 1}));
+    portfolio.flushEvents();
+    CHECK_EQ(investment->getSharesOwned(), 302);
+    CHECK_EQ(investment->getTotalInvested(), invested);
+    CHECK_EQ(splits.size(), 1u);
+    if (splits.size() == 1) {
+        CHECK_EQ(splits[0].cashInLieu, Money());
+    }
+
+    CHECK(!portfolio.applySplit("XYZ", {2, 1}));
+    CHECK_THROWS(portfolio.applySplit("ABC", {0, 1}), std::invalid_argument);
+}
+
+TEST(CorporateActionsApplyToPostsEachSplitOnce) {
+    CorporateActions actions;
+    actions.addSplit("ABC", 100, 2, 1);
+    actions.addCashDividend("ABC", 120, Money::fromWhole(1), Money::fromWhole(50));
+    actions.addStockDividend("ABC", 150, 5.0);
+    actions.addSplit("ABC", 300, 1, 4);
+    actions.addSplit("NEW", 100, 3, 1);    // Before NEW was bought
+    actions.addSplit("NONE", 100, 2, 1);   // Not held
+    CHECK_EQ(actions.size(), 6u);
+
+    Portfolio portfolio("Actions");
+    portfolio.addInvestment(holding("ABC", 100, Money::fromWhole(50), Money::fromWhole(100), 50));
+    portfolio.addInvestment(holding("NEW", 30, Money::fromWhole(10), Money::fromWhole(10), 110));
+
+    // The split and the stock dividend; the cash dividend moves no shares
+    CHECK_EQ(actions.applyTo(portfolio, 200), 2u);
+    const Investment* abc = portfolio.getInvestment("ABC");
+    const Investment* fresh = portfolio.getInvestment("NEW");
+    CHECK(abc != nullptr && fresh != nullptr);
+    if (!abc || !fresh) {
+        return;
+    }
+    CHECK_EQ(abc->getSharesOwned(), 210);
+    CHECK_EQ(abc->getTotalInvested(), Money::fromWhole(5000));
+    CHECK_EQ(abc->getStock()->getLastSplitDay(), 150);
+    CHECK_EQ(fresh->getSharesOwned(), 30);
+
+    // Nothing twice, including after a save and reload
+    CHECK_EQ(actions.applyTo(portfolio, 200), 0u);
+    std::stringstream saved;
+    CHECK(portfolio.saveToStream(saved));
+    Portfolio reloaded("Reloaded");
+    CHECK(reloaded.loadFromStream(saved));
+    CHECK_EQ(actions.applyTo(reloaded, 200), 0u);
+    const Investment* reloadedAbc = reloaded.getInvestment("ABC");
+    CHECK(reloadedAbc != nullptr && reloadedAbc->getSharesOwned() == 210);
+
+    // The reverse split once its ex-day has come
+    CHECK_EQ(actions.applyTo(portfolio, 400), 1u);
+    CHECK_EQ(abc->getSharesOwned(), 52);
+    CHECK_EQ(actions.applyTo(portfolio, 400), 0u);
+}
+
+TEST(CorporateActionsAdjustHistoricalFigures) {
+    CorporateActions actions;
+    actions.addSplit("ABC", 100, 2, 1);
+    actions.addCashDividend("ABC", 200, Money::fromWhole(5), Money::fromWhole(100));
+
+    const AdjustmentFactor early = actions.factorSince("ABC", 50);
+    CHECK_EQ(early.shares.numerator, 2);
+    CHECK_EQ(early.shares.denominator, 1);
+    CHECK(early.prices > 0.474999 && early.prices < 0.475001);
+    CHECK_EQ(actions.factorSince("ABC", 100).shares.numerator, 1);  // Ex-day figures are already split
+    CHECK_EQ(actions.factorSince("ABC", 200).prices, 1.0);
+    CHECK_EQ(actions.factorSince("XYZ", 0).prices, 1.0);
+
+    const int days[] = {50, 99, 100, 150, 250};
+    double prices[] = {100, 100, 50, 50, 50};
+    std::int64_t shares[] = {10, 11, 20, 20, 20};
+    actions.adjustPrices("ABC", days, prices, 5);
+    actions.adjustQuantities("ABC", days, shares, 5);
+    const double expectedPrices[] = {47.5, 47.5, 47.5, 47.5, 50};
+    const std::int64_t expectedShares[] = {20, 22, 20, 20, 20};
+    for (int i = 0; i < 5; ++i) {
+        CHECK(prices[i] > expectedPrices[i] - 1e-9 && prices[i] < expectedPrices[i] + 1e-9);
+        CHECK_EQ(shares[i], expectedShares[i]);
+    }
+
+    CHECK_THROWS(actions.addSplit("ABC", 10, 0, 1), std::invalid_argument);
+    CHECK_THROWS(actions.addCashDividend("ABC", 10, Money::fromWhole(5), Money::fromWhole(5)), std::invalid_argument);
+    CHECK_THROWS(actions.addStockDividend("ABC", 10, 0.0), std::invalid_argument);
+}
@@ -0,0 +1,118 @@
+#include "TestHarness.h"
+#include "../Money.h"
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+// Written for the default six decimals (one unit is 0.000001)
+static_assert(Money::kDecimals == 6, "MoneyTest expects PORTFOLIO_MONEY_DECIMALS=6");
+
+namespace {
+
+constexpr std::int64_t kMax = std::numeric_limits<std::int64_t>::max();
+constexpr std::int64_t kMin = std::numeric_limits<std::int64_t>::min();
+
+// Parsed units, or a sentinel the tests never expect when parsing fails
+std::int64_t parsed(const std::string& text) {
+    Money value = Money::fromUnits(-1);
+    return Money::tryParse(text, value) ? value.raw() : kMin;
+}
+
+} // namespace
+
+TEST(MoneyParsesSignsAndWhitespace) {
+    CHECK_EQ(parsed("150.25"), 150250000);
+    CHECK_EQ(parsed("+150.25"), 150250000);
+    CHECK_EQ(parsed("-150.25"), -150250000);
+    CHECK_EQ(parsed("  42 \t"), 42000000);
+    CHECK_EQ(parsed(".5"), 500000);
+    CHECK_EQ(parsed("7."), 7000000);
+    CHECK_EQ(parsed("-0"), 0);
+    CHECK_EQ(parsed("0.000001"), 1);
+    CHECK_EQ(parsed("1.5e2"), 150000000);  // Older save files
+
+    const char* rejected[] = {"", "   ", "-", "+", ".", "+-1", "--1", "1.2.3", "12a", "$5", "1,000", "1 000"};
+    for (const char* text : rejected) {
+        Money value = Money::fromWhole(7);
+        if (Money::tryParse(text, value)) {
+            testing::fail(__FILE__, __LINE__, std::string("accepted \"") + text + "\"");
+        }
+        CHECK_EQ(value, Money::fromWhole(7));  // Untouched on failure
+    }
+    CHECK_THROWS(Money::fromString("abc"), std::invalid_argument);
+}
+
+// Digits past the sixth decimal round half-to-even on the magnitude, so a
+// negative amount rounds as its positive counterpart does
+TEST(MoneyParseRoundsExtraDecimalsHalfToEven) {
+    CHECK_EQ(parsed("0.0000004"), 0);
+    CHECK_EQ(parsed("0.0000006"), 1);
+    CHECK_EQ(parsed("0.0000005"), 0);          // Tie, to even
+    CHECK_EQ(parsed("0.0000015"), 2);          // Tie, to even
+    CHECK_EQ(parsed("0.00000050000001"), 1);   // Above the tie
+    CHECK_EQ(parsed("0.00000249999999"), 2);
+    CHECK_EQ(parsed("-0.0000015"), -2);
+    CHECK_EQ(parsed("-0.0000025"), -2);
+    CHECK_EQ(parsed("1.2345675"), 1234568);
+    CHECK_EQ(parsed("1.2345665"), 1234566);
+    CHECK_EQ(parsed("9.9999995"), 10000000);   // Carries into the whole part
+}
+
+TEST(MoneyParseRejectsOverflow) {
+    CHECK_EQ(parsed("9223372036854.775807"), kMax);
+    CHECK_EQ(parsed("-9223372036854.775807"), -kMax);
+    CHECK_EQ(parsed("9223372036854.775808"), kMin);   // One unit too many
+    CHECK_EQ(parsed("9223372036854.7758075"), kMin);  // Rounds up past the top
+    CHECK_EQ(parsed("9223372036854.7758065"), kMax - 1);
+    CHECK_EQ(parsed("92233720368547758070"), kMin);
+    CHECK_EQ(parsed("100000000000000000000000000000"), kMin);
+    CHECK_THROWS(Money::fromString("1e20"), std::invalid_argument);
+    CHECK_THROWS(Money::fromDouble(1e20), std::overflow_error);
+}
+
+TEST(MoneyMulDivRoundsHalfToEven) {
+    const Money one = Money::fromUnits(1);
+    CHECK_EQ(one.mulDiv(1, 2), Money());                // 0.5 -> 0
+    CHECK_EQ(Money::fromUnits(3).mulDiv(1, 2), Money::fromUnits(2));  // 1.5 -> 2
+    CHECK_EQ(Money::fromUnits(5).mulDiv(1, 2), Money::fromUnits(2));  // 2.5 -> 2
+    CHECK_EQ(Money::fromUnits(-3).mulDiv(1, 2), Money::fromUnits(-2));
+    CHECK_EQ(Money::fromUnits(-5).mulDiv(1, 2), Money::fromUnits(-2));
+    CHECK_EQ(Money::fromUnits(5).mulDiv(-1, 2), Money::fromUnits(-2));
+    CHECK_EQ(Money::fromUnits(10).mulDiv(1, 3), Money::fromUnits(3));
+    CHECK_EQ(Money::fromUnits(20).mulDiv(1, 3), Money::fromUnits(7));
+    CHECK_EQ(Money::fromWhole(100).mulDiv(2, 3), Money::fromUnits(66666667));
+
+    // The product is taken in 128 bits: only the quotient must fit
+    const Money big = Money::fromUnits(kMax);
+    CHECK_EQ(big.mulDiv(kMax, kMax), big);
+    CHECK_EQ(big.mulDiv(3, 4), Money::fromUnits(6917529027641081855));
+    CHECK_THROWS(big.mulDiv(2, 1), std::overflow_error);
+    CHECK_THROWS(one.mulDiv(1, 0), std::invalid_argument);
+
+    CHECK_EQ(Money::fromUnits(7) / 2, Money::fromUnits(4));  // 3.5 -> 4
+    CHECK_EQ(Money::fromUnits(9) / 2, Money::fromUnits(4));  // 4.5 -> 4
+    CHECK_THROWS(one / 0, std::invalid_argument);
+}
+
+TEST(MoneyCheckedArithmeticThrowsOnOverflow) {
+    const Money top = Money::fromUnits(kMax);
+    const Money bottom = Money::fromUnits(kMin);
+    const Money one = Money::fromUnits(1);
+
+    CHECK_EQ(Money::fromWhole(2).checkedAdd(Money::fromWhole(3)), Money::fromWhole(5));
+    CHECK_EQ(top.checkedAdd(Money()), top);
+    CHECK_EQ(bottom.checkedAdd(top), Money::fromUnits(-1));
+    CHECK_THROWS(top.checkedAdd(one), std::overflow_error);
+    CHECK_THROWS(bottom.checkedAdd(-one), std::overflow_error);
+
+    CHECK_EQ(Money().checkedSubtract(top), -top);
+    CHECK_THROWS(bottom.checkedSubtract(one), std::overflow_error);
+    CHECK_THROWS(Money().checkedSubtract(bottom), std::overflow_error);
+
+    CHECK_EQ(Money::fromString("1.5").checkedMultiply(-4), Money::fromWhole(-6));
+    CHECK_EQ(top.checkedMultiply(-1), -top);
+    CHECK_THROWS(top.checkedMultiply(2), std::overflow_error);
+    CHECK_THROWS(bottom.checkedMultiply(-1), std::overflow_error);
+    CHECK_THROWS(Money::fromWhole(10000000).checkedMultiply(1000000000), std::overflow_error);
+}
@@ -0,0 +1,48 @@
+#include "TestHarness.h"
+#include "../ParallelFor.h"
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+TEST(ParallelForRunsEveryItemOnce) {
+    std::vector<std::atomic<int>> runs(1000);
+    parallelFor(runs.size(), 4, [&](std::size_t item) { runs[item].fetch_add(1); });
+    size_t once = 0;
+    for (const std::atomic<int>& count : runs) {
+        once += count.load() == 1 ? 1 : 0;
+    }
+    CHECK_EQ(once, runs.size());
+    parallelFor(0, 4, [&](std::size_t) { testing::fail(__FILE__, __LINE__, "ran an item of none"); });
+}
+
+// A throw on a worker thread reaches the caller after the join instead of
+// terminating the process, and stops further items from being handed out
+TEST(ParallelForRethrowsWorkerExceptions) {
+    for (std::size_t threads : {std::size_t(1), std::size_t(4)}) {
+        std::atomic<std::size_t> started(0);
+        std::string message;
+        try {
+            parallelFor(100000, threads, [&](std::size_t item) {
+                started.fetch_add(1);
+                if (item == 10) {
+                    throw std::runtime_error("item 10");
+                }
+            });
+        } catch (const std::runtime_error& e) {
+            message = e.what();
+        }
+        CHECK_EQ(message, std::string("item 10"));
+        CHECK(started.load() < 100000);
+    }
+
+    // Several items throwing: exactly one exception comes out
+    std::size_t caught = 0;
+    try {
+        parallelFor(64, 8, [](std::size_t item) { throw std::out_of_range(std::to_string(item)); });
+    } catch (const std::out_of_range&) {
+        ++caught;
+    }
+    CHECK_EQ(caught, 1u);
+}
@@ -0,0 +1,137 @@
+#include "TestHarness.h"
+#include "../Portfolio.h"
+#include "../PositionQuery.h"
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Four positions, one share each, so value == price:
+//   AAPL  Technology    200 (cost  100, +100%)
+//   MSFT  Technology    300 (cost  330, -9.1%)
+//   XOM   Energy         50 (cost   50,    0%)
+//   JNJ   Health Care  1500 (cost 1000,  +50%)
+Portfolio samplePortfolio() {
+    Portfolio portfolio("Query Test");
+    struct Row {
+        const char* symbol;
+        const char* sector;
+        int price;
+        int cost;
+    };
+    const Row rows[] = {
+        {"AAPL", "Technology", 200, 100},
+        {"MSFT", "Technology", 300, 330},
+        {"XOM", "Energy", 50, 50},
+        {"JNJ", "Health Care", 1500, 1000},
+    };
+    for (const Row& row : rows) {
+        auto stock = std::make_shared<Stock>(row.symbol, row.symbol, Money::fromWhole(row.price));
+        stock->setSector(row.sector);
+        portfolio.addInvestment(Investment(stock, 1, Money::fromWhole(row.cost)));
+    }
+    return portfolio;
+}
+
+std::vector<std::string> symbolsFor(const Portfolio& portfolio, const std::string& text) {
+    std::vector<std::string> symbols;
+    for (size_t row : PositionQuery(text).execute(portfolio)) {
+        symbols.push_back(portfolio[row].getStock()->getSymbol());
+    }
+    return symbols;
+}
+
+std::string joined(const std::vector<std::string>& symbols) {
+    std::string text;
+    for (const std::string& symbol : symbols) {
+        text += (text.empty() ? "" : ",") + symbol;
+    }
+    return text;
+}
+
+} // namespace
+
+TEST(PositionQueryAcceptsGrammar) {
+    const PositionQuery all("");
+    CHECK(!all.hasFilter());
+    CHECK(!all.hasSort());
+    CHECK_EQ(all.getLimit(), PositionQuery::kNoLimit);
+
+    const PositionQuery full("WHERE sector = Technology and (return < -5% or weight > 10) "
+                             "ORDER BY value DESC, symbol LIMIT 20");
+    CHECK(full.hasFilter());
+    CHECK(full.hasSort());
+    CHECK_EQ(full.getLimit(), 20u);
+
+    const char* accepted[] = {
+        "price > 100",
+        "price >= $1.5k",
+        "value <= 2m and invested < 1b",
+        "shares == 1",
+        "symbol != 'MSFT'",
+        "sector = \"Health Care\"",
+        "not (gain < 0)",
+        "change <> 0",
+        "sort return asc",
+        "order by weight desc limit 3",
+        "limit 0",
+        "Price > 1 AND Sector = Energy",
+    };
+    for (const char* text : accepted) {
+        try {
+            PositionQuery query(text);
+        } catch (const std::invalid_argument& e) {
+            testing::fail(__FILE__, __LINE__, std::string("rejected \"") + text + "\": " + e.what());
+        }
+    }
+}
+
+TEST(PositionQueryRejectsMalformedText) {
+    const char* rejected[] = {
+        "price >",
+        "> 100",
+        "volume > 5",
+        "price > abc",
+        "(price > 1",
+        "price > 1)",
+        "price > 1 and",
+        "price > 1 or or value < 2",
+        "sector < Technology",
+        "symbol = 'AAPL",
+        "sort",
+        "sort price sideways",
+        "limit",
+        "limit -1",
+        "limit ten",
+        "price > 1 limit 5 limit 6",
+    };
+    for (const char* text : rejected) {
+        bool threw = false;
+        try {
+            PositionQuery query(text);
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        if (!threw) {
+            testing::fail(__FILE__, __LINE__, std::string("accepted \"") + text + "\"");
+        }
+    }
+}
+
+TEST(PositionQueryFiltersSortsAndLimits) {
+    const Portfolio portfolio = samplePortfolio();
+    CHECK_EQ(joined(symbolsFor(portfolio, "")), std::string("AAPL,MSFT,XOM,JNJ"));
+    // Field names are case-insensitive; the values compared against are not
+    CHECK_EQ(joined(symbolsFor(portfolio, "SECTOR = Technology")), std::string("AAPL,MSFT"));
+    CHECK_EQ(joined(symbolsFor(portfolio, "sector = technology")), std::string(""));
+    CHECK_EQ(joined(symbolsFor(portfolio, "sector = 'Health Care'")), std::string("JNJ"));
+    CHECK_EQ(joined(symbolsFor(portfolio, "price >= 1.5k")), std::string("JNJ"));
+    CHECK_EQ(joined(symbolsFor(portfolio, "return < -5%")), std::string("MSFT"));
+    CHECK_EQ(joined(symbolsFor(portfolio, "not sector = Technology sort value")), std::string("XOM,JNJ"));
+    CHECK_EQ(joined(symbolsFor(portfolio, "sector = Technology or return > 40 sort value desc limit 2")),
+             std::string("JNJ,MSFT"));
+    CHECK_EQ(joined(symbolsFor(portfolio, "gain = 0")), std::string("XOM"));
+    CHECK_EQ(joined(symbolsFor(portfolio, "limit 0")), std::string(""));
+}
@@ -0,0 +1,128 @@
+#include "TestHarness.h"
+#include "../SharedPriceTable.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+std::string tableName(const std::string& suffix) {
+    return "portfolio_test_" + std::to_string(getpid()) + "_" + suffix;
+}
+
+} // namespace
+
+TEST(SharedPriceRoundTrip) {
+    const std::string name = tableName("roundtrip");
+    SharedPriceWriter writer;
+    CHECK(writer.create(name, 4));
+    CHECK(writer.publish("AAPL", Money::fromString("150.25"), 1000));
+    CHECK(writer.publish("AAPL", Money::fromString("151.5"), 2000));
+    CHECK(!writer.publish("AAPL", Money::fromWhole(-1), 3000));
+    CHECK(!writer.publish(std::string(SharedPriceWriter::kMaxSymbolLength + 1, 'X'), Money::fromWhole(1), 3000));
+
+    SharedPriceReader reader;
+    CHECK(reader.open(name));
+    std::uint32_t handle = reader.find("AAPL");
+    CHECK(handle != SharedPriceReader::npos);
+    CHECK_EQ(reader.find("MSFT"), SharedPriceReader::npos);
+    SharedPrice price;
+    CHECK(reader.read(handle, price));
+    CHECK_EQ(price.price, Money::fromString("151.5"));
+    CHECK_EQ(price.previousPrice, Money::fromString("150.25"));
+    CHECK_EQ(price.updatedNs, 2000);
+    CHECK_EQ(price.sequence % 2, 0u);
+    CHECK(!reader.read(SharedPriceReader::npos, price));
+
+    // A second writer cannot take a table that is held
+    SharedPriceWriter second;
+    CHECK(!second.create(name));
+    writer.close();
+    CHECK(SharedPriceWriter::remove(name));
+}
+
+// The writer publishes strictly increasing prices with updatedNs equal to the
+// price's units, so every consistent read satisfies price == updatedNs and
+// previousPrice == price - 1. A torn read (fields from two publishes) breaks
+// one of them.
+TEST(SharedPriceSeqlockReadsAreConsistent) {
+    const std::string name = tableName("seqlock");
+    SharedPriceWriter writer;
+    CHECK(writer.create(name, 4));
+    CHECK(writer.publish("HOT", Money::fromUnits(1), 1));
+
+    SharedPriceReader reader;
+    CHECK(reader.open(name));
+    const std::uint32_t handle = reader.find("HOT");
+    CHECK(handle != SharedPriceReader::npos);
+
+    constexpr std::int64_t kPublishes = 200000;
+    std::atomic<bool> done{false};
+    std::thread publisher([&] {
+        for (std::int64_t units = 2; units <= kPublishes; ++units) {
+            writer.publish("HOT", Money::fromUnits(units), units);
+        }
+        done.store(true, std::memory_order_release);
+    });
+
+    size_t reads = 0;
+    size_t torn = 0;
+    std::int64_t last = 0;
+    std::uint32_t lastSequence = 0;
+    bool ordered = true;
+    while (!done.load(std::memory_order_acquire) || reads == 0) {
+        SharedPrice price;
+        if (!reader.read(handle, price)) {
+            continue;
+        }
+        ++reads;
+        if (price.price.raw() != price.updatedNs || price.previousPrice.raw() != price.price.raw() - 1 ||
+            price.sequence % 2 != 0) {
+            ++torn;
+        }
+        if (price.price.raw() < last || price.sequence < lastSequence) {
+            ordered = false;
+        }
+        last = price.price.raw();
+        lastSequence = price.sequence;
+    }
+    publisher.join();
+
+    CHECK(reads > 0);
+    CHECK_EQ(torn, 0u);
+    CHECK(ordered);
+    SharedPrice settled;
+    CHECK(reader.read(handle, settled));
+    CHECK_EQ(settled.price.raw(), kPublishes);
+    writer.close();
+    SharedPriceWriter::remove(name);
+}
+
+// Growing copies every slot into a new segment; a reader follows it with
+// refresh() and finds the old slots unchanged
+TEST(SharedPriceReaderFollowsGrowth) {
+    const std::string name = tableName("growth");
+    SharedPriceWriter writer;
+    CHECK(writer.create(name, 2));
+    CHECK(writer.publish("S0", Money::fromWhole(10), 1));
+
+    SharedPriceReader reader;
+    CHECK(reader.open(name));
+    const std::uint32_t generation = reader.getGeneration();
+    for (int i = 1; i < 100; ++i) {
+        CHECK(writer.publish("S" + std::to_string(i), Money::fromWhole(10 + i), i + 1));
+    }
+    CHECK(writer.getGeneration() != generation);
+
+    CHECK(reader.refresh());
+    CHECK_EQ(reader.getGeneration(), writer.getGeneration());
+    CHECK_EQ(reader.size(), 100u);
+    for (int i = 0; i < 100; ++i) {
+        Money price;
+        CHECK(reader.getPrice("S" + std::to_string(i), price));
+        CHECK_EQ(price, Money::fromWhole(10 + i));
+    }
+    writer.close();
+    SharedPriceWriter::remove(name);
+}
@@ -0,0 +1,74 @@
+// Unit test harness
+//
+// A minimal GoogleTest-style harness with no dependencies: TEST(Name) { ... }
+// registers a test, and the CHECK macros record a failure (file, line and
+// the values involved) and let the test carry on. tests/TestMain.cpp runs
+// every registered test, or those matching --filter=REGEX, and exits
+// non-zero if any check failed or a test threw.
+
+#ifndef TEST_HARNESS_H
+#define TEST_HARNESS_H
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace testing {
+
+struct TestCase {
+    const char* name;
+    void (*function)();
+};
+
+std::vector<TestCase>& registry();
+
+struct Registrar {
+    Registrar(const char* name, void (*function)()) { registry().push_back({name, function}); }
+};
+
+void fail(const char* file, int line, const std::string& message);
+
+// A scratch file path for this run (removed by the caller)
+std::string tempPath(const std::string& name);
+
+template <typename A, typename B>
+void checkEqual(const A& actual, const B& expected, const char* actualText, const char* expectedText,
+                const char* file, int line) {
+    if (!(actual == expected)) {
+        std::ostringstream message;
+        message << "CHECK_EQ(" << actualText << ", " << expectedText << "): " << actual << " != " << expected;
+        fail(file, line, message.str());
+    }
+}
+
+} // namespace testing
+
+#define TEST(name)                                                         \
+    static void name();                                                    \
+    static const ::testing::Registrar name##Registrar(#name, name);        \
+    static void name()
+
+#define CHECK(condition)                                                   \
+    do {                                                                   \
+        if (!(condition)) {                                                \
+            ::testing::fail(__FILE__, __LINE__, "CHECK(" #condition ")");  \
+        }                                                                  \
+    } while (0)
+
+#define CHECK_EQ(actual, expected) \
+    ::testing::checkEqual((actual), (expected), #actual, #expected, __FILE__, __LINE__)
+
+#define CHECK_THROWS(expression, exception)                                                           \
+    do {                                                                                              \
+        bool thrown = false;                                                                          \
+        try {                                                                                         \
+            (void)(expression);                                                                       \
+        } catch (const exception&) {                                                                  \
+            thrown = true;                                                                            \
+        }                                                                                             \
+        if (!thrown) {                                                                                \
+            ::testing::fail(__FILE__, __LINE__, "CHECK_THROWS(" #expression ", " #exception ")");     \
+        }                                                                                             \
+    } while (0)
+
+#endif // TEST_HARNESS_H
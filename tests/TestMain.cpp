@@ -0,0 +1,68 @@
+// Runs the tests registered with TEST() (see TestHarness.h)
+
+#include "TestHarness.h"
+#include <exception>
+#include <iostream>
+#include <regex>
+#include <string>
+
+namespace {
+
+size_t g_failures = 0;
+std::string g_tmpDir = "/tmp";
+
+} // namespace
+
+namespace testing {
+
+std::vector<TestCase>& registry() {
+    static std::vector<TestCase> tests;
+    return tests;
+}
+
+void fail(const char* file, int line, const std::string& message) {
+    ++g_failures;
+    std::cout << "  " << file << ":" << line << ": " << message << "\n";
+}
+
+std::string tempPath(const std::string& name) {
+    return g_tmpDir + "/portfolio_test_" + name;
+}
+
+} // namespace testing
+
+int main(int argc, char** argv) {
+    std::string filter = ".*";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--filter=", 0) == 0) {
+            filter = arg.substr(9);
+        } else if (arg.rfind("--tmpdir=", 0) == 0) {
+            g_tmpDir = arg.substr(9);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--filter=REGEX] [--tmpdir=DIR]\n";
+            return 2;
+        }
+    }
+
+    std::regex pattern(filter);
+    size_t run = 0;
+    size_t failed = 0;
+    for (const testing::TestCase& test : testing::registry()) {
+        if (!std::regex_search(test.name, pattern)) {
+            continue;
+        }
+        ++run;
+        size_t before = g_failures;
+        try {
+            test.function();
+        } catch (const std::exception& e) {
+            testing::fail(test.name, 0, std::string("uncaught exception: ") + e.what());
+        }
+        bool passed = g_failures == before;
+        failed += passed ? 0 : 1;
+        std::cout << (passed ? "[  OK  ] " : "[ FAIL ] ") << test.name << "\n";
+    }
+    std::cout << run - failed << "/" << run << " tests passed\n";
+    return failed == 0 ? 0 : 1;
+}